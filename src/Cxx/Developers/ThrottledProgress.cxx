@@ -0,0 +1,191 @@
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+
+#include "vtkTestThrottledProgressFilter.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+struct ProgressCounter
+{
+  vtkIdType Events = 0;
+  double AbortAt = 2.0; // never
+};
+
+void ProgressFunction(vtkObject* caller, long unsigned int eventId,
+                      void* clientData, void* callData);
+
+void MakePoints(vtkIdType numberOfPoints, vtkPolyData* polyData);
+
+// Run the filter once and return the wall clock time in seconds.
+double Run(vtkTestThrottledProgressFilter* filter, vtkPolyData* input,
+           int mode, ProgressCounter* counter);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  vtkIdType numberOfPoints = 50000000;
+  if (argc > 1)
+  {
+    numberOfPoints = std::stoll(argv[1]);
+  }
+
+  vtkNew<vtkPolyData> input;
+  MakePoints(numberOfPoints, input);
+
+  std::cout << "Points: " << numberOfPoints
+            << "  SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(4);
+
+  struct Case
+  {
+    const char* Name;
+    int Mode;
+    bool Observe;
+  };
+  Case cases[] = {
+      {"No progress", vtkTestThrottledProgressFilter::NO_PROGRESS, false},
+      {"Per iteration", vtkTestThrottledProgressFilter::PER_ITERATION, false},
+      {"Per iteration + observer",
+       vtkTestThrottledProgressFilter::PER_ITERATION, true},
+      {"Throttled", vtkTestThrottledProgressFilter::THROTTLED, false},
+      {"Throttled + observer", vtkTestThrottledProgressFilter::THROTTLED,
+       true},
+  };
+
+  bool ok = true;
+  vtkNew<vtkFloatArray> reference;
+  for (const auto& c : cases)
+  {
+    vtkNew<vtkTestThrottledProgressFilter> filter;
+    filter->SetMaximumEventsPerSecond(10.0);
+    ProgressCounter counter;
+    double seconds =
+        Run(filter, input, c.Mode, c.Observe ? &counter : nullptr);
+
+    auto distances = vtkFloatArray::SafeDownCast(
+        filter->GetOutput()->GetPointData()->GetArray("Distance"));
+    if (!distances)
+    {
+      std::cout << c.Name << ": no output" << std::endl;
+      ok = false;
+      continue;
+    }
+    if (reference->GetNumberOfTuples() == 0)
+    {
+      reference->DeepCopy(distances);
+    }
+    else
+    {
+      for (vtkIdType i = 0; i < numberOfPoints; ++i)
+      {
+        if (distances->GetValue(i) != reference->GetValue(i))
+        {
+          std::cout << c.Name << ": result differs at " << i << std::endl;
+          ok = false;
+          break;
+        }
+      }
+    }
+
+    std::cout << std::left << std::setw(26) << c.Name << std::right
+              << std::setw(10) << seconds << " s  "
+              << filter->GetNumberOfProgressEvents() << " events";
+    if (c.Observe)
+    {
+      std::cout << " (" << counter.Events << " observed)";
+    }
+    std::cout << std::endl;
+
+    // The throttled reporter emits at most MaximumEventsPerSecond.
+    if (c.Mode == vtkTestThrottledProgressFilter::THROTTLED &&
+        filter->GetNumberOfProgressEvents() >
+            static_cast<vtkIdType>(seconds * 10.0) + 1)
+    {
+      std::cout << "  too many events" << std::endl;
+      ok = false;
+    }
+  }
+
+  // Cancel half way through: the workers stop at the next chunk boundary.
+  vtkNew<vtkTestThrottledProgressFilter> filter;
+  filter->SetMaximumEventsPerSecond(1000.0);
+  ProgressCounter counter;
+  counter.AbortAt = 0.5;
+  double seconds = Run(filter, input,
+                       vtkTestThrottledProgressFilter::THROTTLED, &counter);
+  bool aborted =
+      filter->GetOutput()->GetPointData()->GetArray("Distance") == nullptr;
+  std::cout << "Abort at 50%: " << seconds << " s, "
+            << (aborted ? "aborted" : "ran to completion") << std::endl;
+  if (!aborted && numberOfPoints > 10 * filter->GetChunkSize())
+  {
+    ok = false;
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+void ProgressFunction(vtkObject* caller, long unsigned int vtkNotUsed(eventId),
+                      void* clientData, void* vtkNotUsed(callData))
+{
+  auto testFilter = static_cast<vtkTestThrottledProgressFilter*>(caller);
+  auto counter = static_cast<ProgressCounter*>(clientData);
+  ++counter->Events;
+  if (testFilter->GetProgress() >= counter->AbortAt)
+  {
+    testFilter->SetAbortExecute(1);
+  }
+}
+
+void MakePoints(vtkIdType numberOfPoints, vtkPolyData* polyData)
+{
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(numberOfPoints);
+  auto x = static_cast<vtkFloatArray*>(points->GetData())->GetPointer(0);
+  vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      // A cheap, deterministic scatter in the unit cube.
+      auto h = static_cast<unsigned int>(i) * 2654435761u;
+      x[3 * i] = (h & 0x3ff) / 1023.0f;
+      x[3 * i + 1] = ((h >> 10) & 0x3ff) / 1023.0f;
+      x[3 * i + 2] = ((h >> 20) & 0x3ff) / 1023.0f;
+    }
+  });
+  polyData->SetPoints(points);
+}
+
+double Run(vtkTestThrottledProgressFilter* filter, vtkPolyData* input,
+           int mode, ProgressCounter* counter)
+{
+  filter->SetInputData(input);
+  filter->SetProgressMode(mode);
+  if (counter)
+  {
+    vtkNew<vtkCallbackCommand> progressCallback;
+    progressCallback->SetCallback(ProgressFunction);
+    progressCallback->SetClientData(counter);
+    filter->AddObserver(vtkCommand::ProgressEvent, progressCallback);
+  }
+  auto start = std::chrono::steady_clock::now();
+  filter->Update();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+} // namespace
@@ -0,0 +1,51 @@
+#include "vtkTestProgressReporter.h"
+
+#include <vtkAlgorithm.h>
+#include <vtkSMPTools.h>
+
+vtkTestProgressReporter::vtkTestProgressReporter(vtkAlgorithm* algorithm,
+                                                 vtkIdType total,
+                                                 double maximumEventsPerSecond)
+  : Algorithm(algorithm), Total(total > 0 ? total : 1), Done(0),
+    Aborted(false), NumberOfEvents(0)
+{
+  if (maximumEventsPerSecond <= 0.0)
+  {
+    maximumEventsPerSecond = 1.0;
+  }
+  this->Interval =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / maximumEventsPerSecond));
+  this->Last = std::chrono::steady_clock::now();
+}
+
+bool vtkTestProgressReporter::Report(vtkIdType count)
+{
+  vtkIdType done =
+      this->Done.fetch_add(count, std::memory_order_relaxed) + count;
+
+  // Observers expect events from the thread that is executing the pipeline,
+  // so the other workers only count.
+  if (!vtkSMPTools::GetSingleThread())
+  {
+    return !this->IsAborted();
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (now - this->Last >= this->Interval)
+  {
+    this->Last = now;
+    this->Emit(static_cast<double>(done) / this->Total);
+  }
+  if (this->Algorithm->GetAbortExecute())
+  {
+    this->Aborted.store(true, std::memory_order_relaxed);
+  }
+  return !this->IsAborted();
+}
+
+void vtkTestProgressReporter::Emit(double progress)
+{
+  this->Algorithm->UpdateProgress(progress);
+  ++this->NumberOfEvents;
+}
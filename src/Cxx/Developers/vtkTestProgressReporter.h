@@ -0,0 +1,58 @@
+#ifndef __vtkTestProgressReporter_h
+#define __vtkTestProgressReporter_h
+
+#include <vtkType.h>
+
+#include <atomic>
+#include <chrono>
+
+class vtkAlgorithm;
+
+// Description:
+// Shared progress reporter for filters that do their work in vtkSMPTools
+// workers. Workers call Report() at the end of each chunk; the count is
+// accumulated in an atomic, and only the thread that called vtkSMPTools::For
+// invokes UpdateProgress, at most MaximumEventsPerSecond times per second.
+// The same thread polls the algorithm's AbortExecute flag and publishes it
+// to the other workers, which stop at their next chunk boundary. The 0 and 1
+// events are left to the executive.
+class vtkTestProgressReporter
+{
+public:
+  vtkTestProgressReporter(vtkAlgorithm* algorithm, vtkIdType total,
+                          double maximumEventsPerSecond = 10.0);
+
+  // Description:
+  // Add count finished items. Returns false once the execution is aborted.
+  bool Report(vtkIdType count);
+
+  // Description:
+  // Cheap check for workers that want to bail out before a chunk.
+  bool IsAborted() const
+  {
+    return this->Aborted.load(std::memory_order_relaxed);
+  }
+
+  vtkIdType GetNumberOfEvents() const
+  {
+    return this->NumberOfEvents;
+  }
+
+private:
+  void Emit(double progress);
+
+  vtkAlgorithm* Algorithm;
+  vtkIdType Total;
+  std::chrono::steady_clock::duration Interval;
+  std::atomic<vtkIdType> Done;
+  std::atomic<bool> Aborted;
+
+  // Only touched by the calling thread.
+  std::chrono::steady_clock::time_point Last;
+  vtkIdType NumberOfEvents;
+
+  vtkTestProgressReporter(const vtkTestProgressReporter&) = delete;
+  void operator=(const vtkTestProgressReporter&) = delete;
+};
+
+#endif
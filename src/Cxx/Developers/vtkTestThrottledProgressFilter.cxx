@@ -0,0 +1,129 @@
+#include "vtkTestThrottledProgressFilter.h"
+#include "vtkTestProgressReporter.h"
+
+#include <vtkDataObject.h>
+#include <vtkFloatArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <cmath>
+
+vtkStandardNewMacro(vtkTestThrottledProgressFilter);
+
+namespace {
+// The per point work: distance of the point from the origin.
+void ComputeDistances(vtkPoints* points, float* distances, vtkIdType begin,
+                      vtkIdType end)
+{
+  double x[3];
+  for (vtkIdType i = begin; i < end; ++i)
+  {
+    points->GetPoint(i, x);
+    distances[i] =
+        static_cast<float>(std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]));
+  }
+}
+} // namespace
+
+vtkTestThrottledProgressFilter::vtkTestThrottledProgressFilter()
+  : ProgressMode(THROTTLED), MaximumEventsPerSecond(10.0), ChunkSize(65536),
+    NumberOfProgressEvents(0)
+{
+}
+
+int vtkTestThrottledProgressFilter::RequestData(
+    vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector)
+{
+
+  // Get the info objects
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+
+  // Get the input and ouptut
+  vtkPolyData* input =
+      dynamic_cast<vtkPolyData*>(inInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  vtkPolyData* output =
+      dynamic_cast<vtkPolyData*>(outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  output->ShallowCopy(input);
+  this->NumberOfProgressEvents = 0;
+
+  vtkPoints* points = input->GetPoints();
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  if (numberOfPoints == 0)
+  {
+    return 1;
+  }
+
+  vtkNew<vtkFloatArray> distances;
+  distances->SetName("Distance");
+  distances->SetNumberOfTuples(numberOfPoints);
+  float* d = distances->GetPointer(0);
+
+  // Make sure GetPoint is safe to call from several threads.
+  double bounds[6];
+  points->GetBounds(bounds);
+
+  bool aborted = false;
+  if (this->ProgressMode == PER_ITERATION)
+  {
+    // The pattern used by vtkTestProgressReportFilter.
+    for (vtkIdType i = 0; i < numberOfPoints && !aborted; i++)
+    {
+      this->UpdateProgress(static_cast<double>(i) / numberOfPoints);
+      ++this->NumberOfProgressEvents;
+      ComputeDistances(points, d, i, i + 1);
+      aborted = this->GetAbortExecute() != 0;
+    }
+  }
+  else if (this->ProgressMode == NO_PROGRESS)
+  {
+    vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end) {
+      ComputeDistances(points, d, begin, end);
+    });
+  }
+  else
+  {
+    vtkTestProgressReporter reporter(this, numberOfPoints,
+                                     this->MaximumEventsPerSecond);
+    vtkIdType chunkSize = this->ChunkSize;
+    vtkSMPTools::For(0, numberOfPoints, chunkSize,
+                     [&](vtkIdType begin, vtkIdType end) {
+                       // Split large ranges so that every thread reports
+                       // and polls for abort at chunk boundaries.
+                       for (vtkIdType chunk = begin; chunk < end;
+                            chunk += chunkSize)
+                       {
+                         if (reporter.IsAborted())
+                         {
+                           return;
+                         }
+                         vtkIdType last = std::min(end, chunk + chunkSize);
+                         ComputeDistances(points, d, chunk, last);
+                         if (!reporter.Report(last - chunk))
+                         {
+                           return;
+                         }
+                       }
+                     });
+    this->NumberOfProgressEvents = reporter.GetNumberOfEvents();
+    aborted = reporter.IsAborted();
+  }
+
+  // An aborted execution leaves the input untouched.
+  if (!aborted)
+  {
+    output->GetPointData()->AddArray(distances);
+  }
+
+  return 1;
+}
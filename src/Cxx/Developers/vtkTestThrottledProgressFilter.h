@@ -0,0 +1,59 @@
+#ifndef __vtkTestThrottledProgressFilter_h
+#define __vtkTestThrottledProgressFilter_h
+
+#include <vtkPolyDataAlgorithm.h>
+
+class vtkTestThrottledProgressFilter : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkTestThrottledProgressFilter* New();
+  vtkTypeMacro(vtkTestThrottledProgressFilter, vtkPolyDataAlgorithm);
+
+  enum ProgressModes
+  {
+    NO_PROGRESS = 0,   // parallel, never calls UpdateProgress
+    PER_ITERATION = 1, // serial, UpdateProgress for every point
+    THROTTLED = 2      // parallel, vtkTestProgressReporter
+  };
+
+  // Description:
+  // How progress is reported. The default is THROTTLED.
+  vtkSetClampMacro(ProgressMode, int, NO_PROGRESS, THROTTLED);
+  vtkGetMacro(ProgressMode, int);
+
+  // Description:
+  // Upper bound on the ProgressEvent rate in THROTTLED mode.
+  vtkSetMacro(MaximumEventsPerSecond, double);
+  vtkGetMacro(MaximumEventsPerSecond, double);
+
+  // Description:
+  // Number of points a worker processes between two progress reports and
+  // abort checks.
+  vtkSetClampMacro(ChunkSize, vtkIdType, 1, VTK_ID_MAX);
+  vtkGetMacro(ChunkSize, vtkIdType);
+
+  // Description:
+  // Number of ProgressEvents emitted by the last execution.
+  vtkGetMacro(NumberOfProgressEvents, vtkIdType);
+
+protected:
+  vtkTestThrottledProgressFilter();
+  ~vtkTestThrottledProgressFilter()
+  {
+  }
+
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  int ProgressMode;
+  double MaximumEventsPerSecond;
+  vtkIdType ChunkSize;
+  vtkIdType NumberOfProgressEvents;
+
+private:
+  vtkTestThrottledProgressFilter(const vtkTestThrottledProgressFilter&) =
+      delete;
+  void operator=(const vtkTestThrottledProgressFilter&) = delete;
+};
+
+#endif
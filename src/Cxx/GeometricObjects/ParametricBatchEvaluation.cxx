@@ -0,0 +1,734 @@
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkParametricFunction.h>
+#include <vtkParametricFunctionSource.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+#include <vtkParametricBohemianDome.h>
+#include <vtkParametricBour.h>
+#include <vtkParametricBoy.h>
+#include <vtkParametricCatalanMinimal.h>
+#include <vtkParametricConicSpiral.h>
+#include <vtkParametricCrossCap.h>
+#include <vtkParametricDini.h>
+#include <vtkParametricEllipsoid.h>
+#include <vtkParametricEnneper.h>
+#include <vtkParametricFigure8Klein.h>
+#include <vtkParametricHenneberg.h>
+#include <vtkParametricKlein.h>
+#include <vtkParametricKuen.h>
+#include <vtkParametricMobius.h>
+#include <vtkParametricPluckerConoid.h>
+#include <vtkParametricPseudosphere.h>
+#include <vtkParametricRandomHills.h>
+#include <vtkParametricRoman.h>
+#include <vtkParametricSuperEllipsoid.h>
+#include <vtkParametricSuperToroid.h>
+#include <vtkParametricTorus.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Evaluates n samples of a surface. The coordinates are written as
+// structure of arrays so that the loops can be vectorized.
+using BatchKernel = void (*)(vtkParametricFunction* function, const double* u,
+                             const double* v, vtkIdType n, double* x,
+                             double* y, double* z);
+
+/**
+ * A replacement for vtkParametricFunctionSource for surfaces (two
+ * parameters).
+ *
+ * The (u, v) grid is split into tiles that are evaluated in parallel with
+ * vtkSMPTools. The built-in surfaces that have a batch kernel are evaluated
+ * a tile at a time; the others call vtkParametricFunction::Evaluate() once
+ * per sample, which must then be reentrant (it is for the built-in
+ * surfaces).
+ *
+ * The points, in the same order, and the triangles are those of
+ * vtkParametricFunctionSource: a joined direction does not repeat its first
+ * row of points, and the seams are closed with the twists and the
+ * orientation that the function asks for.
+ *
+ * Normals are computed from the grid by central differences. The triangles
+ * only depend on the resolution and on the join, twist and ordering flags,
+ * so they are kept and reused as long as those do not change.
+ */
+class ParallelParametricSource : public vtkPolyDataAlgorithm
+{
+public:
+  static ParallelParametricSource* New();
+  vtkTypeMacro(ParallelParametricSource, vtkPolyDataAlgorithm);
+
+  void SetParametricFunction(vtkParametricFunction* function)
+  {
+    if (this->ParametricFunction != function)
+    {
+      this->ParametricFunction = function;
+      this->Modified();
+    }
+  }
+  vtkParametricFunction* GetParametricFunction()
+  {
+    return this->ParametricFunction;
+  }
+
+  vtkSetClampMacro(UResolution, int, 1, VTK_INT_MAX);
+  vtkGetMacro(UResolution, int);
+  vtkSetClampMacro(VResolution, int, 1, VTK_INT_MAX);
+  vtkGetMacro(VResolution, int);
+
+  // True if the current function is evaluated with a batch kernel.
+  bool HasBatchKernel()
+  {
+    return FindBatchKernel(this->ParametricFunction) != nullptr;
+  }
+
+  // The source is also modified when the function is.
+  vtkMTimeType GetMTime() override
+  {
+    auto mTime = this->Superclass::GetMTime();
+    if (this->ParametricFunction)
+    {
+      mTime = std::max(mTime, this->ParametricFunction->GetMTime());
+    }
+    return mTime;
+  }
+
+  static BatchKernel FindBatchKernel(vtkParametricFunction* function);
+
+protected:
+  ParallelParametricSource()
+  {
+    this->SetNumberOfInputPorts(0);
+  }
+  ~ParallelParametricSource() override = default;
+
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  // The number of points along u and v, then JoinU, JoinV, TwistU, TwistV
+  // and ClockwiseOrdering: everything the triangles depend on.
+  using TopologyKey = std::array<int, 7>;
+
+  void BuildTriangles(const TopologyKey& key);
+
+  vtkSmartPointer<vtkParametricFunction> ParametricFunction;
+  int UResolution = 50;
+  int VResolution = 50;
+
+  // The topology cache.
+  vtkSmartPointer<vtkCellArray> Triangles;
+  TopologyKey TrianglesKey{};
+
+private:
+  ParallelParametricSource(const ParallelParametricSource&) = delete;
+  void operator=(const ParallelParametricSource&) = delete;
+};
+
+vtkStandardNewMacro(ParallelParametricSource);
+
+/**
+ * Create the surfaces, with the parameters used in ParametricObjectsDemo.
+ * The spline is left out as it needs points.
+ */
+std::vector<std::pair<std::string, vtkSmartPointer<vtkParametricFunction>>>
+GetParametricFunctions();
+
+// Largest distance between the points of two outputs, relative to the
+// diagonal of the bounds of the first, or VTK_DOUBLE_MAX if they do not
+// have the same number of points. sameTriangles tells whether both have the
+// same triangles, with the same points in the same order.
+double CompareOutputs(vtkPolyData* reference, vtkPolyData* output,
+                      bool& sameTriangles);
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: ParametricBatchEvaluation [resolution]
+  int resolution = 256;
+  if (argc > 1)
+  {
+    resolution = std::max(2, std::atoi(argv[1]));
+  }
+  const double samples = static_cast<double>(resolution) * resolution;
+
+  vtkNew<vtkTimerLog> timer;
+  bool ok = true;
+
+  std::cout << "Resolution " << resolution << " x " << resolution
+            << ", millions of samples per second" << std::endl;
+  std::cout << std::left << std::setw(16) << "Surface" << std::setw(9)
+            << "Kernel" << std::right << std::setw(12) << "FnSource"
+            << std::setw(12) << "Parallel" << std::setw(10) << "Speedup"
+            << std::setw(12) << "MaxError" << std::endl;
+  std::cout << std::fixed;
+
+  for (const auto& entry : GetParametricFunctions())
+  {
+    auto function = entry.second;
+
+    vtkNew<vtkParametricFunctionSource> reference;
+    reference->SetParametricFunction(function);
+    reference->SetUResolution(resolution);
+    reference->SetVResolution(resolution);
+    timer->StartTimer();
+    reference->Update();
+    timer->StopTimer();
+    const double referenceTime = timer->GetElapsedTime();
+
+    vtkNew<ParallelParametricSource> source;
+    source->SetParametricFunction(function);
+    source->SetUResolution(resolution);
+    source->SetVResolution(resolution);
+    timer->StartTimer();
+    source->Update();
+    timer->StopTimer();
+    const double parallelTime = timer->GetElapsedTime();
+
+    bool sameTriangles = false;
+    const double maxError =
+        CompareOutputs(reference->GetOutput(), source->GetOutput(),
+                       sameTriangles);
+    if (!(maxError < 1.0e-5) || !sameTriangles)
+    {
+      ok = false;
+    }
+
+    std::cout << std::left << std::setw(16) << entry.first << std::setw(9)
+              << (source->HasBatchKernel() ? "batch" : "generic")
+              << std::right << std::setprecision(2) << std::setw(12)
+              << samples / referenceTime / 1.0e6 << std::setw(12)
+              << samples / parallelTime / 1.0e6 << std::setw(10)
+              << referenceTime / parallelTime << std::scientific
+              << std::setprecision(1) << std::setw(12) << maxError
+              << std::fixed << std::endl;
+    if (!sameTriangles)
+    {
+      std::cout << "  The triangles differ from vtkParametricFunctionSource."
+                << std::endl;
+    }
+  }
+
+  // Changing a parameter, but not the resolution, reuses the triangles.
+  vtkNew<vtkParametricTorus> torus;
+  vtkNew<ParallelParametricSource> source;
+  source->SetParametricFunction(torus);
+  source->SetUResolution(resolution);
+  source->SetVResolution(resolution);
+  source->Update();
+  vtkCellArray* triangles = source->GetOutput()->GetPolys();
+  torus->SetRingRadius(2.0);
+  timer->StartTimer();
+  source->Update();
+  timer->StopTimer();
+  const bool reused = source->GetOutput()->GetPolys() == triangles;
+  std::cout << std::setprecision(4) << "\nTorus update after SetRingRadius: "
+            << timer->GetElapsedTime() << " s, triangles "
+            << (reused ? "reused" : "rebuilt") << std::endl;
+  ok = ok && reused;
+
+  std::cout << (ok ? "All surfaces match vtkParametricFunctionSource."
+                   : "Some surfaces do not match vtkParametricFunctionSource.")
+            << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+
+void EvaluateTorus(vtkParametricFunction* function, const double* u,
+                   const double* v, vtkIdType n, double* x, double* y,
+                   double* z)
+{
+  auto torus = static_cast<vtkParametricTorus*>(function);
+  const double ringRadius = torus->GetRingRadius();
+  const double crossSectionRadius = torus->GetCrossSectionRadius();
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    const double t = ringRadius + crossSectionRadius * std::cos(v[i]);
+    x[i] = t * std::cos(u[i]);
+    y[i] = t * std::sin(u[i]);
+    z[i] = crossSectionRadius * std::sin(v[i]);
+  }
+}
+
+void EvaluateEllipsoid(vtkParametricFunction* function, const double* u,
+                       const double* v, vtkIdType n, double* x, double* y,
+                       double* z)
+{
+  auto ellipsoid = static_cast<vtkParametricEllipsoid*>(function);
+  const double xRadius = ellipsoid->GetXRadius();
+  const double yRadius = ellipsoid->GetYRadius();
+  const double zRadius = ellipsoid->GetZRadius();
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    const double sv = std::sin(v[i]);
+    x[i] = xRadius * sv * std::cos(u[i]);
+    y[i] = yRadius * sv * std::sin(u[i]);
+    z[i] = zRadius * std::cos(v[i]);
+  }
+}
+
+void EvaluateEnneper(vtkParametricFunction*, const double* u,
+                     const double* v, vtkIdType n, double* x, double* y,
+                     double* z)
+{
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    const double uu = u[i] * u[i];
+    const double vv = v[i] * v[i];
+    x[i] = u[i] - uu * u[i] / 3.0 + u[i] * vv;
+    y[i] = v[i] - vv * v[i] / 3.0 + v[i] * uu;
+    z[i] = uu - vv;
+  }
+}
+
+// sign(x) |x|^n, as used by the super-quadrics.
+inline double SignedPower(double x, double n)
+{
+  if (x == 0.0)
+  {
+    return 0.0;
+  }
+  return x < 0.0 ? -std::pow(-x, n) : std::pow(x, n);
+}
+
+void EvaluateSuperEllipsoid(vtkParametricFunction* function, const double* u,
+                            const double* v, vtkIdType n, double* x,
+                            double* y, double* z)
+{
+  auto ellipsoid = static_cast<vtkParametricSuperEllipsoid*>(function);
+  const double xRadius = ellipsoid->GetXRadius();
+  const double yRadius = ellipsoid->GetYRadius();
+  const double zRadius = ellipsoid->GetZRadius();
+  const double n1 = ellipsoid->GetN1();
+  const double n2 = ellipsoid->GetN2();
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    const double t = SignedPower(std::sin(v[i]), n1);
+    x[i] = xRadius * t * SignedPower(std::cos(u[i]), n2);
+    y[i] = yRadius * t * SignedPower(std::sin(u[i]), n2);
+    z[i] = zRadius * SignedPower(std::cos(v[i]), n1);
+  }
+}
+
+void EvaluateKlein(vtkParametricFunction*, const double* u, const double* v,
+                   vtkIdType n, double* x, double* y, double* z)
+{
+  const double root2 = std::sqrt(2.0);
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    const double cu2 = std::cos(u[i] / 2);
+    const double su2 = std::sin(u[i] / 2);
+    const double cv = std::cos(v[i]);
+    const double sv = std::sin(v[i]);
+    const double t = cu2 * (root2 + cv) + su2 * sv * cv;
+    x[i] = std::cos(u[i]) * t;
+    y[i] = std::sin(u[i]) * t;
+    z[i] = -su2 * (root2 + cv) + cu2 * sv * cv;
+  }
+}
+
+// Apery's parametrization, from the point (a, b, c) of the unit sphere.
+void EvaluateBoy(vtkParametricFunction* function, const double* u,
+                 const double* v, vtkIdType n, double* x, double* y,
+                 double* z)
+{
+  auto boy = static_cast<vtkParametricBoy*>(function);
+  const double zScale = boy->GetZScale();
+  const double root3 = std::sqrt(3.0);
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    const double sv = std::sin(v[i]);
+    const double a = std::cos(u[i]) * sv;
+    const double b = std::sin(u[i]) * sv;
+    const double c = std::cos(v[i]);
+    const double a2 = a * a;
+    const double b2 = b * b;
+    const double c2 = c * c;
+    const double sum = a + b + c;
+    x[i] = 0.5 *
+        (2.0 * a2 - b2 - c2 + 2.0 * b * c * (b2 - c2) + c * a * (a2 - c2) +
+         a * b * (b2 - a2));
+    y[i] = root3 / 2.0 *
+        (b2 - c2 + (c * a * (c2 - a2) + a * b * (b2 - a2)));
+    z[i] = zScale * sum *
+        (sum * sum * sum + 4.0 * (b - a) * (c - b) * (a - c));
+  }
+}
+
+// Calls Evaluate() for each sample.
+void EvaluateGeneric(vtkParametricFunction* function, const double* u,
+                     const double* v, vtkIdType n, double* x, double* y,
+                     double* z)
+{
+  double derivatives[9];
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    double uvw[3] = {u[i], v[i], 0.0};
+    double point[3];
+    function->Evaluate(uvw, point, derivatives);
+    x[i] = point[0];
+    y[i] = point[1];
+    z[i] = point[2];
+  }
+}
+
+BatchKernel
+ParallelParametricSource::FindBatchKernel(vtkParametricFunction* function)
+{
+  if (!function)
+  {
+    return nullptr;
+  }
+  // Exact class names, a subclass may override Evaluate().
+  const std::string name = function->GetClassName();
+  if (name == "vtkParametricTorus")
+  {
+    return EvaluateTorus;
+  }
+  if (name == "vtkParametricEllipsoid")
+  {
+    return EvaluateEllipsoid;
+  }
+  if (name == "vtkParametricEnneper")
+  {
+    return EvaluateEnneper;
+  }
+  if (name == "vtkParametricSuperEllipsoid")
+  {
+    return EvaluateSuperEllipsoid;
+  }
+  if (name == "vtkParametricKlein")
+  {
+    return EvaluateKlein;
+  }
+  if (name == "vtkParametricBoy")
+  {
+    return EvaluateBoy;
+  }
+  return nullptr;
+}
+
+void ParallelParametricSource::BuildTriangles(const TopologyKey& key)
+{
+  const vtkIdType nu = key[0];
+  const vtkIdType nv = key[1];
+  const bool joinU = key[2] != 0;
+  const bool joinV = key[3] != 0;
+  const bool twistU = key[4] != 0;
+  const bool twistV = key[5] != 0;
+  const bool clockwise = key[6] != 0;
+
+  // The triangle strips of vtkParametricFunctionSource, one between each
+  // pair of consecutive u rows and, with JoinU, one from the last row back
+  // to the first. They are decomposed into triangles as vtkTriangleFilter
+  // does.
+  const vtkIdType numberOfStrips = nu - 1 + (joinU ? 1 : 0);
+  const vtkIdType stripSize = 2 * nv + (joinV ? 2 : 0);
+  const vtkIdType trianglesPerStrip = stripSize - 2;
+  const vtkIdType numberOfCells = numberOfStrips * trianglesPerStrip;
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(numberOfCells + 1);
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(3 * numberOfCells);
+  vtkIdType* o = offsets->GetPointer(0);
+  vtkIdType* c = connectivity->GetPointer(0);
+
+  vtkSMPTools::For(0, numberOfStrips, [&](vtkIdType begin, vtkIdType end) {
+    std::vector<vtkIdType> strip(stripSize);
+    for (vtkIdType s = begin; s < end; ++s)
+    {
+      const vtkIdType row = s * nv;
+      const bool last = s == nu - 1;
+      auto pair = [&](vtkIdType k, vtkIdType id1, vtkIdType id2) {
+        strip[2 * k] = clockwise ? id1 : id2;
+        strip[2 * k + 1] = clockwise ? id2 : id1;
+      };
+      for (vtkIdType j = 0; j < nv; ++j)
+      {
+        pair(j, row + j, last ? (twistU ? nv - 1 - j : j) : row + nv + j);
+      }
+      // The first pair again, closing the strip around v.
+      if (joinV)
+      {
+        const vtkIdType next = last ? (twistU ? nv - 1 : 0) : row + nv;
+        if (twistV)
+        {
+          pair(nv, next, row);
+        }
+        else
+        {
+          pair(nv, row, next);
+        }
+      }
+      // Every other triangle is flipped to keep the orientation.
+      for (vtkIdType t = 0; t < trianglesPerStrip; ++t)
+      {
+        const vtkIdType cell = s * trianglesPerStrip + t;
+        const vtkIdType flip = t % 2;
+        c[3 * cell] = strip[t + flip];
+        c[3 * cell + 1] = strip[t + 1 - flip];
+        c[3 * cell + 2] = strip[t + 2];
+        o[cell] = 3 * cell;
+      }
+    }
+  });
+  o[numberOfCells] = 3 * numberOfCells;
+
+  this->Triangles = vtkSmartPointer<vtkCellArray>::New();
+  this->Triangles->SetData(offsets, connectivity);
+  this->TrianglesKey = key;
+}
+
+int ParallelParametricSource::RequestData(vtkInformation*,
+                                          vtkInformationVector**,
+                                          vtkInformationVector* outputVector)
+{
+  auto output = vtkPolyData::GetData(outputVector);
+  auto function = this->ParametricFunction.GetPointer();
+  if (!function)
+  {
+    vtkErrorMacro(<< "No parametric function.");
+    return 0;
+  }
+
+  // As in vtkParametricFunctionSource, a joined direction stops one step
+  // before its maximum, the seam closes it.
+  const vtkIdType nu = this->UResolution + (function->GetJoinU() ? 0 : 1);
+  const vtkIdType nv = this->VResolution + (function->GetJoinV() ? 0 : 1);
+  const vtkIdType numberOfPoints = nu * nv;
+  const double u0 = function->GetMinimumU();
+  const double v0 = function->GetMinimumV();
+  const double du = (function->GetMaximumU() - u0) / this->UResolution;
+  const double dv = (function->GetMaximumV() - v0) / this->VResolution;
+
+  auto kernel = FindBatchKernel(function);
+  if (!kernel)
+  {
+    // A first call, on this thread, so that lazy initializations (e.g. the
+    // spline) do not happen concurrently.
+    double uvw[3] = {u0, v0, 0.0};
+    double point[3];
+    double derivatives[9];
+    function->Evaluate(uvw, point, derivatives);
+    kernel = EvaluateGeneric;
+  }
+
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(numberOfPoints);
+  auto coordinates = vtkFloatArray::SafeDownCast(points->GetData());
+  float* p = coordinates->GetPointer(0);
+
+  // Tiles of up to 512 consecutive samples, so that the batch buffers stay
+  // in the first level cache. The points are ordered along v first.
+  const vtkIdType tile = 512;
+  vtkSMPTools::For(0, (numberOfPoints + tile - 1) / tile, 16,
+                   [&](vtkIdType begin, vtkIdType end) {
+                     double u[tile], v[tile];
+                     double x[tile], y[tile], z[tile];
+                     for (vtkIdType t = begin; t < end; ++t)
+                     {
+                       const vtkIdType first = t * tile;
+                       const vtkIdType n =
+                           std::min(tile, numberOfPoints - first);
+                       for (vtkIdType k = 0; k < n; ++k)
+                       {
+                         u[k] = u0 + ((first + k) / nv) * du;
+                         v[k] = v0 + ((first + k) % nv) * dv;
+                       }
+                       kernel(function, u, v, n, x, y, z);
+                       float* out = p + 3 * first;
+                       for (vtkIdType k = 0; k < n; ++k)
+                       {
+                         out[3 * k] = static_cast<float>(x[k]);
+                         out[3 * k + 1] = static_cast<float>(y[k]);
+                         out[3 * k + 2] = static_cast<float>(z[k]);
+                       }
+                     }
+                   });
+
+  // Normals from central (one sided on the border) differences. Where the
+  // surface degenerates, e.g. at the poles of the ellipsoid, a neighbouring
+  // row or column is used.
+  double bounds[6];
+  points->GetBounds(bounds);
+  const double size2 = (bounds[1] - bounds[0]) * (bounds[1] - bounds[0]) +
+      (bounds[3] - bounds[2]) * (bounds[3] - bounds[2]) +
+      (bounds[5] - bounds[4]) * (bounds[5] - bounds[4]);
+  auto normalAt = [&](vtkIdType i, vtkIdType j, float normal[3]) {
+    const float* a = p + 3 * (std::max<vtkIdType>(i - 1, 0) * nv + j);
+    const float* b = p + 3 * (std::min(i + 1, nu - 1) * nv + j);
+    const float* c = p + 3 * (i * nv + std::max<vtkIdType>(j - 1, 0));
+    const float* d = p + 3 * (i * nv + std::min(j + 1, nv - 1));
+    const double tu[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double tv[3] = {d[0] - c[0], d[1] - c[1], d[2] - c[2]};
+    const double n[3] = {tu[1] * tv[2] - tu[2] * tv[1],
+                         tu[2] * tv[0] - tu[0] * tv[2],
+                         tu[0] * tv[1] - tu[1] * tv[0]};
+    const double length2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+    if (!(length2 > 1.0e-20 * size2 * size2))
+    {
+      return false;
+    }
+    const double scale = 1.0 / std::sqrt(length2);
+    for (int k = 0; k < 3; ++k)
+    {
+      normal[k] = static_cast<float>(n[k] * scale);
+    }
+    return true;
+  };
+
+  vtkNew<vtkFloatArray> normals;
+  normals->SetName("Normals");
+  normals->SetNumberOfComponents(3);
+  normals->SetNumberOfTuples(numberOfPoints);
+  float* np = normals->GetPointer(0);
+  vtkSMPTools::For(0, nu, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      for (vtkIdType j = 0; j < nv; ++j)
+      {
+        float* normal = np + 3 * (i * nv + j);
+        if (!normalAt(i, j, normal) &&
+            !normalAt(i, j + 1 < nv ? j + 1 : j - 1, normal) &&
+            !normalAt(i + 1 < nu ? i + 1 : i - 1, j, normal))
+        {
+          normal[0] = normal[1] = 0.0f;
+          normal[2] = 1.0f;
+        }
+      }
+    }
+  });
+
+  const TopologyKey key{static_cast<int>(nu), static_cast<int>(nv),
+                        function->GetJoinU(), function->GetJoinV(),
+                        function->GetTwistU(), function->GetTwistV(),
+                        function->GetClockwiseOrdering()};
+  if (!this->Triangles || this->TrianglesKey != key)
+  {
+    this->BuildTriangles(key);
+  }
+
+  output->SetPoints(points);
+  output->SetPolys(this->Triangles);
+  output->GetPointData()->SetNormals(normals);
+  return 1;
+}
+
+std::vector<std::pair<std::string, vtkSmartPointer<vtkParametricFunction>>>
+GetParametricFunctions()
+{
+  vtkNew<vtkParametricEllipsoid> ellipsoid;
+  ellipsoid->SetXRadius(0.5);
+  ellipsoid->SetYRadius(2.0);
+  vtkNew<vtkParametricMobius> mobius;
+  mobius->SetRadius(2.0);
+  mobius->SetMinimumV(-0.5);
+  mobius->SetMaximumV(0.5);
+  vtkNew<vtkParametricRandomHills> randomHills;
+  randomHills->AllowRandomGenerationOn();
+  randomHills->SetRandomSeed(1);
+  randomHills->SetNumberOfHills(30);
+  vtkNew<vtkParametricSuperEllipsoid> superEllipsoid;
+  superEllipsoid->SetN1(0.5);
+  superEllipsoid->SetN2(0.4);
+  vtkNew<vtkParametricSuperToroid> superToroid;
+  superToroid->SetN1(0.5);
+  superToroid->SetN2(3.0);
+
+  return {
+      {"Boy", vtkSmartPointer<vtkParametricBoy>::New()},
+      {"ConicSpiral", vtkSmartPointer<vtkParametricConicSpiral>::New()},
+      {"CrossCap", vtkSmartPointer<vtkParametricCrossCap>::New()},
+      {"Dini", vtkSmartPointer<vtkParametricDini>::New()},
+      {"Ellipsoid", ellipsoid.GetPointer()},
+      {"Enneper", vtkSmartPointer<vtkParametricEnneper>::New()},
+      {"Figure8Klein", vtkSmartPointer<vtkParametricFigure8Klein>::New()},
+      {"Klein", vtkSmartPointer<vtkParametricKlein>::New()},
+      {"Mobius", mobius.GetPointer()},
+      {"RandomHills", randomHills.GetPointer()},
+      {"Roman", vtkSmartPointer<vtkParametricRoman>::New()},
+      {"SuperEllipsoid", superEllipsoid.GetPointer()},
+      {"SuperToroid", superToroid.GetPointer()},
+      {"Torus", vtkSmartPointer<vtkParametricTorus>::New()},
+      {"BohemianDome", vtkSmartPointer<vtkParametricBohemianDome>::New()},
+      {"Bour", vtkSmartPointer<vtkParametricBour>::New()},
+      {"CatalanMinimal", vtkSmartPointer<vtkParametricCatalanMinimal>::New()},
+      {"Henneberg", vtkSmartPointer<vtkParametricHenneberg>::New()},
+      {"Kuen", vtkSmartPointer<vtkParametricKuen>::New()},
+      {"PluckerConoid", vtkSmartPointer<vtkParametricPluckerConoid>::New()},
+      {"Pseudosphere", vtkSmartPointer<vtkParametricPseudosphere>::New()}};
+}
+
+double CompareOutputs(vtkPolyData* reference, vtkPolyData* output,
+                      bool& sameTriangles)
+{
+  sameTriangles = false;
+  const vtkIdType numberOfPoints = reference->GetNumberOfPoints();
+  if (numberOfPoints == 0 || output->GetNumberOfPoints() != numberOfPoints)
+  {
+    return VTK_DOUBLE_MAX;
+  }
+  double bounds[6];
+  reference->GetBounds(bounds);
+  const double diagonal =
+      std::sqrt((bounds[1] - bounds[0]) * (bounds[1] - bounds[0]) +
+                (bounds[3] - bounds[2]) * (bounds[3] - bounds[2]) +
+                (bounds[5] - bounds[4]) * (bounds[5] - bounds[4]));
+  double maxError = 0.0;
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    double expected[3];
+    double actual[3];
+    reference->GetPoint(i, expected);
+    output->GetPoint(i, actual);
+    for (int c = 0; c < 3; ++c)
+    {
+      maxError = std::max(maxError, std::abs(actual[c] - expected[c]));
+    }
+  }
+
+  vtkCellArray* expectedPolys = reference->GetPolys();
+  vtkCellArray* actualPolys = output->GetPolys();
+  const vtkIdType numberOfCells = expectedPolys->GetNumberOfCells();
+  sameTriangles = actualPolys->GetNumberOfCells() == numberOfCells;
+  vtkNew<vtkIdList> expectedIds;
+  vtkNew<vtkIdList> actualIds;
+  for (vtkIdType cellId = 0; sameTriangles && cellId < numberOfCells;
+       ++cellId)
+  {
+    expectedPolys->GetCellAtId(cellId, expectedIds);
+    actualPolys->GetCellAtId(cellId, actualIds);
+    sameTriangles =
+        expectedIds->GetNumberOfIds() == actualIds->GetNumberOfIds() &&
+        std::equal(expectedIds->begin(), expectedIds->end(),
+                   actualIds->begin());
+  }
+  return maxError / diagonal;
+}
+
+} // namespace
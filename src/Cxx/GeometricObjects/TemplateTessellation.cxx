@@ -0,0 +1,719 @@
+#include <vtkCell.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkCellType.h>
+#include <vtkGenericCell.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkTessellatorFilter.h>
+#include <vtkTimerLog.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <vtkBiQuadraticQuad.h>
+#include <vtkQuadraticHexahedron.h>
+#include <vtkQuadraticQuad.h>
+#include <vtkQuadraticWedge.h>
+#include <vtkTriQuadraticHexahedron.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+/**
+ * The fixed level subdivision of one cell type, computed once.
+ *
+ * The cell is split, in parametric space, into Level^d linear cells of the
+ * same shape (hexahedra, wedges or quads). Weights holds the shape
+ * functions of the cell at each sample point, so the samples of a cell are
+ * the product of Weights (samples x nodes) and the coordinates of its nodes
+ * (nodes x 3).
+ */
+struct TessellationTemplate
+{
+  int CellType = VTK_EMPTY_CELL;
+  int NumberOfNodes = 0;
+  int OutputCellType = VTK_EMPTY_CELL;
+  int OutputCellSize = 0;
+  std::vector<double> PCoords;
+  std::vector<double> Weights;
+  // The linear cells, as local sample ids.
+  std::vector<vtkIdType> Connectivity;
+
+  vtkIdType GetNumberOfSamples() const
+  {
+    return static_cast<vtkIdType>(this->PCoords.size() / 3);
+  }
+  vtkIdType GetNumberOfSubCells() const
+  {
+    return static_cast<vtkIdType>(this->Connectivity.size()) /
+        this->OutputCellSize;
+  }
+};
+
+// Returns false if the cell type is not supported.
+bool BuildTemplate(vtkCell* cell, int level, TessellationTemplate& result);
+
+// Expands every cell of grid. Returns nullptr if a cell does not have the
+// type and number of points of the template.
+vtkSmartPointer<vtkUnstructuredGrid>
+TessellateWithTemplate(vtkUnstructuredGrid* grid,
+                       const TessellationTemplate& tessellation);
+
+// n x n x n quadratic hexahedra filling a warped unit cube, so that the
+// cells are curved.
+vtkSmartPointer<vtkUnstructuredGrid> MakeQuadraticHexahedronGrid(int n);
+
+// One cell of the given type, its nodes are the warped parametric
+// coordinates.
+vtkSmartPointer<vtkUnstructuredGrid> MakeWarpedCell(vtkCell* cell);
+
+// Largest distance between a sample and EvaluateLocation() of its
+// parametric coordinates, over the first maxCells cells.
+double GetSampleError(vtkUnstructuredGrid* grid,
+                      const TessellationTemplate& tessellation,
+                      vtkUnstructuredGrid* output, vtkIdType maxCells);
+
+// Largest distance between the middle of an edge of the tessellation and
+// the point of the curved cell at the middle of the parametric edge.
+double GetTemplateChordError(vtkUnstructuredGrid* grid,
+                             const TessellationTemplate& tessellation,
+                             vtkUnstructuredGrid* output, vtkIdType maxCells);
+
+// The same for vtkTessellatorFilter. The input cell of each tetrahedron is
+// given by the "CellId" cell array, the parametric coordinates of its
+// points are found with EvaluatePosition().
+double GetAdaptiveChordError(vtkUnstructuredGrid* grid,
+                             vtkUnstructuredGrid* output, vtkIdType maxCells);
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: TemplateTessellation [cellsPerSide] [level]
+  // 100 cells per side gives one million quadratic hexahedra.
+  int cellsPerSide = 10;
+  int level = 2;
+  if (argc > 1)
+  {
+    cellsPerSide = std::max(1, std::atoi(argv[1]));
+  }
+  if (argc > 2)
+  {
+    level = std::max(1, std::atoi(argv[2]));
+  }
+  // The errors are measured on a subset of the cells.
+  const vtkIdType errorCells = 1000;
+
+  vtkNew<vtkTimerLog> timer;
+  std::cout << std::setprecision(4);
+  bool ok = true;
+
+  // The template works from the shape functions of the cell, check it on
+  // the other supported types.
+  {
+    vtkNew<vtkTriQuadraticHexahedron> triQuadraticHexahedron;
+    vtkNew<vtkQuadraticWedge> quadraticWedge;
+    vtkNew<vtkBiQuadraticQuad> biQuadraticQuad;
+    vtkNew<vtkQuadraticQuad> quadraticQuad;
+    for (vtkCell* cell : std::vector<vtkCell*>{
+             triQuadraticHexahedron, quadraticWedge, biQuadraticQuad,
+             quadraticQuad})
+    {
+      TessellationTemplate tessellation;
+      auto grid = MakeWarpedCell(cell);
+      vtkSmartPointer<vtkUnstructuredGrid> output;
+      if (BuildTemplate(cell, level, tessellation))
+      {
+        output = TessellateWithTemplate(grid, tessellation);
+      }
+      if (!output)
+      {
+        std::cout << "No template for " << cell->GetClassName() << std::endl;
+        ok = false;
+        continue;
+      }
+      const double error = GetSampleError(grid, tessellation, output, 1);
+      std::cout << std::left << std::setw(28) << cell->GetClassName()
+                << std::right << std::setw(6)
+                << tessellation.GetNumberOfSubCells() << " cells, error "
+                << error << std::endl;
+      ok = ok && error < 1.0e-10;
+    }
+  }
+
+  auto grid = MakeQuadraticHexahedronGrid(cellsPerSide);
+  const vtkIdType numberOfCells = grid->GetNumberOfCells();
+  std::cout << "\n"
+            << numberOfCells << " quadratic hexahedra, level " << level
+            << std::endl;
+
+  vtkNew<vtkQuadraticHexahedron> hexahedron;
+  TessellationTemplate tessellation;
+  timer->StartTimer();
+  const bool built = BuildTemplate(hexahedron, level, tessellation);
+  timer->StopTimer();
+  if (!built)
+  {
+    std::cout << "No template for " << hexahedron->GetClassName()
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Template: " << tessellation.GetNumberOfSamples()
+            << " samples, " << tessellation.GetNumberOfSubCells()
+            << " hexahedra, built in " << timer->GetElapsedTime() << " s"
+            << std::endl;
+
+  timer->StartTimer();
+  auto fixed = TessellateWithTemplate(grid, tessellation);
+  timer->StopTimer();
+  const double fixedTime = timer->GetElapsedTime();
+  if (!fixed)
+  {
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkTessellatorFilter> adaptive;
+  adaptive->SetInputData(grid);
+  adaptive->SetMaximumNumberOfSubdivisions(level);
+  timer->StartTimer();
+  adaptive->Update();
+  timer->StopTimer();
+  const double adaptiveTime = timer->GetElapsedTime();
+
+  std::cout << std::left << std::setw(22) << "Path" << std::right
+            << std::setw(12) << "Time (s)" << std::setw(14) << "Cells/s"
+            << std::setw(12) << "Output" << std::setw(12) << "ChordErr"
+            << std::endl;
+  std::cout << std::left << std::setw(22) << "Template, fixed" << std::right
+            << std::setw(12) << fixedTime << std::setw(14)
+            << numberOfCells / fixedTime << std::setw(12)
+            << fixed->GetNumberOfCells() << std::setw(12)
+            << GetTemplateChordError(grid, tessellation, fixed, errorCells)
+            << std::endl;
+  std::cout << std::left << std::setw(22) << "vtkTessellatorFilter"
+            << std::right << std::setw(12) << adaptiveTime << std::setw(14)
+            << numberOfCells / adaptiveTime << std::setw(12)
+            << adaptive->GetOutput()->GetNumberOfCells() << std::setw(12)
+            << GetAdaptiveChordError(grid, adaptive->GetOutput(), errorCells)
+            << std::endl;
+
+  const double sampleError =
+      GetSampleError(grid, tessellation, fixed, errorCells);
+  std::cout << "Largest sample error of the template: " << sampleError
+            << std::endl;
+  ok = ok && sampleError < 1.0e-10;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+
+// The smooth map applied to the meshes.
+void Warp(const double p[3], double x[3])
+{
+  const double twoPi = 2.0 * 3.14159265358979323846;
+  x[0] = p[0] + 0.05 * std::sin(twoPi * p[1]);
+  x[1] = p[1] + 0.05 * std::sin(twoPi * p[2]);
+  x[2] = p[2] + 0.05 * std::sin(twoPi * p[0]);
+}
+
+// The edges of the linear output cells, as pairs of local points.
+const std::vector<int>& GetEdges(int cellType)
+{
+  static const std::vector<int> hexahedron = {0, 1, 1, 2, 2, 3, 3, 0,
+                                              4, 5, 5, 6, 6, 7, 7, 4,
+                                              0, 4, 1, 5, 2, 6, 3, 7};
+  static const std::vector<int> wedge = {0, 1, 1, 2, 2, 0, 3, 4, 4,
+                                         5, 5, 3, 0, 3, 1, 4, 2, 5};
+  static const std::vector<int> quad = {0, 1, 1, 2, 2, 3, 3, 0};
+  static const std::vector<int> tetra = {0, 1, 1, 2, 2, 0,
+                                         0, 3, 1, 3, 2, 3};
+  static const std::vector<int> triangle = {0, 1, 1, 2, 2, 0};
+  static const std::vector<int> none;
+  switch (cellType)
+  {
+    case VTK_HEXAHEDRON:
+      return hexahedron;
+    case VTK_WEDGE:
+      return wedge;
+    case VTK_QUAD:
+      return quad;
+    case VTK_TETRA:
+      return tetra;
+    case VTK_TRIANGLE:
+      return triangle;
+    default:
+      return none;
+  }
+}
+
+bool BuildTemplate(vtkCell* cell, int level, TessellationTemplate& result)
+{
+  result = TessellationTemplate();
+  result.CellType = cell->GetCellType();
+  result.NumberOfNodes = cell->GetNumberOfPoints();
+  const double h = 1.0 / level;
+  const int m = level + 1;
+
+  switch (result.CellType)
+  {
+    case VTK_QUADRATIC_HEXAHEDRON:
+    case VTK_TRIQUADRATIC_HEXAHEDRON:
+    case VTK_QUADRATIC_QUAD:
+    case VTK_BIQUADRATIC_QUAD: {
+      // A regular grid of samples, one layer for the quads.
+      const bool volume = cell->GetCellDimension() == 3;
+      const int layers = volume ? m : 1;
+      for (int k = 0; k < layers; ++k)
+      {
+        for (int j = 0; j < m; ++j)
+        {
+          for (int i = 0; i < m; ++i)
+          {
+            result.PCoords.insert(result.PCoords.end(),
+                                  {i * h, j * h, k * h});
+          }
+        }
+      }
+      auto id = [m](int i, int j, int k) -> vtkIdType {
+        return i + m * (j + m * k);
+      };
+      result.OutputCellType = volume ? VTK_HEXAHEDRON : VTK_QUAD;
+      result.OutputCellSize = volume ? 8 : 4;
+      for (int k = 0; k < std::max(layers - 1, 1); ++k)
+      {
+        for (int j = 0; j < level; ++j)
+        {
+          for (int i = 0; i < level; ++i)
+          {
+            result.Connectivity.insert(
+                result.Connectivity.end(),
+                {id(i, j, k), id(i + 1, j, k), id(i + 1, j + 1, k),
+                 id(i, j + 1, k)});
+            if (volume)
+            {
+              result.Connectivity.insert(
+                  result.Connectivity.end(),
+                  {id(i, j, k + 1), id(i + 1, j, k + 1),
+                   id(i + 1, j + 1, k + 1), id(i, j + 1, k + 1)});
+            }
+          }
+        }
+      }
+      break;
+    }
+    case VTK_QUADRATIC_WEDGE: {
+      // A triangular lattice, r + s <= 1, in each of the layers.
+      std::vector<vtkIdType> rowStart(m + 1, 0);
+      for (int j = 0; j < m; ++j)
+      {
+        rowStart[j + 1] = rowStart[j] + (m - j);
+      }
+      const vtkIdType perLayer = rowStart[m];
+      for (int k = 0; k < m; ++k)
+      {
+        for (int j = 0; j < m; ++j)
+        {
+          for (int i = 0; i + j < m; ++i)
+          {
+            result.PCoords.insert(result.PCoords.end(),
+                                  {i * h, j * h, k * h});
+          }
+        }
+      }
+      auto id = [&](int i, int j, int k) -> vtkIdType {
+        return k * perLayer + rowStart[j] + i;
+      };
+      result.OutputCellType = VTK_WEDGE;
+      result.OutputCellSize = 6;
+      for (int k = 0; k < level; ++k)
+      {
+        for (int j = 0; j < level; ++j)
+        {
+          for (int i = 0; i + j < level; ++i)
+          {
+            result.Connectivity.insert(
+                result.Connectivity.end(),
+                {id(i, j, k), id(i + 1, j, k), id(i, j + 1, k),
+                 id(i, j, k + 1), id(i + 1, j, k + 1), id(i, j + 1, k + 1)});
+            if (i + j + 1 < level)
+            {
+              result.Connectivity.insert(
+                  result.Connectivity.end(),
+                  {id(i + 1, j, k), id(i + 1, j + 1, k), id(i, j + 1, k),
+                   id(i + 1, j, k + 1), id(i + 1, j + 1, k + 1),
+                   id(i, j + 1, k + 1)});
+            }
+          }
+        }
+      }
+      break;
+    }
+    default:
+      return false;
+  }
+
+  const vtkIdType numberOfSamples = result.GetNumberOfSamples();
+  result.Weights.resize(numberOfSamples * result.NumberOfNodes);
+  for (vtkIdType s = 0; s < numberOfSamples; ++s)
+  {
+    cell->InterpolateFunctions(&result.PCoords[3 * s],
+                               &result.Weights[s * result.NumberOfNodes]);
+  }
+  return true;
+}
+
+// Computes the samples of a range of cells: a (samples x nodes) by
+// (nodes x 3) product per cell.
+struct ExpandCells
+{
+  vtkUnstructuredGrid* Grid;
+  const TessellationTemplate* Template;
+  double* Samples;
+  vtkSMPThreadLocalObject<vtkIdList> PointIds;
+
+  void Initialize()
+  {
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    const int numberOfNodes = this->Template->NumberOfNodes;
+    const vtkIdType numberOfSamples = this->Template->GetNumberOfSamples();
+    const double* weights = this->Template->Weights.data();
+    auto cells = this->Grid->GetCells();
+    auto points = this->Grid->GetPoints();
+    vtkIdList* pointIds = this->PointIds.Local();
+    std::vector<double> nodes(3 * numberOfNodes);
+
+    for (vtkIdType cellId = begin; cellId < end; ++cellId)
+    {
+      cells->GetCellAtId(cellId, pointIds);
+      for (int n = 0; n < numberOfNodes; ++n)
+      {
+        points->GetPoint(pointIds->GetId(n), &nodes[3 * n]);
+      }
+      double* out = this->Samples + 3 * cellId * numberOfSamples;
+      for (vtkIdType s = 0; s < numberOfSamples; ++s)
+      {
+        const double* w = weights + s * numberOfNodes;
+        double x = 0.0, y = 0.0, z = 0.0;
+        for (int n = 0; n < numberOfNodes; ++n)
+        {
+          x += w[n] * nodes[3 * n];
+          y += w[n] * nodes[3 * n + 1];
+          z += w[n] * nodes[3 * n + 2];
+        }
+        out[3 * s] = x;
+        out[3 * s + 1] = y;
+        out[3 * s + 2] = z;
+      }
+    }
+  }
+
+  void Reduce()
+  {
+  }
+};
+
+vtkSmartPointer<vtkUnstructuredGrid>
+TessellateWithTemplate(vtkUnstructuredGrid* grid,
+                       const TessellationTemplate& tessellation)
+{
+  if (tessellation.OutputCellSize == 0)
+  {
+    vtkGenericWarningMacro(<< "The template is empty.");
+    return nullptr;
+  }
+  const vtkIdType numberOfCells = grid->GetNumberOfCells();
+  const vtkIdType numberOfSamples = tessellation.GetNumberOfSamples();
+  const vtkIdType numberOfSubCells = tessellation.GetNumberOfSubCells();
+  const vtkIdType cellSize = tessellation.OutputCellSize;
+
+  // The expansion reads NumberOfNodes points of every cell through the
+  // template's weights, so any other cell would be read out of bounds.
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+  {
+    if (grid->GetCellType(cellId) != tessellation.CellType ||
+        grid->GetCells()->GetCellSize(cellId) != tessellation.NumberOfNodes)
+    {
+      vtkGenericWarningMacro(<< "Cell " << cellId << " does not match the "
+                             << "template, it must be of type "
+                             << tessellation.CellType << " with "
+                             << tessellation.NumberOfNodes << " points.");
+      return nullptr;
+    }
+  }
+
+  // The samples are not shared between cells.
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(numberOfCells * numberOfSamples);
+  ExpandCells expand;
+  expand.Grid = grid;
+  expand.Template = &tessellation;
+  expand.Samples = static_cast<double*>(points->GetVoidPointer(0));
+  vtkSMPTools::For(0, numberOfCells, expand);
+
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(numberOfCells * numberOfSubCells + 1);
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(numberOfCells * numberOfSubCells *
+                                  cellSize);
+  vtkIdType* o = offsets->GetPointer(0);
+  vtkIdType* c = connectivity->GetPointer(0);
+  const vtkIdType* local = tessellation.Connectivity.data();
+  const vtkIdType perCell = numberOfSubCells * cellSize;
+  vtkSMPTools::For(0, numberOfCells, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cellId = begin; cellId < end; ++cellId)
+    {
+      const vtkIdType first = cellId * numberOfSamples;
+      for (vtkIdType k = 0; k < perCell; ++k)
+      {
+        c[cellId * perCell + k] = first + local[k];
+      }
+      for (vtkIdType q = 0; q < numberOfSubCells; ++q)
+      {
+        o[cellId * numberOfSubCells + q] = cellId * perCell + q * cellSize;
+      }
+    }
+  });
+  o[numberOfCells * numberOfSubCells] = numberOfCells * perCell;
+
+  vtkNew<vtkCellArray> cells;
+  cells->SetData(offsets, connectivity);
+  auto output = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  output->SetPoints(points);
+  output->SetCells(tessellation.OutputCellType, cells);
+  return output;
+}
+
+vtkSmartPointer<vtkUnstructuredGrid> MakeQuadraticHexahedronGrid(int n)
+{
+  // The nodes lie on a lattice of (2n + 1)^3 half steps. Corners have even
+  // coordinates, edge midpoints exactly one odd coordinate; face and cell
+  // centers are not used by the 20 node hexahedron.
+  const vtkIdType m = 2 * n + 1;
+  std::vector<vtkIdType> pointIds(m * m * m, -1);
+  vtkNew<vtkPoints> points;
+  for (vtkIdType c = 0; c < m; ++c)
+  {
+    for (vtkIdType b = 0; b < m; ++b)
+    {
+      for (vtkIdType a = 0; a < m; ++a)
+      {
+        if ((a % 2) + (b % 2) + (c % 2) > 1)
+        {
+          continue;
+        }
+        const double p[3] = {a * 0.5 / n, b * 0.5 / n, c * 0.5 / n};
+        double x[3];
+        Warp(p, x);
+        pointIds[a + m * (b + m * c)] = points->InsertNextPoint(x);
+      }
+    }
+  }
+
+  // Corners, then the edges, in the order of vtkQuadraticHexahedron.
+  const int corners[8][3] = {{0, 0, 0}, {2, 0, 0}, {2, 2, 0}, {0, 2, 0},
+                             {0, 0, 2}, {2, 0, 2}, {2, 2, 2}, {0, 2, 2}};
+  const int edges[12][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6},
+                            {6, 7}, {7, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+  int nodes[20][3];
+  for (int i = 0; i < 8; ++i)
+  {
+    std::copy(corners[i], corners[i] + 3, nodes[i]);
+  }
+  for (int e = 0; e < 12; ++e)
+  {
+    for (int k = 0; k < 3; ++k)
+    {
+      nodes[8 + e][k] = (corners[edges[e][0]][k] + corners[edges[e][1]][k]) / 2;
+    }
+  }
+
+  auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  grid->SetPoints(points);
+  grid->Allocate(static_cast<vtkIdType>(n) * n * n);
+  vtkNew<vtkIdTypeArray> cellIds;
+  cellIds->SetName("CellId");
+  for (vtkIdType k = 0; k < n; ++k)
+  {
+    for (vtkIdType j = 0; j < n; ++j)
+    {
+      for (vtkIdType i = 0; i < n; ++i)
+      {
+        vtkIdType ids[20];
+        for (int q = 0; q < 20; ++q)
+        {
+          const vtkIdType a = 2 * i + nodes[q][0];
+          const vtkIdType b = 2 * j + nodes[q][1];
+          const vtkIdType c = 2 * k + nodes[q][2];
+          ids[q] = pointIds[a + m * (b + m * c)];
+        }
+        cellIds->InsertNextValue(
+            grid->InsertNextCell(VTK_QUADRATIC_HEXAHEDRON, 20, ids));
+      }
+    }
+  }
+  grid->GetCellData()->AddArray(cellIds);
+  return grid;
+}
+
+vtkSmartPointer<vtkUnstructuredGrid> MakeWarpedCell(vtkCell* cell)
+{
+  const double* pcoords = cell->GetParametricCoords();
+  const vtkIdType numberOfNodes = cell->GetNumberOfPoints();
+  vtkNew<vtkPoints> points;
+  std::vector<vtkIdType> ids(numberOfNodes);
+  for (vtkIdType i = 0; i < numberOfNodes; ++i)
+  {
+    double x[3];
+    Warp(pcoords + 3 * i, x);
+    ids[i] = points->InsertNextPoint(x);
+  }
+  auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  grid->SetPoints(points);
+  grid->InsertNextCell(cell->GetCellType(), numberOfNodes, ids.data());
+  return grid;
+}
+
+double Distance(const double a[3], const double b[3])
+{
+  return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) +
+                   (a[1] - b[1]) * (a[1] - b[1]) +
+                   (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+double GetSampleError(vtkUnstructuredGrid* grid,
+                      const TessellationTemplate& tessellation,
+                      vtkUnstructuredGrid* output, vtkIdType maxCells)
+{
+  vtkNew<vtkGenericCell> cell;
+  std::vector<double> weights(tessellation.NumberOfNodes);
+  const vtkIdType numberOfSamples = tessellation.GetNumberOfSamples();
+  const vtkIdType numberOfCells =
+      std::min(maxCells, grid->GetNumberOfCells());
+  double error = 0.0;
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+  {
+    grid->GetCell(cellId, cell);
+    for (vtkIdType s = 0; s < numberOfSamples; ++s)
+    {
+      int subId = 0;
+      double expected[3];
+      double actual[3];
+      cell->EvaluateLocation(subId, &tessellation.PCoords[3 * s], expected,
+                             weights.data());
+      output->GetPoint(cellId * numberOfSamples + s, actual);
+      error = std::max(error, Distance(expected, actual));
+    }
+  }
+  return error;
+}
+
+double GetTemplateChordError(vtkUnstructuredGrid* grid,
+                             const TessellationTemplate& tessellation,
+                             vtkUnstructuredGrid* output, vtkIdType maxCells)
+{
+  vtkNew<vtkGenericCell> cell;
+  std::vector<double> weights(tessellation.NumberOfNodes);
+  const vtkIdType numberOfSamples = tessellation.GetNumberOfSamples();
+  const vtkIdType numberOfCells =
+      std::min(maxCells, grid->GetNumberOfCells());
+  const auto& edges = GetEdges(tessellation.OutputCellType);
+  const int cellSize = tessellation.OutputCellSize;
+  double error = 0.0;
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+  {
+    grid->GetCell(cellId, cell);
+    for (vtkIdType q = 0; q < tessellation.GetNumberOfSubCells(); ++q)
+    {
+      const vtkIdType* local = &tessellation.Connectivity[q * cellSize];
+      for (size_t e = 0; e < edges.size(); e += 2)
+      {
+        const vtkIdType a = local[edges[e]];
+        const vtkIdType b = local[edges[e + 1]];
+        double middle[3];
+        double xa[3], xb[3];
+        output->GetPoint(cellId * numberOfSamples + a, xa);
+        output->GetPoint(cellId * numberOfSamples + b, xb);
+        for (int k = 0; k < 3; ++k)
+        {
+          middle[k] = 0.5 * (tessellation.PCoords[3 * a + k] +
+                             tessellation.PCoords[3 * b + k]);
+          xa[k] = 0.5 * (xa[k] + xb[k]);
+        }
+        int subId = 0;
+        double exact[3];
+        cell->EvaluateLocation(subId, middle, exact, weights.data());
+        error = std::max(error, Distance(exact, xa));
+      }
+    }
+  }
+  return error;
+}
+
+double GetAdaptiveChordError(vtkUnstructuredGrid* grid,
+                             vtkUnstructuredGrid* output, vtkIdType maxCells)
+{
+  auto cellIds = vtkIdTypeArray::SafeDownCast(
+      output->GetCellData()->GetArray("CellId"));
+  if (!cellIds)
+  {
+    return -1.0;
+  }
+  vtkNew<vtkGenericCell> cell;
+  vtkNew<vtkIdList> pointIds;
+  std::vector<double> weights(grid->GetMaxCellSize());
+  double error = 0.0;
+  for (vtkIdType t = 0; t < output->GetNumberOfCells(); ++t)
+  {
+    const vtkIdType cellId = cellIds->GetValue(t);
+    if (cellId >= maxCells)
+    {
+      continue;
+    }
+    grid->GetCell(cellId, cell);
+    output->GetCellPoints(t, pointIds);
+    const auto& edges = GetEdges(output->GetCellType(t));
+    for (size_t e = 0; e < edges.size(); e += 2)
+    {
+      double x[2][3];
+      double pcoords[2][3];
+      for (int end = 0; end < 2; ++end)
+      {
+        output->GetPoint(pointIds->GetId(edges[e + end]), x[end]);
+        double closest[3];
+        int subId = 0;
+        double dist2 = 0.0;
+        cell->EvaluatePosition(x[end], closest, subId, pcoords[end], dist2,
+                               weights.data());
+      }
+      double middle[3];
+      double chordMiddle[3];
+      for (int k = 0; k < 3; ++k)
+      {
+        middle[k] = 0.5 * (pcoords[0][k] + pcoords[1][k]);
+        chordMiddle[k] = 0.5 * (x[0][k] + x[1][k]);
+      }
+      int subId = 0;
+      double exact[3];
+      cell->EvaluateLocation(subId, middle, exact, weights.data());
+      error = std::max(error, Distance(exact, chordMiddle));
+    }
+  }
+  return error;
+}
+
+} // namespace
@@ -0,0 +1,749 @@
+#include <vtkDataArray.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkEdgeListIterator.h>
+#include <vtkForceDirectedLayoutStrategy.h>
+#include <vtkGraph.h>
+#include <vtkGraphLayout.h>
+#include <vtkGraphLayoutStrategy.h>
+#include <vtkGraphLayoutView.h>
+#include <vtkNamedColors.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkRandomGraphSource.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkRenderer.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSimple2DLayoutStrategy.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+// A force directed layout (Fruchterman-Reingold forces, as in
+// vtkForceDirectedLayoutStrategy) where the all pairs repulsion is
+// approximated with a Barnes-Hut quadtree (octree in 3D). Each iteration is
+// O(V log V + E); the forces are accumulated per vertex in parallel with
+// vtkSMPTools, so no atomics are needed.
+class vtkBarnesHutLayoutStrategy : public vtkGraphLayoutStrategy
+{
+public:
+  static vtkBarnesHutLayoutStrategy* New();
+  vtkTypeMacro(vtkBarnesHutLayoutStrategy, vtkGraphLayoutStrategy);
+
+  // A tree cell of size s at distance d is replaced by its center of mass
+  // when s / d < Theta. Theta = 0 computes the exact sums.
+  vtkSetClampMacro(Theta, double, 0.0, 2.0);
+  vtkGetMacro(Theta, double);
+
+  vtkSetClampMacro(MaxNumberOfIterations, int, 0, VTK_INT_MAX);
+  vtkGetMacro(MaxNumberOfIterations, int);
+
+  // Number of iterations per call to Layout(), i.e. per pipeline update.
+  vtkSetClampMacro(IterationsPerLayout, int, 1, VTK_INT_MAX);
+  vtkGetMacro(IterationsPerLayout, int);
+
+  // The layout is complete (early out) when the temperature, the maximum
+  // displacement of a vertex, drops below Tolerance times the ideal edge
+  // length.
+  vtkSetMacro(Tolerance, double);
+  vtkGetMacro(Tolerance, double);
+
+  // The temperature is multiplied by this factor when an iteration
+  // increases the energy, and divided by it after five that decrease it.
+  vtkSetClampMacro(CoolingFactor, double, 0.5, 1.0);
+  vtkGetMacro(CoolingFactor, double);
+
+  // Start from the current points of the graph, with a low temperature, if
+  // they are not all coincident.
+  vtkSetMacro(WarmStart, bool);
+  vtkGetMacro(WarmStart, bool);
+  vtkBooleanMacro(WarmStart, bool);
+
+  vtkSetMacro(ThreeDimensionalLayout, bool);
+  vtkGetMacro(ThreeDimensionalLayout, bool);
+  vtkBooleanMacro(ThreeDimensionalLayout, bool);
+
+  vtkSetMacro(RandomSeed, int);
+  vtkGetMacro(RandomSeed, int);
+
+  vtkGetMacro(TotalIterations, int);
+
+  void Initialize() override;
+  void Layout() override;
+  int IsLayoutComplete() override
+  {
+    return this->LayoutComplete;
+  }
+
+protected:
+  vtkBarnesHutLayoutStrategy();
+  ~vtkBarnesHutLayoutStrategy() override = default;
+
+private:
+  struct Node
+  {
+    double Center[3];
+    double HalfSize;
+    double CenterOfMass[3];
+    vtkIdType Begin; // range of Order
+    vtkIdType End;
+    int Depth;
+    int FirstChild; // children are contiguous
+    int NumberOfChildren;
+  };
+
+  void BuildTree();
+  void Iterate();
+  void Repulsion(vtkIdType i, double force[3]) const;
+
+  double Theta;
+  int MaxNumberOfIterations;
+  int IterationsPerLayout;
+  double Tolerance;
+  double CoolingFactor;
+  bool WarmStart;
+  bool ThreeDimensionalLayout;
+  int RandomSeed;
+
+  int Dimension = 2;
+  double Temperature = 0.0;
+  double Energy = 0.0;
+  int Progress = 0;
+  int TotalIterations = 0;
+  int LayoutComplete = 0;
+
+  std::vector<double> Positions;
+  std::vector<double> Forces;
+  // Adjacency in compressed rows, both directions of every edge.
+  std::vector<vtkIdType> Offsets;
+  std::vector<vtkIdType> Neighbors;
+  std::vector<double> Weights;
+  // Vertex ids sorted by tree cell, and the cells.
+  std::vector<vtkIdType> Order;
+  std::vector<vtkIdType> Scratch;
+  std::vector<Node> Nodes;
+
+  vtkBarnesHutLayoutStrategy(const vtkBarnesHutLayoutStrategy&) = delete;
+  void operator=(const vtkBarnesHutLayoutStrategy&) = delete;
+};
+
+// Ideal edge length. The initial layout is a square (cube) of side
+// V^(1/Dimension), so every vertex has an area (volume) of 1.
+constexpr double K = 1.0;
+// Leaves hold up to this many vertices, summed exactly.
+constexpr vtkIdType LeafSize = 8;
+constexpr int MaxDepth = 32;
+
+vtkSmartPointer<vtkGraph> MakeGraph(vtkIdType numberOfVertices);
+
+// Run strategy through vtkGraphLayout until it reports completion. Returns
+// the time in seconds.
+double RunLayout(vtkGraph* graph, vtkGraphLayoutStrategy* strategy,
+                 vtkSmartPointer<vtkGraph>& output);
+
+// Normalized stress of the layout, sampled from a few BFS sources:
+// mean over pairs of ((s * |xi - xj| - dij) / dij)^2, with dij the graph
+// distance and s the scale that minimizes it.
+double SampledStress(vtkGraph* graph, int numberOfSources = 32);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  std::vector<vtkIdType> sizes;
+  int iterations = 100;
+  int maxBarnesHutIterations = 500;
+  vtkIdType allPairsLimit = 10000;
+  bool interactive = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-i")
+    {
+      interactive = true;
+    }
+    else
+    {
+      sizes.push_back(std::stoll(arg));
+    }
+  }
+  if (sizes.empty())
+  {
+    sizes.push_back(1000);
+  }
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << std::setprecision(4);
+
+  bool ok = true;
+  vtkSmartPointer<vtkGraph> shown;
+  for (auto numberOfVertices : sizes)
+  {
+    auto graph = MakeGraph(numberOfVertices);
+    std::cout << numberOfVertices << " vertices, "
+              << graph->GetNumberOfEdges() << " edges" << std::endl;
+    auto report = [](const char* name, double seconds, int count,
+                     vtkGraph* output) {
+      double stress = SampledStress(output);
+      std::cout << "  " << std::left << std::setw(16) << name << std::right
+                << std::setw(5) << count << " iterations " << std::setw(10)
+                << 1000.0 * seconds / std::max(count, 1)
+                << " ms/iteration  stress " << stress << std::endl;
+      return stress;
+    };
+
+    vtkNew<vtkBarnesHutLayoutStrategy> barnesHut;
+    barnesHut->SetMaxNumberOfIterations(maxBarnesHutIterations);
+    barnesHut->SetIterationsPerLayout(10);
+    vtkSmartPointer<vtkGraph> output;
+    double seconds = RunLayout(graph, barnesHut, output);
+    double stress =
+        report("Barnes-Hut", seconds, barnesHut->GetTotalIterations(), output);
+    ok = ok && std::isfinite(stress) &&
+        barnesHut->GetTotalIterations() < maxBarnesHutIterations;
+    shown = output;
+
+    // Restart from the converged layout.
+    vtkNew<vtkBarnesHutLayoutStrategy> warm;
+    warm->SetMaxNumberOfIterations(maxBarnesHutIterations);
+    warm->WarmStartOn();
+    vtkSmartPointer<vtkGraph> warmOutput;
+    seconds = RunLayout(output, warm, warmOutput);
+    report("Warm start", seconds, warm->GetTotalIterations(), warmOutput);
+    ok = ok && warm->GetTotalIterations() < barnesHut->GetTotalIterations();
+
+    if (numberOfVertices > allPairsLimit)
+    {
+      std::cout << "  (all pairs strategies skipped above " << allPairsLimit
+                << " vertices)" << std::endl;
+      continue;
+    }
+
+    vtkNew<vtkSimple2DLayoutStrategy> simple2D;
+    simple2D->SetMaxNumberOfIterations(iterations);
+    simple2D->SetIterationsPerLayout(iterations);
+    seconds = RunLayout(graph, simple2D, output);
+    report("Simple2D", seconds, iterations, output);
+
+    vtkNew<vtkForceDirectedLayoutStrategy> forceDirected;
+    forceDirected->SetMaxNumberOfIterations(iterations);
+    forceDirected->SetIterationsPerLayout(iterations);
+    seconds = RunLayout(graph, forceDirected, output);
+    report("ForceDirected", seconds, iterations, output);
+  }
+
+  if (interactive)
+  {
+    vtkNew<vtkNamedColors> colors;
+
+    vtkNew<vtkGraphLayoutView> graphLayoutView;
+    graphLayoutView->AddRepresentationFromInput(shown);
+    graphLayoutView->SetLayoutStrategyToPassThrough();
+    graphLayoutView->GetRenderer()->SetBackground(
+        colors->GetColor3d("Navy").GetData());
+    graphLayoutView->GetRenderer()->SetBackground2(
+        colors->GetColor3d("MidnightBlue").GetData());
+    graphLayoutView->GetRenderWindow()->SetWindowName("BarnesHutGraphLayout");
+    graphLayoutView->Render();
+    graphLayoutView->ResetCamera();
+    graphLayoutView->GetInteractor()->Start();
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+vtkStandardNewMacro(vtkBarnesHutLayoutStrategy);
+
+vtkBarnesHutLayoutStrategy::vtkBarnesHutLayoutStrategy()
+  : Theta(0.8), MaxNumberOfIterations(200), IterationsPerLayout(200),
+    Tolerance(0.01), CoolingFactor(0.9), WarmStart(false),
+    ThreeDimensionalLayout(false), RandomSeed(123)
+{
+}
+
+void vtkBarnesHutLayoutStrategy::Initialize()
+{
+  this->TotalIterations = 0;
+  this->Energy = VTK_DOUBLE_MAX;
+  this->Progress = 0;
+  this->Dimension = this->ThreeDimensionalLayout ? 3 : 2;
+  vtkIdType numberOfVertices = this->Graph->GetNumberOfVertices();
+  this->LayoutComplete = numberOfVertices == 0;
+  this->Positions.assign(3 * numberOfVertices, 0.0);
+  this->Forces.assign(3 * numberOfVertices, 0.0);
+
+  // Warm start from the current points if they are spread out.
+  vtkPoints* points = this->Graph->GetPoints();
+  bool warm = false;
+  if (this->WarmStart && points &&
+      points->GetNumberOfPoints() == numberOfVertices)
+  {
+    double bounds[6];
+    points->GetBounds(bounds);
+    warm = bounds[1] > bounds[0] || bounds[3] > bounds[2];
+  }
+  double side = std::pow(static_cast<double>(std::max<vtkIdType>(
+                             numberOfVertices, 1)),
+                         1.0 / this->Dimension);
+  if (warm)
+  {
+    for (vtkIdType i = 0; i < numberOfVertices; ++i)
+    {
+      points->GetPoint(i, &this->Positions[3 * i]);
+      if (this->Dimension == 2)
+      {
+        this->Positions[3 * i + 2] = 0.0;
+      }
+    }
+    this->Temperature = 0.1 * K;
+  }
+  else
+  {
+    std::mt19937 generator(this->RandomSeed);
+    std::uniform_real_distribution<double> distribution(0.0, side);
+    for (vtkIdType i = 0; i < numberOfVertices; ++i)
+    {
+      for (int j = 0; j < this->Dimension; ++j)
+      {
+        this->Positions[3 * i + j] = distribution(generator);
+      }
+    }
+    this->Temperature = side / 10.0;
+  }
+
+  // Adjacency, normalized edge weights.
+  vtkDataArray* weights = nullptr;
+  if (this->WeightEdges && this->EdgeWeightField)
+  {
+    weights = vtkArrayDownCast<vtkDataArray>(
+        this->Graph->GetEdgeData()->GetAbstractArray(this->EdgeWeightField));
+  }
+  double maxWeight = weights ? weights->GetRange(0)[1] : 1.0;
+  if (maxWeight <= 0.0)
+  {
+    maxWeight = 1.0;
+  }
+
+  this->Offsets.assign(numberOfVertices + 1, 0);
+  vtkNew<vtkEdgeListIterator> edges;
+  this->Graph->GetEdges(edges);
+  while (edges->HasNext())
+  {
+    vtkEdgeType e = edges->Next();
+    if (e.Source != e.Target)
+    {
+      ++this->Offsets[e.Source + 1];
+      ++this->Offsets[e.Target + 1];
+    }
+  }
+  std::partial_sum(this->Offsets.begin(), this->Offsets.end(),
+                   this->Offsets.begin());
+  this->Neighbors.resize(this->Offsets.back());
+  this->Weights.resize(this->Offsets.back());
+  std::vector<vtkIdType> next(this->Offsets.begin(), this->Offsets.end() - 1);
+  this->Graph->GetEdges(edges);
+  while (edges->HasNext())
+  {
+    vtkEdgeType e = edges->Next();
+    if (e.Source == e.Target)
+    {
+      continue;
+    }
+    double w = weights ? weights->GetTuple1(e.Id) / maxWeight : 1.0;
+    this->Neighbors[next[e.Source]] = e.Target;
+    this->Weights[next[e.Source]++] = w;
+    this->Neighbors[next[e.Target]] = e.Source;
+    this->Weights[next[e.Target]++] = w;
+  }
+}
+
+void vtkBarnesHutLayoutStrategy::Layout()
+{
+  if (!this->Graph || this->LayoutComplete)
+  {
+    return;
+  }
+  for (int i = 0; i < this->IterationsPerLayout && !this->LayoutComplete;
+       ++i)
+  {
+    this->Iterate();
+    if (++this->TotalIterations >= this->MaxNumberOfIterations)
+    {
+      this->LayoutComplete = 1;
+    }
+  }
+
+  vtkPoints* points = this->Graph->GetPoints();
+  vtkIdType numberOfVertices = this->Graph->GetNumberOfVertices();
+  points->SetNumberOfPoints(numberOfVertices);
+  for (vtkIdType i = 0; i < numberOfVertices; ++i)
+  {
+    points->SetPoint(i, &this->Positions[3 * i]);
+  }
+  points->Modified();
+}
+
+void vtkBarnesHutLayoutStrategy::BuildTree()
+{
+  vtkIdType numberOfVertices = this->Graph->GetNumberOfVertices();
+  const double* x = this->Positions.data();
+  this->Order.resize(numberOfVertices);
+  std::iota(this->Order.begin(), this->Order.end(), 0);
+  this->Scratch.resize(numberOfVertices);
+
+  double lo[3] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, VTK_DOUBLE_MAX};
+  double hi[3] = {VTK_DOUBLE_MIN, VTK_DOUBLE_MIN, VTK_DOUBLE_MIN};
+  for (vtkIdType i = 0; i < numberOfVertices; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      lo[j] = std::min(lo[j], x[3 * i + j]);
+      hi[j] = std::max(hi[j], x[3 * i + j]);
+    }
+  }
+  Node root;
+  root.HalfSize = 0.0;
+  for (int j = 0; j < 3; ++j)
+  {
+    root.Center[j] = 0.5 * (lo[j] + hi[j]);
+    root.HalfSize = std::max(root.HalfSize, 0.5 * (hi[j] - lo[j]));
+  }
+  root.HalfSize = root.HalfSize * 1.001 + 1e-9;
+  root.Begin = 0;
+  root.End = numberOfVertices;
+  root.Depth = 0;
+  this->Nodes.clear();
+  this->Nodes.push_back(root);
+
+  // Breadth first: split each cell with a counting sort of its range.
+  const int numberOfOctants = 1 << this->Dimension;
+  for (size_t n = 0; n < this->Nodes.size(); ++n)
+  {
+    Node node = this->Nodes[n];
+    vtkIdType count = node.End - node.Begin;
+    double com[3] = {0.0, 0.0, 0.0};
+    for (vtkIdType k = node.Begin; k < node.End; ++k)
+    {
+      const double* p = x + 3 * this->Order[k];
+      com[0] += p[0];
+      com[1] += p[1];
+      com[2] += p[2];
+    }
+    for (int j = 0; j < 3; ++j)
+    {
+      this->Nodes[n].CenterOfMass[j] = com[j] / count;
+    }
+    this->Nodes[n].FirstChild = -1;
+    this->Nodes[n].NumberOfChildren = 0;
+    if (count <= LeafSize || node.Depth >= MaxDepth)
+    {
+      continue;
+    }
+
+    auto octant = [&](vtkIdType id) {
+      const double* p = x + 3 * id;
+      return (p[0] >= node.Center[0] ? 1 : 0) |
+          (p[1] >= node.Center[1] ? 2 : 0) |
+          (this->Dimension == 3 && p[2] >= node.Center[2] ? 4 : 0);
+    };
+    vtkIdType starts[9] = {0};
+    for (vtkIdType k = node.Begin; k < node.End; ++k)
+    {
+      ++starts[octant(this->Order[k]) + 1];
+    }
+    std::partial_sum(starts, starts + 9, starts);
+    vtkIdType fill[8];
+    std::copy(starts, starts + 8, fill);
+    for (vtkIdType k = node.Begin; k < node.End; ++k)
+    {
+      vtkIdType id = this->Order[k];
+      this->Scratch[node.Begin + fill[octant(id)]++] = id;
+    }
+    std::copy(this->Scratch.begin() + node.Begin,
+              this->Scratch.begin() + node.End,
+              this->Order.begin() + node.Begin);
+
+    int firstChild = static_cast<int>(this->Nodes.size());
+    int numberOfChildren = 0;
+    for (int o = 0; o < numberOfOctants; ++o)
+    {
+      if (starts[o + 1] == starts[o])
+      {
+        continue;
+      }
+      Node child;
+      child.HalfSize = 0.5 * node.HalfSize;
+      for (int j = 0; j < 3; ++j)
+      {
+        double sign = (o >> j) & 1 ? 1.0 : -1.0;
+        child.Center[j] = j < this->Dimension
+            ? node.Center[j] + sign * child.HalfSize
+            : node.Center[j];
+      }
+      child.Begin = node.Begin + starts[o];
+      child.End = node.Begin + starts[o + 1];
+      child.Depth = node.Depth + 1;
+      this->Nodes.push_back(child);
+      ++numberOfChildren;
+    }
+    this->Nodes[n].FirstChild = firstChild;
+    this->Nodes[n].NumberOfChildren = numberOfChildren;
+  }
+}
+
+void vtkBarnesHutLayoutStrategy::Repulsion(vtkIdType i, double force[3]) const
+{
+  // Fruchterman-Reingold repulsion k^2 / d along the unit vector, i.e.
+  // delta * k^2 / d^2, times the number of vertices in a far cell.
+  const double* x = this->Positions.data();
+  const double* p = x + 3 * i;
+  const double theta2 = this->Theta * this->Theta;
+  const double minimum2 = 1e-6 * K * K;
+
+  int stack[MaxDepth * 8 + 8];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0)
+  {
+    const Node& node = this->Nodes[stack[--top]];
+    if (node.NumberOfChildren == 0)
+    {
+      for (vtkIdType k = node.Begin; k < node.End; ++k)
+      {
+        vtkIdType j = this->Order[k];
+        if (j == i)
+        {
+          continue;
+        }
+        double delta[3] = {p[0] - x[3 * j], p[1] - x[3 * j + 1],
+                           p[2] - x[3 * j + 2]};
+        double d2 = delta[0] * delta[0] + delta[1] * delta[1] +
+            delta[2] * delta[2];
+        if (d2 < minimum2)
+        {
+          // Coincident vertices: push them apart along x.
+          delta[0] = i < j ? -1e-3 * K : 1e-3 * K;
+          d2 = minimum2;
+        }
+        double s = K * K / d2;
+        force[0] += s * delta[0];
+        force[1] += s * delta[1];
+        force[2] += s * delta[2];
+      }
+      continue;
+    }
+
+    double delta[3] = {p[0] - node.CenterOfMass[0],
+                       p[1] - node.CenterOfMass[1],
+                       p[2] - node.CenterOfMass[2]};
+    double d2 =
+        delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2];
+    double size = 2.0 * node.HalfSize;
+    if (size * size < theta2 * d2)
+    {
+      double s = (node.End - node.Begin) * K * K / d2;
+      force[0] += s * delta[0];
+      force[1] += s * delta[1];
+      force[2] += s * delta[2];
+    }
+    else
+    {
+      for (int c = 0; c < node.NumberOfChildren; ++c)
+      {
+        stack[top++] = node.FirstChild + c;
+      }
+    }
+  }
+}
+
+void vtkBarnesHutLayoutStrategy::Iterate()
+{
+  this->BuildTree();
+
+  vtkIdType numberOfVertices = this->Graph->GetNumberOfVertices();
+  double* x = this->Positions.data();
+  double* f = this->Forces.data();
+
+  // Each vertex gathers its own forces, repulsion from the tree and
+  // attraction d^2 / k from its neighbors.
+  vtkSMPTools::For(0, numberOfVertices, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      double force[3] = {0.0, 0.0, 0.0};
+      this->Repulsion(i, force);
+      const double* p = x + 3 * i;
+      for (vtkIdType k = this->Offsets[i]; k < this->Offsets[i + 1]; ++k)
+      {
+        const double* q = x + 3 * this->Neighbors[k];
+        double delta[3] = {p[0] - q[0], p[1] - q[1], p[2] - q[2]};
+        double d = std::sqrt(delta[0] * delta[0] + delta[1] * delta[1] +
+                             delta[2] * delta[2]);
+        double s = this->Weights[k] * d / K;
+        force[0] -= s * delta[0];
+        force[1] -= s * delta[1];
+        force[2] -= s * delta[2];
+      }
+      std::copy(force, force + 3, f + 3 * i);
+    }
+  });
+
+  // Move every vertex by at most the temperature, and sum the energy
+  // |f|^2 for the adaptive cooling.
+  const double temperature = this->Temperature;
+  vtkSMPThreadLocal<double> energy(0.0);
+  vtkSMPTools::For(0, numberOfVertices, [&](vtkIdType begin, vtkIdType end) {
+    double& sum = energy.Local();
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      double* fi = f + 3 * i;
+      double length2 = fi[0] * fi[0] + fi[1] * fi[1] + fi[2] * fi[2];
+      if (length2 > 0.0)
+      {
+        double length = std::sqrt(length2);
+        double step = std::min(length, temperature);
+        for (int j = 0; j < 3; ++j)
+        {
+          x[3 * i + j] += fi[j] / length * step;
+        }
+        sum += length2;
+      }
+    }
+  });
+  double total = 0.0;
+  for (double sum : energy)
+  {
+    total += sum;
+  }
+
+  // Adaptive cooling (Hu 2005): cool when the energy goes up, heat up again
+  // after five iterations of progress.
+  if (total < this->Energy)
+  {
+    if (++this->Progress >= 5)
+    {
+      this->Progress = 0;
+      this->Temperature /= this->CoolingFactor;
+    }
+  }
+  else
+  {
+    this->Progress = 0;
+    this->Temperature *= this->CoolingFactor;
+  }
+  this->Energy = total;
+  if (this->Temperature < this->Tolerance * K)
+  {
+    this->LayoutComplete = 1;
+  }
+}
+
+vtkSmartPointer<vtkGraph> MakeGraph(vtkIdType numberOfVertices)
+{
+  vtkNew<vtkRandomGraphSource> source;
+  source->SetNumberOfVertices(numberOfVertices);
+  source->SetNumberOfEdges(2 * numberOfVertices);
+  // Start with a random tree, so that the graph is connected.
+  source->StartWithTreeOn();
+  source->SetSeed(123);
+  source->Update();
+  return source->GetOutput();
+}
+
+double RunLayout(vtkGraph* graph, vtkGraphLayoutStrategy* strategy,
+                 vtkSmartPointer<vtkGraph>& output)
+{
+  vtkNew<vtkGraphLayout> layout;
+  layout->SetInputData(graph);
+  layout->SetLayoutStrategy(strategy);
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  layout->Update();
+  while (!layout->IsLayoutComplete())
+  {
+    layout->Modified();
+    layout->Update();
+  }
+  timer->StopTimer();
+
+  output = layout->GetOutput();
+  return timer->GetElapsedTime();
+}
+
+double SampledStress(vtkGraph* graph, int numberOfSources)
+{
+  vtkIdType numberOfVertices = graph->GetNumberOfVertices();
+  if (numberOfVertices < 2)
+  {
+    return 0.0;
+  }
+  std::vector<std::vector<vtkIdType>> adjacency(numberOfVertices);
+  vtkNew<vtkEdgeListIterator> edges;
+  graph->GetEdges(edges);
+  while (edges->HasNext())
+  {
+    vtkEdgeType e = edges->Next();
+    adjacency[e.Source].push_back(e.Target);
+    adjacency[e.Target].push_back(e.Source);
+  }
+
+  // With s the optimal scale, sum ((s x - d) / d)^2 = n - A^2 / B where
+  // A = sum x / d and B = sum x^2 / d^2.
+  vtkPoints* points = graph->GetPoints();
+  double a = 0.0;
+  double b = 0.0;
+  double n = 0.0;
+  std::vector<int> distance(numberOfVertices);
+  std::vector<vtkIdType> queue(numberOfVertices);
+  vtkIdType stride = std::max<vtkIdType>(numberOfVertices / numberOfSources, 1);
+  for (vtkIdType source = 0; source < numberOfVertices; source += stride)
+  {
+    std::fill(distance.begin(), distance.end(), -1);
+    distance[source] = 0;
+    vtkIdType head = 0;
+    vtkIdType tail = 0;
+    queue[tail++] = source;
+    double ps[3];
+    points->GetPoint(source, ps);
+    while (head < tail)
+    {
+      vtkIdType v = queue[head++];
+      if (v != source)
+      {
+        double pv[3];
+        points->GetPoint(v, pv);
+        double x = std::sqrt((pv[0] - ps[0]) * (pv[0] - ps[0]) +
+                             (pv[1] - ps[1]) * (pv[1] - ps[1]) +
+                             (pv[2] - ps[2]) * (pv[2] - ps[2]));
+        double d = distance[v];
+        a += x / d;
+        b += x * x / (d * d);
+        n += 1.0;
+      }
+      for (auto w : adjacency[v])
+      {
+        if (distance[w] < 0)
+        {
+          distance[w] = distance[v] + 1;
+          queue[tail++] = w;
+        }
+      }
+    }
+  }
+  return b > 0.0 ? (n - a * a / b) / n : 1.0;
+}
+} // namespace
@@ -0,0 +1,1470 @@
+#include <vtkActor.h>
+#include <vtkActorCollection.h>
+#include <vtkCamera.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkFieldData.h>
+#include <vtkFloatArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+#include <vtkTypeInt32Array.h>
+#include <vtkTypeInt64Array.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkXMLMultiBlockDataReader.h>
+#include <vtkXMLMultiBlockDataWriter.h>
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+/**
+ * The layout of a scene snapshot. All the records have a fixed size, and
+ * the values of the arrays follow them, each at an offset that is a
+ * multiple of Alignment, so that a memory mapped file can be used as is.
+ *
+ * Header
+ * ActorRecord[NumberOfActors]
+ * GeometryRecord[NumberOfGeometries]
+ * ArrayRecord[NumberOfArrays]    point and cell data
+ * char[StringsSize]              array names
+ * values of the arrays
+ *
+ * Numbers are stored in the byte order of the computer that saved the
+ * snapshot; restoring on one with another order fails.
+ */
+constexpr std::uint32_t SnapshotVersion = 1;
+constexpr std::uint32_t ByteOrderMark = 0x01020304;
+constexpr std::uint64_t Alignment = 64;
+
+struct CameraRecord
+{
+  double Position[3];
+  double FocalPoint[3];
+  double ViewUp[3];
+  double ViewAngle;
+  double ParallelScale;
+  double ClippingRange[2];
+  std::int32_t ParallelProjection;
+  std::int32_t Reserved;
+};
+
+struct PropertyRecord
+{
+  double Ambient;
+  double AmbientColor[3];
+  double Diffuse;
+  double DiffuseColor[3];
+  double Specular;
+  double SpecularColor[3];
+  double SpecularPower;
+  double Opacity;
+  double EdgeColor[3];
+  double PointSize;
+  double LineWidth;
+  std::int32_t Interpolation;
+  std::int32_t Representation;
+  std::int32_t EdgeVisibility;
+  std::int32_t BackfaceCulling;
+  std::int32_t FrontfaceCulling;
+  std::int32_t Lighting;
+  std::int32_t RenderPointsAsSpheres;
+  std::int32_t Shading;
+};
+
+struct MapperRecord
+{
+  double ScalarRange[2];
+  std::int32_t ScalarVisibility;
+  std::int32_t ScalarMode;
+  std::int32_t ColorMode;
+  std::int32_t InterpolateScalarsBeforeMapping;
+  std::int32_t UseLookupTableScalarRange;
+  std::int32_t Reserved;
+};
+
+struct ActorRecord
+{
+  double Position[3];
+  double Orientation[3];
+  double Origin[3];
+  double Scale[3];
+  double UserMatrix[16];
+  PropertyRecord Property;
+  PropertyRecord BackfaceProperty;
+  MapperRecord Mapper;
+  std::uint32_t Geometry;
+  std::int32_t HasUserMatrix;
+  std::int32_t HasBackfaceProperty;
+  std::int32_t Visibility;
+  std::int32_t Pickable;
+  std::int32_t Dragable;
+  std::int32_t ForceOpaque;
+  std::int32_t ForceTranslucent;
+};
+
+// An array: its values at Offset, and its name in the strings.
+struct ArrayRecord
+{
+  std::uint64_t Offset;
+  std::uint64_t NumberOfTuples;
+  std::int32_t DataType;
+  std::int32_t NumberOfComponents;
+  std::int32_t Attribute; // As vtkDataSetAttributes::AttributeTypes, or -1.
+  std::uint32_t NameOffset;
+  std::uint32_t NameLength;
+  std::uint32_t Reserved;
+};
+
+// A vtkPolyData: the points, the offsets and connectivity of the verts,
+// lines, polys and strips, and a range of the array records for the point
+// and cell data. An array with a DataType of 0 is absent.
+struct GeometryRecord
+{
+  ArrayRecord Points;
+  ArrayRecord Offsets[4];
+  ArrayRecord Connectivity[4];
+  std::uint32_t FirstPointArray;
+  std::uint32_t NumberOfPointArrays;
+  std::uint32_t FirstCellArray;
+  std::uint32_t NumberOfCellArrays;
+};
+
+struct Header
+{
+  char Magic[8];
+  std::uint32_t Version;
+  std::uint32_t ByteOrder;
+  std::uint64_t FileSize;
+  std::uint32_t NumberOfActors;
+  std::uint32_t NumberOfGeometries;
+  std::uint32_t NumberOfArrays;
+  std::uint32_t StringsSize;
+  std::uint64_t ActorsOffset;
+  std::uint64_t GeometriesOffset;
+  std::uint64_t ArraysOffset;
+  std::uint64_t StringsOffset;
+  CameraRecord Camera;
+};
+
+static_assert(std::is_trivially_copyable<Header>::value &&
+                std::is_trivially_copyable<ActorRecord>::value &&
+                std::is_trivially_copyable<GeometryRecord>::value,
+              "The records are written as they are in memory.");
+
+const char SnapshotMagic[8] = {'V', 'T', 'K', 'S', 'N', 'A', 'P', '\0'};
+
+/**
+ * A file mapped in memory, copy on write: arrays that wrap it can be
+ * modified without changing the file.
+ *
+ * Wrap() makes the values of a vtkDataArray point into the file, with a
+ * free function that releases the file when the last array that wraps
+ * it releases its values, wherever the array has gone in the meantime.
+ */
+class MappedFile
+{
+public:
+  static std::shared_ptr<MappedFile> Open(const std::string& fileName);
+  ~MappedFile();
+
+  const char* GetData() const
+  {
+    return this->Data;
+  }
+  std::uint64_t GetSize() const
+  {
+    return this->Size;
+  }
+
+  static void Wrap(const std::shared_ptr<MappedFile>& file,
+                   std::uint64_t offset, vtkIdType numberOfValues,
+                   vtkDataArray* array);
+
+  // True if the pointer is in a file that arrays wrap.
+  static bool IsMapped(const void* pointer);
+
+private:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+
+  static void Release(void* pointer);
+
+  char* Data = nullptr;
+  std::uint64_t Size = 0;
+#ifdef _WIN32
+  HANDLE File = INVALID_HANDLE_VALUE;
+  HANDLE Mapping = nullptr;
+#endif
+
+  // The files that arrays wrap, by address, and how many arrays do.
+  struct Use
+  {
+    std::shared_ptr<MappedFile> File;
+    vtkIdType NumberOfArrays = 0;
+  };
+  static std::mutex UsesMutex;
+  static std::map<const char*, Use> Uses;
+};
+
+std::mutex MappedFile::UsesMutex;
+std::map<const char*, MappedFile::Use> MappedFile::Uses;
+
+// Saves the camera and the actors of the renderer, with vtkPolyDataMapper
+// and vtkPolyData input, to a snapshot. Geometry shared by actors is saved
+// once.
+bool SaveSceneSnapshot(vtkRenderer* renderer, const std::string& fileName);
+
+// Restores the camera and adds the actors of a snapshot to the renderer.
+// The arrays of the geometry wrap the mapped file. The header and the
+// extent of the arrays are checked, not the values of the arrays: the file
+// is trusted not to have, say, point ids out of range.
+bool RestoreSceneSnapshot(const std::string& fileName, vtkRenderer* renderer);
+
+// The same scene state, in the field data of the blocks of a
+// vtkMultiBlockDataSet written by vtkXMLMultiBlockDataWriter, as
+// ExportPolyDataScene does. Each actor has its own block.
+void SaveMultiBlockScene(vtkRenderer* renderer, const std::string& fileName);
+bool RestoreMultiBlockScene(const std::string& fileName,
+                            vtkRenderer* renderer);
+
+vtkSmartPointer<vtkRenderer> MakeScene(int numberOfActors,
+                                       vtkIdType numberOfTriangles);
+bool SameScene(vtkRenderer* a, vtkRenderer* b, vtkIdType& numberOfArrays,
+               vtkIdType& numberOfMappedArrays);
+double TouchPoints(vtkRenderer* renderer);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const int numberOfActors = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+  const vtkIdType numberOfTriangles =
+    argc > 2 ? std::max<vtkIdType>(1, std::atoll(argv[2])) : 2000000;
+  const std::string directory = argc > 3 ? argv[3] : ".";
+
+  auto scene = MakeScene(numberOfActors, numberOfTriangles);
+  vtkIdType triangles = 0;
+  auto actors = scene->GetActors();
+  actors->InitTraversal();
+  while (vtkActor* actor = actors->GetNextActor())
+  {
+    triangles += vtkPolyData::SafeDownCast(actor->GetMapper()->GetInput())
+                   ->GetNumberOfPolys();
+  }
+  std::cout << numberOfActors << " actors, " << triangles << " triangles"
+            << std::endl;
+
+  const std::string snapshotName = directory + "/Scene.vtksnap";
+  const std::string multiBlockName = directory + "/Scene.vtm";
+  const std::string blockDirectory = directory + "/Scene";
+  vtkNew<vtkTimerLog> timer;
+  bool ok = true;
+  std::cout << std::left << std::setw(22) << "Format" << std::right
+            << std::setw(10) << "Save" << std::setw(10) << "Restore"
+            << std::setw(12) << "+ bounds" << std::setw(14) << "Size (MB)"
+            << std::setw(10) << "Same" << std::endl;
+  std::cout << std::fixed << std::setprecision(3);
+  for (int format = 0; format < 2; ++format)
+  {
+    const bool snapshot = format == 0;
+    const std::string& fileName = snapshot ? snapshotName : multiBlockName;
+    timer->StartTimer();
+    if (snapshot)
+    {
+      ok = SaveSceneSnapshot(scene, fileName) && ok;
+    }
+    else
+    {
+      SaveMultiBlockScene(scene, fileName);
+    }
+    timer->StopTimer();
+    const double saveTime = timer->GetElapsedTime();
+
+    vtkNew<vtkRenderer> restored;
+    timer->StartTimer();
+    const bool restoredOk = snapshot
+      ? RestoreSceneSnapshot(fileName, restored)
+      : RestoreMultiBlockScene(fileName, restored);
+    timer->StopTimer();
+    const double restoreTime = timer->GetElapsedTime();
+    // A mapped file is read as its pages are first used.
+    timer->StartTimer();
+    TouchPoints(restored);
+    timer->StopTimer();
+    const double touchTime = timer->GetElapsedTime();
+
+    vtkIdType numberOfArrays = 0;
+    vtkIdType numberOfMappedArrays = 0;
+    const bool same = restoredOk &&
+      SameScene(scene, restored, numberOfArrays, numberOfMappedArrays);
+    ok = ok && same;
+
+    // The multiblock writer saves the blocks in a directory of their own.
+    auto size =
+      static_cast<double>(vtksys::SystemTools::FileLength(fileName));
+    if (!snapshot)
+    {
+      vtksys::Directory blocks;
+      blocks.Load(blockDirectory);
+      for (unsigned long i = 0; i < blocks.GetNumberOfFiles(); ++i)
+      {
+        size += static_cast<double>(vtksys::SystemTools::FileLength(
+          blockDirectory + "/" + blocks.GetFile(i)));
+      }
+    }
+    std::cout << std::left << std::setw(22)
+              << (snapshot ? "Binary snapshot" : "XML multiblock")
+              << std::right << std::setw(10) << saveTime << std::setw(10)
+              << restoreTime << std::setw(12) << restoreTime + touchTime
+              << std::setw(14) << std::setprecision(1) << size / 1048576.0
+              << std::setprecision(3) << std::setw(10)
+              << (same ? "yes" : "no") << std::endl;
+    if (snapshot)
+    {
+      std::cout << "  " << numberOfMappedArrays << " of " << numberOfArrays
+                << " arrays wrap the mapped file" << std::endl;
+      ok = ok && numberOfMappedArrays == numberOfArrays;
+    }
+  }
+
+  vtksys::SystemTools::RemoveFile(snapshotName);
+  vtksys::SystemTools::RemoveFile(multiBlockName);
+  vtksys::SystemTools::RemoveADirectory(blockDirectory);
+  std::cout << (ok ? "Both formats restore the scene."
+                   : "A restored scene differs.")
+            << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& fileName)
+{
+  std::shared_ptr<MappedFile> file(new MappedFile);
+#ifdef _WIN32
+  file->File = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+  LARGE_INTEGER size;
+  if (file->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(file->File, &size) ||
+      size.QuadPart == 0)
+  {
+    return nullptr;
+  }
+  file->Mapping =
+    CreateFileMappingA(file->File, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  if (!file->Mapping)
+  {
+    return nullptr;
+  }
+  file->Data =
+    static_cast<char*>(MapViewOfFile(file->Mapping, FILE_MAP_COPY, 0, 0, 0));
+  file->Size = static_cast<std::uint64_t>(size.QuadPart);
+#else
+  const int descriptor = open(fileName.c_str(), O_RDONLY);
+  struct stat status;
+  if (descriptor < 0 || fstat(descriptor, &status) != 0 ||
+      status.st_size == 0)
+  {
+    if (descriptor >= 0)
+    {
+      close(descriptor);
+    }
+    return nullptr;
+  }
+  void* data = mmap(nullptr, static_cast<size_t>(status.st_size),
+                    PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (data == MAP_FAILED)
+  {
+    return nullptr;
+  }
+  file->Data = static_cast<char*>(data);
+  file->Size = static_cast<std::uint64_t>(status.st_size);
+#endif
+  return file->Data ? file : nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+  if (this->Data)
+  {
+    UnmapViewOfFile(this->Data);
+  }
+  if (this->Mapping)
+  {
+    CloseHandle(this->Mapping);
+  }
+  if (this->File != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(this->File);
+  }
+#else
+  if (this->Data)
+  {
+    munmap(this->Data, static_cast<size_t>(this->Size));
+  }
+#endif
+}
+
+void MappedFile::Wrap(const std::shared_ptr<MappedFile>& file,
+                      std::uint64_t offset, vtkIdType numberOfValues,
+                      vtkDataArray* array)
+{
+  {
+    std::lock_guard<std::mutex> lock(UsesMutex);
+    Use& use = Uses[file->Data];
+    use.File = file;
+    ++use.NumberOfArrays;
+  }
+  array->SetVoidArray(file->Data + offset, numberOfValues, 0,
+                      vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+  array->SetArrayFreeFunction(&MappedFile::Release);
+}
+
+void MappedFile::Release(void* pointer)
+{
+  std::lock_guard<std::mutex> lock(UsesMutex);
+  auto use = Uses.upper_bound(static_cast<const char*>(pointer));
+  if (use == Uses.begin())
+  {
+    return;
+  }
+  --use;
+  if (--use->second.NumberOfArrays == 0)
+  {
+    // The last reference to the file, which unmaps it.
+    Uses.erase(use);
+  }
+}
+
+bool MappedFile::IsMapped(const void* pointer)
+{
+  std::lock_guard<std::mutex> lock(UsesMutex);
+  auto use = Uses.upper_bound(static_cast<const char*>(pointer));
+  if (use == Uses.begin())
+  {
+    return false;
+  }
+  --use;
+  return static_cast<const char*>(pointer) <
+    use->first + use->second.File->Size;
+}
+
+CameraRecord MakeCameraRecord(vtkCamera* camera)
+{
+  CameraRecord record;
+  std::memset(&record, 0, sizeof(record));
+  camera->GetPosition(record.Position);
+  camera->GetFocalPoint(record.FocalPoint);
+  camera->GetViewUp(record.ViewUp);
+  record.ViewAngle = camera->GetViewAngle();
+  record.ParallelScale = camera->GetParallelScale();
+  camera->GetClippingRange(record.ClippingRange);
+  record.ParallelProjection = camera->GetParallelProjection();
+  return record;
+}
+
+void RestoreCamera(const CameraRecord& record, vtkCamera* camera)
+{
+  camera->SetPosition(record.Position);
+  camera->SetFocalPoint(record.FocalPoint);
+  camera->SetViewUp(record.ViewUp);
+  camera->SetViewAngle(record.ViewAngle);
+  camera->SetParallelScale(record.ParallelScale);
+  camera->SetClippingRange(record.ClippingRange);
+  camera->SetParallelProjection(record.ParallelProjection);
+}
+
+PropertyRecord MakePropertyRecord(vtkProperty* property)
+{
+  PropertyRecord record;
+  std::memset(&record, 0, sizeof(record));
+  record.Ambient = property->GetAmbient();
+  property->GetAmbientColor(record.AmbientColor);
+  record.Diffuse = property->GetDiffuse();
+  property->GetDiffuseColor(record.DiffuseColor);
+  record.Specular = property->GetSpecular();
+  property->GetSpecularColor(record.SpecularColor);
+  record.SpecularPower = property->GetSpecularPower();
+  record.Opacity = property->GetOpacity();
+  property->GetEdgeColor(record.EdgeColor);
+  record.PointSize = property->GetPointSize();
+  record.LineWidth = property->GetLineWidth();
+  record.Interpolation = property->GetInterpolation();
+  record.Representation = property->GetRepresentation();
+  record.EdgeVisibility = property->GetEdgeVisibility();
+  record.BackfaceCulling = property->GetBackfaceCulling();
+  record.FrontfaceCulling = property->GetFrontfaceCulling();
+  record.Lighting = property->GetLighting();
+  record.RenderPointsAsSpheres = property->GetRenderPointsAsSpheres();
+  record.Shading = property->GetShading();
+  return record;
+}
+
+void RestoreProperty(const PropertyRecord& record, vtkProperty* property)
+{
+  property->SetAmbient(record.Ambient);
+  property->SetAmbientColor(record.AmbientColor);
+  property->SetDiffuse(record.Diffuse);
+  property->SetDiffuseColor(record.DiffuseColor);
+  property->SetSpecular(record.Specular);
+  property->SetSpecularColor(record.SpecularColor);
+  property->SetSpecularPower(record.SpecularPower);
+  property->SetOpacity(record.Opacity);
+  property->SetEdgeColor(record.EdgeColor);
+  property->SetPointSize(static_cast<float>(record.PointSize));
+  property->SetLineWidth(static_cast<float>(record.LineWidth));
+  property->SetInterpolation(record.Interpolation);
+  property->SetRepresentation(record.Representation);
+  property->SetEdgeVisibility(record.EdgeVisibility);
+  property->SetBackfaceCulling(record.BackfaceCulling);
+  property->SetFrontfaceCulling(record.FrontfaceCulling);
+  property->SetLighting(record.Lighting != 0);
+  property->SetRenderPointsAsSpheres(record.RenderPointsAsSpheres != 0);
+  property->SetShading(record.Shading);
+}
+
+ActorRecord MakeActorRecord(vtkActor* actor, std::uint32_t geometry)
+{
+  ActorRecord record;
+  std::memset(&record, 0, sizeof(record));
+  actor->GetPosition(record.Position);
+  actor->GetOrientation(record.Orientation);
+  actor->GetOrigin(record.Origin);
+  actor->GetScale(record.Scale);
+  // The matrix of a user transform, or the user matrix.
+  if (vtkMatrix4x4* matrix = actor->GetUserMatrix())
+  {
+    record.HasUserMatrix = 1;
+    std::copy(&matrix->Element[0][0], &matrix->Element[0][0] + 16,
+              record.UserMatrix);
+  }
+  record.Property = MakePropertyRecord(actor->GetProperty());
+  if (vtkProperty* backfaceProperty = actor->GetBackfaceProperty())
+  {
+    record.HasBackfaceProperty = 1;
+    record.BackfaceProperty = MakePropertyRecord(backfaceProperty);
+  }
+  auto mapper = vtkPolyDataMapper::SafeDownCast(actor->GetMapper());
+  mapper->GetScalarRange(record.Mapper.ScalarRange);
+  record.Mapper.ScalarVisibility = mapper->GetScalarVisibility();
+  record.Mapper.ScalarMode = mapper->GetScalarMode();
+  record.Mapper.ColorMode = mapper->GetColorMode();
+  record.Mapper.InterpolateScalarsBeforeMapping =
+    mapper->GetInterpolateScalarsBeforeMapping();
+  record.Mapper.UseLookupTableScalarRange =
+    mapper->GetUseLookupTableScalarRange();
+  record.Geometry = geometry;
+  record.Visibility = actor->GetVisibility();
+  record.Pickable = actor->GetPickable();
+  record.Dragable = actor->GetDragable();
+  record.ForceOpaque = actor->GetForceOpaque();
+  record.ForceTranslucent = actor->GetForceTranslucent();
+  return record;
+}
+
+vtkSmartPointer<vtkActor> RestoreActor(const ActorRecord& record,
+                                       vtkPolyData* polyData)
+{
+  vtkNew<vtkPolyDataMapper> mapper;
+  mapper->SetInputData(polyData);
+  mapper->SetScalarRange(record.Mapper.ScalarRange);
+  mapper->SetScalarVisibility(record.Mapper.ScalarVisibility);
+  mapper->SetScalarMode(record.Mapper.ScalarMode);
+  mapper->SetColorMode(record.Mapper.ColorMode);
+  mapper->SetInterpolateScalarsBeforeMapping(
+    record.Mapper.InterpolateScalarsBeforeMapping);
+  mapper->SetUseLookupTableScalarRange(
+    record.Mapper.UseLookupTableScalarRange);
+
+  auto actor = vtkSmartPointer<vtkActor>::New();
+  actor->SetMapper(mapper);
+  actor->SetPosition(record.Position);
+  actor->SetOrientation(record.Orientation);
+  actor->SetOrigin(record.Origin);
+  actor->SetScale(record.Scale);
+  if (record.HasUserMatrix)
+  {
+    vtkNew<vtkTransform> userTransform;
+    userTransform->SetMatrix(record.UserMatrix);
+    actor->SetUserTransform(userTransform);
+  }
+  RestoreProperty(record.Property, actor->GetProperty());
+  if (record.HasBackfaceProperty)
+  {
+    vtkNew<vtkProperty> backfaceProperty;
+    RestoreProperty(record.BackfaceProperty, backfaceProperty);
+    actor->SetBackfaceProperty(backfaceProperty);
+  }
+  actor->SetVisibility(record.Visibility);
+  actor->SetPickable(record.Pickable);
+  actor->SetDragable(record.Dragable);
+  actor->SetForceOpaque(record.ForceOpaque != 0);
+  actor->SetForceTranslucent(record.ForceTranslucent != 0);
+  return actor;
+}
+
+// The actors of the renderer that a snapshot can hold.
+std::vector<vtkActor*> SceneActors(vtkRenderer* renderer)
+{
+  std::vector<vtkActor*> sceneActors;
+  auto actors = renderer->GetActors();
+  actors->InitTraversal();
+  while (vtkActor* actor = actors->GetNextActor())
+  {
+    auto mapper = vtkPolyDataMapper::SafeDownCast(actor->GetMapper());
+    if (mapper && vtkPolyData::SafeDownCast(mapper->GetInput()))
+    {
+      sceneActors.push_back(actor);
+    }
+  }
+  return sceneActors;
+}
+
+// The types of the arrays a snapshot holds.
+bool IsSnapshotType(int dataType)
+{
+  switch (dataType)
+  {
+    vtkTemplateMacro(return true);
+  }
+  return false;
+}
+
+std::uint64_t AlignOffset(std::uint64_t offset)
+{
+  return (offset + Alignment - 1) / Alignment * Alignment;
+}
+
+std::uint64_t ArraySize(const ArrayRecord& record)
+{
+  return record.NumberOfTuples *
+    static_cast<std::uint64_t>(record.NumberOfComponents) *
+    static_cast<std::uint64_t>(vtkDataArray::GetDataTypeSize(record.DataType));
+}
+
+// The arrays of a snapshot as it is written. Each one has a record in a
+// geometry, at Slot, or else in DataRecords.
+class SnapshotWriter
+{
+public:
+  enum Slot
+  {
+    Data = -1,
+    Points,
+    Offsets,
+    Connectivity = Offsets + 4
+  };
+
+  std::vector<GeometryRecord> GeometryRecords;
+  std::vector<ArrayRecord> DataRecords;
+  std::string Strings;
+
+  // Adds an array of the last geometry, with the attribute type, or -1,
+  // for point and cell data. Returns false if it cannot be saved.
+  bool Add(vtkDataArray* array, int slot, int attribute = -1)
+  {
+    if (!array || !IsSnapshotType(array->GetDataType()))
+    {
+      return false;
+    }
+    ArrayRecord record;
+    std::memset(&record, 0, sizeof(record));
+    vtkSmartPointer<vtkDataArray> values = array;
+    if (!array->HasStandardMemoryLayout())
+    {
+      values = vtk::TakeSmartPointer(
+        vtkDataArray::CreateDataArray(array->GetDataType()));
+      values->DeepCopy(array);
+    }
+    record.NumberOfTuples =
+      static_cast<std::uint64_t>(values->GetNumberOfTuples());
+    record.DataType = values->GetDataType();
+    record.NumberOfComponents = values->GetNumberOfComponents();
+    record.Attribute = attribute;
+    if (const char* name = array->GetName())
+    {
+      record.NameOffset = static_cast<std::uint32_t>(this->Strings.size());
+      record.NameLength = static_cast<std::uint32_t>(std::strlen(name));
+      this->Strings += name;
+    }
+    if (slot == Data)
+    {
+      this->DataRecords.push_back(record);
+      this->Locations.emplace_back(slot, this->DataRecords.size() - 1);
+    }
+    else
+    {
+      this->Record(this->GeometryRecords.size() - 1, slot) = record;
+      this->Locations.emplace_back(slot, this->GeometryRecords.size() - 1);
+    }
+    this->Arrays.push_back(values);
+    return true;
+  }
+
+  // Places the values of the arrays from the offset on, and returns the
+  // size of the file.
+  std::uint64_t Place(std::uint64_t offset)
+  {
+    for (const auto& location : this->Locations)
+    {
+      ArrayRecord& record = this->Record(location.second, location.first);
+      offset = AlignOffset(offset);
+      record.Offset = offset;
+      offset += ArraySize(record);
+    }
+    return offset;
+  }
+
+  // Calls write(values, size, offset) for each array.
+  template <typename Write> void WriteArrays(Write&& write)
+  {
+    for (size_t i = 0; i < this->Arrays.size(); ++i)
+    {
+      const ArrayRecord& record =
+        this->Record(this->Locations[i].second, this->Locations[i].first);
+      write(this->Arrays[i]->GetVoidPointer(0), ArraySize(record),
+            record.Offset);
+    }
+  }
+
+private:
+  ArrayRecord& Record(size_t index, int slot)
+  {
+    if (slot == Data)
+    {
+      return this->DataRecords[index];
+    }
+    GeometryRecord& geometry = this->GeometryRecords[index];
+    return slot == Points ? geometry.Points
+      : slot < Connectivity ? geometry.Offsets[slot - Offsets]
+                            : geometry.Connectivity[slot - Connectivity];
+  }
+
+  std::vector<vtkSmartPointer<vtkDataArray>> Arrays;
+  std::vector<std::pair<int, size_t>> Locations;
+};
+
+bool SaveSceneSnapshot(vtkRenderer* renderer, const std::string& fileName)
+{
+  std::vector<ActorRecord> actorRecords;
+  std::map<vtkPolyData*, std::uint32_t> geometries;
+  SnapshotWriter writer;
+  for (vtkActor* actor : SceneActors(renderer))
+  {
+    auto polyData = vtkPolyData::SafeDownCast(actor->GetMapper()->GetInput());
+    auto found = geometries.find(polyData);
+    if (found == geometries.end())
+    {
+      found = geometries
+                .emplace(polyData, static_cast<std::uint32_t>(
+                                     writer.GeometryRecords.size()))
+                .first;
+      GeometryRecord geometry;
+      std::memset(&geometry, 0, sizeof(geometry));
+      writer.GeometryRecords.push_back(geometry);
+      if (polyData->GetPoints())
+      {
+        writer.Add(polyData->GetPoints()->GetData(), SnapshotWriter::Points);
+      }
+      vtkCellArray* cells[4] = {polyData->GetVerts(), polyData->GetLines(),
+                                polyData->GetPolys(), polyData->GetStrips()};
+      for (int k = 0; k < 4; ++k)
+      {
+        if (cells[k] && cells[k]->GetNumberOfCells() > 0 &&
+            !(writer.Add(cells[k]->GetOffsetsArray(),
+                         SnapshotWriter::Offsets + k) &&
+              writer.Add(cells[k]->GetConnectivityArray(),
+                         SnapshotWriter::Connectivity + k)))
+        {
+          vtkGenericWarningMacro(<< "Cannot save the cells of a geometry.");
+          return false;
+        }
+      }
+      vtkDataSetAttributes* attributes[2] = {polyData->GetPointData(),
+                                             polyData->GetCellData()};
+      std::uint32_t first[2];
+      std::uint32_t count[2];
+      for (int a = 0; a < 2; ++a)
+      {
+        first[a] = static_cast<std::uint32_t>(writer.DataRecords.size());
+        for (int i = 0; i < attributes[a]->GetNumberOfArrays(); ++i)
+        {
+          // Bit arrays are not saved.
+          writer.Add(attributes[a]->GetArray(i), SnapshotWriter::Data,
+                     attributes[a]->IsArrayAnAttribute(i));
+        }
+        count[a] =
+          static_cast<std::uint32_t>(writer.DataRecords.size()) - first[a];
+      }
+      GeometryRecord& record = writer.GeometryRecords.back();
+      record.FirstPointArray = first[0];
+      record.NumberOfPointArrays = count[0];
+      record.FirstCellArray = first[1];
+      record.NumberOfCellArrays = count[1];
+    }
+    actorRecords.push_back(MakeActorRecord(actor, found->second));
+  }
+
+  // The layout: the records, then the values of the arrays.
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.Magic, SnapshotMagic, sizeof(header.Magic));
+  header.Version = SnapshotVersion;
+  header.ByteOrder = ByteOrderMark;
+  header.NumberOfActors = static_cast<std::uint32_t>(actorRecords.size());
+  header.NumberOfGeometries =
+    static_cast<std::uint32_t>(writer.GeometryRecords.size());
+  header.NumberOfArrays = static_cast<std::uint32_t>(writer.DataRecords.size());
+  header.StringsSize = static_cast<std::uint32_t>(writer.Strings.size());
+  header.Camera = MakeCameraRecord(renderer->GetActiveCamera());
+  header.ActorsOffset = AlignOffset(sizeof(Header));
+  header.GeometriesOffset = AlignOffset(
+    header.ActorsOffset + actorRecords.size() * sizeof(ActorRecord));
+  header.ArraysOffset =
+    AlignOffset(header.GeometriesOffset +
+                writer.GeometryRecords.size() * sizeof(GeometryRecord));
+  header.StringsOffset = AlignOffset(
+    header.ArraysOffset + writer.DataRecords.size() * sizeof(ArrayRecord));
+  header.FileSize = writer.Place(header.StringsOffset + writer.Strings.size());
+
+  std::ofstream file(fileName, std::ios::binary);
+  if (!file)
+  {
+    vtkGenericWarningMacro(<< "Cannot write " << fileName);
+    return false;
+  }
+  std::uint64_t position = 0;
+  auto write = [&](const void* data, std::uint64_t size, std::uint64_t at) {
+    static const char zeros[Alignment] = {};
+    while (position < at)
+    {
+      const auto padding = std::min<std::uint64_t>(Alignment, at - position);
+      file.write(zeros, static_cast<std::streamsize>(padding));
+      position += padding;
+    }
+    file.write(static_cast<const char*>(data),
+               static_cast<std::streamsize>(size));
+    position += size;
+  };
+  write(&header, sizeof(header), 0);
+  write(actorRecords.data(), actorRecords.size() * sizeof(ActorRecord),
+        header.ActorsOffset);
+  write(writer.GeometryRecords.data(),
+        writer.GeometryRecords.size() * sizeof(GeometryRecord),
+        header.GeometriesOffset);
+  write(writer.DataRecords.data(),
+        writer.DataRecords.size() * sizeof(ArrayRecord), header.ArraysOffset);
+  write(writer.Strings.data(), writer.Strings.size(), header.StringsOffset);
+  writer.WriteArrays(write);
+  if (!file)
+  {
+    vtkGenericWarningMacro(<< "Error writing " << fileName);
+    return false;
+  }
+  return true;
+}
+
+// A checked view of a mapped snapshot.
+class SnapshotReader
+{
+public:
+  bool Open(const std::string& fileName)
+  {
+    this->File = MappedFile::Open(fileName);
+    if (!this->File || this->File->GetSize() < sizeof(Header))
+    {
+      vtkGenericWarningMacro(<< "Cannot map " << fileName);
+      return false;
+    }
+    std::memcpy(&this->Layout, this->File->GetData(), sizeof(Header));
+    const auto& h = this->Layout;
+    if (std::memcmp(h.Magic, SnapshotMagic, sizeof(h.Magic)) != 0 ||
+        h.Version != SnapshotVersion || h.ByteOrder != ByteOrderMark ||
+        h.FileSize > this->File->GetSize() ||
+        !this->InFile(h.ActorsOffset,
+                      std::uint64_t(h.NumberOfActors) * sizeof(ActorRecord)) ||
+        !this->InFile(h.GeometriesOffset, std::uint64_t(h.NumberOfGeometries) *
+                        sizeof(GeometryRecord)) ||
+        !this->InFile(h.ArraysOffset,
+                      std::uint64_t(h.NumberOfArrays) * sizeof(ArrayRecord)) ||
+        !this->InFile(h.StringsOffset, h.StringsSize))
+    {
+      vtkGenericWarningMacro(<< fileName << " is not a valid snapshot.");
+      return false;
+    }
+    return true;
+  }
+
+  const Header& GetHeader() const
+  {
+    return this->Layout;
+  }
+  template <typename T> const T* Records(std::uint64_t offset) const
+  {
+    return reinterpret_cast<const T*>(this->File->GetData() + offset);
+  }
+
+  // A new array that wraps the values of the record, or nullptr if the
+  // record is not valid.
+  vtkSmartPointer<vtkDataArray> NewArray(const ArrayRecord& record,
+                                         bool cellArray) const
+  {
+    if (!IsSnapshotType(record.DataType) || record.NumberOfComponents < 1 ||
+        record.Offset % Alignment != 0 ||
+        record.NumberOfTuples > this->Layout.FileSize /
+            (std::uint64_t(record.NumberOfComponents) *
+             vtkDataArray::GetDataTypeSize(record.DataType)) ||
+        !this->InFile(record.Offset, ArraySize(record)) ||
+        !this->InFile(this->Layout.StringsOffset + record.NameOffset,
+                      record.NameLength) ||
+        std::uint64_t(record.NameOffset) + record.NameLength >
+          this->Layout.StringsSize)
+    {
+      return nullptr;
+    }
+    vtkSmartPointer<vtkDataArray> array;
+    if (cellArray)
+    {
+      // The types vtkCellArray stores without a copy.
+      const int size = vtkDataArray::GetDataTypeSize(record.DataType);
+      if (record.DataType == VTK_FLOAT || record.DataType == VTK_DOUBLE)
+      {
+        return nullptr;
+      }
+      else if (size == 4)
+      {
+        array = vtkSmartPointer<vtkTypeInt32Array>::New();
+      }
+      else if (size == 8)
+      {
+        array = vtkSmartPointer<vtkTypeInt64Array>::New();
+      }
+      else
+      {
+        return nullptr;
+      }
+    }
+    else
+    {
+      array =
+        vtk::TakeSmartPointer(vtkDataArray::CreateDataArray(record.DataType));
+    }
+    if (record.NameLength > 0)
+    {
+      array->SetName(std::string(this->File->GetData() +
+                                   this->Layout.StringsOffset +
+                                   record.NameOffset,
+                                 record.NameLength)
+                       .c_str());
+    }
+    array->SetNumberOfComponents(record.NumberOfComponents);
+    const auto numberOfValues = static_cast<vtkIdType>(
+      record.NumberOfTuples * record.NumberOfComponents);
+    if (numberOfValues > 0)
+    {
+      MappedFile::Wrap(this->File, record.Offset, numberOfValues, array);
+    }
+    return array;
+  }
+
+private:
+  bool InFile(std::uint64_t offset, std::uint64_t size) const
+  {
+    return offset <= this->Layout.FileSize &&
+      size <= this->Layout.FileSize - offset;
+  }
+
+  std::shared_ptr<MappedFile> File;
+  Header Layout;
+};
+
+bool RestoreSceneSnapshot(const std::string& fileName, vtkRenderer* renderer)
+{
+  SnapshotReader reader;
+  if (!reader.Open(fileName))
+  {
+    return false;
+  }
+  const Header& header = reader.GetHeader();
+  const auto* geometryRecords =
+    reader.Records<GeometryRecord>(header.GeometriesOffset);
+  const auto* arrayRecords = reader.Records<ArrayRecord>(header.ArraysOffset);
+  std::vector<vtkSmartPointer<vtkPolyData>> geometries;
+  for (std::uint32_t g = 0; g < header.NumberOfGeometries; ++g)
+  {
+    const GeometryRecord& record = geometryRecords[g];
+    auto polyData = vtkSmartPointer<vtkPolyData>::New();
+    if (record.Points.DataType != 0)
+    {
+      auto data = reader.NewArray(record.Points, false);
+      if (!data || data->GetNumberOfComponents() != 3)
+      {
+        vtkGenericWarningMacro(<< "Invalid points in " << fileName);
+        return false;
+      }
+      vtkNew<vtkPoints> points;
+      points->SetData(data);
+      polyData->SetPoints(points);
+    }
+    for (int k = 0; k < 4; ++k)
+    {
+      if (record.Offsets[k].DataType == 0)
+      {
+        continue;
+      }
+      auto offsets = reader.NewArray(record.Offsets[k], true);
+      auto connectivity = reader.NewArray(record.Connectivity[k], true);
+      if (!offsets || !connectivity ||
+          offsets->GetDataType() != connectivity->GetDataType() ||
+          offsets->GetNumberOfComponents() != 1 ||
+          connectivity->GetNumberOfComponents() != 1)
+      {
+        vtkGenericWarningMacro(<< "Invalid cells in " << fileName);
+        return false;
+      }
+      vtkNew<vtkCellArray> cells;
+      if (!cells->SetData(offsets, connectivity))
+      {
+        vtkGenericWarningMacro(<< "Invalid cells in " << fileName);
+        return false;
+      }
+      if (k == 0)
+      {
+        polyData->SetVerts(cells);
+      }
+      else if (k == 1)
+      {
+        polyData->SetLines(cells);
+      }
+      else if (k == 2)
+      {
+        polyData->SetPolys(cells);
+      }
+      else
+      {
+        polyData->SetStrips(cells);
+      }
+    }
+    const std::uint32_t first[2] = {record.FirstPointArray,
+                                    record.FirstCellArray};
+    const std::uint32_t count[2] = {record.NumberOfPointArrays,
+                                    record.NumberOfCellArrays};
+    vtkDataSetAttributes* attributes[2] = {polyData->GetPointData(),
+                                           polyData->GetCellData()};
+    for (int a = 0; a < 2; ++a)
+    {
+      if (std::uint64_t(first[a]) + count[a] > header.NumberOfArrays)
+      {
+        vtkGenericWarningMacro(<< "Invalid arrays in " << fileName);
+        return false;
+      }
+      for (std::uint32_t i = first[a]; i < first[a] + count[a]; ++i)
+      {
+        auto array = reader.NewArray(arrayRecords[i], false);
+        if (!array)
+        {
+          vtkGenericWarningMacro(<< "Invalid array in " << fileName);
+          return false;
+        }
+        const int index = attributes[a]->AddArray(array);
+        if (arrayRecords[i].Attribute >= 0 &&
+            arrayRecords[i].Attribute < vtkDataSetAttributes::NUM_ATTRIBUTES)
+        {
+          attributes[a]->SetActiveAttribute(index, arrayRecords[i].Attribute);
+        }
+      }
+    }
+    geometries.push_back(polyData);
+  }
+
+  const auto* actorRecords = reader.Records<ActorRecord>(header.ActorsOffset);
+  for (std::uint32_t a = 0; a < header.NumberOfActors; ++a)
+  {
+    if (actorRecords[a].Geometry >= geometries.size())
+    {
+      vtkGenericWarningMacro(<< "Invalid actor in " << fileName);
+      return false;
+    }
+    renderer->AddActor(
+      RestoreActor(actorRecords[a], geometries[actorRecords[a].Geometry]));
+  }
+  RestoreCamera(header.Camera, renderer->GetActiveCamera());
+  return true;
+}
+
+template <typename Record>
+vtkSmartPointer<vtkUnsignedCharArray> RecordArray(const Record& record,
+                                                  const char* name)
+{
+  auto array = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  array->SetName(name);
+  array->SetNumberOfValues(sizeof(Record));
+  std::memcpy(array->GetPointer(0), &record, sizeof(Record));
+  return array;
+}
+
+template <typename Record>
+bool GetRecord(vtkFieldData* fieldData, const char* name, Record& record)
+{
+  auto array =
+    vtkUnsignedCharArray::SafeDownCast(fieldData->GetAbstractArray(name));
+  if (!array || array->GetNumberOfValues() != sizeof(Record))
+  {
+    return false;
+  }
+  std::memcpy(&record, array->GetPointer(0), sizeof(Record));
+  return true;
+}
+
+void SaveMultiBlockScene(vtkRenderer* renderer, const std::string& fileName)
+{
+  const auto actors = SceneActors(renderer);
+  vtkNew<vtkMultiBlockDataSet> multiBlock;
+  multiBlock->SetNumberOfBlocks(static_cast<unsigned int>(actors.size()));
+  for (size_t a = 0; a < actors.size(); ++a)
+  {
+    vtkNew<vtkPolyData> polyData;
+    polyData->ShallowCopy(actors[a]->GetMapper()->GetInput());
+    // The field data is the block's own.
+    vtkNew<vtkFieldData> fieldData;
+    polyData->SetFieldData(fieldData);
+    fieldData->AddArray(RecordArray(
+      MakeActorRecord(actors[a], static_cast<std::uint32_t>(a)), "Actor"));
+    if (a == 0)
+    {
+      fieldData->AddArray(RecordArray(
+        MakeCameraRecord(renderer->GetActiveCamera()), "Camera"));
+    }
+    multiBlock->SetBlock(static_cast<unsigned int>(a), polyData);
+  }
+  vtkNew<vtkXMLMultiBlockDataWriter> writer;
+  writer->SetInputData(multiBlock);
+  writer->SetFileName(fileName.c_str());
+  writer->SetDataModeToBinary();
+  writer->SetCompressorTypeToNone();
+  writer->Write();
+}
+
+bool RestoreMultiBlockScene(const std::string& fileName,
+                            vtkRenderer* renderer)
+{
+  vtkNew<vtkXMLMultiBlockDataReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  auto multiBlock = vtkMultiBlockDataSet::SafeDownCast(reader->GetOutput());
+  if (!multiBlock)
+  {
+    return false;
+  }
+  for (unsigned int a = 0; a < multiBlock->GetNumberOfBlocks(); ++a)
+  {
+    auto polyData = vtkPolyData::SafeDownCast(multiBlock->GetBlock(a));
+    ActorRecord record;
+    if (!polyData || !GetRecord(polyData->GetFieldData(), "Actor", record))
+    {
+      return false;
+    }
+    CameraRecord camera;
+    if (a == 0 && GetRecord(polyData->GetFieldData(), "Camera", camera))
+    {
+      RestoreCamera(camera, renderer->GetActiveCamera());
+    }
+    polyData->GetFieldData()->Initialize();
+    renderer->AddActor(RestoreActor(record, polyData));
+  }
+  return true;
+}
+
+// A sphere with about the number of triangles, its height as the point
+// scalars and its cell ids as a cell array.
+vtkSmartPointer<vtkPolyData> MakeGeometry(vtkIdType numberOfTriangles,
+                                          double radius)
+{
+  // A sphere has about 2 * theta * (phi - 1) triangles.
+  const int resolution = std::max(
+    3, static_cast<int>(std::sqrt(numberOfTriangles / 2.0)) + 1);
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(radius);
+  sphere->SetThetaResolution(resolution);
+  sphere->SetPhiResolution(resolution);
+  sphere->Update();
+  auto polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->ShallowCopy(sphere->GetOutput());
+
+  const vtkIdType numberOfPoints = polyData->GetNumberOfPoints();
+  vtkNew<vtkFloatArray> height;
+  height->SetName("Height");
+  height->SetNumberOfValues(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    double x[3];
+    polyData->GetPoint(i, x);
+    height->SetValue(i, static_cast<float>(x[2]));
+  }
+  polyData->GetPointData()->SetScalars(height);
+  vtkNew<vtkFloatArray> cellIds;
+  cellIds->SetName("CellId");
+  cellIds->SetNumberOfValues(polyData->GetNumberOfCells());
+  for (vtkIdType i = 0; i < polyData->GetNumberOfCells(); ++i)
+  {
+    cellIds->SetValue(i, static_cast<float>(i));
+  }
+  polyData->GetCellData()->AddArray(cellIds);
+  return polyData;
+}
+
+vtkSmartPointer<vtkRenderer> MakeScene(int numberOfActors,
+                                       vtkIdType numberOfTriangles)
+{
+  auto renderer = vtkSmartPointer<vtkRenderer>::New();
+  const vtkIdType trianglesPerActor =
+    std::max<vtkIdType>(1, numberOfTriangles / numberOfActors);
+  const int side =
+    static_cast<int>(std::ceil(std::cbrt(static_cast<double>(numberOfActors))));
+  vtkSmartPointer<vtkPolyData> geometry;
+  for (int a = 0; a < numberOfActors; ++a)
+  {
+    // The last two actors share their geometry.
+    if (a < 2 || a != numberOfActors - 1)
+    {
+      geometry = MakeGeometry(trianglesPerActor, 0.4 + 0.001 * a);
+    }
+    vtkNew<vtkPolyDataMapper> mapper;
+    mapper->SetInputData(geometry);
+    mapper->SetScalarRange(-0.5, 0.5);
+    mapper->SetScalarVisibility(a % 2);
+    vtkNew<vtkActor> actor;
+    actor->SetMapper(mapper);
+    actor->SetPosition(a % side, (a / side) % side, a / (side * side));
+    actor->SetOrientation(3.0 * a, 5.0 * a, 7.0 * a);
+    actor->SetScale(1.0 + 0.01 * a, 1.0, 1.0 - 0.005 * a);
+    auto property = actor->GetProperty();
+    property->SetDiffuseColor(a % 3 / 2.0, a % 5 / 4.0, a % 7 / 6.0);
+    property->SetSpecular(0.5);
+    property->SetSpecularPower(a % 50 + 1);
+    property->SetOpacity(a % 4 == 0 ? 0.5 : 1.0);
+    if (a % 3 == 0)
+    {
+      property->EdgeVisibilityOn();
+      property->SetEdgeColor(0.2, 0.2, 0.3);
+      property->SetRepresentationToWireframe();
+    }
+    if (a % 5 == 0)
+    {
+      vtkNew<vtkProperty> backProperty;
+      backProperty->SetDiffuseColor(0.0, 0.6, 0.6);
+      actor->SetBackfaceProperty(backProperty);
+      vtkNew<vtkTransform> userTransform;
+      userTransform->RotateZ(30.0);
+      actor->SetUserTransform(userTransform);
+    }
+    renderer->AddActor(actor);
+  }
+  renderer->GetActiveCamera()->Azimuth(30);
+  renderer->GetActiveCamera()->Elevation(30);
+  renderer->ResetCamera();
+  return renderer;
+}
+
+bool SameValues(const double* a, const double* b, int n)
+{
+  for (int i = 0; i < n; ++i)
+  {
+    if (std::abs(a[i] - b[i]) > 1e-12 * std::max(1.0, std::abs(a[i])))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The same values, with the same type, name and number of components.
+bool SameArray(vtkDataArray* a, vtkDataArray* b)
+{
+  if (!a || !b)
+  {
+    return a == b;
+  }
+  if (a->GetNumberOfValues() != b->GetNumberOfValues() ||
+      a->GetNumberOfComponents() != b->GetNumberOfComponents() ||
+      std::string(a->GetName() ? a->GetName() : "") !=
+        std::string(b->GetName() ? b->GetName() : ""))
+  {
+    return false;
+  }
+  if (a->GetDataType() == b->GetDataType() &&
+      a->HasStandardMemoryLayout() && b->HasStandardMemoryLayout())
+  {
+    return a->GetNumberOfValues() == 0 ||
+      std::memcmp(a->GetVoidPointer(0), b->GetVoidPointer(0),
+                  static_cast<size_t>(a->GetNumberOfValues()) *
+                    a->GetDataTypeSize()) == 0;
+  }
+  // Cells read from XML may be stored with another integer type.
+  const int numberOfComponents = a->GetNumberOfComponents();
+  for (vtkIdType i = 0; i < a->GetNumberOfTuples(); ++i)
+  {
+    for (int c = 0; c < numberOfComponents; ++c)
+    {
+      if (a->GetComponent(i, c) != b->GetComponent(i, c))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool SameGeometry(vtkPolyData* a, vtkPolyData* b, vtkIdType& numberOfArrays,
+                  vtkIdType& numberOfMappedArrays)
+{
+  auto count = [&](vtkDataArray* array) {
+    if (array && array->GetNumberOfValues() > 0)
+    {
+      ++numberOfArrays;
+      numberOfMappedArrays += MappedFile::IsMapped(array->GetVoidPointer(0));
+    }
+  };
+  bool same = SameArray(a->GetPoints()->GetData(), b->GetPoints()->GetData());
+  count(b->GetPoints()->GetData());
+  vtkCellArray* cellsA[4] = {a->GetVerts(), a->GetLines(), a->GetPolys(),
+                             a->GetStrips()};
+  vtkCellArray* cellsB[4] = {b->GetVerts(), b->GetLines(), b->GetPolys(),
+                             b->GetStrips()};
+  for (int k = 0; k < 4 && same; ++k)
+  {
+    same = cellsA[k]->GetNumberOfCells() == cellsB[k]->GetNumberOfCells();
+    if (same && cellsA[k]->GetNumberOfCells() > 0)
+    {
+      same = SameArray(cellsA[k]->GetOffsetsArray(),
+                       cellsB[k]->GetOffsetsArray()) &&
+        SameArray(cellsA[k]->GetConnectivityArray(),
+                  cellsB[k]->GetConnectivityArray());
+      count(cellsB[k]->GetOffsetsArray());
+      count(cellsB[k]->GetConnectivityArray());
+    }
+  }
+  vtkDataSetAttributes* attributesA[2] = {a->GetPointData(), a->GetCellData()};
+  vtkDataSetAttributes* attributesB[2] = {b->GetPointData(), b->GetCellData()};
+  for (int k = 0; k < 2 && same; ++k)
+  {
+    same = attributesA[k]->GetNumberOfArrays() ==
+      attributesB[k]->GetNumberOfArrays();
+    for (int i = 0; i < attributesA[k]->GetNumberOfArrays() && same; ++i)
+    {
+      same = SameArray(attributesA[k]->GetArray(i),
+                       attributesB[k]->GetArray(i)) &&
+        attributesA[k]->IsArrayAnAttribute(i) ==
+          attributesB[k]->IsArrayAnAttribute(i);
+      count(attributesB[k]->GetArray(i));
+    }
+  }
+  return same;
+}
+
+bool SameActor(const ActorRecord& a, const ActorRecord& b)
+{
+  return SameValues(a.Position, b.Position, 3) &&
+    SameValues(a.Orientation, b.Orientation, 3) &&
+    SameValues(a.Origin, b.Origin, 3) && SameValues(a.Scale, b.Scale, 3) &&
+    SameValues(a.UserMatrix, b.UserMatrix, 16) &&
+    std::memcmp(&a.Property, &b.Property, sizeof(a.Property)) == 0 &&
+    std::memcmp(&a.BackfaceProperty, &b.BackfaceProperty,
+                sizeof(a.BackfaceProperty)) == 0 &&
+    std::memcmp(&a.Mapper, &b.Mapper, sizeof(a.Mapper)) == 0 &&
+    a.HasUserMatrix == b.HasUserMatrix &&
+    a.HasBackfaceProperty == b.HasBackfaceProperty &&
+    a.Visibility == b.Visibility && a.Pickable == b.Pickable &&
+    a.Dragable == b.Dragable && a.ForceOpaque == b.ForceOpaque &&
+    a.ForceTranslucent == b.ForceTranslucent;
+}
+
+bool SameScene(vtkRenderer* a, vtkRenderer* b, vtkIdType& numberOfArrays,
+               vtkIdType& numberOfMappedArrays)
+{
+  const auto actorsA = SceneActors(a);
+  const auto actorsB = SceneActors(b);
+  if (actorsA.size() != actorsB.size())
+  {
+    return false;
+  }
+  const CameraRecord cameraA = MakeCameraRecord(a->GetActiveCamera());
+  const CameraRecord cameraB = MakeCameraRecord(b->GetActiveCamera());
+  bool same = SameValues(cameraA.Position, cameraB.Position, 3) &&
+    SameValues(cameraA.FocalPoint, cameraB.FocalPoint, 3) &&
+    SameValues(cameraA.ViewUp, cameraB.ViewUp, 3) &&
+    SameValues(&cameraA.ViewAngle, &cameraB.ViewAngle, 1) &&
+    SameValues(&cameraA.ParallelScale, &cameraB.ParallelScale, 1) &&
+    SameValues(cameraA.ClippingRange, cameraB.ClippingRange, 2) &&
+    cameraA.ParallelProjection == cameraB.ParallelProjection;
+  // Each pair of geometries is compared once.
+  std::set<std::pair<vtkDataObject*, vtkDataObject*>> geometries;
+  for (size_t i = 0; i < actorsA.size() && same; ++i)
+  {
+    same = SameActor(MakeActorRecord(actorsA[i], 0),
+                     MakeActorRecord(actorsB[i], 0));
+    auto geometryA = actorsA[i]->GetMapper()->GetInput();
+    auto geometryB = actorsB[i]->GetMapper()->GetInput();
+    if (same && geometries.emplace(geometryA, geometryB).second)
+    {
+      same = SameGeometry(vtkPolyData::SafeDownCast(geometryA),
+                          vtkPolyData::SafeDownCast(geometryB),
+                          numberOfArrays, numberOfMappedArrays);
+    }
+  }
+  return same;
+}
+
+// Reads all the points, as the first render would.
+double TouchPoints(vtkRenderer* renderer)
+{
+  double sum = 0.0;
+  for (vtkActor* actor : SceneActors(renderer))
+  {
+    double bounds[6];
+    vtkPolyData::SafeDownCast(actor->GetMapper()->GetInput())
+      ->GetBounds(bounds);
+    sum += bounds[1] - bounds[0];
+  }
+  return sum;
+}
+} // namespace
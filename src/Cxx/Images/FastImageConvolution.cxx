@@ -0,0 +1,1192 @@
+#include <vtkImageAlgorithm.h>
+#include <vtkImageConvolve.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * Correlate a single component float or double image with a kernel:
+ *
+ * out(x, y, z) = sum w(i, j, k) in(x + i - rx, y + j - ry, z + k - rz)
+ *
+ * where r is the kernel radius along each axis and the image is extended
+ * by repeating its edge voxels. One of four methods is used:
+ *
+ *  - SEPARABLE: the kernel is the outer product of three 1D kernels, which
+ *    is detected when the kernel is set, and is applied as 1D passes.
+ *  - SEPARABLE_FFT: the same passes, each one with FFTs of the lines.
+ *  - DENSE: every tap of the kernel.
+ *  - FFT: a 3D FFT of the padded image.
+ *
+ * The direct methods accumulate whole X rows, one tap at a time, so the
+ * inner loops are contiguous and vectorize for every axis. The FFT passes
+ * along Y and Z gather tiles of X adjacent lines, reading whole cache
+ * lines, and transform them one after the other.
+ *
+ * AUTOMATIC switches to the FFTs when the longest kernel axis (separable
+ * kernels) or the number of nonzero taps reaches a crossover. The
+ * defaults are rough starting points, not measurements; the crossovers
+ * depend on the machine, the image size and the number of threads. This
+ * example measures them and sets them with SetSeparableFFTKernelLength()
+ * and SetDenseFFTNumberOfTaps().
+ */
+class FastImageConvolution : public vtkImageAlgorithm
+{
+public:
+  static FastImageConvolution* New();
+  vtkTypeMacro(FastImageConvolution, vtkImageAlgorithm);
+
+  enum Methods
+  {
+    AUTOMATIC,
+    SEPARABLE,
+    SEPARABLE_FFT,
+    DENSE,
+    FFT
+  };
+
+  /**
+   * Set the kernel, x fastest. The sizes must be odd.
+   */
+  void SetKernel(const int size[3], const double* kernel);
+
+  /**
+   * Whether the kernel is the outer product of three 1D kernels.
+   */
+  bool GetKernelIsSeparable()
+  {
+    return this->Separable;
+  }
+
+  vtkSetClampMacro(Method, int, AUTOMATIC, FFT);
+  vtkGetMacro(Method, int);
+
+  /**
+   * The method that AUTOMATIC selects for the current kernel.
+   */
+  int GetAutomaticMethod();
+
+  /**
+   * The method used by the last execution.
+   */
+  vtkGetMacro(LastMethod, int);
+
+  vtkSetClampMacro(SeparableFFTKernelLength, int, 1, VTK_INT_MAX);
+  vtkGetMacro(SeparableFFTKernelLength, int);
+  vtkSetClampMacro(DenseFFTNumberOfTaps, vtkIdType, 1, VTK_ID_MAX);
+  vtkGetMacro(DenseFFTNumberOfTaps, vtkIdType);
+
+  static const char* GetMethodAsString(int method);
+
+protected:
+  FastImageConvolution() = default;
+  ~FastImageConvolution() override = default;
+
+  int RequestUpdateExtent(vtkInformation*, vtkInformationVector**,
+                          vtkInformationVector*) override;
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  template <class T>
+  void Execute(vtkImageData* input, vtkImageData* output, int method);
+
+  int KernelSize[3] = {1, 1, 1};
+  std::vector<double> Kernel{1.0};
+  vtkIdType NumberOfTaps = 1;
+  // The 1D kernels along X, Y and Z when the kernel is separable.
+  std::vector<double> Factors[3] = {{1.0}, {1.0}, {1.0}};
+  bool Separable = true;
+  int Method = AUTOMATIC;
+  int LastMethod = AUTOMATIC;
+  // Tunable defaults, see the class comment.
+  int SeparableFFTKernelLength = 55;
+  vtkIdType DenseFFTNumberOfTaps = 600;
+
+private:
+  FastImageConvolution(const FastImageConvolution&) = delete;
+  void operator=(const FastImageConvolution&) = delete;
+};
+
+vtkStandardNewMacro(FastImageConvolution);
+
+void MakeVolume(int size, vtkImageData* image);
+
+// Normalized kernels of size 2 * radius + 1 along each axis. The Gaussian
+// is separable, the ball is not.
+std::vector<double> GaussianKernel(int radius);
+std::vector<double> BallKernel(int radius);
+
+// Run the filter and return the time in seconds.
+double Convolve(FastImageConvolution* filter, vtkImageData* input,
+                int method, vtkImageData* output);
+
+double MaxDifference(vtkImageData* a, vtkImageData* b);
+
+// Compare with vtkImageConvolve, which skips the taps outside of the
+// image, away from the boundaries.
+bool CompareWithImageConvolve();
+
+// Sets the crossovers of filter from a sweep. A crossover that was not
+// reached is set just past the largest kernel measured, so that the direct
+// methods are kept wherever they were measured to be faster.
+void Calibrate(FastImageConvolution* filter, int separableCrossover,
+               int largestLength, vtkIdType denseCrossover,
+               vtkIdType largestDenseTaps);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Defaults are small; 512 gives 512^3 volumes.
+  int size = 64;
+  int maximumRadius = 31;
+  if (argc > 1)
+  {
+    size = std::stoi(argv[1]);
+  }
+  if (argc > 2)
+  {
+    maximumRadius = std::stoi(argv[2]);
+  }
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+
+  bool ok = CompareWithImageConvolve();
+
+  vtkNew<vtkImageData> volume;
+  MakeVolume(size, volume);
+  const double numberOfVoxels = volume->GetNumberOfPoints();
+  std::cout << size << "^3 float volume, times in ms" << std::endl;
+  std::cout << "         Gaussian                              Ball"
+            << std::endl;
+  std::cout << "radius   separable  sep. FFT  automatic        taps     "
+               "dense       FFT  automatic"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+
+  // The crossovers are where the FFTs become faster and stay faster. The
+  // dense method is skipped once the FFT wins twice in a row, or when it
+  // would be too slow.
+  const double maximumDenseWork = 2e10;
+  bool runDense = true;
+  int denseLosses = 0;
+  int separableCrossover = 0;
+  vtkIdType denseCrossover = 0;
+  vtkIdType largestDenseTaps = 0;
+
+  vtkNew<FastImageConvolution> filter;
+  vtkNew<vtkImageData> first;
+  vtkNew<vtkImageData> second;
+  for (int radius = 1; radius <= maximumRadius; ++radius)
+  {
+    const int length = 2 * radius + 1;
+    const int kernelSize[3] = {length, length, length};
+
+    auto gaussian = GaussianKernel(radius);
+    filter->SetKernel(kernelSize, gaussian.data());
+    if (!filter->GetKernelIsSeparable())
+    {
+      std::cout << "The Gaussian kernel is not detected as separable"
+                << std::endl;
+      ok = false;
+    }
+    double direct = Convolve(filter, volume,
+                             FastImageConvolution::SEPARABLE, first);
+    double fft = Convolve(filter, volume,
+                          FastImageConvolution::SEPARABLE_FFT, second);
+    ok = ok && MaxDifference(first, second) < 1e-4;
+    if (fft >= direct)
+    {
+      separableCrossover = 0;
+    }
+    else if (!separableCrossover)
+    {
+      separableCrossover = length;
+    }
+    std::cout << std::setw(6) << radius << std::setw(12) << 1000.0 * direct
+              << std::setw(10) << 1000.0 * fft << "  " << std::left
+              << std::setw(14)
+              << FastImageConvolution::GetMethodAsString(
+                     filter->GetAutomaticMethod())
+              << std::right;
+
+    std::vector<double> ball = BallKernel(radius);
+    filter->SetKernel(kernelSize, ball.data());
+    vtkIdType taps = std::count_if(ball.begin(), ball.end(),
+                                   [](double w) { return w != 0.0; });
+    if (filter->GetKernelIsSeparable())
+    {
+      std::cout << "The ball kernel is detected as separable" << std::endl;
+      ok = false;
+    }
+    fft = Convolve(filter, volume, FastImageConvolution::FFT, second);
+    std::cout << std::setw(7) << taps;
+    runDense = runDense && taps * numberOfVoxels <= maximumDenseWork;
+    if (runDense)
+    {
+      direct = Convolve(filter, volume, FastImageConvolution::DENSE, first);
+      ok = ok && MaxDifference(first, second) < 1e-4;
+      largestDenseTaps = taps;
+      std::cout << std::setw(10) << 1000.0 * direct;
+      if (fft >= direct)
+      {
+        denseCrossover = 0;
+        denseLosses = 0;
+      }
+      else
+      {
+        denseCrossover = denseCrossover ? denseCrossover : taps;
+        runDense = ++denseLosses < 2;
+      }
+    }
+    else
+    {
+      std::cout << std::setw(10) << "-";
+    }
+    std::cout << std::setw(10) << 1000.0 * fft << "  "
+              << FastImageConvolution::GetMethodAsString(
+                     filter->GetAutomaticMethod())
+              << std::endl;
+  }
+
+  std::cout << "Measured crossovers: separable FFT from kernel length ";
+  if (separableCrossover)
+  {
+    std::cout << separableCrossover;
+  }
+  else
+  {
+    std::cout << "> " << 2 * maximumRadius + 1;
+  }
+  std::cout << " (default " << filter->GetSeparableFFTKernelLength()
+            << "), FFT from ";
+  if (denseCrossover)
+  {
+    std::cout << denseCrossover;
+  }
+  else
+  {
+    std::cout << "more than the largest dense kernel";
+  }
+  std::cout << " taps (default " << filter->GetDenseFFTNumberOfTaps() << ")"
+            << std::endl;
+
+  // Use the measured crossovers and time the automatic method again where
+  // they change its choice.
+  vtkNew<FastImageConvolution> calibrated;
+  Calibrate(calibrated, separableCrossover, 2 * maximumRadius + 1,
+            denseCrossover, largestDenseTaps);
+  std::cout << "Calibrated: separable FFT from kernel length "
+            << calibrated->GetSeparableFFTKernelLength() << ", FFT from "
+            << calibrated->GetDenseFFTNumberOfTaps() << " taps" << std::endl;
+  int changes = 0;
+  for (int radius = 1; radius <= maximumRadius; ++radius)
+  {
+    const int length = 2 * radius + 1;
+    const int kernelSize[3] = {length, length, length};
+    for (const auto& kernel : {GaussianKernel(radius), BallKernel(radius)})
+    {
+      filter->SetKernel(kernelSize, kernel.data());
+      calibrated->SetKernel(kernelSize, kernel.data());
+      const int before = filter->GetAutomaticMethod();
+      const int after = calibrated->GetAutomaticMethod();
+      if (before == after)
+      {
+        continue;
+      }
+      ++changes;
+      const double beforeTime =
+          Convolve(filter, volume, FastImageConvolution::AUTOMATIC, first);
+      const double afterTime = Convolve(
+          calibrated, volume, FastImageConvolution::AUTOMATIC, second);
+      ok = ok && MaxDifference(first, second) < 1e-4;
+      std::cout << "  radius " << std::setw(2) << radius << ", "
+                << std::left << std::setw(8)
+                << (calibrated->GetKernelIsSeparable() ? "Gaussian" : "ball")
+                << std::right << ": "
+                << FastImageConvolution::GetMethodAsString(before) << " "
+                << 1000.0 * beforeTime << " ms -> "
+                << FastImageConvolution::GetMethodAsString(after) << " "
+                << 1000.0 * afterTime << " ms" << std::endl;
+    }
+  }
+  if (changes == 0)
+  {
+    std::cout << "  The calibration does not change any choice."
+              << std::endl;
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+// The smallest n' >= n with no prime factors other than 2, 3 and 5.
+int NiceSize(int n)
+{
+  for (;; ++n)
+  {
+    int m = n;
+    for (int p : {2, 3, 5})
+    {
+      while (m % p == 0)
+      {
+        m /= p;
+      }
+    }
+    if (m == 1)
+    {
+      return n;
+    }
+  }
+}
+
+/**
+ * A mixed radix (2, 3 and 5) complex FFT of a given length, decimation in
+ * time. The inverse is not normalized.
+ */
+template <class T>
+class FFTPlan
+{
+public:
+  FFTPlan(int length, bool inverse) : Length(length)
+  {
+    for (int p : {2, 3, 5})
+    {
+      while (length % p == 0)
+      {
+        this->Radices.push_back(p);
+        length /= p;
+        this->Lengths.push_back(length);
+      }
+    }
+    const double sign = inverse ? 1.0 : -1.0;
+    const double pi = std::acos(-1.0);
+    for (int i = 0; i < this->Length; ++i)
+    {
+      double angle = sign * 2.0 * pi * i / this->Length;
+      this->Twiddles.emplace_back(static_cast<T>(std::cos(angle)),
+                                  static_cast<T>(std::sin(angle)));
+    }
+  }
+
+  // out = FFT(in); in and out must not overlap.
+  void Transform(const std::complex<T>* in, std::complex<T>* out) const
+  {
+    this->Work(out, in, 1, 0);
+  }
+
+private:
+  void Work(std::complex<T>* out, const std::complex<T>* in, vtkIdType stride,
+            size_t level) const
+  {
+    const int p = this->Radices[level];
+    const int m = this->Lengths[level];
+    for (int q = 0; q < p; ++q)
+    {
+      if (m == 1)
+      {
+        out[q] = in[q * stride];
+      }
+      else
+      {
+        this->Work(out + q * m, in + q * stride, stride * p, level + 1);
+      }
+    }
+
+    const std::complex<T>* twiddles = this->Twiddles.data();
+    if (p == 2)
+    {
+      for (int k = 0; k < m; ++k)
+      {
+        std::complex<T> t = out[m + k] * twiddles[k * stride];
+        out[m + k] = out[k] - t;
+        out[k] += t;
+      }
+      return;
+    }
+    std::complex<T> scratch[5];
+    for (int u = 0; u < m; ++u)
+    {
+      for (int q = 0; q < p; ++q)
+      {
+        scratch[q] = out[u + q * m];
+      }
+      for (int q1 = 0; q1 < p; ++q1)
+      {
+        const vtkIdType k = u + q1 * m;
+        vtkIdType index = 0;
+        std::complex<T> sum = scratch[0];
+        for (int q = 1; q < p; ++q)
+        {
+          index += stride * k;
+          if (index >= this->Length)
+          {
+            index -= this->Length;
+          }
+          sum += scratch[q] * twiddles[index];
+        }
+        out[k] = sum;
+      }
+    }
+  }
+
+  int Length;
+  std::vector<int> Radices;
+  // The length of the sub-transforms below each level.
+  std::vector<int> Lengths;
+  std::vector<std::complex<T>> Twiddles;
+};
+
+// Call f(offset, count, lineStride) for groups of lines along axis of a
+// dims[0] x dims[1] x dims[2] array, in parallel. Line i of a group starts
+// at offset + i * lineStride. Groups along Y and Z are tiles of up to width
+// X adjacent lines, so that gathering them reads whole cache lines; groups
+// along X are pairs of rows.
+template <class F>
+void ForEachLineGroup(const int dims[3], int axis, int width, F&& f)
+{
+  const vtkIdType nx = dims[0];
+  if (axis == 0)
+  {
+    const vtkIdType rows = static_cast<vtkIdType>(dims[1]) * dims[2];
+    vtkSMPTools::For(0, (rows + 1) / 2, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType group = begin; group < end; ++group)
+      {
+        f(2 * group * nx, static_cast<int>(std::min<vtkIdType>(
+                              2, rows - 2 * group)),
+          nx);
+      }
+    });
+    return;
+  }
+  const vtkIdType tiles = (nx + width - 1) / width;
+  const vtkIdType others = axis == 1 ? dims[2] : dims[1];
+  const vtkIdType otherStride = axis == 1 ? nx * dims[1] : nx;
+  vtkSMPTools::For(0, others * tiles, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType group = begin; group < end; ++group)
+    {
+      const vtkIdType x0 = (group % tiles) * width;
+      f((group / tiles) * otherStride + x0,
+        static_cast<int>(std::min<vtkIdType>(width, nx - x0)), 1);
+    }
+  });
+}
+
+vtkIdType AxisStride(const int dims[3], int axis)
+{
+  return axis == 0 ? 1
+                   : axis == 1 ? dims[0]
+                               : static_cast<vtkIdType>(dims[0]) * dims[1];
+}
+
+// Direct correlation, one nonzero kernel row at a time, accumulated over
+// whole X rows.
+template <class T>
+void CorrelateDirect(const T* in, T* out, const int dims[3],
+                     const int size[3], const std::vector<double>& kernel)
+{
+  const int nx = dims[0];
+  const int ny = dims[1];
+  const int nz = dims[2];
+  const int rx = size[0] / 2;
+  const int ry = size[1] / 2;
+  const int rz = size[2] / 2;
+
+  struct KernelRow
+  {
+    int J;
+    int K;
+    std::vector<T> Weights;
+  };
+  std::vector<KernelRow> kernelRows;
+  for (int k = 0; k < size[2]; ++k)
+  {
+    for (int j = 0; j < size[1]; ++j)
+    {
+      const double* w = kernel.data() + (k * size[1] + j) * size[0];
+      if (std::any_of(w, w + size[0], [](double v) { return v != 0.0; }))
+      {
+        kernelRows.push_back({j, k, std::vector<T>(w, w + size[0])});
+      }
+    }
+  }
+
+  vtkSMPThreadLocal<std::vector<T>> paddedRows;
+  const vtkIdType rows = static_cast<vtkIdType>(ny) * nz;
+  vtkSMPTools::For(0, rows, [&](vtkIdType begin, vtkIdType end) {
+    std::vector<T>& padded = paddedRows.Local();
+    padded.resize(nx + 2 * rx);
+    for (vtkIdType row = begin; row < end; ++row)
+    {
+      const int y = static_cast<int>(row % ny);
+      const int z = static_cast<int>(row / ny);
+      T* o = out + row * nx;
+      std::fill(o, o + nx, T(0));
+      for (const auto& kernelRow : kernelRows)
+      {
+        const int yy = std::clamp(y + kernelRow.J - ry, 0, ny - 1);
+        const int zz = std::clamp(z + kernelRow.K - rz, 0, nz - 1);
+        const T* source = in + (static_cast<vtkIdType>(zz) * ny + yy) * nx;
+        if (rx > 0)
+        {
+          // Repeat the edges.
+          std::fill(padded.begin(), padded.begin() + rx, source[0]);
+          std::copy(source, source + nx, padded.begin() + rx);
+          std::fill(padded.begin() + rx + nx, padded.end(), source[nx - 1]);
+          source = padded.data();
+        }
+        for (int i = 0; i < size[0]; ++i)
+        {
+          const T w = kernelRow.Weights[i];
+          if (w == T(0))
+          {
+            continue;
+          }
+          const T* s = source + i;
+          for (int x = 0; x < nx; ++x)
+          {
+            o[x] += w * s[x];
+          }
+        }
+      }
+    }
+  });
+}
+
+// A 1D correlation along axis with FFTs of the lines. Two lines are
+// transformed together as the real and imaginary parts of one complex line.
+template <class T>
+void CorrelateAxisFFT(const T* in, T* out, const int dims[3], int axis,
+                      const std::vector<double>& weights)
+{
+  using Complex = std::complex<T>;
+  const int n = dims[axis];
+  const int r = static_cast<int>(weights.size()) / 2;
+  const int length = NiceSize(n + 2 * r);
+  const vtkIdType stride = AxisStride(dims, axis);
+  FFTPlan<T> forward(length, false);
+  FFTPlan<T> inverse(length, true);
+
+  // The spectrum of the flipped kernel, scaled for the inverse transform.
+  std::vector<Complex> kernel(length);
+  std::vector<Complex> spectrum(length);
+  for (int t = 0; t < 2 * r + 1; ++t)
+  {
+    kernel[(r - t + length) % length] =
+        Complex(static_cast<T>(weights[t] / length));
+  }
+  forward.Transform(kernel.data(), spectrum.data());
+
+  struct Scratch
+  {
+    std::vector<Complex> Lines;
+    std::vector<Complex> Line;
+  };
+  vtkSMPThreadLocal<Scratch> scratch;
+  ForEachLineGroup(dims, axis, 16, [&](vtkIdType offset, int count,
+                                       vtkIdType lineStride) {
+    Scratch& s = scratch.Local();
+    const int pairs = (count + 1) / 2;
+    s.Lines.resize(static_cast<size_t>(pairs) * length);
+    s.Line.resize(length);
+
+    // Gather the padded lines, repeating the edges.
+    for (int j = 0; j < length; ++j)
+    {
+      if (j >= n + 2 * r)
+      {
+        for (int p = 0; p < pairs; ++p)
+        {
+          s.Lines[p * length + j] = Complex(0);
+        }
+        continue;
+      }
+      const T* source = in + offset + std::clamp(j - r, 0, n - 1) * stride;
+      for (int i = 0; i < count; i += 2)
+      {
+        const T im = i + 1 < count ? source[(i + 1) * lineStride] : T(0);
+        s.Lines[(i / 2) * length + j] = Complex(source[i * lineStride], im);
+      }
+    }
+
+    for (int p = 0; p < pairs; ++p)
+    {
+      Complex* line = s.Lines.data() + p * length;
+      forward.Transform(line, s.Line.data());
+      for (int k = 0; k < length; ++k)
+      {
+        s.Line[k] *= spectrum[k];
+      }
+      inverse.Transform(s.Line.data(), line);
+    }
+
+    for (int c = 0; c < n; ++c)
+    {
+      T* target = out + offset + c * stride;
+      for (int i = 0; i < count; i += 2)
+      {
+        const Complex v = s.Lines[(i / 2) * length + c + r];
+        target[i * lineStride] = v.real();
+        if (i + 1 < count)
+        {
+          target[(i + 1) * lineStride] = v.imag();
+        }
+      }
+    }
+  });
+}
+
+// In place 3D FFT of an l[0] x l[1] x l[2] array, one axis at a time.
+template <class T>
+void Transform3D(std::vector<std::complex<T>>& data, const int l[3],
+                 bool inverse)
+{
+  using Complex = std::complex<T>;
+  struct Scratch
+  {
+    std::vector<Complex> Lines;
+    std::vector<Complex> Spectra;
+  };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    const int length = l[axis];
+    if (length == 1)
+    {
+      continue;
+    }
+    const vtkIdType stride = AxisStride(l, axis);
+    FFTPlan<T> plan(length, inverse);
+    vtkSMPThreadLocal<Scratch> scratch;
+    ForEachLineGroup(l, axis, 16, [&](vtkIdType offset, int count,
+                                      vtkIdType lineStride) {
+      Scratch& s = scratch.Local();
+      s.Lines.resize(static_cast<size_t>(count) * length);
+      s.Spectra.resize(s.Lines.size());
+      for (int j = 0; j < length; ++j)
+      {
+        const Complex* source = data.data() + offset + j * stride;
+        for (int i = 0; i < count; ++i)
+        {
+          s.Lines[i * length + j] = source[i * lineStride];
+        }
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        plan.Transform(s.Lines.data() + i * length,
+                       s.Spectra.data() + i * length);
+      }
+      for (int j = 0; j < length; ++j)
+      {
+        Complex* target = data.data() + offset + j * stride;
+        for (int i = 0; i < count; ++i)
+        {
+          target[i * lineStride] = s.Spectra[i * length + j];
+        }
+      }
+    });
+  }
+}
+
+// Correlation with a 3D FFT of the padded image and the flipped kernel.
+template <class T>
+void CorrelateFFT(const T* in, T* out, const int dims[3], const int size[3],
+                  const std::vector<double>& kernel)
+{
+  using Complex = std::complex<T>;
+  int r[3];
+  int l[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    r[i] = size[i] / 2;
+    l[i] = NiceSize(dims[i] + 2 * r[i]);
+  }
+  const vtkIdType lx = l[0];
+  const vtkIdType lxy = lx * l[1];
+  const vtkIdType nx = dims[0];
+  const vtkIdType nxy = nx * dims[1];
+  std::vector<Complex> data(lxy * l[2]);
+  std::vector<Complex> spectrum(data.size());
+
+  vtkSMPTools::For(0, l[2], [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType k = begin; k < end; ++k)
+    {
+      Complex* slice = data.data() + k * lxy;
+      for (int j = 0; j < l[1]; ++j)
+      {
+        for (int i = 0; i < l[0]; ++i)
+        {
+          T value = 0;
+          if (i < dims[0] + 2 * r[0] && j < dims[1] + 2 * r[1] &&
+              k < dims[2] + 2 * r[2])
+          {
+            value = in[std::clamp(static_cast<int>(k) - r[2], 0,
+                                  dims[2] - 1) *
+                           nxy +
+                       std::clamp(j - r[1], 0, dims[1] - 1) * nx +
+                       std::clamp(i - r[0], 0, dims[0] - 1)];
+          }
+          slice[j * lx + i] = Complex(value);
+        }
+      }
+    }
+  });
+  // Scaled for the inverse transform.
+  const double scale = 1.0 / (lxy * l[2]);
+  for (int k = 0; k < size[2]; ++k)
+  {
+    for (int j = 0; j < size[1]; ++j)
+    {
+      for (int i = 0; i < size[0]; ++i)
+      {
+        const vtkIdType index = ((r[2] - k + l[2]) % l[2]) * lxy +
+            ((r[1] - j + l[1]) % l[1]) * lx + (r[0] - i + l[0]) % l[0];
+        spectrum[index] = Complex(
+            static_cast<T>(scale * kernel[(k * size[1] + j) * size[0] + i]));
+      }
+    }
+  }
+
+  Transform3D(data, l, false);
+  Transform3D(spectrum, l, false);
+  vtkSMPTools::For(0, data.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      data[i] *= spectrum[i];
+    }
+  });
+  Transform3D(data, l, true);
+
+  vtkSMPTools::For(0, dims[2], [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType z = begin; z < end; ++z)
+    {
+      for (int y = 0; y < dims[1]; ++y)
+      {
+        const Complex* source =
+            data.data() + (z + r[2]) * lxy + (y + r[1]) * lx + r[0];
+        T* target = out + z * nxy + y * nx;
+        for (int x = 0; x < dims[0]; ++x)
+        {
+          target[x] = source[x].real();
+        }
+      }
+    }
+  });
+}
+
+void FastImageConvolution::SetKernel(const int size[3], const double* kernel)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    if (size[i] < 1 || size[i] % 2 == 0)
+    {
+      vtkErrorMacro(<< "The kernel sizes must be odd.");
+      return;
+    }
+  }
+  std::copy(size, size + 3, this->KernelSize);
+  const vtkIdType n = static_cast<vtkIdType>(size[0]) * size[1] * size[2];
+  this->Kernel.assign(kernel, kernel + n);
+  this->NumberOfTaps =
+      std::count_if(kernel, kernel + n, [](double w) { return w != 0.0; });
+
+  // If w = a b c, then a(i) = w(i, j0, k0), b(j) = w(i0, j, k0) / w(i0,
+  // j0, k0) and c(k) = w(i0, j0, k) / w(i0, j0, k0) for any (i0, j0, k0)
+  // with a nonzero tap. The largest tap is used.
+  auto w = [&](int i, int j, int k) {
+    return kernel[(static_cast<vtkIdType>(k) * size[1] + j) * size[0] + i];
+  };
+  const vtkIdType largest =
+      std::max_element(kernel, kernel + n,
+                       [](double a, double b) {
+                         return std::abs(a) < std::abs(b);
+                       }) -
+      kernel;
+  const int i0 = static_cast<int>(largest % size[0]);
+  const int j0 = static_cast<int>((largest / size[0]) % size[1]);
+  const int k0 = static_cast<int>(largest / (size[0] * size[1]));
+  const double pivot = kernel[largest] != 0.0 ? kernel[largest] : 1.0;
+  for (int i = 0; i < 3; ++i)
+  {
+    this->Factors[i].resize(size[i]);
+  }
+  for (int i = 0; i < size[0]; ++i)
+  {
+    this->Factors[0][i] = w(i, j0, k0);
+  }
+  for (int j = 0; j < size[1]; ++j)
+  {
+    this->Factors[1][j] = w(i0, j, k0) / pivot;
+  }
+  for (int k = 0; k < size[2]; ++k)
+  {
+    this->Factors[2][k] = w(i0, j0, k) / pivot;
+  }
+  const double tolerance = 1e-6 * std::abs(pivot);
+  this->Separable = true;
+  for (int k = 0; k < size[2] && this->Separable; ++k)
+  {
+    for (int j = 0; j < size[1] && this->Separable; ++j)
+    {
+      for (int i = 0; i < size[0]; ++i)
+      {
+        double product =
+            this->Factors[0][i] * this->Factors[1][j] * this->Factors[2][k];
+        if (std::abs(w(i, j, k) - product) > tolerance)
+        {
+          this->Separable = false;
+          break;
+        }
+      }
+    }
+  }
+  this->Modified();
+}
+
+int FastImageConvolution::GetAutomaticMethod()
+{
+  if (this->Separable)
+  {
+    int longest = *std::max_element(this->KernelSize, this->KernelSize + 3);
+    return longest >= this->SeparableFFTKernelLength ? SEPARABLE_FFT
+                                                     : SEPARABLE;
+  }
+  return this->NumberOfTaps >= this->DenseFFTNumberOfTaps ? FFT : DENSE;
+}
+
+const char* FastImageConvolution::GetMethodAsString(int method)
+{
+  switch (method)
+  {
+  case SEPARABLE:
+    return "separable";
+  case SEPARABLE_FFT:
+    return "separable FFT";
+  case DENSE:
+    return "dense";
+  case FFT:
+    return "FFT";
+  default:
+    return "automatic";
+  }
+}
+
+int FastImageConvolution::RequestUpdateExtent(
+    vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector,
+    vtkInformationVector* vtkNotUsed(outputVector))
+{
+  // The edges are repeated from the whole image.
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  int extent[6];
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent, 6);
+  return 1;
+}
+
+int FastImageConvolution::RequestData(vtkInformation* vtkNotUsed(request),
+                                      vtkInformationVector** inputVector,
+                                      vtkInformationVector* outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  vtkImageData* output = vtkImageData::GetData(outputVector);
+  if (input->GetNumberOfScalarComponents() != 1)
+  {
+    vtkErrorMacro(<< "Only single component images are supported.");
+    return 0;
+  }
+
+  int method = this->Method;
+  if (method == AUTOMATIC)
+  {
+    method = this->GetAutomaticMethod();
+  }
+  else if ((method == SEPARABLE || method == SEPARABLE_FFT) &&
+           !this->Separable)
+  {
+    vtkErrorMacro(<< "The kernel is not separable.");
+    return 0;
+  }
+
+  output->SetExtent(input->GetExtent());
+  output->AllocateScalars(input->GetScalarType(), 1);
+  switch (input->GetScalarType())
+  {
+  case VTK_FLOAT:
+    this->Execute<float>(input, output, method);
+    break;
+  case VTK_DOUBLE:
+    this->Execute<double>(input, output, method);
+    break;
+  default:
+    vtkErrorMacro(<< "Only float and double images are supported.");
+    return 0;
+  }
+  this->LastMethod = method;
+  return 1;
+}
+
+template <class T>
+void FastImageConvolution::Execute(vtkImageData* input, vtkImageData* output,
+                                   int method)
+{
+  int dims[3];
+  input->GetDimensions(dims);
+  const T* in = static_cast<T*>(input->GetScalarPointer());
+  T* out = static_cast<T*>(output->GetScalarPointer());
+
+  if (method == DENSE)
+  {
+    CorrelateDirect(in, out, dims, this->KernelSize, this->Kernel);
+    return;
+  }
+  if (method == FFT)
+  {
+    CorrelateFFT(in, out, dims, this->KernelSize, this->Kernel);
+    return;
+  }
+
+  // One pass per axis, skipping the identities, alternating between out
+  // and a buffer so that the last pass writes out.
+  std::vector<int> axes;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (this->KernelSize[axis] > 1 || this->Factors[axis][0] != 1.0)
+    {
+      axes.push_back(axis);
+    }
+  }
+  if (axes.empty())
+  {
+    std::copy(in, in + input->GetNumberOfPoints(), out);
+    return;
+  }
+  std::vector<T> buffer(axes.size() > 1 ? input->GetNumberOfPoints() : 0);
+  const T* source = in;
+  for (size_t pass = 0; pass < axes.size(); ++pass)
+  {
+    T* target = (axes.size() - pass) % 2 == 1 ? out : buffer.data();
+    const int axis = axes[pass];
+    const std::vector<double>& weights = this->Factors[axis];
+    if (method == SEPARABLE_FFT && weights.size() > 1)
+    {
+      CorrelateAxisFFT(source, target, dims, axis, weights);
+    }
+    else
+    {
+      int size[3] = {1, 1, 1};
+      size[axis] = static_cast<int>(weights.size());
+      CorrelateDirect(source, target, dims, size, weights);
+    }
+    source = target;
+  }
+}
+
+void MakeVolume(int size, vtkImageData* image)
+{
+  image->SetDimensions(size, size, size);
+  image->AllocateScalars(VTK_FLOAT, 1);
+  auto values = static_cast<float*>(image->GetScalarPointer());
+  vtkSMPTools::For(0, size, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType z = begin; z < end; ++z)
+    {
+      float* v = values + z * size * size;
+      for (int y = 0; y < size; ++y)
+      {
+        for (int x = 0; x < size; ++x)
+        {
+          // Smooth structure and some noise, in [0, 1].
+          auto h = static_cast<unsigned int>((z * size + y) * size + x) *
+              2654435761u;
+          *v++ = 0.4f + 0.3f * std::sin(0.2f * x) * std::cos(0.15f * y) +
+              0.2f * std::sin(0.1f * z) + 0.1f * (h >> 24) / 255.0f;
+        }
+      }
+    }
+  });
+}
+
+std::vector<double> GaussianKernel(int radius)
+{
+  const int length = 2 * radius + 1;
+  const double sigma = std::max(radius / 3.0, 0.5);
+  std::vector<double> g(length);
+  double sum = 0.0;
+  for (int t = 0; t < length; ++t)
+  {
+    g[t] = std::exp(-0.5 * (t - radius) * (t - radius) / (sigma * sigma));
+    sum += g[t];
+  }
+  std::vector<double> kernel;
+  kernel.reserve(length * length * length);
+  for (int k = 0; k < length; ++k)
+  {
+    for (int j = 0; j < length; ++j)
+    {
+      for (int i = 0; i < length; ++i)
+      {
+        kernel.push_back(g[i] * g[j] * g[k] / (sum * sum * sum));
+      }
+    }
+  }
+  return kernel;
+}
+
+std::vector<double> BallKernel(int radius)
+{
+  const int length = 2 * radius + 1;
+  std::vector<double> kernel;
+  kernel.reserve(length * length * length);
+  double taps = 0.0;
+  for (int k = -radius; k <= radius; ++k)
+  {
+    for (int j = -radius; j <= radius; ++j)
+    {
+      for (int i = -radius; i <= radius; ++i)
+      {
+        bool inside = i * i + j * j + k * k <= radius * radius;
+        kernel.push_back(inside ? 1.0 : 0.0);
+        taps += inside;
+      }
+    }
+  }
+  for (auto& w : kernel)
+  {
+    w /= taps;
+  }
+  return kernel;
+}
+
+double Convolve(FastImageConvolution* filter, vtkImageData* input,
+                int method, vtkImageData* output)
+{
+  vtkNew<vtkTimerLog> timer;
+  filter->SetInputData(input);
+  filter->SetMethod(method);
+  timer->StartTimer();
+  filter->Update();
+  timer->StopTimer();
+  output->DeepCopy(filter->GetOutput());
+  return timer->GetElapsedTime();
+}
+
+double MaxDifference(vtkImageData* a, vtkImageData* b)
+{
+  auto x = static_cast<float*>(a->GetScalarPointer());
+  auto y = static_cast<float*>(b->GetScalarPointer());
+  double difference = 0.0;
+  for (vtkIdType i = 0; i < a->GetNumberOfPoints(); ++i)
+  {
+    difference = std::max(difference, std::abs(double(x[i]) - y[i]));
+  }
+  return difference;
+}
+
+bool CompareWithImageConvolve()
+{
+  vtkNew<vtkImageData> volume;
+  MakeVolume(24, volume);
+
+  // A separable binomial kernel and a 7 point stencil, which is not.
+  double binomial[27];
+  double stencil[27] = {};
+  const double b[3] = {0.25, 0.5, 0.25};
+  for (int k = 0; k < 3; ++k)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        binomial[(k * 3 + j) * 3 + i] = b[i] * b[j] * b[k];
+      }
+    }
+  }
+  stencil[13] = 0.4;
+  for (int i : {4, 10, 12, 14, 16, 22})
+  {
+    stencil[i] = 0.1;
+  }
+
+  bool ok = true;
+  const int size[3] = {3, 3, 3};
+  for (double* kernel : {binomial, stencil})
+  {
+    vtkNew<vtkImageConvolve> convolve;
+    convolve->SetInputData(volume);
+    convolve->SetKernel3x3x3(kernel);
+    convolve->Update();
+
+    vtkNew<FastImageConvolution> filter;
+    filter->SetInputData(volume);
+    filter->SetKernel(size, kernel);
+    for (int method : {FastImageConvolution::AUTOMATIC,
+                       FastImageConvolution::SEPARABLE_FFT,
+                       FastImageConvolution::DENSE, FastImageConvolution::FFT})
+    {
+      if (method == FastImageConvolution::SEPARABLE_FFT &&
+          !filter->GetKernelIsSeparable())
+      {
+        continue;
+      }
+      filter->SetMethod(method);
+      filter->Update();
+      double difference = 0.0;
+      for (int z = 1; z < 23; ++z)
+      {
+        for (int y = 1; y < 23; ++y)
+        {
+          for (int x = 1; x < 23; ++x)
+          {
+            difference = std::max(
+                difference,
+                std::abs(convolve->GetOutput()->GetScalarComponentAsDouble(
+                             x, y, z, 0) -
+                         filter->GetOutput()->GetScalarComponentAsDouble(
+                             x, y, z, 0)));
+          }
+        }
+      }
+      if (difference > 1e-5)
+      {
+        std::cout << "vtkImageConvolve and the "
+                  << FastImageConvolution::GetMethodAsString(
+                         filter->GetLastMethod())
+                  << " method differ by " << difference << std::endl;
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+
+void Calibrate(FastImageConvolution* filter, int separableCrossover,
+               int largestLength, vtkIdType denseCrossover,
+               vtkIdType largestDenseTaps)
+{
+  filter->SetSeparableFFTKernelLength(
+      separableCrossover ? separableCrossover : largestLength + 1);
+  if (denseCrossover)
+  {
+    filter->SetDenseFFTNumberOfTaps(denseCrossover);
+  }
+  else if (largestDenseTaps)
+  {
+    filter->SetDenseFFTNumberOfTaps(largestDenseTaps + 1);
+  }
+}
+} // namespace
@@ -0,0 +1,635 @@
+#include <vtkDataSetAttributes.h>
+#include <vtkImageAccumulate.h>
+#include <vtkImageAlgorithm.h>
+#include <vtkImageData.h>
+#include <vtkImageExtractComponents.h>
+#include <vtkImageStencilData.h>
+#include <vtkImplicitFunctionToImageStencil.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphere.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+/**
+ * One histogram per scalar component, computed in a single pass over the
+ * image. Bin i of every component counts the values in
+ * [BinOrigin + i * BinSpacing, BinOrigin + (i + 1) * BinSpacing), as
+ * vtkImageAccumulate does; values outside of the bins are not counted.
+ *
+ * The output is a NumberOfBins x NumberOfComponents image of vtkIdType.
+ * Rows are counted in parallel into per-thread bin arrays that are merged at
+ * the end. 8 and 16 bit types are counted directly by value (256 or 65536
+ * counters per component), and the counts are binned only once, when the
+ * output is generated.
+ *
+ * An optional vtkImageStencilData on port 1 restricts the voxels counted.
+ *
+ * Incremental updates: call InvalidateExtent() with the extent that is
+ * about to change *before* changing the input values, then modify the input
+ * and update. The counts of the old values are removed and only the changed
+ * extents are counted again. If anything else changes (bins, input
+ * structure, stencil) or the input is modified without InvalidateExtent(),
+ * the next update counts the whole image.
+ */
+class MultiComponentHistogram : public vtkImageAlgorithm
+{
+public:
+  static MultiComponentHistogram* New();
+  vtkTypeMacro(MultiComponentHistogram, vtkImageAlgorithm);
+
+  vtkSetClampMacro(NumberOfBins, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfBins, int);
+  vtkSetMacro(BinOrigin, double);
+  vtkGetMacro(BinOrigin, double);
+  vtkSetMacro(BinSpacing, double);
+  vtkGetMacro(BinSpacing, double);
+
+  void SetStencilData(vtkImageStencilData* stencil)
+  {
+    this->SetInputData(1, stencil);
+  }
+
+  void InvalidateExtent(const int extent[6]);
+
+  // Whether the last execution only counted the invalidated extents.
+  vtkGetMacro(LastUpdateWasIncremental, bool);
+
+  // The histogram of a component in the output.
+  vtkIdType* GetHistogram(int component)
+  {
+    return static_cast<vtkIdType*>(
+               this->GetOutput()->GetScalarPointer()) +
+        component * this->NumberOfBins;
+  }
+
+protected:
+  MultiComponentHistogram()
+  {
+    this->SetNumberOfInputPorts(2);
+  }
+  ~MultiComponentHistogram() override = default;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestInformation(vtkInformation*, vtkInformationVector**,
+                         vtkInformationVector*) override;
+  int RequestUpdateExtent(vtkInformation*, vtkInformationVector**,
+                          vtkInformationVector*) override;
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  // Add (sign = 1) or remove (sign = -1) the values in extent to Counts.
+  void Count(vtkImageData* input, vtkImageStencilData* stencil,
+             const int extent[6], vtkIdType sign);
+
+  int NumberOfBins = 256;
+  double BinOrigin = 0.0;
+  double BinSpacing = 1.0;
+  bool LastUpdateWasIncremental = false;
+
+  // Counts per component, by value for 8 and 16 bit types, by bin otherwise.
+  std::vector<vtkIdType> Counts;
+  vtkIdType CountsPerComponent = 0;
+  // What Counts was computed from.
+  vtkImageData* CountedInput = nullptr;
+  int CountedExtent[6] = {0, -1, 0, -1, 0, -1};
+  int CountedScalarType = VTK_VOID;
+  int CountedComponents = 0;
+  vtkTimeStamp CountTime;
+  std::vector<std::vector<int>> PendingExtents;
+
+private:
+  MultiComponentHistogram(const MultiComponentHistogram&) = delete;
+  void operator=(const MultiComponentHistogram&) = delete;
+};
+
+vtkStandardNewMacro(MultiComponentHistogram);
+
+void MakeVolume(int size, vtkImageData* image);
+void MakeRGBImage(int width, int height, vtkImageData* image);
+
+// The current approach: one vtkImageAccumulate (after a
+// vtkImageExtractComponents for multi-component images) per component.
+std::vector<std::vector<vtkIdType>>
+PerComponentHistograms(vtkImageData* image, int numberOfBins, double origin,
+                       double spacing, vtkImageStencilData* stencil);
+
+bool SameHistograms(MultiComponentHistogram* histogram,
+                    const std::vector<std::vector<vtkIdType>>& expected);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Defaults are small; 512 7680 4320 gives 512^3 and 8K.
+  int volumeSize = 128;
+  int width = 1920;
+  int height = 1080;
+  if (argc > 3)
+  {
+    volumeSize = std::stoi(argv[1]);
+    width = std::stoi(argv[2]);
+    height = std::stoi(argv[3]);
+  }
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+
+  bool ok = true;
+  vtkNew<vtkTimerLog> timer;
+  auto report = [](const char* name, double megaBytes, double seconds) {
+    std::cout << "  " << std::left << std::setw(26) << name << std::right
+              << std::setw(10) << megaBytes / seconds << " MB/s" << std::endl;
+  };
+
+  struct Case
+  {
+    std::string Name;
+    vtkSmartPointer<vtkImageData> Image;
+    int NumberOfBins;
+    double Origin;
+    double Spacing;
+  };
+  std::vector<Case> cases(2);
+  cases[0].Name = std::to_string(volumeSize) + "^3 short volume";
+  cases[0].Image = vtkSmartPointer<vtkImageData>::New();
+  MakeVolume(volumeSize, cases[0].Image);
+  cases[0].NumberOfBins = 1024;
+  cases[0].Origin = -1024.0;
+  cases[0].Spacing = 4.0;
+  cases[1].Name = std::to_string(width) + "x" + std::to_string(height) +
+      " RGB image";
+  cases[1].Image = vtkSmartPointer<vtkImageData>::New();
+  MakeRGBImage(width, height, cases[1].Image);
+  cases[1].NumberOfBins = 256;
+  cases[1].Origin = 0.0;
+  cases[1].Spacing = 1.0;
+
+  for (auto& c : cases)
+  {
+    vtkImageData* image = c.Image;
+    double megaBytes = image->GetNumberOfPoints() *
+        image->GetNumberOfScalarComponents() * image->GetScalarSize() / 1e6;
+    std::cout << c.Name << " (" << megaBytes << " MB)" << std::endl;
+
+    timer->StartTimer();
+    auto expected = PerComponentHistograms(image, c.NumberOfBins, c.Origin,
+                                           c.Spacing, nullptr);
+    timer->StopTimer();
+    report("Per component pipeline", megaBytes, timer->GetElapsedTime());
+
+    vtkNew<MultiComponentHistogram> histogram;
+    histogram->SetInputData(image);
+    histogram->SetNumberOfBins(c.NumberOfBins);
+    histogram->SetBinOrigin(c.Origin);
+    histogram->SetBinSpacing(c.Spacing);
+    timer->StartTimer();
+    histogram->Update();
+    timer->StopTimer();
+    report("Single pass", megaBytes, timer->GetElapsedTime());
+    bool same = SameHistograms(histogram, expected);
+
+    // Change a block and update incrementally.
+    int* whole = image->GetExtent();
+    int block[6];
+    for (int i = 0; i < 3; ++i)
+    {
+      int n = whole[2 * i + 1] - whole[2 * i] + 1;
+      int size = std::max(n / 8, 1);
+      block[2 * i] = whole[2 * i] + (n > 1 ? size : 0);
+      block[2 * i + 1] = std::min(block[2 * i] + size - 1, whole[2 * i + 1]);
+    }
+    histogram->InvalidateExtent(block);
+    for (int z = block[4]; z <= block[5]; ++z)
+    {
+      for (int y = block[2]; y <= block[3]; ++y)
+      {
+        for (int x = block[0]; x <= block[1]; ++x)
+        {
+          for (int k = 0; k < image->GetNumberOfScalarComponents(); ++k)
+          {
+            image->SetScalarComponentFromDouble(x, y, z, k, (x + y) % 200);
+          }
+        }
+      }
+    }
+    image->Modified();
+    timer->StartTimer();
+    histogram->Update();
+    timer->StopTimer();
+    std::cout << "  Incremental update       " << std::setw(10)
+              << 1000.0 * timer->GetElapsedTime() << " ms"
+              << (histogram->GetLastUpdateWasIncremental() ? ""
+                                                           : " (full pass)")
+              << std::endl;
+    expected = PerComponentHistograms(image, c.NumberOfBins, c.Origin,
+                                      c.Spacing, nullptr);
+    same = same && histogram->GetLastUpdateWasIncremental() &&
+        SameHistograms(histogram, expected);
+
+    // Restrict to a sphere.
+    vtkNew<vtkSphere> sphere;
+    double bounds[6];
+    image->GetBounds(bounds);
+    sphere->SetCenter(0.5 * (bounds[0] + bounds[1]),
+                      0.5 * (bounds[2] + bounds[3]),
+                      0.5 * (bounds[4] + bounds[5]));
+    sphere->SetRadius(0.4 * (bounds[1] - bounds[0]));
+    vtkNew<vtkImplicitFunctionToImageStencil> toStencil;
+    toStencil->SetInput(sphere);
+    toStencil->SetOutputOrigin(image->GetOrigin());
+    toStencil->SetOutputSpacing(image->GetSpacing());
+    toStencil->SetOutputWholeExtent(image->GetExtent());
+    toStencil->Update();
+    histogram->SetStencilData(toStencil->GetOutput());
+    timer->StartTimer();
+    histogram->Update();
+    timer->StopTimer();
+    report("Single pass, stencil", megaBytes, timer->GetElapsedTime());
+    expected = PerComponentHistograms(image, c.NumberOfBins, c.Origin,
+                                      c.Spacing, toStencil->GetOutput());
+    same = same && SameHistograms(histogram, expected);
+
+    std::cout << "  histograms " << (same ? "match" : "DIFFER") << std::endl;
+    ok = ok && same;
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+int MultiComponentHistogram::FillInputPortInformation(int port,
+                                                      vtkInformation* info)
+{
+  if (port == 1)
+  {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageStencilData");
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    return 1;
+  }
+  return this->Superclass::FillInputPortInformation(port, info);
+}
+
+int MultiComponentHistogram::RequestInformation(
+    vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector)
+{
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  int components = 1;
+  vtkInformation* scalarInfo = vtkDataObject::GetActiveFieldInformation(
+      inInfo, vtkDataObject::FIELD_ASSOCIATION_POINTS,
+      vtkDataSetAttributes::SCALARS);
+  if (scalarInfo &&
+      scalarInfo->Has(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS()))
+  {
+    components = scalarInfo->Get(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS());
+  }
+  int extent[6] = {0, this->NumberOfBins - 1, 0, components - 1, 0, 0};
+  double origin[3] = {this->BinOrigin, 0.0, 0.0};
+  double spacing[3] = {this->BinSpacing, 1.0, 1.0};
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent, 6);
+  outInfo->Set(vtkDataObject::ORIGIN(), origin, 3);
+  outInfo->Set(vtkDataObject::SPACING(), spacing, 3);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_ID_TYPE, 1);
+  return 1;
+}
+
+int MultiComponentHistogram::RequestUpdateExtent(
+    vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector,
+    vtkInformationVector* vtkNotUsed(outputVector))
+{
+  // The histogram always needs the whole input.
+  for (int port = 0; port < 2; ++port)
+  {
+    vtkInformation* inInfo = inputVector[port]->GetInformationObject(0);
+    if (inInfo)
+    {
+      int extent[6];
+      inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
+      inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent,
+                  6);
+    }
+  }
+  return 1;
+}
+
+// Counting by value for 8 and 16 bit types.
+template <class T>
+constexpr bool CountByValue()
+{
+  return std::is_integral<T>::value && sizeof(T) <= 2;
+}
+
+template <class T>
+vtkIdType NumberOfCounters(int numberOfBins)
+{
+  return CountByValue<T>() ? (sizeof(T) == 1 ? 256 : 65536) : numberOfBins;
+}
+
+template <class T>
+void CountExtent(vtkImageData* input, vtkImageStencilData* stencil,
+                 const int extent[6], int numberOfBins, double origin,
+                 double spacing, vtkIdType sign, std::vector<vtkIdType>& counts)
+{
+  const int components = input->GetNumberOfScalarComponents();
+  const vtkIdType perComponent = NumberOfCounters<T>(numberOfBins);
+  const vtkIdType rowsPerSlice = extent[3] - extent[2] + 1;
+  const vtkIdType numberOfRows = rowsPerSlice * (extent[5] - extent[4] + 1);
+  const T* first = static_cast<T*>(input->GetScalarPointer());
+  int* whole = input->GetExtent();
+  vtkIdType increments[3];
+  input->GetIncrements(increments);
+
+  vtkSMPThreadLocal<std::vector<vtkIdType>> localCounts;
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType begin, vtkIdType end) {
+    std::vector<vtkIdType>& local = localCounts.Local();
+    if (local.empty())
+    {
+      local.assign(components * perComponent, 0);
+    }
+    vtkIdType* c = local.data();
+    auto countSpan = [&](int x0, int x1, int y, int z) {
+      const T* p = first + (x0 - whole[0]) * increments[0] +
+          (y - whole[2]) * increments[1] + (z - whole[4]) * increments[2];
+      const vtkIdType n = x1 - x0 + 1;
+      for (vtkIdType i = 0; i < n; ++i, p += components)
+      {
+        for (int k = 0; k < components; ++k)
+        {
+          if (CountByValue<T>())
+          {
+            // Offset signed types so that the minimum maps to 0.
+            auto index = static_cast<vtkIdType>(p[k]) -
+                static_cast<vtkIdType>(std::numeric_limits<T>::min());
+            ++c[k * perComponent + index];
+          }
+          else
+          {
+            double bin = std::floor((p[k] - origin) / spacing);
+            if (bin >= 0.0 && bin < numberOfBins)
+            {
+              ++c[k * perComponent + static_cast<vtkIdType>(bin)];
+            }
+          }
+        }
+      }
+    };
+    for (vtkIdType row = begin; row < end; ++row)
+    {
+      int y = extent[2] + static_cast<int>(row % rowsPerSlice);
+      int z = extent[4] + static_cast<int>(row / rowsPerSlice);
+      if (!stencil)
+      {
+        countSpan(extent[0], extent[1], y, z);
+        continue;
+      }
+      int iter = 0;
+      int r1, r2;
+      while (stencil->GetNextExtent(r1, r2, extent[0], extent[1], y, z, iter))
+      {
+        countSpan(r1, r2, y, z);
+      }
+    }
+  });
+
+  for (auto& local : localCounts)
+  {
+    for (size_t i = 0; i < local.size(); ++i)
+    {
+      counts[i] += sign * local[i];
+    }
+  }
+}
+
+void MultiComponentHistogram::Count(vtkImageData* input,
+                                    vtkImageStencilData* stencil,
+                                    const int extent[6], vtkIdType sign)
+{
+  switch (input->GetScalarType())
+  {
+    vtkTemplateMacro(CountExtent<VTK_TT>(
+        input, stencil, extent, this->NumberOfBins, this->BinOrigin,
+        this->BinSpacing, sign, this->Counts));
+  }
+}
+
+void MultiComponentHistogram::InvalidateExtent(const int extent[6])
+{
+  vtkImageData* input = vtkImageData::SafeDownCast(this->GetInput());
+  if (!input || input != this->CountedInput ||
+      input->GetMTime() > this->CountTime ||
+      this->Superclass::GetMTime() > this->CountTime)
+  {
+    // Nothing valid to update.
+    return;
+  }
+  std::vector<int> clamped(6);
+  for (int i = 0; i < 6; i += 2)
+  {
+    clamped[i] = std::max(extent[i], this->CountedExtent[i]);
+    clamped[i + 1] = std::min(extent[i + 1], this->CountedExtent[i + 1]);
+    if (clamped[i] > clamped[i + 1])
+    {
+      return;
+    }
+  }
+  auto stencil =
+      vtkImageStencilData::SafeDownCast(this->GetInputDataObject(1, 0));
+  this->Count(input, stencil, clamped.data(), -1);
+  this->PendingExtents.push_back(clamped);
+}
+
+int MultiComponentHistogram::RequestData(vtkInformation* vtkNotUsed(request),
+                                         vtkInformationVector** inputVector,
+                                         vtkInformationVector* outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  vtkImageStencilData* stencil = vtkImageStencilData::GetData(inputVector[1]);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkImageData* output = vtkImageData::GetData(outInfo);
+
+  const int components = input->GetNumberOfScalarComponents();
+  const int scalarType = input->GetScalarType();
+  int* extent = input->GetExtent();
+
+  bool incremental = input == this->CountedInput &&
+      scalarType == this->CountedScalarType &&
+      components == this->CountedComponents &&
+      std::equal(extent, extent + 6, this->CountedExtent) &&
+      this->Superclass::GetMTime() < this->CountTime &&
+      (!stencil || stencil->GetMTime() < this->CountTime) &&
+      !this->PendingExtents.empty();
+  if (incremental)
+  {
+    for (auto& changed : this->PendingExtents)
+    {
+      this->Count(input, stencil, changed.data(), 1);
+    }
+  }
+  else
+  {
+    switch (scalarType)
+    {
+      vtkTemplateMacro(this->CountsPerComponent =
+                           NumberOfCounters<VTK_TT>(this->NumberOfBins));
+    }
+    this->Counts.assign(components * this->CountsPerComponent, 0);
+    this->Count(input, stencil, extent, 1);
+    this->CountedInput = input;
+    this->CountedScalarType = scalarType;
+    this->CountedComponents = components;
+    std::copy(extent, extent + 6, this->CountedExtent);
+  }
+  this->PendingExtents.clear();
+  this->CountTime.Modified();
+  this->LastUpdateWasIncremental = incremental;
+
+  int outExtent[6] = {0, this->NumberOfBins - 1, 0, components - 1, 0, 0};
+  output->SetExtent(outExtent);
+  output->AllocateScalars(VTK_ID_TYPE, 1);
+  auto bins = static_cast<vtkIdType*>(output->GetScalarPointer());
+  std::fill(bins, bins + components * this->NumberOfBins, 0);
+
+  // Bin the counts that were taken by value.
+  bool byValue = false;
+  double minimum = 0.0;
+  switch (scalarType)
+  {
+    vtkTemplateMacro(byValue = CountByValue<VTK_TT>();
+                     minimum = std::numeric_limits<VTK_TT>::min());
+  }
+  for (int k = 0; k < components; ++k)
+  {
+    const vtkIdType* counts =
+        this->Counts.data() + k * this->CountsPerComponent;
+    vtkIdType* out = bins + k * this->NumberOfBins;
+    if (!byValue)
+    {
+      std::copy(counts, counts + this->NumberOfBins, out);
+      continue;
+    }
+    for (vtkIdType v = 0; v < this->CountsPerComponent; ++v)
+    {
+      double bin =
+          std::floor((minimum + v - this->BinOrigin) / this->BinSpacing);
+      if (bin >= 0.0 && bin < this->NumberOfBins)
+      {
+        out[static_cast<vtkIdType>(bin)] += counts[v];
+      }
+    }
+  }
+  return 1;
+}
+
+void MakeVolume(int size, vtkImageData* image)
+{
+  image->SetDimensions(size, size, size);
+  image->AllocateScalars(VTK_SHORT, 1);
+  auto values = static_cast<short*>(image->GetScalarPointer());
+  vtkSMPTools::For(0, size, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType z = begin; z < end; ++z)
+    {
+      short* p = values + z * size * size;
+      for (int y = 0; y < size; ++y)
+      {
+        for (int x = 0; x < size; ++x)
+        {
+          // CT like values between -1024 and 3071.
+          auto h = static_cast<unsigned int>((z * size + y) * size + x) *
+              2654435761u;
+          *p++ = static_cast<short>((x * 7 + y * 3 + z + (h >> 28)) % 4096 -
+                                    1024);
+        }
+      }
+    }
+  });
+}
+
+void MakeRGBImage(int width, int height, vtkImageData* image)
+{
+  image->SetDimensions(width, height, 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  auto pixels = static_cast<unsigned char*>(image->GetScalarPointer());
+  vtkSMPTools::For(0, height, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType y = begin; y < end; ++y)
+    {
+      unsigned char* p = pixels + 3 * y * width;
+      for (int x = 0; x < width; ++x)
+      {
+        *p++ = static_cast<unsigned char>(x);
+        *p++ = static_cast<unsigned char>(y);
+        *p++ = static_cast<unsigned char>((x * y) >> 4);
+      }
+    }
+  });
+}
+
+std::vector<std::vector<vtkIdType>>
+PerComponentHistograms(vtkImageData* image, int numberOfBins, double origin,
+                       double spacing, vtkImageStencilData* stencil)
+{
+  int components = image->GetNumberOfScalarComponents();
+  std::vector<std::vector<vtkIdType>> histograms(components);
+  for (int k = 0; k < components; ++k)
+  {
+    vtkNew<vtkImageExtractComponents> extract;
+    extract->SetInputData(image);
+    extract->SetComponents(k);
+
+    vtkNew<vtkImageAccumulate> accumulate;
+    if (components > 1)
+    {
+      accumulate->SetInputConnection(extract->GetOutputPort());
+    }
+    else
+    {
+      accumulate->SetInputData(image);
+    }
+    accumulate->SetComponentExtent(0, numberOfBins - 1, 0, 0, 0, 0);
+    accumulate->SetComponentOrigin(origin, 0, 0);
+    accumulate->SetComponentSpacing(spacing, 0, 0);
+    if (stencil)
+    {
+      accumulate->SetStencilData(stencil);
+    }
+    accumulate->Update();
+    auto counts = static_cast<vtkIdType*>(
+        accumulate->GetOutput()->GetScalarPointer());
+    histograms[k].assign(counts, counts + numberOfBins);
+  }
+  return histograms;
+}
+
+bool SameHistograms(MultiComponentHistogram* histogram,
+                    const std::vector<std::vector<vtkIdType>>& expected)
+{
+  for (size_t k = 0; k < expected.size(); ++k)
+  {
+    if (!std::equal(expected[k].begin(), expected[k].end(),
+                    histogram->GetHistogram(static_cast<int>(k))))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
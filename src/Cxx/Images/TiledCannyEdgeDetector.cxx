@@ -0,0 +1,980 @@
+#include <vtkCellArray.h>
+#include <vtkGeometryFilter.h>
+#include <vtkImageCast.h>
+#include <vtkImageConstantPad.h>
+#include <vtkImageData.h>
+#include <vtkImageGaussianSmooth.h>
+#include <vtkImageGradient.h>
+#include <vtkImageLuminance.h>
+#include <vtkImageMagnitude.h>
+#include <vtkImageNonMaximumSuppression.h>
+#include <vtkImageToStructuredPoints.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkLinkEdgels.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkStripper.h>
+#include <vtkStructuredPoints.h>
+#include <vtkSubPixelPositionEdgels.h>
+#include <vtkThreshold.h>
+#include <vtkTimerLog.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+/**
+ * Canny edge detection of a 2D image in one filter, producing linked
+ * polylines with subpixel points.
+ *
+ * The image is processed in tiles of TileSize x TileSize pixels, in
+ * parallel. Each tile loads its pixels and a halo (converting RGB to
+ * luminance), then smooths, takes the gradient, suppresses the non maxima
+ * along the gradient and applies the two thresholds in buffers that fit in
+ * cache. Only one byte of state and two bytes of subpixel offset per pixel
+ * are kept for the whole image. Tracing adds a hash map from the edge
+ * pixels to their points, a few tens of bytes per edge pixel.
+ *
+ * Hysteresis is a union-find of the 8-connected candidate pixels: each
+ * tile labels its own components, then the tiles merge their components
+ * along their borders in parallel with a lock free union-find. Components
+ * with a pixel above HighThreshold are kept. The edges are then traced
+ * into polylines, which is serial.
+ */
+class TiledCannyEdgeDetector : public vtkPolyDataAlgorithm
+{
+public:
+  static TiledCannyEdgeDetector* New();
+  vtkTypeMacro(TiledCannyEdgeDetector, vtkPolyDataAlgorithm);
+
+  /**
+   * The Gaussian smoothing, in pixels. The kernel radius is
+   * StandardDeviation * RadiusFactor.
+   */
+  vtkSetClampMacro(StandardDeviation, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(StandardDeviation, double);
+  vtkSetClampMacro(RadiusFactor, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(RadiusFactor, double);
+
+  /**
+   * Gradient magnitudes for the hysteresis: edges are the local maxima
+   * above LowThreshold connected to one above HighThreshold.
+   */
+  vtkSetMacro(LowThreshold, double);
+  vtkGetMacro(LowThreshold, double);
+  vtkSetMacro(HighThreshold, double);
+  vtkGetMacro(HighThreshold, double);
+
+  vtkSetClampMacro(TileSize, int, 8, VTK_INT_MAX);
+  vtkGetMacro(TileSize, int);
+
+  /**
+   * The memory used by the last execution besides the input and output, in
+   * kibibytes.
+   */
+  vtkGetMacro(WorkingMemorySize, vtkIdType);
+
+protected:
+  TiledCannyEdgeDetector() = default;
+  ~TiledCannyEdgeDetector() override = default;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  double StandardDeviation = 2.0;
+  double RadiusFactor = 1.5;
+  double LowThreshold = 2.0;
+  double HighThreshold = 10.0;
+  int TileSize = 128;
+  vtkIdType WorkingMemorySize = 0;
+
+private:
+  TiledCannyEdgeDetector(const TiledCannyEdgeDetector&) = delete;
+  void operator=(const TiledCannyEdgeDetector&) = delete;
+};
+
+vtkStandardNewMacro(TiledCannyEdgeDetector);
+
+// An RGB image of discs on a gradient, with some noise.
+void MakeImage(int size, vtkImageData* image);
+
+// The pipeline of the CannyEdgeDetector example, without the rendering.
+// Returns the time in seconds and the memory held by the pipeline's
+// outputs in MB.
+double RunFilterChain(vtkImageData* image, double& megaBytes,
+                      vtkPolyData* edges);
+
+bool SamePolyData(vtkPolyData* a, vtkPolyData* b);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Defaults are small; 8192 gives an 8K x 8K image.
+  int size = 1024;
+  if (argc > 1)
+  {
+    size = std::stoi(argv[1]);
+  }
+
+  vtkNew<vtkImageData> image;
+  MakeImage(size, image);
+  std::cout << size << " x " << size << " RGB image, SMP backend: "
+            << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  auto report = [](const char* name, double seconds, double megaBytes,
+                   vtkPolyData* edges) {
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(10) << 1000.0 * seconds << " ms" << std::setw(10)
+              << megaBytes << " MB" << std::setw(10)
+              << edges->GetNumberOfLines() << " lines" << std::setw(10)
+              << edges->GetNumberOfPoints() << " points" << std::endl;
+  };
+
+  vtkNew<vtkPolyData> chainEdges;
+  double chainMegaBytes = 0.0;
+  double seconds = RunFilterChain(image, chainMegaBytes, chainEdges);
+  report("Filter chain", seconds, chainMegaBytes, chainEdges);
+
+  vtkNew<vtkTimerLog> timer;
+  vtkNew<TiledCannyEdgeDetector> canny;
+  canny->SetInputData(image);
+  timer->StartTimer();
+  canny->Update();
+  timer->StopTimer();
+  report("Tiled", timer->GetElapsedTime(),
+         (canny->GetWorkingMemorySize() +
+          canny->GetOutput()->GetActualMemorySize()) /
+             1024.0,
+         canny->GetOutput());
+
+  // Tiles of a different size, which are not aligned with the first ones:
+  // the tiles and the merging along their borders must not change the
+  // edges. With one tile, for the smaller images, there is no merging.
+  vtkNew<TiledCannyEdgeDetector> reference;
+  reference->SetInputData(image);
+  reference->SetTileSize(std::min(size, 1000));
+  timer->StartTimer();
+  reference->Update();
+  timer->StopTimer();
+  report(size <= 1000 ? "One tile" : "1000^2 tiles", timer->GetElapsedTime(),
+         (reference->GetWorkingMemorySize() +
+          reference->GetOutput()->GetActualMemorySize()) /
+             1024.0,
+         reference->GetOutput());
+
+  bool ok = SamePolyData(canny->GetOutput(), reference->GetOutput()) &&
+      canny->GetOutput()->GetNumberOfLines() > 0;
+  std::cout << "Edges " << (ok ? "match" : "DIFFER") << std::endl;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+enum PixelState : unsigned char
+{
+  NONE,
+  WEAK,
+  STRONG,
+  EDGE,
+  VISITED
+};
+
+// Subpixel offsets are stored in 1/254 pixels.
+const float OffsetScale = 254.0f;
+
+// The state of the whole image, shared by the tiles.
+struct CannyImage
+{
+  int Width = 0;
+  int Height = 0;
+  std::vector<unsigned char> State;
+  std::vector<signed char> Offsets;
+};
+
+struct CannyTile
+{
+  int X0 = 0;
+  int X1 = 0;
+  int Y0 = 0;
+  int Y1 = 0;
+  int NumberOfComponents = 0;
+  vtkIdType FirstComponent = 0;
+  // The component of each candidate pixel, in raster order.
+  std::vector<int> Labels;
+  // Whether each component has a strong pixel.
+  std::vector<unsigned char> Strong;
+  // The components of the pixels along the borders, or -1.
+  std::vector<int> Top;
+  std::vector<int> Bottom;
+  std::vector<int> Left;
+  std::vector<int> Right;
+};
+
+struct TileScratch
+{
+  std::vector<float> A;
+  std::vector<float> B;
+  std::vector<float> Gx;
+  std::vector<float> Gy;
+  std::vector<float> Magnitude;
+  std::vector<int> Parent;
+  std::vector<int> Label;
+};
+
+int FindRoot(std::vector<int>& parent, int i)
+{
+  while (parent[i] != i)
+  {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+// Lock free union-find: roots are linked to smaller roots with a compare
+// and swap, and paths are halved as they are followed.
+int FindRoot(std::vector<std::atomic<int>>& parent, int i)
+{
+  for (;;)
+  {
+    int p = parent[i].load();
+    if (p == i)
+    {
+      return i;
+    }
+    int grandParent = parent[p].load();
+    if (p != grandParent)
+    {
+      parent[i].compare_exchange_weak(p, grandParent);
+    }
+    i = grandParent;
+  }
+}
+
+void Union(std::vector<std::atomic<int>>& parent, int a, int b)
+{
+  for (;;)
+  {
+    a = FindRoot(parent, a);
+    b = FindRoot(parent, b);
+    if (a == b)
+    {
+      return;
+    }
+    if (a < b)
+    {
+      std::swap(a, b);
+    }
+    int expected = a;
+    if (parent[a].compare_exchange_strong(expected, b))
+    {
+      return;
+    }
+  }
+}
+
+// Smoothing, gradient, non maximum suppression and thresholds of one tile,
+// then the connected components of its candidate pixels.
+template <class T>
+void DetectTile(const T* scalars, int components, const vtkIdType inc[2],
+                const double spacing[2], const std::vector<float>& gaussian,
+                float low, float high, CannyTile& tile, TileScratch& s,
+                CannyImage& image)
+{
+  const int r = static_cast<int>(gaussian.size()) / 2;
+  const int halo = r + 2;
+  const int w = tile.X1 - tile.X0 + 2 * halo;
+  const int h = tile.Y1 - tile.Y0 + 2 * halo;
+  for (auto* buffer : {&s.A, &s.B, &s.Gx, &s.Gy, &s.Magnitude})
+  {
+    buffer->resize(static_cast<size_t>(w) * h);
+  }
+
+  // Load the tile and its halo, repeating the image edges.
+  for (int j = 0; j < h; ++j)
+  {
+    const int y = std::clamp(tile.Y0 - halo + j, 0, image.Height - 1);
+    const T* row = scalars + y * inc[1];
+    float* a = s.A.data() + j * w;
+    for (int i = 0; i < w; ++i)
+    {
+      const int x = std::clamp(tile.X0 - halo + i, 0, image.Width - 1);
+      const T* p = row + x * inc[0];
+      a[i] = components >= 3 ? 0.30f * p[0] + 0.59f * p[1] + 0.11f * p[2]
+                             : static_cast<float>(p[0]);
+    }
+  }
+
+  // Smooth along X then Y, one tap at a time over whole rows. The outer r
+  // pixels of the halo are only inputs.
+  for (int j = 0; j < h; ++j)
+  {
+    const float* a = s.A.data() + j * w;
+    float* b = s.B.data() + j * w;
+    std::fill(b + r, b + w - r, 0.0f);
+    for (int t = 0; t <= 2 * r; ++t)
+    {
+      const float g = gaussian[t];
+      for (int i = r; i < w - r; ++i)
+      {
+        b[i] += g * a[i + t - r];
+      }
+    }
+  }
+  for (int j = r; j < h - r; ++j)
+  {
+    float* a = s.A.data() + j * w;
+    std::fill(a + r, a + w - r, 0.0f);
+    for (int t = 0; t <= 2 * r; ++t)
+    {
+      const float g = gaussian[t];
+      const float* b = s.B.data() + (j + t - r) * w;
+      for (int i = r; i < w - r; ++i)
+      {
+        a[i] += g * b[i];
+      }
+    }
+  }
+
+  // Central differences, as vtkImageGradient.
+  const float sx = static_cast<float>(0.5 / spacing[0]);
+  const float sy = static_cast<float>(0.5 / spacing[1]);
+  for (int j = r + 1; j < h - r - 1; ++j)
+  {
+    const float* a = s.A.data() + j * w;
+    float* gx = s.Gx.data() + j * w;
+    float* gy = s.Gy.data() + j * w;
+    float* m = s.Magnitude.data() + j * w;
+    for (int i = r + 1; i < w - r - 1; ++i)
+    {
+      gx[i] = sx * (a[i + 1] - a[i - 1]);
+      gy[i] = sy * (a[i + w] - a[i - w]);
+      m[i] = std::sqrt(gx[i] * gx[i] + gy[i] * gy[i]);
+    }
+  }
+
+  // Keep the maxima along the gradient, quantized to one of four
+  // directions, and fit a parabola through the three magnitudes for the
+  // subpixel position.
+  const int tw = tile.X1 - tile.X0;
+  const int th = tile.Y1 - tile.Y0;
+  for (int j = 0; j < th; ++j)
+  {
+    const vtkIdType pixel =
+        static_cast<vtkIdType>(tile.Y0 + j) * image.Width + tile.X0;
+    unsigned char* state = image.State.data() + pixel;
+    signed char* offsets = image.Offsets.data() + 2 * pixel;
+    for (int i = 0; i < tw; ++i)
+    {
+      const int k = (j + halo) * w + i + halo;
+      const float m = s.Magnitude[k];
+      state[i] = NONE;
+      if (m < low)
+      {
+        continue;
+      }
+      const float gx = s.Gx[k];
+      const float gy = s.Gy[k];
+      int dx = 1;
+      int dy = 0;
+      if (std::abs(gy) > 0.4142f * std::abs(gx))
+      {
+        dx = std::abs(gx) > 0.4142f * std::abs(gy) ? (gx * gy > 0 ? 1 : -1)
+                                                   : 0;
+        dy = 1;
+      }
+      const float forward = s.Magnitude[k + dy * w + dx];
+      const float backward = s.Magnitude[k - dy * w - dx];
+      if (!(m > forward && m >= backward))
+      {
+        continue;
+      }
+      const float curvature = backward - 2.0f * m + forward;
+      const float t = curvature < 0.0f
+          ? std::clamp(0.5f * (backward - forward) / curvature, -0.5f, 0.5f)
+          : 0.0f;
+      state[i] = m >= high ? STRONG : WEAK;
+      offsets[2 * i] = static_cast<signed char>(std::lround(t * dx *
+                                                            OffsetScale));
+      offsets[2 * i + 1] =
+          static_cast<signed char>(std::lround(t * dy * OffsetScale));
+    }
+  }
+
+  // The 8-connected components of the candidates in the tile.
+  s.Parent.assign(static_cast<size_t>(tw) * th, -1);
+  auto candidate = [&](int i, int j) {
+    return i >= 0 && i < tw && j >= 0 && s.Parent[j * tw + i] >= 0;
+  };
+  for (int j = 0; j < th; ++j)
+  {
+    const unsigned char* state =
+        image.State.data() + static_cast<vtkIdType>(tile.Y0 + j) * image.Width +
+        tile.X0;
+    for (int i = 0; i < tw; ++i)
+    {
+      if (state[i] == NONE)
+      {
+        continue;
+      }
+      const int k = j * tw + i;
+      s.Parent[k] = k;
+      const int previous[4][2] = {{i - 1, j}, {i - 1, j - 1}, {i, j - 1},
+                                  {i + 1, j - 1}};
+      for (const auto& n : previous)
+      {
+        if (candidate(n[0], n[1]))
+        {
+          int a = FindRoot(s.Parent, k);
+          int b = FindRoot(s.Parent, n[1] * tw + n[0]);
+          s.Parent[std::max(a, b)] = std::min(a, b);
+        }
+      }
+    }
+  }
+
+  // Number the components in raster order.
+  tile.Labels.clear();
+  tile.Strong.clear();
+  tile.Top.assign(tw, -1);
+  tile.Bottom.assign(tw, -1);
+  tile.Left.assign(th, -1);
+  tile.Right.assign(th, -1);
+  s.Label.assign(s.Parent.size(), -1);
+  for (int j = 0; j < th; ++j)
+  {
+    const unsigned char* state =
+        image.State.data() + static_cast<vtkIdType>(tile.Y0 + j) * image.Width +
+        tile.X0;
+    for (int i = 0; i < tw; ++i)
+    {
+      if (state[i] == NONE)
+      {
+        continue;
+      }
+      int& c = s.Label[FindRoot(s.Parent, j * tw + i)];
+      if (c < 0)
+      {
+        c = static_cast<int>(tile.Strong.size());
+        tile.Strong.push_back(0);
+      }
+      tile.Labels.push_back(c);
+      tile.Strong[c] |= state[i] == STRONG;
+      if (j == 0)
+      {
+        tile.Top[i] = c;
+      }
+      if (j == th - 1)
+      {
+        tile.Bottom[i] = c;
+      }
+      if (i == 0)
+      {
+        tile.Left[j] = c;
+      }
+      if (i == tw - 1)
+      {
+        tile.Right[j] = c;
+      }
+    }
+  }
+  tile.NumberOfComponents = static_cast<int>(tile.Strong.size());
+}
+
+// Trace the EDGE pixels into polylines. Chains start at the end points,
+// then anywhere on the remaining pixels (branches and loops); they follow
+// the 4-connected neighbors first. A chain that starts next to a traced
+// pixel starts from that pixel, and shares its point, so that the branches
+// stay connected. Returns the bytes used by the map from the traced pixels
+// to their points.
+vtkIdType TraceEdges(CannyImage& image, const double origin[3],
+                     const double spacing[3], vtkPolyData* output)
+{
+  const int w = image.Width;
+  const int h = image.Height;
+  const int dx[8] = {1, 0, -1, 0, 1, -1, -1, 1};
+  const int dy[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+  auto neighbor = [&](vtkIdType p, int n, unsigned char mask) -> vtkIdType {
+    const int x = static_cast<int>(p % w) + dx[n];
+    const int y = static_cast<int>(p / w) + dy[n];
+    if (x < 0 || x >= w || y < 0 || y >= h)
+    {
+      return -1;
+    }
+    const vtkIdType q = static_cast<vtkIdType>(y) * w + x;
+    return (1 << image.State[q]) & mask ? q : -1;
+  };
+  const unsigned char edge = 1 << EDGE;
+  const unsigned char traced = 1 << VISITED;
+  const vtkIdType numberOfPixels = static_cast<vtkIdType>(w) * h;
+
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> lines;
+  std::vector<vtkIdType> chain;
+  // The point of each traced pixel. Only the edge pixels are keyed, so the
+  // map grows with the length of the edges, not with the image.
+  std::unordered_map<vtkIdType, vtkIdType> pointIds;
+  auto addPoint = [&](vtkIdType p) {
+    auto inserted = pointIds.emplace(p, 0);
+    if (inserted.second)
+    {
+      const double x = p % w + image.Offsets[2 * p] / OffsetScale;
+      const double y = p / w + image.Offsets[2 * p + 1] / OffsetScale;
+      inserted.first->second = points->InsertNextPoint(
+          origin[0] + spacing[0] * x, origin[1] + spacing[1] * y, origin[2]);
+    }
+    chain.push_back(inserted.first->second);
+  };
+  auto trace = [&](vtkIdType start) {
+    chain.clear();
+    for (int n = 0; n < 8; ++n)
+    {
+      vtkIdType q = neighbor(start, n, traced);
+      if (q >= 0)
+      {
+        addPoint(q);
+        break;
+      }
+    }
+    vtkIdType p = start;
+    while (p >= 0)
+    {
+      image.State[p] = VISITED;
+      addPoint(p);
+      vtkIdType next = -1;
+      for (int n = 0; n < 8 && next < 0; ++n)
+      {
+        next = neighbor(p, n, edge);
+      }
+      p = next;
+    }
+    if (chain.size() > 1)
+    {
+      lines->InsertNextCell(static_cast<vtkIdType>(chain.size()),
+                            chain.data());
+    }
+  };
+
+  for (vtkIdType p = 0; p < numberOfPixels; ++p)
+  {
+    if (image.State[p] != EDGE)
+    {
+      continue;
+    }
+    int neighbors = 0;
+    for (int n = 0; n < 8; ++n)
+    {
+      neighbors += neighbor(p, n, edge | traced) >= 0;
+    }
+    if (neighbors == 1)
+    {
+      trace(p);
+    }
+  }
+  for (vtkIdType p = 0; p < numberOfPixels; ++p)
+  {
+    if (image.State[p] == EDGE)
+    {
+      trace(p);
+    }
+  }
+
+  output->SetPoints(points);
+  output->SetLines(lines);
+
+  // A bucket pointer per bucket, and a node holding the next pointer, the
+  // key and the value per pixel.
+  return static_cast<vtkIdType>(
+      pointIds.bucket_count() * sizeof(void*) +
+      pointIds.size() *
+          (sizeof(void*) + sizeof(std::pair<const vtkIdType, vtkIdType>)));
+}
+
+int TiledCannyEdgeDetector::FillInputPortInformation(int vtkNotUsed(port),
+                                                     vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  return 1;
+}
+
+int TiledCannyEdgeDetector::RequestData(vtkInformation* vtkNotUsed(request),
+                                        vtkInformationVector** inputVector,
+                                        vtkInformationVector* outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector);
+
+  int dims[3];
+  input->GetDimensions(dims);
+  if (dims[2] != 1)
+  {
+    vtkErrorMacro(<< "The input must be a 2D image in the XY plane.");
+    return 0;
+  }
+  const int components = input->GetNumberOfScalarComponents();
+  if (components == 2)
+  {
+    vtkErrorMacro(<< "The input must be grey scale or RGB.");
+    return 0;
+  }
+
+  CannyImage image;
+  image.Width = dims[0];
+  image.Height = dims[1];
+  const vtkIdType numberOfPixels = static_cast<vtkIdType>(dims[0]) * dims[1];
+  image.State.resize(numberOfPixels);
+  image.Offsets.resize(2 * numberOfPixels);
+
+  const int radius =
+      static_cast<int>(this->StandardDeviation * this->RadiusFactor);
+  std::vector<float> gaussian(2 * radius + 1, 1.0f);
+  if (radius > 0)
+  {
+    double sum = 0.0;
+    for (int t = -radius; t <= radius; ++t)
+    {
+      sum += std::exp(-0.5 * t * t /
+                      (this->StandardDeviation * this->StandardDeviation));
+    }
+    for (int t = -radius; t <= radius; ++t)
+    {
+      gaussian[t + radius] = static_cast<float>(
+          std::exp(-0.5 * t * t /
+                   (this->StandardDeviation * this->StandardDeviation)) /
+          sum);
+    }
+  }
+
+  const int size = this->TileSize;
+  const int tilesX = (dims[0] + size - 1) / size;
+  const int tilesY = (dims[1] + size - 1) / size;
+  std::vector<CannyTile> tiles(static_cast<size_t>(tilesX) * tilesY);
+  for (int ty = 0; ty < tilesY; ++ty)
+  {
+    for (int tx = 0; tx < tilesX; ++tx)
+    {
+      CannyTile& tile = tiles[ty * tilesX + tx];
+      tile.X0 = tx * size;
+      tile.X1 = std::min(tile.X0 + size, dims[0]);
+      tile.Y0 = ty * size;
+      tile.Y1 = std::min(tile.Y0 + size, dims[1]);
+    }
+  }
+
+  // Detect the candidates and their components, tile by tile.
+  vtkIdType scratchBytes = 0;
+  {
+    double spacing[3];
+    input->GetSpacing(spacing);
+    vtkIdType increments[3];
+    input->GetIncrements(increments);
+    const float low = static_cast<float>(this->LowThreshold);
+    const float high = static_cast<float>(this->HighThreshold);
+    vtkSMPThreadLocal<TileScratch> scratch;
+    vtkSMPTools::For(0, tiles.size(), [&](vtkIdType begin, vtkIdType end) {
+      TileScratch& s = scratch.Local();
+      for (vtkIdType t = begin; t < end; ++t)
+      {
+        switch (input->GetScalarType())
+        {
+          vtkTemplateMacro(DetectTile(
+              static_cast<VTK_TT*>(input->GetScalarPointer()), components,
+              increments, spacing, gaussian, low, high, tiles[t], s, image));
+        }
+      }
+    });
+    for (auto& s : scratch)
+    {
+      scratchBytes += 4 * (s.A.capacity() + s.B.capacity() +
+                           s.Gx.capacity() + s.Gy.capacity() +
+                           s.Magnitude.capacity() + s.Parent.capacity() +
+                           s.Label.capacity());
+    }
+  }
+
+  // Merge the components along the tile borders, in parallel.
+  vtkIdType numberOfComponents = 0;
+  vtkIdType tileBytes = 0;
+  for (auto& tile : tiles)
+  {
+    tile.FirstComponent = numberOfComponents;
+    numberOfComponents += tile.NumberOfComponents;
+    tileBytes += 4 * (tile.Labels.size() + tile.Top.size() +
+                      tile.Bottom.size() + tile.Left.size() +
+                      tile.Right.size()) +
+        tile.Strong.size();
+  }
+  std::vector<std::atomic<int>> parent(numberOfComponents);
+  vtkSMPTools::For(0, numberOfComponents, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType c = begin; c < end; ++c)
+    {
+      parent[c].store(static_cast<int>(c));
+    }
+  });
+  vtkSMPTools::For(0, tiles.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+      const int tx = static_cast<int>(t % tilesX);
+      const int ty = static_cast<int>(t / tilesX);
+      const CannyTile& tile = tiles[t];
+      auto merge = [&](const CannyTile& other, int a, int b) {
+        if (a >= 0 && b >= 0)
+        {
+          Union(parent, static_cast<int>(tile.FirstComponent + a),
+                static_cast<int>(other.FirstComponent + b));
+        }
+      };
+      if (tx + 1 < tilesX)
+      {
+        const CannyTile& east = tiles[t + 1];
+        const int n = tile.Y1 - tile.Y0;
+        for (int j = 0; j < n; ++j)
+        {
+          for (int k = std::max(j - 1, 0); k <= std::min(j + 1, n - 1); ++k)
+          {
+            merge(east, tile.Right[j], east.Left[k]);
+          }
+        }
+      }
+      if (ty + 1 < tilesY)
+      {
+        const CannyTile& south = tiles[t + tilesX];
+        const int n = tile.X1 - tile.X0;
+        for (int i = 0; i < n; ++i)
+        {
+          for (int k = std::max(i - 1, 0); k <= std::min(i + 1, n - 1); ++k)
+          {
+            merge(south, tile.Bottom[i], south.Top[k]);
+          }
+        }
+        if (tx + 1 < tilesX)
+        {
+          const CannyTile& southEast = tiles[t + tilesX + 1];
+          merge(southEast, tile.Bottom.back(), southEast.Top.front());
+        }
+        if (tx > 0)
+        {
+          const CannyTile& southWest = tiles[t + tilesX - 1];
+          merge(southWest, tile.Bottom.front(), southWest.Top.back());
+        }
+      }
+    }
+  });
+
+  // Keep the components with a strong pixel.
+  std::vector<unsigned char> strong(numberOfComponents, 0);
+  for (const auto& tile : tiles)
+  {
+    for (int c = 0; c < tile.NumberOfComponents; ++c)
+    {
+      if (tile.Strong[c])
+      {
+        strong[FindRoot(parent, static_cast<int>(tile.FirstComponent + c))] =
+            1;
+      }
+    }
+  }
+  vtkSMPTools::For(0, tiles.size(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+      const CannyTile& tile = tiles[t];
+      auto label = tile.Labels.begin();
+      for (int y = tile.Y0; y < tile.Y1; ++y)
+      {
+        unsigned char* state =
+            image.State.data() + static_cast<vtkIdType>(y) * dims[0];
+        for (int x = tile.X0; x < tile.X1; ++x)
+        {
+          if (state[x] != NONE)
+          {
+            const int c = static_cast<int>(tile.FirstComponent + *label++);
+            state[x] = strong[FindRoot(parent, c)] ? EDGE : NONE;
+          }
+        }
+      }
+    }
+  });
+
+  const vtkIdType hysteresisBytes = 3 * numberOfPixels + scratchBytes +
+      tileBytes + numberOfComponents * (sizeof(std::atomic<int>) + 1);
+
+  double origin[3];
+  double spacing[3];
+  input->GetOrigin(origin);
+  input->GetSpacing(spacing);
+  int* extent = input->GetExtent();
+  for (int i = 0; i < 2; ++i)
+  {
+    origin[i] += extent[2 * i] * spacing[i];
+  }
+  origin[2] += extent[4] * spacing[2];
+  // The per pixel state is still held while the edges are traced.
+  const vtkIdType traceBytes = TraceEdges(image, origin, spacing, output);
+  this->WorkingMemorySize = (hysteresisBytes + traceBytes) / 1024;
+  return 1;
+}
+
+void MakeImage(int size, vtkImageData* image)
+{
+  image->SetDimensions(size, size, 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  auto pixels = static_cast<unsigned char*>(image->GetScalarPointer());
+  const int cell = 128;
+  vtkSMPTools::For(0, size, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType y = begin; y < end; ++y)
+    {
+      unsigned char* p = pixels + 3 * y * size;
+      for (int x = 0; x < size; ++x)
+      {
+        // One disc per cell, of varying size and contrast.
+        const int i = x / cell;
+        const int j = static_cast<int>(y) / cell;
+        const unsigned int h = (i * 73856093u) ^ (j * 19349663u);
+        const double radius = cell * (0.2 + 0.25 * (h % 7) / 6.0);
+        const double u = x - (i + 0.5) * cell;
+        const double v = y - (j + 0.5) * cell;
+        double value = 40.0 + 80.0 * x / size;
+        if (u * u + v * v < radius * radius)
+        {
+          value += 40.0 + 20.0 * (h % 5);
+        }
+        const auto noise = static_cast<unsigned int>(y * size + x) *
+            2654435761u;
+        value += static_cast<double>(noise >> 29) - 3.5;
+        const auto c =
+            static_cast<unsigned char>(std::clamp(value, 0.0, 255.0));
+        *p++ = c;
+        *p++ = static_cast<unsigned char>(0.9 * c);
+        *p++ = static_cast<unsigned char>(0.8 * c);
+      }
+    }
+  });
+}
+
+double RunFilterChain(vtkImageData* image, double& megaBytes,
+                      vtkPolyData* edges)
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+
+  vtkNew<vtkImageLuminance> il;
+  il->SetInputData(image);
+
+  vtkNew<vtkImageCast> ic;
+  ic->SetOutputScalarTypeToFloat();
+  ic->SetInputConnection(il->GetOutputPort());
+
+  vtkNew<vtkImageGaussianSmooth> gs;
+  gs->SetInputConnection(ic->GetOutputPort());
+  gs->SetDimensionality(2);
+  gs->SetRadiusFactors(1, 1, 0);
+
+  vtkNew<vtkImageGradient> imgGradient;
+  imgGradient->SetInputConnection(gs->GetOutputPort());
+  imgGradient->SetDimensionality(2);
+
+  vtkNew<vtkImageMagnitude> imgMagnitude;
+  imgMagnitude->SetInputConnection(imgGradient->GetOutputPort());
+
+  vtkNew<vtkImageNonMaximumSuppression> nonMax;
+  imgMagnitude->Update();
+  nonMax->SetMagnitudeInputData(imgMagnitude->GetOutput());
+  imgGradient->Update();
+  nonMax->SetVectorInputData(imgGradient->GetOutput());
+  nonMax->SetDimensionality(2);
+
+  vtkNew<vtkImageConstantPad> pad;
+  pad->SetInputConnection(imgGradient->GetOutputPort());
+  pad->SetOutputNumberOfScalarComponents(3);
+  pad->SetConstant(0);
+
+  vtkNew<vtkImageToStructuredPoints> i2sp1;
+  i2sp1->SetInputConnection(nonMax->GetOutputPort());
+  pad->Update();
+  i2sp1->SetVectorInputData(pad->GetOutput());
+
+  vtkNew<vtkLinkEdgels> imgLink;
+  imgLink->SetInputConnection(i2sp1->GetOutputPort());
+  imgLink->SetGradientThreshold(2);
+
+  vtkNew<vtkThreshold> thresholdEdges;
+  thresholdEdges->SetInputConnection(imgLink->GetOutputPort());
+  thresholdEdges->SetUpperThreshold(10);
+  thresholdEdges->SetThresholdFunction(vtkThreshold::THRESHOLD_UPPER);
+  thresholdEdges->AllScalarsOff();
+
+  vtkNew<vtkGeometryFilter> gf;
+  gf->SetInputConnection(thresholdEdges->GetOutputPort());
+
+  vtkNew<vtkImageToStructuredPoints> i2sp;
+  i2sp->SetInputConnection(imgMagnitude->GetOutputPort());
+  i2sp->SetVectorInputData(pad->GetOutput());
+
+  vtkNew<vtkSubPixelPositionEdgels> spe;
+  spe->SetInputConnection(gf->GetOutputPort());
+  i2sp->Update();
+  spe->SetGradMapsData(i2sp->GetStructuredPointsOutput());
+
+  vtkNew<vtkStripper> strip;
+  strip->SetInputConnection(spe->GetOutputPort());
+  strip->Update();
+  timer->StopTimer();
+
+  // Every stage keeps its output. The structured points share the arrays
+  // of their inputs and are not counted.
+  vtkDataObject* outputs[] = {
+      il->GetOutput(),         ic->GetOutput(),
+      gs->GetOutput(),         imgGradient->GetOutput(),
+      imgMagnitude->GetOutput(), nonMax->GetOutput(),
+      pad->GetOutput(),        imgLink->GetOutput(),
+      thresholdEdges->GetOutput(), gf->GetOutput(),
+      spe->GetOutput(),        strip->GetOutput()};
+  unsigned long kibiBytes = 0;
+  for (auto output : outputs)
+  {
+    kibiBytes += output->GetActualMemorySize();
+  }
+  megaBytes = kibiBytes / 1024.0;
+  edges->ShallowCopy(strip->GetOutput());
+  return timer->GetElapsedTime();
+}
+
+bool SamePolyData(vtkPolyData* a, vtkPolyData* b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfLines() != b->GetNumberOfLines())
+  {
+    return false;
+  }
+  for (vtkIdType i = 0; i < a->GetNumberOfPoints(); ++i)
+  {
+    double p[3];
+    double q[3];
+    a->GetPoint(i, p);
+    b->GetPoint(i, q);
+    if (p[0] != q[0] || p[1] != q[1] || p[2] != q[2])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
@@ -0,0 +1,770 @@
+#include <vtkBox.h>
+#include <vtkClipPolyData.h>
+#include <vtkCylinder.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageAlgorithm.h>
+#include <vtkImageData.h>
+#include <vtkImplicitBoolean.h>
+#include <vtkImplicitFunction.h>
+#include <vtkImplicitFunctionCollection.h>
+#include <vtkImplicitTextureCoords.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPlane.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkQuadric.h>
+#include <vtkSMPTools.h>
+#include <vtkSampleFunction.h>
+#include <vtkSphere.h>
+#include <vtkSphereSource.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * An implicit function tree flattened into a linear program for a stack
+ * machine.
+ *
+ * Each instruction works on a whole block of points: a leaf (sphere,
+ * plane, cylinder, quadric) pushes the values of its function, a boolean
+ * combines the two values on top of the stack. The loops over the block
+ * have no virtual calls and no branches other than selects, so the
+ * compiler can vectorize them.
+ *
+ * Only trees made of vtkSphere, vtkPlane, vtkCylinder, vtkQuadric and
+ * vtkImplicitBoolean nodes without transforms are compiled. The arithmetic
+ * is done in the same order as the EvaluateFunction() of these classes.
+ */
+class ImplicitProgram
+{
+public:
+  static constexpr vtkIdType BlockSize = 256;
+
+  // Returns false, and leaves the program empty, if a node is not
+  // supported.
+  bool Compile(vtkImplicitFunction* function)
+  {
+    this->Instructions.clear();
+    this->StackDepth = 0;
+    int depth = 0;
+    if (!this->CompileNode(function, depth))
+    {
+      this->Instructions.clear();
+      return false;
+    }
+    return true;
+  }
+
+  bool IsEmpty() const
+  {
+    return this->Instructions.empty();
+  }
+
+  size_t GetNumberOfInstructions() const
+  {
+    return this->Instructions.size();
+  }
+
+  // The number of doubles of scratch space EvaluateBlock() needs.
+  vtkIdType GetStackSize() const
+  {
+    return this->StackDepth * BlockSize;
+  }
+
+  // Evaluates n <= BlockSize points given as separate coordinate arrays.
+  void EvaluateBlock(const double* x, const double* y, const double* z,
+                     vtkIdType n, double* values, double* stack) const;
+
+  // Evaluates all the points, in parallel.
+  void EvaluatePoints(vtkPoints* points, double* values) const;
+
+private:
+  enum OpCode
+  {
+    Sphere,
+    Plane,
+    Cylinder,
+    Quadric,
+    Union,
+    Intersection,
+    Difference,
+    Magnitude,
+    UnionOfMagnitudes
+  };
+
+  struct Instruction
+  {
+    OpCode Op;
+    // The stack slot written by the instruction.
+    int Slot;
+    double C[10];
+  };
+
+  bool CompileNode(vtkImplicitFunction* function, int& depth);
+
+  void Push(OpCode op, int& depth, std::vector<double> constants)
+  {
+    Instruction instruction{op, depth, {}};
+    std::copy(constants.begin(), constants.end(), instruction.C);
+    this->Instructions.push_back(instruction);
+    this->StackDepth = std::max(this->StackDepth, ++depth);
+  }
+
+  void Combine(OpCode op, int& depth)
+  {
+    --depth;
+    this->Instructions.push_back({op, depth - 1, {}});
+  }
+
+  std::vector<Instruction> Instructions;
+  int StackDepth = 0;
+};
+
+/**
+ * Like vtkSampleFunction, without normals or capping, but the implicit
+ * function is compiled into an ImplicitProgram when possible. Otherwise
+ * FunctionValue() is called for each point.
+ */
+class CompiledSampleFunction : public vtkImageAlgorithm
+{
+public:
+  static CompiledSampleFunction* New();
+  vtkTypeMacro(CompiledSampleFunction, vtkImageAlgorithm);
+
+  void SetImplicitFunction(vtkImplicitFunction* function)
+  {
+    if (this->ImplicitFunction != function)
+    {
+      this->ImplicitFunction = function;
+      this->Modified();
+    }
+  }
+
+  vtkSetVector3Macro(SampleDimensions, int);
+  vtkGetVector3Macro(SampleDimensions, int);
+  vtkSetVector6Macro(ModelBounds, double);
+  vtkGetVector6Macro(ModelBounds, double);
+
+  // Whether the last execution used the compiled program.
+  bool GetCompiled() const
+  {
+    return !this->Program.IsEmpty();
+  }
+
+  vtkMTimeType GetMTime() override
+  {
+    auto mTime = this->Superclass::GetMTime();
+    if (this->ImplicitFunction)
+    {
+      mTime = std::max(mTime, this->ImplicitFunction->GetMTime());
+    }
+    return mTime;
+  }
+
+protected:
+  CompiledSampleFunction()
+  {
+    this->SetNumberOfInputPorts(0);
+  }
+  ~CompiledSampleFunction() override = default;
+
+  int RequestInformation(vtkInformation*, vtkInformationVector**,
+                         vtkInformationVector*) override;
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  vtkSmartPointer<vtkImplicitFunction> ImplicitFunction;
+  int SampleDimensions[3] = {50, 50, 50};
+  double ModelBounds[6] = {-1.0, 1.0, -1.0, 1.0, -1.0, 1.0};
+  ImplicitProgram Program;
+
+private:
+  CompiledSampleFunction(const CompiledSampleFunction&) = delete;
+  void operator=(const CompiledSampleFunction&) = delete;
+};
+
+vtkStandardNewMacro(CompiledSampleFunction);
+
+// The tree used for the measurements: a difference of a union of two
+// spheres with a cylinder and a plane, six nodes.
+vtkSmartPointer<vtkImplicitFunction> MakeTree();
+
+// The texture coordinates of vtkImplicitTextureCoords with only an R
+// function, from values computed by the program: the values are scaled so
+// that 0 maps to 0.5 and the largest magnitude to 0.001 or 0.999.
+void ComputeTextureCoords(const ImplicitProgram& program, vtkPoints* points,
+                          vtkFloatArray* tcoords);
+
+// Largest difference relative to max(1, |a|), and the number of values
+// that differ at all.
+void Compare(vtkDataArray* a, vtkDataArray* b, double& error,
+             vtkIdType& different);
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: CompiledImplicitFunction [dimension]
+  int dimension = 64;
+  if (argc > 1)
+  {
+    dimension = std::max(2, std::atoi(argv[1]));
+  }
+  const double numberOfSamples =
+      static_cast<double>(dimension) * dimension * dimension;
+
+  auto tree = MakeTree();
+  vtkNew<vtkTimerLog> timer;
+  std::cout << std::setprecision(4);
+  bool ok = true;
+
+  ImplicitProgram program;
+  program.Compile(tree);
+  std::cout << "The tree compiles to " << program.GetNumberOfInstructions()
+            << " instructions." << std::endl;
+
+  // Sampling.
+  vtkNew<vtkSampleFunction> sample;
+  sample->SetImplicitFunction(tree);
+  sample->SetModelBounds(-1.5, 1.5, -1.5, 1.5, -1.5, 1.5);
+  sample->SetSampleDimensions(dimension, dimension, dimension);
+  sample->ComputeNormalsOff();
+  timer->StartTimer();
+  sample->Update();
+  timer->StopTimer();
+  const double sampleTime = timer->GetElapsedTime();
+
+  vtkNew<CompiledSampleFunction> compiled;
+  compiled->SetImplicitFunction(tree);
+  compiled->SetModelBounds(-1.5, 1.5, -1.5, 1.5, -1.5, 1.5);
+  compiled->SetSampleDimensions(dimension, dimension, dimension);
+  timer->StartTimer();
+  compiled->Update();
+  timer->StopTimer();
+  const double compiledTime = timer->GetElapsedTime();
+
+  double error = 0.0;
+  vtkIdType different = 0;
+  Compare(sample->GetOutput()->GetPointData()->GetScalars(),
+          compiled->GetOutput()->GetPointData()->GetScalars(), error,
+          different);
+  std::cout << dimension << "^3 samples, millions of samples per second\n"
+            << "  vtkSampleFunction:      "
+            << numberOfSamples / sampleTime / 1.0e6 << "\n"
+            << "  CompiledSampleFunction: "
+            << numberOfSamples / compiledTime / 1.0e6 << " ("
+            << sampleTime / compiledTime << "x)\n"
+            << "  " << different << " values differ, largest difference "
+            << error << std::endl;
+  ok = ok && compiled->GetCompiled() && error < 1.0e-12;
+
+  // Clipping: the program computes the clip scalars, vtkClipPolyData
+  // clips by scalars instead of calling the function for each point.
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(1.2);
+  sphere->SetThetaResolution(dimension * 4);
+  sphere->SetPhiResolution(dimension * 4);
+  sphere->Update();
+
+  vtkNew<vtkClipPolyData> clip;
+  clip->SetInputConnection(sphere->GetOutputPort());
+  clip->SetClipFunction(tree);
+  timer->StartTimer();
+  clip->Update();
+  timer->StopTimer();
+  const double clipTime = timer->GetElapsedTime();
+
+  vtkNew<vtkPolyData> withScalars;
+  withScalars->ShallowCopy(sphere->GetOutput());
+  timer->StartTimer();
+  vtkNew<vtkDoubleArray> values;
+  values->SetName("Values");
+  values->SetNumberOfTuples(withScalars->GetNumberOfPoints());
+  program.EvaluatePoints(withScalars->GetPoints(), values->GetPointer(0));
+  withScalars->GetPointData()->SetScalars(values);
+  vtkNew<vtkClipPolyData> scalarClip;
+  scalarClip->SetInputData(withScalars);
+  scalarClip->Update();
+  timer->StopTimer();
+  const double scalarClipTime = timer->GetElapsedTime();
+
+  const bool sameClip = clip->GetOutput()->GetNumberOfPoints() ==
+          scalarClip->GetOutput()->GetNumberOfPoints() &&
+      clip->GetOutput()->GetNumberOfCells() ==
+          scalarClip->GetOutput()->GetNumberOfCells();
+  std::cout << "Clipping " << withScalars->GetNumberOfPoints()
+            << " points\n"
+            << "  vtkClipPolyData with the function: " << clipTime << " s\n"
+            << "  compiled values, then clip:        " << scalarClipTime
+            << " s, " << (sameClip ? "same" : "different") << " output"
+            << std::endl;
+  ok = ok && sameClip;
+
+  // Texture coordinates: the program computes the function values,
+  // the scaling of vtkImplicitTextureCoords is applied to them.
+  vtkNew<vtkImplicitTextureCoords> textureCoords;
+  textureCoords->SetInputConnection(sphere->GetOutputPort());
+  textureCoords->SetRFunction(tree);
+  timer->StartTimer();
+  textureCoords->Update();
+  timer->StopTimer();
+  const double textureCoordsTime = timer->GetElapsedTime();
+
+  vtkNew<vtkFloatArray> tcoords;
+  timer->StartTimer();
+  ComputeTextureCoords(program, sphere->GetOutput()->GetPoints(), tcoords);
+  timer->StopTimer();
+  const double compiledTextureCoordsTime = timer->GetElapsedTime();
+
+  // Both round the values to float, a last bit difference in the double
+  // may round differently.
+  Compare(textureCoords->GetOutput()->GetPointData()->GetTCoords(), tcoords,
+          error, different);
+  std::cout << "Texture coordinates\n"
+            << "  vtkImplicitTextureCoords:     " << textureCoordsTime
+            << " s\n"
+            << "  compiled values, then scaled: " << compiledTextureCoordsTime
+            << " s, " << different << " values differ, largest difference "
+            << error << std::endl;
+  ok = ok && error < 1.0e-6;
+
+  // A tree with a node the compiler does not know falls back to
+  // FunctionValue().
+  vtkNew<vtkBox> box;
+  vtkNew<vtkImplicitBoolean> withBox;
+  withBox->AddFunction(tree);
+  withBox->AddFunction(box);
+  compiled->SetImplicitFunction(withBox);
+  compiled->Update();
+  std::cout << "With a vtkBox: "
+            << (compiled->GetCompiled() ? "compiled" : "not compiled")
+            << std::endl;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+
+bool ImplicitProgram::CompileNode(vtkImplicitFunction* function, int& depth)
+{
+  if (!function || function->GetTransform())
+  {
+    return false;
+  }
+  // Exact class names, a subclass may override EvaluateFunction().
+  const std::string name = function->GetClassName();
+  if (name == "vtkSphere")
+  {
+    auto sphere = static_cast<vtkSphere*>(function);
+    const double* c = sphere->GetCenter();
+    this->Push(Sphere, depth, {c[0], c[1], c[2], sphere->GetRadius()});
+    return true;
+  }
+  if (name == "vtkPlane")
+  {
+    auto plane = static_cast<vtkPlane*>(function);
+    const double* n = plane->GetNormal();
+    const double* o = plane->GetOrigin();
+    this->Push(Plane, depth, {n[0], n[1], n[2], o[0], o[1], o[2]});
+    return true;
+  }
+  if (name == "vtkCylinder")
+  {
+    auto cylinder = static_cast<vtkCylinder*>(function);
+    const double* c = cylinder->GetCenter();
+    const double* a = cylinder->GetAxis();
+    this->Push(Cylinder, depth,
+               {c[0], c[1], c[2], a[0], a[1], a[2], cylinder->GetRadius()});
+    return true;
+  }
+  if (name == "vtkQuadric")
+  {
+    const double* a = static_cast<vtkQuadric*>(function)->GetCoefficients();
+    this->Push(Quadric, depth, std::vector<double>(a, a + 10));
+    return true;
+  }
+  if (name != "vtkImplicitBoolean")
+  {
+    return false;
+  }
+
+  auto boolean = static_cast<vtkImplicitBoolean*>(function);
+  auto children = boolean->GetFunction();
+  if (children->GetNumberOfItems() == 0)
+  {
+    return false;
+  }
+  const int operation = boolean->GetOperationType();
+  vtkCollectionSimpleIterator it;
+  children->InitTraversal(it);
+  bool first = true;
+  while (auto child = children->GetNextImplicitFunction(it))
+  {
+    if (!this->CompileNode(child, depth))
+    {
+      return false;
+    }
+    switch (operation)
+    {
+      case vtkImplicitBoolean::VTK_UNION:
+        if (!first)
+        {
+          this->Combine(Union, depth);
+        }
+        break;
+      case vtkImplicitBoolean::VTK_INTERSECTION:
+        if (!first)
+        {
+          this->Combine(Intersection, depth);
+        }
+        break;
+      case vtkImplicitBoolean::VTK_DIFFERENCE:
+        if (!first)
+        {
+          this->Combine(Difference, depth);
+        }
+        break;
+      case vtkImplicitBoolean::VTK_UNION_OF_MAGNITUDES:
+        this->Instructions.push_back({Magnitude, depth - 1, {}});
+        if (!first)
+        {
+          this->Combine(UnionOfMagnitudes, depth);
+        }
+        break;
+      default:
+        return false;
+    }
+    first = false;
+  }
+  return true;
+}
+
+void ImplicitProgram::EvaluateBlock(const double* x, const double* y,
+                                    const double* z, vtkIdType n,
+                                    double* values, double* stack) const
+{
+  for (const auto& instruction : this->Instructions)
+  {
+    double* out = stack + instruction.Slot * BlockSize;
+    // The value below, for the booleans.
+    const double* b = out + BlockSize;
+    const double* c = instruction.C;
+    switch (instruction.Op)
+    {
+      case Sphere:
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          out[i] = (x[i] - c[0]) * (x[i] - c[0]) +
+              (y[i] - c[1]) * (y[i] - c[1]) + (z[i] - c[2]) * (z[i] - c[2]) -
+              c[3] * c[3];
+        }
+        break;
+      case Plane:
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          out[i] = c[0] * (x[i] - c[3]) + c[1] * (y[i] - c[4]) +
+              c[2] * (z[i] - c[5]);
+        }
+        break;
+      case Cylinder:
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          const double dx = x[i] - c[0];
+          const double dy = y[i] - c[1];
+          const double dz = z[i] - c[2];
+          const double projection = c[3] * dx + c[4] * dy + c[5] * dz;
+          out[i] = (dx * dx + dy * dy + dz * dz) - projection * projection -
+              c[6] * c[6];
+        }
+        break;
+      case Quadric:
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          out[i] = c[0] * x[i] * x[i] + c[1] * y[i] * y[i] +
+              c[2] * z[i] * z[i] + c[3] * x[i] * y[i] + c[4] * y[i] * z[i] +
+              c[5] * x[i] * z[i] + c[6] * x[i] + c[7] * y[i] + c[8] * z[i] +
+              c[9];
+        }
+        break;
+      case Union:
+      case UnionOfMagnitudes:
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          out[i] = b[i] < out[i] ? b[i] : out[i];
+        }
+        break;
+      case Intersection:
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          out[i] = b[i] > out[i] ? b[i] : out[i];
+        }
+        break;
+      case Difference:
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          const double v = -1.0 * b[i];
+          out[i] = v > out[i] ? v : out[i];
+        }
+        break;
+      case Magnitude:
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          out[i] = std::abs(out[i]);
+        }
+        break;
+    }
+  }
+  std::copy(stack, stack + n, values);
+}
+
+// Splits AOS coordinates into the block arrays.
+template <typename T>
+void EvaluateArray(const ImplicitProgram& program, const T* points,
+                   vtkIdType numberOfPoints, double* values)
+{
+  const vtkIdType blockSize = ImplicitProgram::BlockSize;
+  vtkSMPTools::For(
+      0, (numberOfPoints + blockSize - 1) / blockSize,
+      [&](vtkIdType begin, vtkIdType end) {
+        std::vector<double> stack(program.GetStackSize());
+        double x[blockSize], y[blockSize], z[blockSize];
+        for (vtkIdType block = begin; block < end; ++block)
+        {
+          const vtkIdType first = block * blockSize;
+          const vtkIdType n = std::min(blockSize, numberOfPoints - first);
+          const T* p = points + 3 * first;
+          for (vtkIdType i = 0; i < n; ++i)
+          {
+            x[i] = p[3 * i];
+            y[i] = p[3 * i + 1];
+            z[i] = p[3 * i + 2];
+          }
+          program.EvaluateBlock(x, y, z, n, values + first, stack.data());
+        }
+      });
+}
+
+void ImplicitProgram::EvaluatePoints(vtkPoints* points, double* values) const
+{
+  const vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  auto data = points->GetData();
+  if (auto floats = vtkFloatArray::SafeDownCast(data))
+  {
+    EvaluateArray(*this, floats->GetPointer(0), numberOfPoints, values);
+  }
+  else if (auto doubles = vtkDoubleArray::SafeDownCast(data))
+  {
+    EvaluateArray(*this, doubles->GetPointer(0), numberOfPoints, values);
+  }
+  else
+  {
+    std::vector<double> copy(3 * numberOfPoints);
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+      points->GetPoint(i, &copy[3 * i]);
+    }
+    EvaluateArray(*this, copy.data(), numberOfPoints, values);
+  }
+}
+
+int CompiledSampleFunction::RequestInformation(
+    vtkInformation* vtkNotUsed(request),
+    vtkInformationVector** vtkNotUsed(inputVector),
+    vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  int extent[6] = {0, this->SampleDimensions[0] - 1,
+                   0, this->SampleDimensions[1] - 1,
+                   0, this->SampleDimensions[2] - 1};
+  double origin[3];
+  double spacing[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    origin[i] = this->ModelBounds[2 * i];
+    spacing[i] = this->SampleDimensions[i] > 1
+        ? (this->ModelBounds[2 * i + 1] - this->ModelBounds[2 * i]) /
+            (this->SampleDimensions[i] - 1)
+        : 1.0;
+  }
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent, 6);
+  outInfo->Set(vtkDataObject::ORIGIN(), origin, 3);
+  outInfo->Set(vtkDataObject::SPACING(), spacing, 3);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_DOUBLE, 1);
+  return 1;
+}
+
+int CompiledSampleFunction::RequestData(
+    vtkInformation* vtkNotUsed(request),
+    vtkInformationVector** vtkNotUsed(inputVector),
+    vtkInformationVector* outputVector)
+{
+  if (!this->ImplicitFunction)
+  {
+    vtkErrorMacro(<< "No implicit function specified");
+    return 0;
+  }
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkImageData* output = vtkImageData::GetData(outInfo);
+
+  int extent[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+  output->SetExtent(extent);
+  output->AllocateScalars(VTK_DOUBLE, 1);
+  output->GetPointData()->GetScalars()->SetName("scalars");
+  auto scalars = static_cast<double*>(output->GetScalarPointer());
+  double origin[3];
+  double spacing[3];
+  output->GetOrigin(origin);
+  output->GetSpacing(spacing);
+
+  const vtkIdType rowLength = extent[1] - extent[0] + 1;
+  const vtkIdType rowsPerSlice = extent[3] - extent[2] + 1;
+  const vtkIdType numberOfRows = rowsPerSlice * (extent[5] - extent[4] + 1);
+  const vtkIdType blockSize = ImplicitProgram::BlockSize;
+  this->Program.Compile(this->ImplicitFunction);
+  const ImplicitProgram& program = this->Program;
+  vtkImplicitFunction* function = this->ImplicitFunction;
+
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType begin, vtkIdType end) {
+    std::vector<double> stack(program.GetStackSize());
+    double x[blockSize], y[blockSize], z[blockSize];
+    for (vtkIdType row = begin; row < end; ++row)
+    {
+      const double yRow = origin[1] + (extent[2] + row % rowsPerSlice) *
+          spacing[1];
+      const double zRow = origin[2] + (extent[4] + row / rowsPerSlice) *
+          spacing[2];
+      double* out = scalars + row * rowLength;
+      for (vtkIdType first = 0; first < rowLength; first += blockSize)
+      {
+        const vtkIdType n = std::min(blockSize, rowLength - first);
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          x[i] = origin[0] + (extent[0] + first + i) * spacing[0];
+          y[i] = yRow;
+          z[i] = zRow;
+        }
+        if (program.IsEmpty())
+        {
+          for (vtkIdType i = 0; i < n; ++i)
+          {
+            double point[3] = {x[i], y[i], z[i]};
+            out[first + i] = function->FunctionValue(point);
+          }
+        }
+        else
+        {
+          program.EvaluateBlock(x, y, z, n, out + first, stack.data());
+        }
+      }
+    }
+  });
+  return 1;
+}
+
+vtkSmartPointer<vtkImplicitFunction> MakeTree()
+{
+  vtkNew<vtkSphere> sphere1;
+  sphere1->SetCenter(-0.4, 0.0, 0.0);
+  sphere1->SetRadius(0.8);
+  vtkNew<vtkSphere> sphere2;
+  sphere2->SetCenter(0.4, 0.1, 0.0);
+  sphere2->SetRadius(0.7);
+  vtkNew<vtkImplicitBoolean> spheres;
+  spheres->SetOperationTypeToUnion();
+  spheres->AddFunction(sphere1);
+  spheres->AddFunction(sphere2);
+
+  vtkNew<vtkCylinder> cylinder;
+  cylinder->SetRadius(0.3);
+  cylinder->SetAxis(0.0, 0.0, 1.0);
+  vtkNew<vtkPlane> plane;
+  plane->SetOrigin(0.0, 0.5, 0.0);
+  plane->SetNormal(0.0, -1.0, 0.0);
+
+  auto tree = vtkSmartPointer<vtkImplicitBoolean>::New();
+  tree->SetOperationTypeToDifference();
+  tree->AddFunction(spheres);
+  tree->AddFunction(cylinder);
+  tree->AddFunction(plane);
+  return tree;
+}
+
+void ComputeTextureCoords(const ImplicitProgram& program, vtkPoints* points,
+                          vtkFloatArray* tcoords)
+{
+  const vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  std::vector<double> values(numberOfPoints);
+  program.EvaluatePoints(points, values.data());
+
+  // The same scale as vtkImplicitTextureCoords, from the range of the
+  // values, applied to the values rounded to float as it stores them.
+  double low = VTK_DOUBLE_MAX;
+  double high = -VTK_DOUBLE_MAX;
+  for (double value : values)
+  {
+    low = std::min(low, value);
+    high = std::max(high, value);
+  }
+  double scale = 1.0;
+  if (high > 0.0 && (low >= 0.0 || high > -low))
+  {
+    scale = 0.499 / high;
+  }
+  else if (low < 0.0)
+  {
+    scale = -0.499 / low;
+  }
+
+  tcoords->SetName("Texture Coordinates");
+  tcoords->SetNumberOfComponents(1);
+  tcoords->SetNumberOfTuples(numberOfPoints);
+  float* t = tcoords->GetPointer(0);
+  vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      t[i] = static_cast<float>(
+          0.5 + scale * static_cast<float>(values[i]));
+    }
+  });
+}
+
+void Compare(vtkDataArray* a, vtkDataArray* b, double& error,
+             vtkIdType& different)
+{
+  error = 0.0;
+  different = 0;
+  if (!a || !b || a->GetNumberOfTuples() != b->GetNumberOfTuples())
+  {
+    error = VTK_DOUBLE_MAX;
+    return;
+  }
+  for (vtkIdType i = 0; i < a->GetNumberOfTuples(); ++i)
+  {
+    const double va = a->GetComponent(i, 0);
+    const double vb = b->GetComponent(i, 0);
+    if (va != vb)
+    {
+      ++different;
+      error = std::max(error,
+                       std::abs(va - vb) / std::max(1.0, std::abs(va)));
+    }
+  }
+}
+
+} // namespace
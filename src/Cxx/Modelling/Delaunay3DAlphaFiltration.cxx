@@ -0,0 +1,802 @@
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkCellData.h>
+#include <vtkCellType.h>
+#include <vtkDelaunay3D.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkTetra.h>
+#include <vtkTimerLog.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkUnstructuredGridAlgorithm.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * vtkDelaunay3D's alpha output, from an alpha complex that is computed
+ * once.
+ *
+ * The first execution triangulates the input with vtkDelaunay3D (Alpha = 0)
+ * and builds the alpha filtration: every tetrahedron, triangle, edge and
+ * vertex of the Delaunay complex with the range of alpha for which
+ * vtkDelaunay3D outputs it, AlphaBirth <= alpha < AlphaDeath. A simplex is
+ * born when its circumradius (half the length for an edge) reaches alpha.
+ * A triangle, edge or vertex is only output while no simplex containing it
+ * is, so it dies when the first of those is born; tetrahedra never die.
+ *
+ * Changing Alpha does not triangulate again. The simplices of each type are
+ * sorted by birth, so the ones born at Alpha are a prefix of each type,
+ * found by a binary search. The prefixes are filtered on AlphaDeath in
+ * parallel. The filtration is rebuilt when the input or Tolerance change.
+ */
+class AlphaFiltrationDelaunay3D : public vtkUnstructuredGridAlgorithm
+{
+public:
+  static AlphaFiltrationDelaunay3D* New();
+  vtkTypeMacro(AlphaFiltrationDelaunay3D, vtkUnstructuredGridAlgorithm);
+
+  /**
+   * As for vtkDelaunay3D: zero outputs all the tetrahedra.
+   */
+  vtkSetClampMacro(Alpha, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(Alpha, double);
+
+  /**
+   * Passed to vtkDelaunay3D.
+   */
+  vtkSetClampMacro(Tolerance, double, 0.0, 1.0);
+  vtkGetMacro(Tolerance, double);
+
+  /**
+   * All the simplices of the Delaunay complex, with their AlphaBirth and
+   * AlphaDeath as cell data. Tetrahedra come first, then triangles, edges
+   * and vertices, each sorted by birth.
+   */
+  vtkUnstructuredGrid* GetFiltration()
+  {
+    return this->Filtration;
+  }
+
+  /**
+   * The time taken by the last triangulation and filtration build, in
+   * seconds.
+   */
+  vtkGetMacro(FiltrationTime, double);
+
+protected:
+  AlphaFiltrationDelaunay3D() = default;
+  ~AlphaFiltrationDelaunay3D() override = default;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  bool BuildFiltration(vtkPointSet* input);
+  void ExtractComplex(vtkUnstructuredGrid* output);
+
+  double Alpha = 0.0;
+  double Tolerance = 0.001;
+  double FiltrationTime = 0.0;
+
+  vtkNew<vtkUnstructuredGrid> Filtration;
+  vtkNew<vtkIdTypeArray> Offsets;
+  vtkNew<vtkIdTypeArray> Connectivity;
+  vtkNew<vtkUnsignedCharArray> Types;
+  vtkNew<vtkDoubleArray> Birth;
+  vtkNew<vtkDoubleArray> Death;
+  // The first cell of each type in Filtration, and the end.
+  vtkIdType TypeBegin[5] = {0, 0, 0, 0, 0};
+  // What the filtration was built from.
+  vtkMTimeType FiltrationInputTime = 0;
+  double FiltrationTolerance = -1.0;
+
+private:
+  AlphaFiltrationDelaunay3D(const AlphaFiltrationDelaunay3D&) = delete;
+  void operator=(const AlphaFiltrationDelaunay3D&) = delete;
+};
+
+vtkStandardNewMacro(AlphaFiltrationDelaunay3D);
+
+// Points uniformly distributed in the unit cube.
+void MakeCloud(vtkIdType numberOfPoints, vtkPolyData* cloud);
+
+// Counts the tetrahedra, triangles, lines and vertices.
+std::array<vtkIdType, 4> CountCells(vtkUnstructuredGrid* grid);
+
+// The same cells, in any order and with any point order.
+bool SameCells(vtkUnstructuredGrid* a, vtkUnstructuredGrid* b);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Defaults are small; 1000000 replays the slider on a 1M point cloud.
+  vtkIdType numberOfPoints = 20000;
+  int numberOfSteps = 10;
+  if (argc > 1)
+  {
+    numberOfPoints = std::stoll(argv[1]);
+  }
+  if (argc > 2)
+  {
+    numberOfSteps = std::max(std::stoi(argv[2]), 1);
+  }
+
+  vtkNew<vtkPolyData> cloud;
+  MakeCloud(numberOfPoints, cloud);
+  std::cout << numberOfPoints << " points, SMP backend: "
+            << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+
+  vtkNew<AlphaFiltrationDelaunay3D> filtration;
+  filtration->SetInputData(cloud);
+  filtration->Update();
+  std::cout << "Triangulation and filtration: "
+            << 1000.0 * filtration->GetFiltrationTime() << " ms, "
+            << filtration->GetFiltration()->GetNumberOfCells()
+            << " simplices, "
+            << filtration->GetFiltration()->GetActualMemorySize() / 1024.0
+            << " MB" << std::endl;
+
+  vtkNew<vtkDelaunay3D> delaunay3D;
+  delaunay3D->SetInputData(cloud);
+
+  // The slider is dragged from 0.2 to 1 mean point spacing and back, so
+  // that the output goes from mostly vertices to mostly tetrahedra.
+  const double spacing =
+      std::cbrt(1.0 / std::max<vtkIdType>(numberOfPoints, 1));
+  std::cout << std::setw(8) << "alpha" << std::setw(10) << "tetras"
+            << std::setw(10) << "tris" << std::setw(10) << "lines"
+            << std::setw(10) << "verts" << std::setw(14) << "Delaunay3D"
+            << std::setw(14) << "filtration" << std::endl;
+  vtkNew<vtkTimerLog> timer;
+  double delaunayTime = 0.0;
+  double filtrationTime = 0.0;
+  bool ok = true;
+  for (int step = 0; step < numberOfSteps; ++step)
+  {
+    const double t =
+        numberOfSteps > 1 ? step / (numberOfSteps - 1.0) : 0.5;
+    const double alpha =
+        spacing * (0.2 + 0.8 * (1.0 - std::abs(2.0 * t - 1.0)));
+
+    delaunay3D->SetAlpha(alpha);
+    timer->StartTimer();
+    delaunay3D->Update();
+    timer->StopTimer();
+    const double delaunayStep = timer->GetElapsedTime();
+    delaunayTime += delaunayStep;
+
+    filtration->SetAlpha(alpha);
+    timer->StartTimer();
+    filtration->Update();
+    timer->StopTimer();
+    const double filtrationStep = timer->GetElapsedTime();
+    filtrationTime += filtrationStep;
+
+    const bool same =
+        SameCells(delaunay3D->GetOutput(), filtration->GetOutput());
+    ok = ok && same;
+    const std::array<vtkIdType, 4> counts =
+        CountCells(filtration->GetOutput());
+    std::cout << std::setprecision(4) << std::setw(8) << alpha
+              << std::setprecision(1);
+    for (vtkIdType count : counts)
+    {
+      std::cout << std::setw(10) << count;
+    }
+    std::cout << std::setw(11) << 1000.0 * delaunayStep << " ms"
+              << std::setw(11) << 1000.0 * filtrationStep << " ms"
+              << (same ? "" : "  DIFFER") << std::endl;
+  }
+
+  std::cout << "Per change: Delaunay3D "
+            << 1000.0 * delaunayTime / numberOfSteps << " ms, filtration "
+            << 1000.0 * filtrationTime / numberOfSteps << " ms ("
+            << delaunayTime / std::max(filtrationTime, 1e-9) << "x)"
+            << std::endl;
+  std::cout << "Cell sets " << (ok ? "match" : "DIFFER") << std::endl;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+const double Never = std::numeric_limits<double>::infinity();
+
+// Cells are extracted in blocks of this many candidates.
+const vtkIdType BlockSize = 65536;
+
+// A simplex of the filtration with N points.
+template <int N>
+struct Simplex
+{
+  vtkIdType Ids[N];
+  double Birth;
+  double Death;
+};
+
+// The square of the circumradius of a triangle.
+double TriangleRadius2(const double a[3], const double b[3], const double c[3])
+{
+  double u[3];
+  double v[3];
+  double w[3];
+  double normal[3];
+  vtkMath::Subtract(b, a, u);
+  vtkMath::Subtract(c, a, v);
+  vtkMath::Subtract(c, b, w);
+  vtkMath::Cross(u, v, normal);
+  const double normal2 = vtkMath::Dot(normal, normal);
+  if (normal2 == 0.0)
+  {
+    return Never;
+  }
+  return vtkMath::Dot(u, u) * vtkMath::Dot(v, v) * vtkMath::Dot(w, w) /
+      (4.0 * normal2);
+}
+
+// The triangles and edges found by one thread, each recorded from its
+// smallest point.
+struct LocalSimplices
+{
+  std::vector<Simplex<3>> Triangles;
+  std::vector<Simplex<2>> Edges;
+
+  // A triangle (a, B, C) of one tetrahedron around the point a.
+  struct TriangleUse
+  {
+    vtkIdType B;
+    vtkIdType C;
+    double Radius2;
+    double TetraRadius2;
+  };
+  // An edge (a, B) of one tetrahedron, and the smallest circumradius of
+  // the tetrahedron and its two triangles that contain the edge.
+  struct EdgeUse
+  {
+    vtkIdType B;
+    double Length2;
+    double Cover2;
+  };
+  std::vector<TriangleUse> TriangleUses;
+  std::vector<EdgeUse> EdgeUses;
+};
+
+// Writes the simplices of one type to the filtration arrays, starting at
+// cell first. The caller sets offsets[first], where the connectivity of the
+// type starts.
+template <int N>
+void CopySimplices(const std::vector<Simplex<N>>& simplices, int cellType,
+                   vtkIdType first, vtkIdType* offsets,
+                   vtkIdType* connectivity, unsigned char* types,
+                   double* birth, double* death)
+{
+  const vtkIdType start = offsets[first];
+  vtkSMPTools::For(
+      0, static_cast<vtkIdType>(simplices.size()),
+      [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i)
+        {
+          const Simplex<N>& simplex = simplices[i];
+          const vtkIdType cell = first + i;
+          offsets[cell + 1] = start + N * (i + 1);
+          std::copy(simplex.Ids, simplex.Ids + N,
+                    connectivity + start + N * i);
+          types[cell] = static_cast<unsigned char>(cellType);
+          birth[cell] = simplex.Birth;
+          death[cell] = simplex.Death;
+        }
+      });
+}
+
+// Records the vertex a, and the triangles and edges whose smallest point
+// is a, from the tetrahedra around a. The tetrahedra births are still
+// squared.
+void CollectSimplices(vtkIdType a, vtkPoints* points,
+                      const std::vector<Simplex<4>>& tetras,
+                      const vtkIdType* around, const vtkIdType* aroundEnd,
+                      LocalSimplices& local, Simplex<1>& vertex)
+{
+  auto& triangleUses = local.TriangleUses;
+  auto& edgeUses = local.EdgeUses;
+  triangleUses.clear();
+  edgeUses.clear();
+  double xa[3];
+  double x[3][3];
+  points->GetPoint(a, xa);
+  double vertexDeath2 = Never;
+  for (const vtkIdType* t = around; t != aroundEnd; ++t)
+  {
+    const Simplex<4>& tetra = tetras[*t];
+    vtkIdType others[3];
+    int n = 0;
+    for (vtkIdType id : tetra.Ids)
+    {
+      if (id != a)
+      {
+        others[n++] = id;
+      }
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+      points->GetPoint(others[i], x[i]);
+    }
+    const double tetraRadius2 = tetra.Birth;
+    // length2[i] is the edge to others[i], radius2[i] the triangle
+    // without others[i].
+    double length2[3];
+    double radius2[3];
+    for (int i = 0; i < 3; ++i)
+    {
+      length2[i] = 0.25 * vtkMath::Distance2BetweenPoints(xa, x[i]);
+      radius2[i] = TriangleRadius2(xa, x[(i + 1) % 3], x[(i + 2) % 3]);
+    }
+    vertexDeath2 = std::min(vertexDeath2, tetraRadius2);
+    for (int i = 0; i < 3; ++i)
+    {
+      vertexDeath2 = std::min({vertexDeath2, length2[i], radius2[i]});
+      const vtkIdType b = others[(i + 1) % 3];
+      const vtkIdType c = others[(i + 2) % 3];
+      if (others[i] > a)
+      {
+        edgeUses.push_back(
+            {others[i], length2[i],
+             std::min({tetraRadius2, radius2[(i + 1) % 3],
+                       radius2[(i + 2) % 3]})});
+      }
+      if (b > a && c > a)
+      {
+        triangleUses.push_back({std::min(b, c), std::max(b, c),
+                                radius2[i], tetraRadius2});
+      }
+    }
+  }
+  vertex = {{a}, 0.0, std::sqrt(vertexDeath2)};
+
+  // An edge dies when the first triangle or tetrahedron containing it
+  // is born.
+  std::sort(edgeUses.begin(), edgeUses.end(),
+            [](const LocalSimplices::EdgeUse& u,
+               const LocalSimplices::EdgeUse& v) { return u.B < v.B; });
+  for (size_t i = 0; i < edgeUses.size();)
+  {
+    size_t j = i + 1;
+    double cover2 = edgeUses[i].Cover2;
+    for (; j < edgeUses.size() && edgeUses[j].B == edgeUses[i].B; ++j)
+    {
+      cover2 = std::min(cover2, edgeUses[j].Cover2);
+    }
+    if (edgeUses[i].Length2 < cover2)
+    {
+      local.Edges.push_back({{a, edgeUses[i].B},
+                             std::sqrt(edgeUses[i].Length2),
+                             std::sqrt(cover2)});
+    }
+    i = j;
+  }
+
+  // A triangle is shared by one or two tetrahedra, and dies when the
+  // first of them is born.
+  std::sort(triangleUses.begin(), triangleUses.end(),
+            [](const LocalSimplices::TriangleUse& u,
+               const LocalSimplices::TriangleUse& v) {
+              return u.B < v.B || (u.B == v.B && u.C < v.C);
+            });
+  for (size_t i = 0; i < triangleUses.size();)
+  {
+    size_t j = i + 1;
+    double cover2 = triangleUses[i].TetraRadius2;
+    for (; j < triangleUses.size() &&
+         triangleUses[j].B == triangleUses[i].B &&
+         triangleUses[j].C == triangleUses[i].C;
+         ++j)
+    {
+      cover2 = std::min(cover2, triangleUses[j].TetraRadius2);
+    }
+    if (triangleUses[i].Radius2 < cover2)
+    {
+      local.Triangles.push_back(
+          {{a, triangleUses[i].B, triangleUses[i].C},
+           std::sqrt(triangleUses[i].Radius2), std::sqrt(cover2)});
+    }
+    i = j;
+  }
+}
+
+template <int N>
+void SortByBirth(std::vector<Simplex<N>>& simplices)
+{
+  vtkSMPTools::Sort(simplices.begin(), simplices.end(),
+                    [](const Simplex<N>& a, const Simplex<N>& b) {
+                      return a.Birth < b.Birth;
+                    });
+}
+
+int AlphaFiltrationDelaunay3D::FillInputPortInformation(int vtkNotUsed(port),
+                                                        vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkPointSet");
+  return 1;
+}
+
+int AlphaFiltrationDelaunay3D::RequestData(
+    vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector)
+{
+  vtkPointSet* input = vtkPointSet::GetData(inputVector[0]);
+  vtkUnstructuredGrid* output = vtkUnstructuredGrid::GetData(outputVector);
+
+  if (input->GetMTime() != this->FiltrationInputTime ||
+      this->Tolerance != this->FiltrationTolerance)
+  {
+    if (!this->BuildFiltration(input))
+    {
+      return 0;
+    }
+    this->FiltrationInputTime = input->GetMTime();
+    this->FiltrationTolerance = this->Tolerance;
+  }
+  this->ExtractComplex(output);
+  return 1;
+}
+
+bool AlphaFiltrationDelaunay3D::BuildFiltration(vtkPointSet* input)
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+
+  // Triangulate a copy, so that the internal pipeline does not hold on to
+  // the input.
+  vtkSmartPointer<vtkPointSet> copy =
+      vtkSmartPointer<vtkPointSet>::Take(input->NewInstance());
+  copy->ShallowCopy(input);
+  vtkNew<vtkDelaunay3D> delaunay3D;
+  delaunay3D->SetInputData(copy);
+  delaunay3D->SetTolerance(this->Tolerance);
+  delaunay3D->Update();
+  vtkUnstructuredGrid* mesh = delaunay3D->GetOutput();
+
+  vtkPoints* points = input->GetPoints();
+  const vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  const vtkIdType numberOfTetras = mesh->GetNumberOfCells();
+
+  std::vector<Simplex<4>> tetras(numberOfTetras);
+  auto iter = vtkSmartPointer<vtkCellArrayIterator>::Take(
+      mesh->GetCells()->NewIterator());
+  vtkIdType tetraId = 0;
+  for (iter->GoToFirstCell(); !iter->IsDoneWithTraversal();
+       iter->GoToNextCell(), ++tetraId)
+  {
+    vtkIdType npts;
+    const vtkIdType* pts;
+    iter->GetCurrentCell(npts, pts);
+    if (npts != 4 ||
+        std::any_of(pts, pts + 4, [numberOfPoints](vtkIdType id) {
+          return id >= numberOfPoints;
+        }))
+    {
+      vtkErrorMacro(<< "vtkDelaunay3D output a cell that is not a "
+                       "tetrahedron of the input points.");
+      return false;
+    }
+    std::copy(pts, pts + 4, tetras[tetraId].Ids);
+  }
+
+  vtkSMPTools::For(0, numberOfTetras, [&](vtkIdType begin, vtkIdType end) {
+    double x[4][3];
+    double center[3];
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        points->GetPoint(tetras[t].Ids[j], x[j]);
+      }
+      // Squared for now, like the radii below.
+      tetras[t].Birth = vtkTetra::Circumsphere(x[0], x[1], x[2], x[3], center);
+      tetras[t].Death = Never;
+    }
+  });
+
+  // The tetrahedra around each point.
+  std::vector<vtkIdType> incidenceOffsets(numberOfPoints + 1, 0);
+  for (const Simplex<4>& tetra : tetras)
+  {
+    for (vtkIdType id : tetra.Ids)
+    {
+      ++incidenceOffsets[id + 1];
+    }
+  }
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    incidenceOffsets[i + 1] += incidenceOffsets[i];
+  }
+  std::vector<vtkIdType> incidence(incidenceOffsets.back());
+  {
+    std::vector<vtkIdType> next(incidenceOffsets.begin(),
+                                incidenceOffsets.end() - 1);
+    for (vtkIdType t = 0; t < numberOfTetras; ++t)
+    {
+      for (vtkIdType id : tetras[t].Ids)
+      {
+        incidence[next[id]++] = t;
+      }
+    }
+  }
+
+  // Each point records its vertex, and the triangles and edges it is the
+  // smallest point of.
+  std::vector<Simplex<1>> vertices(numberOfPoints);
+  vtkSMPThreadLocal<LocalSimplices> localSimplices;
+  vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end) {
+    LocalSimplices& local = localSimplices.Local();
+    for (vtkIdType a = begin; a < end; ++a)
+    {
+      CollectSimplices(a, points, tetras,
+                       incidence.data() + incidenceOffsets[a],
+                       incidence.data() + incidenceOffsets[a + 1], local,
+                       vertices[a]);
+    }
+  });
+  vtkSMPTools::For(0, numberOfTetras, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+      tetras[t].Birth = std::sqrt(tetras[t].Birth);
+    }
+  });
+
+  std::vector<Simplex<3>> triangles;
+  std::vector<Simplex<2>> edges;
+  for (LocalSimplices& local : localSimplices)
+  {
+    triangles.insert(triangles.end(), local.Triangles.begin(),
+                     local.Triangles.end());
+    edges.insert(edges.end(), local.Edges.begin(), local.Edges.end());
+    local = LocalSimplices();
+  }
+  SortByBirth(tetras);
+  SortByBirth(triangles);
+  SortByBirth(edges);
+
+  this->TypeBegin[0] = 0;
+  this->TypeBegin[1] = numberOfTetras;
+  this->TypeBegin[2] = this->TypeBegin[1] + triangles.size();
+  this->TypeBegin[3] = this->TypeBegin[2] + edges.size();
+  this->TypeBegin[4] = this->TypeBegin[3] + numberOfPoints;
+  const vtkIdType numberOfCells = this->TypeBegin[4];
+  this->Offsets->SetNumberOfValues(numberOfCells + 1);
+  this->Connectivity->SetNumberOfValues(
+      4 * numberOfTetras + 3 * triangles.size() + 2 * edges.size() +
+      numberOfPoints);
+  this->Types->SetNumberOfValues(numberOfCells);
+  this->Birth->SetName("AlphaBirth");
+  this->Birth->SetNumberOfValues(numberOfCells);
+  this->Death->SetName("AlphaDeath");
+  this->Death->SetNumberOfValues(numberOfCells);
+
+  vtkIdType* offsets = this->Offsets->GetPointer(0);
+  vtkIdType* connectivity = this->Connectivity->GetPointer(0);
+  unsigned char* types = this->Types->GetPointer(0);
+  double* birth = this->Birth->GetPointer(0);
+  double* death = this->Death->GetPointer(0);
+  // The connectivity of each type starts where the previous one ends.
+  offsets[0] = 0;
+  CopySimplices(tetras, VTK_TETRA, this->TypeBegin[0], offsets, connectivity,
+                types, birth, death);
+  offsets[this->TypeBegin[1]] = 4 * numberOfTetras;
+  CopySimplices(triangles, VTK_TRIANGLE, this->TypeBegin[1], offsets,
+                connectivity, types, birth, death);
+  offsets[this->TypeBegin[2]] = 4 * numberOfTetras + 3 * triangles.size();
+  CopySimplices(edges, VTK_LINE, this->TypeBegin[2], offsets, connectivity,
+                types, birth, death);
+  offsets[this->TypeBegin[3]] =
+      4 * numberOfTetras + 3 * triangles.size() + 2 * edges.size();
+  CopySimplices(vertices, VTK_VERTEX, this->TypeBegin[3], offsets,
+                connectivity, types, birth, death);
+
+  vtkNew<vtkCellArray> cells;
+  cells->SetData(this->Offsets, this->Connectivity);
+  this->Filtration->Initialize();
+  this->Filtration->SetPoints(points);
+  this->Filtration->SetCells(this->Types, cells);
+  this->Filtration->GetCellData()->AddArray(this->Birth);
+  this->Filtration->GetCellData()->AddArray(this->Death);
+
+  timer->StopTimer();
+  this->FiltrationTime = timer->GetElapsedTime();
+  return true;
+}
+
+void AlphaFiltrationDelaunay3D::ExtractComplex(vtkUnstructuredGrid* output)
+{
+  const vtkIdType* offsets = this->Offsets->GetPointer(0);
+  const vtkIdType* connectivity = this->Connectivity->GetPointer(0);
+  const unsigned char* types = this->Types->GetPointer(0);
+  const double* birth = this->Birth->GetPointer(0);
+  const double* death = this->Death->GetPointer(0);
+  const double alpha = this->Alpha;
+
+  // The candidates are the simplices born at alpha. With alpha = 0, like
+  // vtkDelaunay3D, only the tetrahedra are output.
+  struct Block
+  {
+    vtkIdType Begin;
+    vtkIdType End;
+    vtkIdType Cells;
+    vtkIdType Size;
+  };
+  std::vector<Block> blocks;
+  for (int type = 0; type < 4; ++type)
+  {
+    vtkIdType begin = this->TypeBegin[type];
+    vtkIdType end = this->TypeBegin[type + 1];
+    if (alpha > 0.0)
+    {
+      end = std::upper_bound(birth + begin, birth + end, alpha) - birth;
+    }
+    else if (type > 0)
+    {
+      end = begin;
+    }
+    for (; begin < end; begin += BlockSize)
+    {
+      blocks.push_back({begin, std::min(begin + BlockSize, end), 0, 0});
+    }
+  }
+
+  const vtkIdType numberOfBlocks = static_cast<vtkIdType>(blocks.size());
+  vtkSMPTools::For(0, numberOfBlocks, [&](vtkIdType first, vtkIdType last) {
+    for (vtkIdType b = first; b < last; ++b)
+    {
+      Block& block = blocks[b];
+      for (vtkIdType i = block.Begin; i < block.End; ++i)
+      {
+        if (alpha < death[i])
+        {
+          ++block.Cells;
+          block.Size += offsets[i + 1] - offsets[i];
+        }
+      }
+    }
+  });
+  vtkIdType numberOfCells = 0;
+  vtkIdType size = 0;
+  for (Block& block : blocks)
+  {
+    std::swap(numberOfCells, block.Cells);
+    std::swap(size, block.Size);
+    numberOfCells += block.Cells;
+    size += block.Size;
+  }
+
+  vtkNew<vtkIdTypeArray> outputOffsets;
+  outputOffsets->SetNumberOfValues(numberOfCells + 1);
+  vtkNew<vtkIdTypeArray> outputConnectivity;
+  outputConnectivity->SetNumberOfValues(size);
+  vtkNew<vtkUnsignedCharArray> outputTypes;
+  outputTypes->SetNumberOfValues(numberOfCells);
+  vtkIdType* outOffsets = outputOffsets->GetPointer(0);
+  vtkIdType* outConnectivity = outputConnectivity->GetPointer(0);
+  unsigned char* outTypes = outputTypes->GetPointer(0);
+  outOffsets[numberOfCells] = size;
+  vtkSMPTools::For(0, numberOfBlocks, [&](vtkIdType first, vtkIdType last) {
+    for (vtkIdType b = first; b < last; ++b)
+    {
+      const Block& block = blocks[b];
+      vtkIdType cell = block.Cells;
+      vtkIdType offset = block.Size;
+      for (vtkIdType i = block.Begin; i < block.End; ++i)
+      {
+        if (alpha < death[i])
+        {
+          outOffsets[cell] = offset;
+          outTypes[cell++] = types[i];
+          offset = std::copy(connectivity + offsets[i],
+                             connectivity + offsets[i + 1],
+                             outConnectivity + offset) -
+              outConnectivity;
+        }
+      }
+    }
+  });
+
+  vtkNew<vtkCellArray> cells;
+  cells->SetData(outputOffsets, outputConnectivity);
+  output->SetPoints(this->Filtration->GetPoints());
+  output->SetCells(outputTypes, cells);
+}
+
+void MakeCloud(vtkIdType numberOfPoints, vtkPolyData* cloud)
+{
+  vtkNew<vtkMinimalStandardRandomSequence> random;
+  random->SetSeed(8775070);
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+    {
+      x[j] = random->GetValue();
+      random->Next();
+    }
+    points->SetPoint(i, x);
+  }
+  cloud->SetPoints(points);
+}
+
+std::array<vtkIdType, 4> CountCells(vtkUnstructuredGrid* grid)
+{
+  std::array<vtkIdType, 4> counts = {0, 0, 0, 0};
+  for (vtkIdType i = 0; i < grid->GetNumberOfCells(); ++i)
+  {
+    switch (grid->GetCellType(i))
+    {
+    case VTK_TETRA:
+      ++counts[0];
+      break;
+    case VTK_TRIANGLE:
+      ++counts[1];
+      break;
+    case VTK_LINE:
+      ++counts[2];
+      break;
+    case VTK_VERTEX:
+      ++counts[3];
+      break;
+    default:
+      break;
+    }
+  }
+  return counts;
+}
+
+bool SameCells(vtkUnstructuredGrid* a, vtkUnstructuredGrid* b)
+{
+  // The cell type, then the sorted point ids padded with -1.
+  auto keys = [](vtkUnstructuredGrid* grid) {
+    std::vector<std::array<vtkIdType, 5>> cellKeys(grid->GetNumberOfCells());
+    vtkNew<vtkIdList> ids;
+    for (vtkIdType i = 0; i < grid->GetNumberOfCells(); ++i)
+    {
+      std::array<vtkIdType, 5>& key = cellKeys[i];
+      key.fill(-1);
+      key[0] = grid->GetCellType(i);
+      grid->GetCellPoints(i, ids);
+      const vtkIdType n = std::min<vtkIdType>(ids->GetNumberOfIds(), 4);
+      for (vtkIdType j = 0; j < n; ++j)
+      {
+        key[j + 1] = ids->GetId(j);
+      }
+      std::sort(key.begin() + 1, key.begin() + 1 + n);
+    }
+    vtkSMPTools::Sort(cellKeys.begin(), cellKeys.end());
+    return cellKeys;
+  };
+  return a->GetNumberOfCells() == b->GetNumberOfCells() &&
+      keys(a) == keys(b);
+}
+} // namespace
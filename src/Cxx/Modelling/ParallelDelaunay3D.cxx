@@ -0,0 +1,1351 @@
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkDelaunay3D.h>
+#include <vtkIdTypeArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkTetra.h>
+#include <vtkTimerLog.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkUnstructuredGridAlgorithm.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+/**
+ * vtkDelaunay3D with a spatially sorted insertion order, and a parallel
+ * mode that triangulates regions of space concurrently.
+ *
+ * vtkDelaunay3D inserts the points in input order. Sorting them along a
+ * Hilbert curve keeps consecutive insertions close together, so the search
+ * for the tetrahedron containing the next point is short and touches memory
+ * that is in cache. BRIO (biased randomized insertion order) inserts random
+ * rounds of growing size, each sorted along the curve, which keeps the
+ * locality and avoids the long thin tetrahedra a purely sorted order makes
+ * early on.
+ *
+ * With NumberOfRegions > 1, the bounds are split into a grid of regions.
+ * Each region triangulates its points plus a halo around them with its own
+ * vtkDelaunay3D, in parallel. A point of the region is resolved when every
+ * tetrahedron around it is certified Delaunay for all the points: either
+ * its circumsphere lies in the triangulated window, or no point outside the
+ * window is in it. The resolved points output the tetrahedra around them
+ * of which they are the smallest point id, so every tetrahedron is output
+ * once. The unresolved points, mostly near the convex hull where the
+ * circumspheres are large, are split in small cells and triangulated again
+ * with twice the halo, until the last round uses all the points. The
+ * points are assumed to be in general position, and points closer than
+ * Tolerance are merged first. Slivers on the hull with circumspheres
+ * larger than the bounds may be left out, as vtkDelaunay3D mostly does.
+ */
+class SortedDelaunay3D : public vtkUnstructuredGridAlgorithm
+{
+public:
+  static SortedDelaunay3D* New();
+  vtkTypeMacro(SortedDelaunay3D, vtkUnstructuredGridAlgorithm);
+
+  enum InsertionOrders
+  {
+    INPUT_ORDER,
+    HILBERT,
+    BRIO
+  };
+
+  vtkSetClampMacro(InsertionOrder, int, INPUT_ORDER, BRIO);
+  vtkGetMacro(InsertionOrder, int);
+
+  /**
+   * The number of regions triangulated in parallel, 1 for a single
+   * vtkDelaunay3D.
+   */
+  vtkSetClampMacro(NumberOfRegions, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfRegions, int);
+
+  /**
+   * The halo around each region, in mean point spacings of the region.
+   */
+  vtkSetClampMacro(HaloFactor, double, 0.5, VTK_DOUBLE_MAX);
+  vtkGetMacro(HaloFactor, double);
+
+  /**
+   * As for vtkDelaunay3D, a fraction of the diagonal of the bounds.
+   */
+  vtkSetClampMacro(Tolerance, double, 0.0, 1.0);
+  vtkGetMacro(Tolerance, double);
+
+  /**
+   * For the last parallel execution: the number of rounds of
+   * triangulation, and the number of points that were not resolved by the
+   * first round.
+   */
+  vtkGetMacro(NumberOfRounds, int);
+  vtkGetMacro(NumberOfConflictPoints, vtkIdType);
+
+  /**
+   * The memory used by the last execution besides the input and output, in
+   * kibibytes: the point bins and the region triangulations of the first
+   * round.
+   */
+  vtkGetMacro(WorkingMemorySize, vtkIdType);
+
+protected:
+  SortedDelaunay3D() = default;
+  ~SortedDelaunay3D() override = default;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  void TriangulateRegions(vtkPoints* points, const double bounds[6],
+                          std::vector<vtkIdType>& tetras);
+
+  int InsertionOrder = BRIO;
+  int NumberOfRegions = 1;
+  double HaloFactor = 3.0;
+  double Tolerance = 0.001;
+  int NumberOfRounds = 0;
+  vtkIdType NumberOfConflictPoints = 0;
+  vtkIdType WorkingMemorySize = 0;
+
+private:
+  SortedDelaunay3D(const SortedDelaunay3D&) = delete;
+  void operator=(const SortedDelaunay3D&) = delete;
+};
+
+vtkStandardNewMacro(SortedDelaunay3D);
+
+// Points in the unit cube, in random order: uniform, or in Gaussian
+// clusters of different sizes.
+void MakeCloud(vtkIdType numberOfPoints, bool clustered, vtkPolyData* cloud);
+
+// The number of tetrahedra with a point of the mesh strictly inside their
+// circumsphere.
+vtkIdType CountDelaunayViolations(vtkUnstructuredGrid* mesh);
+
+// The number of tetrahedra that are in only one of the meshes, and how many
+// of those have their circumsphere inside the bounds of the points: those
+// are the same in any Delaunay triangulation of points in general
+// position.
+void CompareTetras(vtkUnstructuredGrid* a, vtkUnstructuredGrid* b,
+                   vtkIdType& differing, vtkIdType& interiorDiffering);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Defaults are small; the benchmark is meant for 100000 to 10000000.
+  vtkIdType numberOfPoints = 20000;
+  int numberOfRegions =
+      std::max(8, 2 * vtkSMPTools::GetEstimatedNumberOfThreads());
+  if (argc > 1)
+  {
+    numberOfPoints = std::stoll(argv[1]);
+  }
+  if (argc > 2)
+  {
+    numberOfRegions = std::max(std::stoi(argv[2]), 2);
+  }
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+
+  // Random points have no near duplicates at this tolerance, so all the
+  // modes triangulate the same points.
+  const double tolerance = 1e-7;
+  bool ok = true;
+  for (bool clustered : {false, true})
+  {
+    vtkNew<vtkPolyData> cloud;
+    MakeCloud(numberOfPoints, clustered, cloud);
+    std::cout << numberOfPoints << (clustered ? " clustered" : " uniform")
+              << " points" << std::endl;
+    std::cout << std::left << std::setw(22) << "Mode" << std::right
+              << std::setw(12) << "Time" << std::setw(12) << "Memory"
+              << std::setw(12) << "Tetras" << std::setw(12) << "Violations"
+              << std::setw(12) << "Differing" << std::endl;
+
+    vtkNew<vtkTimerLog> timer;
+    vtkNew<vtkDelaunay3D> reference;
+    reference->SetInputData(cloud);
+    reference->SetTolerance(tolerance);
+    timer->StartTimer();
+    reference->Update();
+    timer->StopTimer();
+
+    auto report = [&](const std::string& name, double seconds,
+                      vtkIdType workingMemory, vtkUnstructuredGrid* mesh,
+                      bool compare) {
+      const vtkIdType violations = CountDelaunayViolations(mesh);
+      std::cout << std::left << std::setw(22) << name << std::right
+                << std::setw(9) << 1000.0 * seconds << " ms" << std::setw(9)
+                << (workingMemory + mesh->GetActualMemorySize()) / 1024.0
+                << " MB" << std::setw(12) << mesh->GetNumberOfCells()
+                << std::setw(12) << violations;
+      ok = ok && violations == 0 && mesh->GetNumberOfCells() > 0;
+      if (compare)
+      {
+        vtkIdType differing;
+        vtkIdType interiorDiffering;
+        CompareTetras(reference->GetOutput(), mesh, differing,
+                      interiorDiffering);
+        std::cout << std::setw(12) << differing;
+        if (interiorDiffering > 0)
+        {
+          std::cout << " (" << interiorDiffering << " inside)";
+          ok = false;
+        }
+      }
+      std::cout << std::endl;
+    };
+    report("vtkDelaunay3D", timer->GetElapsedTime(), 0,
+           reference->GetOutput(), false);
+
+    struct Mode
+    {
+      const char* Name;
+      int Order;
+      int Regions;
+    };
+    const std::string parallelName =
+        "BRIO, " + std::to_string(numberOfRegions) + " regions";
+    for (const Mode& mode :
+         {Mode{"Hilbert", SortedDelaunay3D::HILBERT, 1},
+          Mode{"BRIO", SortedDelaunay3D::BRIO, 1},
+          Mode{parallelName.c_str(), SortedDelaunay3D::BRIO,
+               numberOfRegions}})
+    {
+      vtkNew<SortedDelaunay3D> delaunay3D;
+      delaunay3D->SetInputData(cloud);
+      delaunay3D->SetTolerance(tolerance);
+      delaunay3D->SetInsertionOrder(mode.Order);
+      delaunay3D->SetNumberOfRegions(mode.Regions);
+      timer->StartTimer();
+      delaunay3D->Update();
+      timer->StopTimer();
+      report(mode.Name, timer->GetElapsedTime(),
+             delaunay3D->GetWorkingMemorySize(), delaunay3D->GetOutput(),
+             true);
+      if (mode.Regions > 1)
+      {
+        std::cout << "  " << delaunay3D->GetNumberOfRounds() << " rounds, "
+                  << delaunay3D->GetNumberOfConflictPoints()
+                  << " points triangulated again" << std::endl;
+      }
+    }
+  }
+  std::cout << (ok ? "All triangulations are Delaunay"
+                   : "Some triangulations are NOT Delaunay or differ")
+            << std::endl;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+// Bits per axis of the Hilbert keys, leaving room for the BRIO round.
+const int HilbertBits = 19;
+
+// Rounds of region triangulation before the last one, which triangulates
+// the remaining points with all the points.
+const int MaximumRounds = 5;
+
+// The points in each cell of a regular grid over some bounds, as
+// compressed rows.
+struct PointBins
+{
+  double Origin[3];
+  double Spacing[3];
+  int Dimensions[3];
+  std::vector<vtkIdType> Offsets;
+  std::vector<vtkIdType> Ids;
+
+  void Build(vtkPoints* points, const std::vector<vtkIdType>& ids,
+             const double bounds[6], double pointsPerBin);
+
+  vtkIdType GetMemorySize() const
+  {
+    return static_cast<vtkIdType>(
+        (this->Offsets.size() + this->Ids.size()) * sizeof(vtkIdType) / 1024);
+  }
+
+  int Index(double x, int axis) const
+  {
+    const double i = std::floor((x - this->Origin[axis]) / this->Spacing[axis]);
+    return static_cast<int>(
+        std::clamp(i, 0.0, this->Dimensions[axis] - 1.0));
+  }
+
+  vtkIdType Bin(int i, int j, int k) const
+  {
+    return i +
+        static_cast<vtkIdType>(this->Dimensions[0]) *
+        (j + static_cast<vtkIdType>(this->Dimensions[1]) * k);
+  }
+
+  // Calls f(id) for the points in the bins that overlap the box, until f
+  // returns false. The caller tests the points.
+  template <typename F> void ForEachInBox(const double box[6], F&& f) const
+  {
+    int lo[3];
+    int hi[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      lo[axis] = this->Index(box[2 * axis], axis);
+      hi[axis] = this->Index(box[2 * axis + 1], axis);
+    }
+    for (int k = lo[2]; k <= hi[2]; ++k)
+    {
+      for (int j = lo[1]; j <= hi[1]; ++j)
+      {
+        const vtkIdType row = this->Bin(0, j, k);
+        for (vtkIdType b = this->Offsets[row + lo[0]];
+             b < this->Offsets[row + hi[0] + 1]; ++b)
+        {
+          if (!f(this->Ids[b]))
+          {
+            return;
+          }
+        }
+      }
+    }
+  }
+
+  // As ForEachInBox, for the bins that overlap the sphere. Only the bins
+  // of each column that the sphere crosses are visited, so that the thin
+  // caps of large spheres are cheap.
+  template <typename F>
+  void ForEachInSphere(const double center[3], double radius, F&& f) const
+  {
+    int lo[2];
+    int hi[2];
+    for (int axis = 0; axis < 2; ++axis)
+    {
+      lo[axis] = this->Index(center[axis] - radius, axis);
+      hi[axis] = this->Index(center[axis] + radius, axis);
+    }
+    const double radius2 = radius * radius;
+    for (int j = lo[1]; j <= hi[1]; ++j)
+    {
+      const double y0 = this->Origin[1] + j * this->Spacing[1];
+      const double dy = std::max(
+          {y0 - center[1], 0.0, center[1] - y0 - this->Spacing[1]});
+      for (int i = lo[0]; i <= hi[0]; ++i)
+      {
+        const double x0 = this->Origin[0] + i * this->Spacing[0];
+        const double dx = std::max(
+            {x0 - center[0], 0.0, center[0] - x0 - this->Spacing[0]});
+        const double remaining2 = radius2 - dx * dx - dy * dy;
+        if (remaining2 < 0.0)
+        {
+          continue;
+        }
+        const double dz = std::sqrt(remaining2);
+        const int khi = this->Index(center[2] + dz, 2);
+        for (int k = this->Index(center[2] - dz, 2); k <= khi; ++k)
+        {
+          const vtkIdType bin = this->Bin(i, j, k);
+          for (vtkIdType b = this->Offsets[bin]; b < this->Offsets[bin + 1];
+               ++b)
+          {
+            if (!f(this->Ids[b]))
+            {
+              return;
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+// The mean distance between count points spread over the box. The axes
+// along which the box is flat are left out.
+double MeanSpacing(const double box[6], double count)
+{
+  double extent[3];
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    extent[axis] = std::max(box[2 * axis + 1] - box[2 * axis], 0.0);
+  }
+  const double largest = std::max({extent[0], extent[1], extent[2]});
+  if (largest == 0.0)
+  {
+    return 1.0;
+  }
+  double volume = 1.0;
+  int dimension = 0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (extent[axis] > 1e-6 * largest)
+    {
+      volume *= extent[axis];
+      ++dimension;
+    }
+  }
+  return std::pow(volume / std::max(count, 1.0), 1.0 / dimension);
+}
+
+void PointBins::Build(vtkPoints* points, const std::vector<vtkIdType>& ids,
+                      const double bounds[6], double pointsPerBin)
+{
+  const double binSize = MeanSpacing(bounds, ids.size() / pointsPerBin);
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    const double extent = bounds[2 * axis + 1] - bounds[2 * axis];
+    this->Origin[axis] = bounds[2 * axis];
+    this->Dimensions[axis] =
+        std::clamp(static_cast<int>(extent / binSize), 1, 1 << 16);
+    this->Spacing[axis] =
+        extent > 0.0 ? extent / this->Dimensions[axis] : 1.0;
+  }
+
+  const vtkIdType numberOfIds = static_cast<vtkIdType>(ids.size());
+  std::vector<vtkIdType> binOfId(numberOfIds);
+  vtkSMPTools::For(0, numberOfIds, [&](vtkIdType begin, vtkIdType end) {
+    double x[3];
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      points->GetPoint(ids[i], x);
+      binOfId[i] = this->Bin(this->Index(x[0], 0), this->Index(x[1], 1),
+                             this->Index(x[2], 2));
+    }
+  });
+  this->Offsets.assign(this->Bin(0, 0, this->Dimensions[2]) + 1, 0);
+  for (vtkIdType bin : binOfId)
+  {
+    ++this->Offsets[bin + 1];
+  }
+  for (size_t b = 1; b < this->Offsets.size(); ++b)
+  {
+    this->Offsets[b] += this->Offsets[b - 1];
+  }
+  this->Ids.resize(numberOfIds);
+  std::vector<vtkIdType> next(this->Offsets.begin(), this->Offsets.end() - 1);
+  for (vtkIdType i = 0; i < numberOfIds; ++i)
+  {
+    this->Ids[next[binOfId[i]]++] = ids[i];
+  }
+}
+
+// The position along a Hilbert curve with 2^HilbertBits cells per axis of
+// the quantized coordinates, from Skilling's transposed form.
+std::uint64_t HilbertKey(std::uint32_t x[3])
+{
+  const std::uint32_t m = 1u << (HilbertBits - 1);
+  for (std::uint32_t q = m; q > 1; q >>= 1)
+  {
+    const std::uint32_t p = q - 1;
+    for (int i = 0; i < 3; ++i)
+    {
+      if (x[i] & q)
+      {
+        x[0] ^= p;
+      }
+      else
+      {
+        const std::uint32_t t = (x[0] ^ x[i]) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+  x[1] ^= x[0];
+  x[2] ^= x[1];
+  std::uint32_t t = 0;
+  for (std::uint32_t q = m; q > 1; q >>= 1)
+  {
+    if (x[2] & q)
+    {
+      t ^= q - 1;
+    }
+  }
+  std::uint64_t key = 0;
+  for (int b = HilbertBits - 1; b >= 0; --b)
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      key = (key << 1) | (((x[i] ^ t) >> b) & 1u);
+    }
+  }
+  return key;
+}
+
+// Reorders ids for insertion. The BRIO round of a point is the number of
+// trailing zero bits of a hash of its id, so that each round has about
+// half the points of the next one; the smallest round is inserted first.
+void SortForInsertion(vtkPoints* points, const double bounds[6], int order,
+                      std::vector<vtkIdType>& ids)
+{
+  if (order == SortedDelaunay3D::INPUT_ORDER)
+  {
+    return;
+  }
+  const int maximumRound = 63 - 3 * HilbertBits;
+  const double cells = static_cast<double>(1u << HilbertBits);
+  double scale[3];
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    const double extent = bounds[2 * axis + 1] - bounds[2 * axis];
+    scale[axis] = extent > 0.0 ? (cells - 1.0) / extent : 0.0;
+  }
+  const vtkIdType numberOfIds = static_cast<vtkIdType>(ids.size());
+  std::vector<std::pair<std::uint64_t, vtkIdType>> keys(numberOfIds);
+  vtkSMPTools::For(0, numberOfIds, [&](vtkIdType begin, vtkIdType end) {
+    double x[3];
+    std::uint32_t q[3];
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      points->GetPoint(ids[i], x);
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        q[axis] = static_cast<std::uint32_t>(std::clamp(
+            (x[axis] - bounds[2 * axis]) * scale[axis], 0.0, cells - 1.0));
+      }
+      std::uint64_t key = HilbertKey(q);
+      if (order == SortedDelaunay3D::BRIO)
+      {
+        // SplitMix64 of the id.
+        std::uint64_t h = static_cast<std::uint64_t>(ids[i]) +
+            0x9e3779b97f4a7c15ull;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+        h ^= h >> 31;
+        int round = 0;
+        while (round < maximumRound && !(h & (1ull << round)))
+        {
+          ++round;
+        }
+        key |= static_cast<std::uint64_t>(maximumRound - round)
+            << (3 * HilbertBits);
+      }
+      keys[i] = {key, ids[i]};
+    }
+  });
+  vtkSMPTools::Sort(keys.begin(), keys.end());
+  for (vtkIdType i = 0; i < numberOfIds; ++i)
+  {
+    ids[i] = keys[i].second;
+  }
+}
+
+// Triangulates the points ids, inserted in that order, with vtkDelaunay3D
+// and appends the tetrahedra, as point ids, to tetras. Returns the size of
+// the triangulation in kibibytes.
+vtkIdType Triangulate(vtkPoints* points, const std::vector<vtkIdType>& ids,
+                      double tolerance, std::vector<vtkIdType>& tetras)
+{
+  const vtkIdType numberOfIds = static_cast<vtkIdType>(ids.size());
+  vtkNew<vtkPoints> subset;
+  subset->SetDataTypeToDouble();
+  subset->SetNumberOfPoints(numberOfIds);
+  double x[3];
+  for (vtkIdType i = 0; i < numberOfIds; ++i)
+  {
+    points->GetPoint(ids[i], x);
+    subset->SetPoint(i, x);
+  }
+  vtkNew<vtkPolyData> cloud;
+  cloud->SetPoints(subset);
+  vtkNew<vtkDelaunay3D> delaunay3D;
+  delaunay3D->SetInputData(cloud);
+  delaunay3D->SetTolerance(tolerance);
+  delaunay3D->Update();
+
+  vtkUnstructuredGrid* mesh = delaunay3D->GetOutput();
+  tetras.reserve(tetras.size() + 4 * mesh->GetNumberOfCells());
+  auto iter = vtkSmartPointer<vtkCellArrayIterator>::Take(
+      mesh->GetCells()->NewIterator());
+  for (iter->GoToFirstCell(); !iter->IsDoneWithTraversal();
+       iter->GoToNextCell())
+  {
+    vtkIdType npts;
+    const vtkIdType* pts;
+    iter->GetCurrentCell(npts, pts);
+    if (npts == 4)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        tetras.push_back(ids[pts[j]]);
+      }
+    }
+  }
+  return static_cast<vtkIdType>(mesh->GetActualMemorySize());
+}
+
+bool InsideBox(const double box[6], const double x[3])
+{
+  return x[0] >= box[0] && x[0] <= box[1] && x[1] >= box[2] &&
+      x[1] <= box[3] && x[2] >= box[4] && x[2] <= box[5];
+}
+
+// Whether the part of the sphere inside the bounds is inside the window.
+bool SphereInWindow(const double center[3], double radius,
+                    const double window[6], const double bounds[6])
+{
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if ((center[axis] - radius < window[2 * axis] &&
+         window[2 * axis] > bounds[2 * axis]) ||
+        (center[axis] + radius > window[2 * axis + 1] &&
+         window[2 * axis + 1] < bounds[2 * axis + 1]))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The state shared by the regions.
+struct RegionContext
+{
+  vtkPoints* Points;
+  double Bounds[6];
+  PointBins Bins;
+  // Whether each point is triangulated, or merged with another one.
+  std::vector<unsigned char> Kept;
+  // The diagonal of the bounds.
+  double SliverRadius;
+
+  // Whether a point outside the window is strictly inside the sphere.
+  bool PointInSphere(const double window[6], const double center[3],
+                     double radius2, const vtkIdType ids[4]) const
+  {
+    bool found = false;
+    this->Bins.ForEachInSphere(
+        center, std::sqrt(radius2), [&](vtkIdType id) {
+          double y[3];
+          this->Points->GetPoint(id, y);
+          found = this->Kept[id] && !InsideBox(window, y) &&
+              vtkMath::Distance2BetweenPoints(y, center) < radius2 &&
+              std::find(ids, ids + 4, id) == ids + 4;
+          return !found;
+        });
+    return found;
+  }
+
+  // Whether a point is strictly beyond the triangle and inside the sphere
+  // of radius SliverRadius through it. With no such point, a tetrahedron on
+  // that side of the triangle would be a sliver on the convex hull with a
+  // larger sphere, which vtkDelaunay3D mostly leaves out too.
+  bool PointBeyondFace(const double x[3][3], const double normal[3],
+                       const vtkIdType ids[3]) const
+  {
+    double u[3];
+    double v[3];
+    double uv[3];
+    vtkMath::Subtract(x[1], x[0], u);
+    vtkMath::Subtract(x[2], x[0], v);
+    vtkMath::Cross(u, v, uv);
+    const double uv2 = vtkMath::Dot(uv, uv);
+    if (uv2 == 0.0)
+    {
+      return true;
+    }
+    double w[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      w[axis] = vtkMath::Dot(u, u) * v[axis] - vtkMath::Dot(v, v) * u[axis];
+    }
+    double center[3];
+    vtkMath::Cross(w, uv, center);
+    const double r2 = vtkMath::Dot(center, center) / (4.0 * uv2 * uv2);
+    const double radius = std::max(this->SliverRadius, std::sqrt(r2));
+    const double height = std::sqrt(std::max(radius * radius - r2, 0.0)) /
+        vtkMath::Norm(normal);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      center[axis] = x[0][axis] + center[axis] / (2.0 * uv2) +
+          height * normal[axis];
+    }
+    const double radius2 = radius * radius;
+    bool found = false;
+    this->Bins.ForEachInSphere(center, radius, [&](vtkIdType id) {
+      double y[3];
+      this->Points->GetPoint(id, y);
+      found = this->Kept[id] &&
+          vtkMath::Distance2BetweenPoints(y, center) < radius2 &&
+          normal[0] * (y[0] - x[0][0]) + normal[1] * (y[1] - x[0][1]) +
+                  normal[2] * (y[2] - x[0][2]) >
+              0.0 &&
+          std::find(ids, ids + 3, id) == ids + 3;
+      return !found;
+    });
+    return found;
+  }
+};
+
+// Finds which of the pending points have the same tetrahedra around them
+// in the triangulation tetras of the points in the window as in the
+// triangulation of all the points. Appends the tetrahedra of which those
+// points are the smallest id to output, and leaves the other points in
+// pending. In the last round the window has all the points.
+void ResolveStars(const RegionContext& context, const double window[6],
+                  bool last, const std::vector<vtkIdType>& tetras,
+                  std::vector<vtkIdType>& pending,
+                  std::vector<vtkIdType>& output)
+{
+  std::unordered_map<vtkIdType, vtkIdType> pendingIndex;
+  pendingIndex.reserve(pending.size());
+  for (size_t k = 0; k < pending.size(); ++k)
+  {
+    pendingIndex[pending[k]] = static_cast<vtkIdType>(k);
+  }
+
+  // The tetrahedra around each pending point, as compressed rows.
+  const vtkIdType numberOfTetras = static_cast<vtkIdType>(tetras.size() / 4);
+  std::vector<vtkIdType> starOffsets(pending.size() + 1, 0);
+  std::vector<vtkIdType> starTetras;
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    std::vector<vtkIdType> next(starOffsets.begin(), starOffsets.end() - 1);
+    for (vtkIdType t = 0; t < numberOfTetras; ++t)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        auto found = pendingIndex.find(tetras[4 * t + j]);
+        if (found == pendingIndex.end())
+        {
+          continue;
+        }
+        if (pass == 0)
+        {
+          ++starOffsets[found->second + 1];
+        }
+        else
+        {
+          starTetras[next[found->second]++] = t;
+        }
+      }
+    }
+    if (pass == 0)
+    {
+      for (size_t k = 0; k < pending.size(); ++k)
+      {
+        starOffsets[k + 1] += starOffsets[k];
+      }
+      starTetras.resize(starOffsets.back());
+    }
+  }
+
+  // Whether a tetrahedron is Delaunay for all the points, computed once.
+  // The triangulation makes it so for the points of the window, so only
+  // the points outside are tested.
+  std::vector<signed char> certified(numberOfTetras, -1);
+  auto certify = [&](vtkIdType t) {
+    if (certified[t] < 0)
+    {
+      const vtkIdType* ids = &tetras[4 * t];
+      double x[4][3];
+      for (int j = 0; j < 4; ++j)
+      {
+        context.Points->GetPoint(ids[j], x[j]);
+      }
+      double center[3];
+      const double radius2 =
+          vtkTetra::Circumsphere(x[0], x[1], x[2], x[3], center);
+      certified[t] = SphereInWindow(center, std::sqrt(radius2), window,
+                                    context.Bounds) ||
+              !context.PointInSphere(window, center, radius2, ids)
+          ? 1
+          : 0;
+    }
+    return certified[t] == 1;
+  };
+
+  // The triangles around a point, as the two other points of the
+  // triangle and the fourth point of the tetrahedron.
+  std::vector<std::array<vtkIdType, 3>> faces;
+  std::vector<vtkIdType> unresolved;
+  for (size_t k = 0; k < pending.size(); ++k)
+  {
+    const vtkIdType p = pending[k];
+    bool resolved = last || starOffsets[k + 1] > starOffsets[k];
+    for (vtkIdType s = starOffsets[k];
+         !last && resolved && s < starOffsets[k + 1]; ++s)
+    {
+      resolved = certify(starTetras[s]);
+    }
+
+    // Where the tetrahedra do not close around the point, the triangle on
+    // the open side must be on the convex hull of all the points.
+    faces.clear();
+    for (vtkIdType s = starOffsets[k];
+         !last && resolved && s < starOffsets[k + 1]; ++s)
+    {
+      const vtkIdType* ids = &tetras[4 * starTetras[s]];
+      vtkIdType others[3];
+      int n = 0;
+      for (int j = 0; j < 4; ++j)
+      {
+        if (ids[j] != p)
+        {
+          others[n++] = ids[j];
+        }
+      }
+      for (int j = 0; j < 3; ++j)
+      {
+        const vtkIdType a = others[(j + 1) % 3];
+        const vtkIdType b = others[(j + 2) % 3];
+        faces.push_back({std::min(a, b), std::max(a, b), others[j]});
+      }
+    }
+    std::sort(faces.begin(), faces.end());
+    for (size_t f = 0; resolved && f < faces.size();)
+    {
+      size_t g = f + 1;
+      while (g < faces.size() && faces[g][0] == faces[f][0] &&
+             faces[g][1] == faces[f][1])
+      {
+        ++g;
+      }
+      if (g == f + 1)
+      {
+        const vtkIdType ids[3] = {p, faces[f][0], faces[f][1]};
+        double x[3][3];
+        double opposite[3];
+        for (int j = 0; j < 3; ++j)
+        {
+          context.Points->GetPoint(ids[j], x[j]);
+        }
+        context.Points->GetPoint(faces[f][2], opposite);
+        double u[3];
+        double v[3];
+        double w[3];
+        double normal[3];
+        vtkMath::Subtract(x[1], x[0], u);
+        vtkMath::Subtract(x[2], x[0], v);
+        vtkMath::Subtract(opposite, x[0], w);
+        vtkMath::Cross(u, v, normal);
+        if (vtkMath::Dot(normal, w) > 0.0)
+        {
+          vtkMath::MultiplyScalar(normal, -1.0);
+        }
+        resolved = !context.PointBeyondFace(x, normal, ids);
+      }
+      f = g;
+    }
+
+    if (!resolved)
+    {
+      unresolved.push_back(p);
+      continue;
+    }
+    for (vtkIdType s = starOffsets[k]; s < starOffsets[k + 1]; ++s)
+    {
+      const vtkIdType* ids = &tetras[4 * starTetras[s]];
+      if (*std::min_element(ids, ids + 4) == p)
+      {
+        output.insert(output.end(), ids, ids + 4);
+      }
+    }
+  }
+  pending.swap(unresolved);
+}
+
+int SortedDelaunay3D::FillInputPortInformation(int vtkNotUsed(port),
+                                               vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkPointSet");
+  return 1;
+}
+
+int SortedDelaunay3D::RequestData(vtkInformation* vtkNotUsed(request),
+                                  vtkInformationVector** inputVector,
+                                  vtkInformationVector* outputVector)
+{
+  vtkPointSet* input = vtkPointSet::GetData(inputVector[0]);
+  vtkUnstructuredGrid* output = vtkUnstructuredGrid::GetData(outputVector);
+
+  vtkPoints* points = input->GetPoints();
+  const vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  if (numberOfPoints < 4)
+  {
+    vtkErrorMacro(<< "At least four points are needed.");
+    return 0;
+  }
+  double bounds[6];
+  input->GetBounds(bounds);
+
+  std::vector<vtkIdType> tetras;
+  this->NumberOfRounds = 0;
+  this->NumberOfConflictPoints = 0;
+  if (this->NumberOfRegions > 1)
+  {
+    this->TriangulateRegions(points, bounds, tetras);
+  }
+  else
+  {
+    std::vector<vtkIdType> ids(numberOfPoints);
+    std::iota(ids.begin(), ids.end(), 0);
+    SortForInsertion(points, bounds, this->InsertionOrder, ids);
+    this->WorkingMemorySize =
+        static_cast<vtkIdType>(ids.size() * sizeof(vtkIdType) / 1024) +
+        Triangulate(points, ids, this->Tolerance, tetras);
+  }
+
+  const vtkIdType numberOfTetras = static_cast<vtkIdType>(tetras.size() / 4);
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(numberOfTetras + 1);
+  for (vtkIdType t = 0; t <= numberOfTetras; ++t)
+  {
+    offsets->SetValue(t, 4 * t);
+  }
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(4 * numberOfTetras);
+  std::copy(tetras.begin(), tetras.end(), connectivity->GetPointer(0));
+  vtkNew<vtkCellArray> cells;
+  cells->SetData(offsets, connectivity);
+  output->SetPoints(points);
+  output->SetCells(VTK_TETRA, cells);
+  return 1;
+}
+
+void SortedDelaunay3D::TriangulateRegions(vtkPoints* points,
+                                          const double bounds[6],
+                                          std::vector<vtkIdType>& tetras)
+{
+  const vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  RegionContext context;
+  context.Points = points;
+  std::copy(bounds, bounds + 6, context.Bounds);
+  std::vector<vtkIdType> ids(numberOfPoints);
+  std::iota(ids.begin(), ids.end(), 0);
+  context.Bins.Build(points, ids, bounds, 2.0);
+
+  // Merge the points closer than Tolerance, keeping the first one as
+  // vtkDelaunay3D does, so that all the regions skip the same points.
+  double diagonal2 = 0.0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    const double extent = bounds[2 * axis + 1] - bounds[2 * axis];
+    diagonal2 += extent * extent;
+  }
+  const double tolerance2 = this->Tolerance * this->Tolerance * diagonal2;
+  const double tolerance = std::sqrt(tolerance2);
+  context.SliverRadius = std::sqrt(diagonal2);
+  context.Kept.assign(numberOfPoints, 0);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    double x[3];
+    points->GetPoint(i, x);
+    const double box[6] = {x[0] - tolerance, x[0] + tolerance,
+                           x[1] - tolerance, x[1] + tolerance,
+                           x[2] - tolerance, x[2] + tolerance};
+    bool duplicate = false;
+    context.Bins.ForEachInBox(box, [&](vtkIdType id) {
+      double y[3];
+      points->GetPoint(id, y);
+      duplicate = context.Kept[id] &&
+          vtkMath::Distance2BetweenPoints(x, y) <= tolerance2;
+      return !duplicate;
+    });
+    context.Kept[i] = duplicate ? 0 : 1;
+  }
+
+  // A grid of regions, with cells as close to cubes as the count allows.
+  int divisions[3] = {1, 1, 1};
+  double extent[3];
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    extent[axis] = bounds[2 * axis + 1] - bounds[2 * axis];
+  }
+  while (divisions[0] * divisions[1] * divisions[2] < this->NumberOfRegions)
+  {
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+    {
+      if (extent[a] / divisions[a] > extent[axis] / divisions[axis])
+      {
+        axis = a;
+      }
+    }
+    ++divisions[axis];
+  }
+  const int numberOfRegions = divisions[0] * divisions[1] * divisions[2];
+
+  // The points of each region, which it resolves.
+  std::vector<std::vector<vtkIdType>> pending(numberOfRegions);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    if (!context.Kept[i])
+    {
+      continue;
+    }
+    double x[3];
+    points->GetPoint(i, x);
+    int region = 0;
+    for (int axis = 2; axis >= 0; --axis)
+    {
+      const int index = extent[axis] > 0.0
+          ? static_cast<int>((x[axis] - bounds[2 * axis]) / extent[axis] *
+                             divisions[axis])
+          : 0;
+      region =
+          region * divisions[axis] + std::clamp(index, 0, divisions[axis] - 1);
+    }
+    pending[region].push_back(i);
+  }
+
+  // The halo of a region doubles from one round to the next.
+  std::vector<double> halos(numberOfRegions);
+  for (int region = 0; region < numberOfRegions; ++region)
+  {
+    const int index[3] = {region % divisions[0],
+                          (region / divisions[0]) % divisions[1],
+                          region / (divisions[0] * divisions[1])};
+    double core[6];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      core[2 * axis] =
+          bounds[2 * axis] + extent[axis] * index[axis] / divisions[axis];
+      core[2 * axis + 1] = bounds[2 * axis] +
+          extent[axis] * (index[axis] + 1) / divisions[axis];
+    }
+    halos[region] =
+        this->HaloFactor * MeanSpacing(core, pending[region].size());
+  }
+
+  // Each group of points is triangulated with the points around it. The
+  // first round has a group per region.
+  struct Group
+  {
+    int Region;
+    std::vector<vtkIdType> Ids;
+    std::vector<vtkIdType> Tetras;
+  };
+  std::vector<Group> groups(numberOfRegions);
+  for (int region = 0; region < numberOfRegions; ++region)
+  {
+    groups[region].Region = region;
+    groups[region].Ids.swap(pending[region]);
+  }
+  std::vector<std::vector<vtkIdType>> found;
+  std::vector<vtkIdType> memorySizes(groups.size(), 0);
+  for (int round = 0; round < MaximumRounds && !groups.empty(); ++round)
+  {
+    const vtkIdType numberOfGroups = static_cast<vtkIdType>(groups.size());
+    vtkSMPTools::For(
+        0, numberOfGroups, 1, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType g = begin; g < end; ++g)
+      {
+        Group& group = groups[g];
+        double window[6] = {VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX,
+                            -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+        for (vtkIdType id : group.Ids)
+        {
+          double x[3];
+          points->GetPoint(id, x);
+          for (int axis = 0; axis < 3; ++axis)
+          {
+            window[2 * axis] = std::min(window[2 * axis], x[axis]);
+            window[2 * axis + 1] = std::max(window[2 * axis + 1], x[axis]);
+          }
+        }
+        const double halo = halos[group.Region] * (1 << round);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          window[2 * axis] =
+              std::max(window[2 * axis] - halo, bounds[2 * axis]);
+          window[2 * axis + 1] =
+              std::min(window[2 * axis + 1] + halo, bounds[2 * axis + 1]);
+        }
+
+        std::vector<vtkIdType> windowIds;
+        context.Bins.ForEachInBox(window, [&](vtkIdType id) {
+          double x[3];
+          points->GetPoint(id, x);
+          if (context.Kept[id] && InsideBox(window, x))
+          {
+            windowIds.push_back(id);
+          }
+          return true;
+        });
+        SortForInsertion(points, window, this->InsertionOrder, windowIds);
+        std::vector<vtkIdType> windowTetras;
+        const vtkIdType memorySize =
+            Triangulate(points, windowIds, 0.0, windowTetras);
+        if (round == 0)
+        {
+          memorySizes[g] = memorySize +
+              static_cast<vtkIdType>(
+                  (windowIds.size() + windowTetras.size()) *
+                  sizeof(vtkIdType) / 1024);
+        }
+        ResolveStars(context, window, false, windowTetras, group.Ids,
+                     group.Tetras);
+      }
+    });
+    this->NumberOfRounds = round + 1;
+
+    // The points left, mostly near the convex hull where the circumspheres
+    // are large, are split in cells a few halos wide so that the next
+    // windows stay small.
+    std::map<std::array<vtkIdType, 4>, Group> cells;
+    vtkIdType left = 0;
+    for (Group& group : groups)
+    {
+      found.push_back(std::move(group.Tetras));
+      const double cellSize = 4.0 * halos[group.Region] * (2 << round);
+      for (vtkIdType id : group.Ids)
+      {
+        double x[3];
+        points->GetPoint(id, x);
+        std::array<vtkIdType, 4> key = {group.Region, 0, 0, 0};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          key[axis + 1] = static_cast<vtkIdType>(
+              (x[axis] - bounds[2 * axis]) / cellSize);
+        }
+        Group& cell = cells[key];
+        cell.Region = group.Region;
+        cell.Ids.push_back(id);
+      }
+      left += static_cast<vtkIdType>(group.Ids.size());
+    }
+    if (round == 0)
+    {
+      this->NumberOfConflictPoints = left;
+    }
+    groups.clear();
+    for (auto& cell : cells)
+    {
+      groups.push_back(std::move(cell.second));
+    }
+  }
+
+  // The points still left are resolved with all the points.
+  std::vector<vtkIdType> left;
+  for (const Group& group : groups)
+  {
+    left.insert(left.end(), group.Ids.begin(), group.Ids.end());
+  }
+  if (!left.empty())
+  {
+    ids.clear();
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+      if (context.Kept[i])
+      {
+        ids.push_back(i);
+      }
+    }
+    SortForInsertion(points, bounds, this->InsertionOrder, ids);
+    std::vector<vtkIdType> allTetras;
+    Triangulate(points, ids, 0.0, allTetras);
+    found.emplace_back();
+    ResolveStars(context, bounds, true, allTetras, left, found.back());
+    ++this->NumberOfRounds;
+  }
+
+  this->WorkingMemorySize = context.Bins.GetMemorySize() +
+      static_cast<vtkIdType>(numberOfPoints / 1024);
+  for (vtkIdType memorySize : memorySizes)
+  {
+    this->WorkingMemorySize += memorySize;
+  }
+  for (const auto& regionFound : found)
+  {
+    tetras.insert(tetras.end(), regionFound.begin(), regionFound.end());
+  }
+}
+
+void MakeCloud(vtkIdType numberOfPoints, bool clustered, vtkPolyData* cloud)
+{
+  vtkNew<vtkMinimalStandardRandomSequence> random;
+  random->SetSeed(clustered ? 8775070 : 5489);
+  auto next = [&random]() {
+    random->Next();
+    return random->GetValue();
+  };
+
+  // Clusters of different sizes and densities.
+  const int numberOfClusters = 16;
+  std::vector<std::array<double, 4>> clusters(numberOfClusters);
+  for (auto& cluster : clusters)
+  {
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      cluster[axis] = 0.15 + 0.7 * next();
+    }
+    cluster[3] = 0.01 + 0.07 * next();
+  }
+
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(numberOfPoints);
+  double x[3];
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    if (!clustered)
+    {
+      x[0] = next();
+      x[1] = next();
+      x[2] = next();
+    }
+    else
+    {
+      const auto& cluster =
+          clusters[std::min(static_cast<int>(next() * numberOfClusters),
+                            numberOfClusters - 1)];
+      // Box-Muller, for three normal deviates out of four uniform ones.
+      for (int axis = 0; axis < 3; axis += 2)
+      {
+        const double r = std::sqrt(-2.0 * std::log(1.0 - next()));
+        const double theta = 2.0 * vtkMath::Pi() * next();
+        x[axis] = cluster[axis] + cluster[3] * r * std::cos(theta);
+        if (axis + 1 < 3)
+        {
+          x[axis + 1] = cluster[axis + 1] + cluster[3] * r * std::sin(theta);
+        }
+      }
+    }
+    points->SetPoint(i, x);
+  }
+  cloud->SetPoints(points);
+}
+
+// The tetrahedra of the mesh, with their point ids sorted.
+std::vector<std::array<vtkIdType, 4>> GetTetras(vtkUnstructuredGrid* mesh)
+{
+  std::vector<std::array<vtkIdType, 4>> tetras;
+  tetras.reserve(mesh->GetNumberOfCells());
+  auto iter = vtkSmartPointer<vtkCellArrayIterator>::Take(
+      mesh->GetCells()->NewIterator());
+  for (iter->GoToFirstCell(); !iter->IsDoneWithTraversal();
+       iter->GoToNextCell())
+  {
+    vtkIdType npts;
+    const vtkIdType* pts;
+    iter->GetCurrentCell(npts, pts);
+    if (npts == 4)
+    {
+      std::array<vtkIdType, 4> tetra = {pts[0], pts[1], pts[2], pts[3]};
+      std::sort(tetra.begin(), tetra.end());
+      tetras.push_back(tetra);
+    }
+  }
+  return tetras;
+}
+
+double TetraCircumsphere(vtkPoints* points,
+                         const std::array<vtkIdType, 4>& tetra,
+                         double center[3])
+{
+  double x[4][3];
+  for (int j = 0; j < 4; ++j)
+  {
+    points->GetPoint(tetra[j], x[j]);
+  }
+  return vtkTetra::Circumsphere(x[0], x[1], x[2], x[3], center);
+}
+
+vtkIdType CountDelaunayViolations(vtkUnstructuredGrid* mesh)
+{
+  const auto tetras = GetTetras(mesh);
+  vtkPoints* points = mesh->GetPoints();
+
+  // Only the points of the mesh, leaving out the merged ones.
+  std::vector<unsigned char> used(mesh->GetNumberOfPoints(), 0);
+  for (const auto& tetra : tetras)
+  {
+    for (vtkIdType id : tetra)
+    {
+      used[id] = 1;
+    }
+  }
+  std::vector<vtkIdType> ids;
+  for (vtkIdType i = 0; i < mesh->GetNumberOfPoints(); ++i)
+  {
+    if (used[i])
+    {
+      ids.push_back(i);
+    }
+  }
+  double bounds[6];
+  mesh->GetBounds(bounds);
+  PointBins bins;
+  bins.Build(points, ids, bounds, 2.0);
+
+  vtkSMPThreadLocal<vtkIdType> violations(0);
+  const vtkIdType numberOfTetras = static_cast<vtkIdType>(tetras.size());
+  vtkSMPTools::For(0, numberOfTetras, [&](vtkIdType begin, vtkIdType end) {
+    vtkIdType& count = violations.Local();
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+      double center[3];
+      const double radius2 = TetraCircumsphere(points, tetras[t], center);
+      // Points on the sphere, to round off, are not violations.
+      const double inside2 = radius2 * (1.0 - 1e-10);
+      bool violated = false;
+      bins.ForEachInSphere(center, std::sqrt(radius2), [&](vtkIdType id) {
+        double y[3];
+        points->GetPoint(id, y);
+        violated = vtkMath::Distance2BetweenPoints(y, center) < inside2 &&
+            std::find(tetras[t].begin(), tetras[t].end(), id) ==
+                tetras[t].end();
+        return !violated;
+      });
+      count += violated ? 1 : 0;
+    }
+  });
+  vtkIdType total = 0;
+  for (vtkIdType count : violations)
+  {
+    total += count;
+  }
+  return total;
+}
+
+void CompareTetras(vtkUnstructuredGrid* a, vtkUnstructuredGrid* b,
+                   vtkIdType& differing, vtkIdType& interiorDiffering)
+{
+  auto tetrasA = GetTetras(a);
+  auto tetrasB = GetTetras(b);
+  vtkSMPTools::Sort(tetrasA.begin(), tetrasA.end());
+  vtkSMPTools::Sort(tetrasB.begin(), tetrasB.end());
+  std::vector<std::array<vtkIdType, 4>> difference;
+  std::set_symmetric_difference(tetrasA.begin(), tetrasA.end(),
+                                tetrasB.begin(), tetrasB.end(),
+                                std::back_inserter(difference));
+  double bounds[6];
+  a->GetBounds(bounds);
+  differing = static_cast<vtkIdType>(difference.size());
+  interiorDiffering = 0;
+  for (const auto& tetra : difference)
+  {
+    double center[3];
+    const double radius = std::sqrt(
+        TetraCircumsphere(a->GetPoints(), tetra, center));
+    const double box[6] = {center[0] - radius, center[0] + radius,
+                           center[1] - radius, center[1] + radius,
+                           center[2] - radius, center[2] + radius};
+    const double lo[3] = {box[0], box[2], box[4]};
+    const double hi[3] = {box[1], box[3], box[5]};
+    if (InsideBox(bounds, lo) && InsideBox(bounds, hi))
+    {
+      ++interiorDiffering;
+    }
+  }
+}
+} // namespace
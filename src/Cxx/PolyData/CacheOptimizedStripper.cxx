@@ -0,0 +1,1099 @@
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkCellData.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkStripper.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+/**
+ * Triangle strips, or triangles, ordered for the post-transform vertex
+ * cache of the GPU.
+ *
+ * The triangles of the input (polygons with three points, and the
+ * triangles of the input strips) are sorted along a Morton curve through
+ * their centroids and split into patches of TrianglesPerPatch triangles,
+ * which are processed in parallel with vtkSMPTools.
+ *
+ * With ReorderTriangles on, the triangles of each patch are ordered for a
+ * first in first out cache of CacheSize points. With GenerateStrips off,
+ * they are output in the order of Tipsify (Sander, Nehab and Barczak,
+ * "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw",
+ * 2007). Strips are grown while simulating the cache: each one stops
+ * before it misses more than half of the cache, and the next one starts
+ * from the triangles around the newest points of the cache, in the
+ * direction with the fewest misses per triangle, so that it runs back
+ * along the previous one. With ReorderTriangles off, the strips follow the
+ * Morton order and only stop at MaximumLength triangles.
+ *
+ * A strip only continues through triangles with the same orientation, so
+ * the output has the orientation of the input.
+ *
+ * With RenumberPoints on, the points are renumbered in the order in which
+ * the strips or triangles first use them, so that the vertex fetches walk
+ * through the point arrays; the points that no triangle uses follow, in
+ * their input order.
+ *
+ * Vertices, lines and the other polygons are passed through. Cell data is
+ * passed only with GenerateStrips off.
+ */
+class CacheOptimizedStripper : public vtkPolyDataAlgorithm
+{
+public:
+  static CacheOptimizedStripper* New();
+  vtkTypeMacro(CacheOptimizedStripper, vtkPolyDataAlgorithm);
+
+  vtkSetMacro(ReorderTriangles, bool);
+  vtkGetMacro(ReorderTriangles, bool);
+  vtkBooleanMacro(ReorderTriangles, bool);
+
+  vtkSetClampMacro(CacheSize, int, 3, VTK_INT_MAX);
+  vtkGetMacro(CacheSize, int);
+
+  vtkSetMacro(GenerateStrips, bool);
+  vtkGetMacro(GenerateStrips, bool);
+  vtkBooleanMacro(GenerateStrips, bool);
+
+  /**
+   * The maximum number of triangles in a strip.
+   */
+  vtkSetClampMacro(MaximumLength, int, 1, VTK_INT_MAX);
+  vtkGetMacro(MaximumLength, int);
+
+  vtkSetMacro(RenumberPoints, bool);
+  vtkGetMacro(RenumberPoints, bool);
+  vtkBooleanMacro(RenumberPoints, bool);
+
+  vtkSetClampMacro(TrianglesPerPatch, int, 1, VTK_INT_MAX);
+  vtkGetMacro(TrianglesPerPatch, int);
+
+  // The number of patches of the last execution.
+  vtkGetMacro(NumberOfPatches, vtkIdType);
+
+protected:
+  CacheOptimizedStripper() = default;
+  ~CacheOptimizedStripper() override = default;
+
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  bool ReorderTriangles = true;
+  int CacheSize = 32;
+  bool GenerateStrips = true;
+  int MaximumLength = 1000;
+  bool RenumberPoints = true;
+  int TrianglesPerPatch = 65536;
+
+  vtkIdType NumberOfPatches = 0;
+
+private:
+  CacheOptimizedStripper(const CacheOptimizedStripper&) = delete;
+  void operator=(const CacheOptimizedStripper&) = delete;
+};
+
+vtkStandardNewMacro(CacheOptimizedStripper);
+
+// The triangles of a patch, with the points numbered from 0, and the
+// triangles around each point.
+struct PatchMesh
+{
+  std::vector<vtkIdType> Points; // Local to input point ids, sorted.
+  std::vector<vtkIdType> Triangles;
+  std::vector<vtkIdType> Offsets;
+  std::vector<vtkIdType> Incident;
+
+  vtkIdType GetNumberOfTriangles() const
+  {
+    return static_cast<vtkIdType>(this->Triangles.size() / 3);
+  }
+  vtkIdType GetNumberOfPoints() const
+  {
+    return static_cast<vtkIdType>(this->Points.size());
+  }
+};
+
+// A first in first out vertex cache: a point is in the cache if fewer than
+// Size misses happened since its own miss.
+struct VertexCache
+{
+  std::vector<vtkIdType> MissTime;
+  std::vector<vtkIdType> Ring;
+  vtkIdType Misses = 0;
+  vtkIdType Size = 0;
+
+  void Reset(vtkIdType numberOfPoints, int size)
+  {
+    this->Size = size;
+    this->Misses = 0;
+    this->MissTime.assign(numberOfPoints, -this->Size);
+    this->Ring.assign(size, 0);
+  }
+  bool Contains(vtkIdType id) const
+  {
+    return this->Misses - this->MissTime[id] < this->Size;
+  }
+  void Fetch(vtkIdType id)
+  {
+    if (!this->Contains(id))
+    {
+      this->Ring[this->Misses % this->Size] = id;
+      this->MissTime[id] = this->Misses++;
+    }
+  }
+};
+
+// The buffers a thread reuses from patch to patch.
+struct PatchScratch
+{
+  PatchMesh Mesh;
+  std::vector<vtkIdType> Order;
+  std::vector<vtkIdType> Live;
+  std::vector<vtkIdType> CacheTime;
+  std::vector<vtkIdType> DeadEnds;
+  std::vector<vtkIdType> Candidates;
+  std::vector<vtkIdType> Marks;
+  VertexCache Cache;
+};
+
+// What a patch outputs: strips (point ids and sizes) or triangle ids.
+struct PatchOutput
+{
+  std::vector<vtkIdType> Connectivity;
+  std::vector<vtkIdType> Sizes;
+  std::vector<vtkIdType> Triangles;
+};
+
+void BuildPatchMesh(const vtkIdType* triangles, const vtkIdType* ids,
+                    vtkIdType n, PatchMesh& mesh);
+void TipsifyOrder(const PatchMesh& mesh, int cacheSize, PatchScratch& scratch);
+void BuildStrips(const PatchMesh& mesh, int maximumLength, int cacheSize,
+                 PatchScratch& scratch, PatchOutput& output);
+std::uint64_t MortonCode(const double x[3], const double bounds[6]);
+
+vtkSmartPointer<vtkPolyData> MakeSphere(int resolution, bool shuffle);
+double CacheMissRatio(vtkPolyData* polyData, int cacheSize);
+vtkIdType CountTriangles(vtkPolyData* polyData);
+std::vector<std::array<vtkIdType, 3>> OrientedTriangles(vtkPolyData* polyData);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  std::vector<int> resolutions;
+  for (int i = 1; i < argc; ++i)
+  {
+    resolutions.push_back(std::max(8, std::atoi(argv[i])));
+  }
+  if (resolutions.empty())
+  {
+    resolutions.push_back(300);
+  }
+  const int cacheSize = 32;
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << "Average cache miss ratio (ACMR) for a FIFO cache of "
+            << cacheSize << " vertices" << std::endl;
+
+  vtkNew<vtkTimerLog> timer;
+  bool ok = true;
+  for (int resolution : resolutions)
+  {
+    for (bool shuffle : {false, true})
+    {
+      auto sphere = MakeSphere(resolution, shuffle);
+      const auto expected = OrientedTriangles(sphere);
+      std::cout << CountTriangles(sphere) << " triangles, "
+                << (shuffle ? "shuffled" : "sphere source") << " order"
+                << std::endl;
+      std::cout << std::left << std::setw(24) << "Method" << std::right
+                << std::setw(12) << "Time" << std::setw(12) << "Strips"
+                << std::setw(8) << "ACMR" << std::endl;
+      std::cout << std::fixed;
+      std::cout << std::left << std::setw(24) << "Input" << std::right
+                << std::setw(12) << "" << std::setw(12) << "-"
+                << std::setw(8) << std::setprecision(3)
+                << CacheMissRatio(sphere, cacheSize) << std::endl;
+
+      vtkNew<vtkStripper> stripper;
+      stripper->SetInputData(sphere);
+      timer->StartTimer();
+      stripper->Update();
+      timer->StopTimer();
+      auto output = stripper->GetOutput();
+      std::cout << std::left << std::setw(24) << "vtkStripper" << std::right
+                << std::setw(9) << std::setprecision(1)
+                << 1000.0 * timer->GetElapsedTime() << " ms"
+                << std::setw(12) << output->GetNumberOfStrips()
+                << std::setw(8) << std::setprecision(3)
+                << CacheMissRatio(output, cacheSize) << std::endl;
+
+      struct Method
+      {
+        const char* Name;
+        bool Reorder;
+        bool Strips;
+      };
+      const Method methods[] = {{"Morton strips", false, true},
+                                {"Reordered triangles", true, false},
+                                {"Reordered strips", true, true}};
+      for (const auto& method : methods)
+      {
+        vtkNew<CacheOptimizedStripper> optimizer;
+        optimizer->SetInputData(sphere);
+        optimizer->SetCacheSize(cacheSize);
+        optimizer->SetReorderTriangles(method.Reorder);
+        optimizer->SetGenerateStrips(method.Strips);
+        timer->StartTimer();
+        optimizer->Update();
+        timer->StopTimer();
+        output = optimizer->GetOutput();
+        std::cout << std::left << std::setw(24) << method.Name << std::right
+                  << std::setw(9) << std::setprecision(1)
+                  << 1000.0 * timer->GetElapsedTime() << " ms"
+                  << std::setw(12);
+        if (method.Strips)
+        {
+          std::cout << output->GetNumberOfStrips();
+        }
+        else
+        {
+          std::cout << "-";
+        }
+        std::cout << std::setw(8) << std::setprecision(3)
+                  << CacheMissRatio(output, cacheSize) << std::endl;
+
+        // The same triangles, with the same orientation, must come out.
+        if (OrientedTriangles(output) != expected)
+        {
+          std::cout << "  The triangles differ from the input" << std::endl;
+          ok = false;
+        }
+      }
+      std::cout.unsetf(std::ios_base::floatfield);
+    }
+  }
+  if (ok)
+  {
+    std::cout << "All outputs have the triangles of the input" << std::endl;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+int CacheOptimizedStripper::RequestData(vtkInformation* vtkNotUsed(request),
+                                        vtkInformationVector** inputVector,
+                                        vtkInformationVector* outputVector)
+{
+  vtkPolyData* input = vtkPolyData::GetData(inputVector[0]);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector);
+  this->NumberOfPatches = 0;
+  vtkPoints* inPoints = input->GetPoints();
+  if (!inPoints)
+  {
+    return 1;
+  }
+  const vtkIdType numberOfPoints = input->GetNumberOfPoints();
+
+  // Gather the triangles, and the input cells they come from. The cell ids
+  // of vtkPolyData number the vertices, lines, polygons and strips in turn.
+  std::vector<vtkIdType> triangles;
+  std::vector<vtkIdType> sources;
+  vtkNew<vtkCellArray> otherPolys;
+  vtkNew<vtkIdList> otherSources;
+  const vtkIdType firstPoly =
+    input->GetNumberOfVerts() + input->GetNumberOfLines();
+  vtkIdType cellId = firstPoly;
+  vtkIdType npts;
+  const vtkIdType* pts;
+  auto polys = vtk::TakeSmartPointer(input->GetPolys()->NewIterator());
+  for (polys->GoToFirstCell(); !polys->IsDoneWithTraversal();
+       polys->GoToNextCell(), ++cellId)
+  {
+    polys->GetCurrentCell(npts, pts);
+    if (npts == 3)
+    {
+      triangles.insert(triangles.end(), pts, pts + 3);
+      sources.push_back(cellId);
+    }
+    else
+    {
+      otherPolys->InsertNextCell(npts, pts);
+      otherSources->InsertNextId(cellId);
+    }
+  }
+  auto strips = vtk::TakeSmartPointer(input->GetStrips()->NewIterator());
+  for (strips->GoToFirstCell(); !strips->IsDoneWithTraversal();
+       strips->GoToNextCell(), ++cellId)
+  {
+    strips->GetCurrentCell(npts, pts);
+    for (vtkIdType i = 0; i + 2 < npts; ++i)
+    {
+      // Every other triangle of a strip is flipped; skip the degenerate
+      // triangles that join the parts of a strip.
+      const vtkIdType a = pts[i + (i & 1)];
+      const vtkIdType b = pts[i + 1 - (i & 1)];
+      const vtkIdType c = pts[i + 2];
+      if (a != b && b != c && c != a)
+      {
+        triangles.insert(triangles.end(), {a, b, c});
+        sources.push_back(cellId);
+      }
+    }
+  }
+  const vtkIdType numberOfTriangles =
+    static_cast<vtkIdType>(sources.size());
+
+  // Sort the triangles along a Morton curve through their centroids, which
+  // splits them into compact patches.
+  double bounds[6];
+  input->GetBounds(bounds);
+  std::vector<std::pair<std::uint64_t, vtkIdType>> keys(numberOfTriangles);
+  vtkSMPTools::For(0, numberOfTriangles, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+      double centroid[3] = {0.0, 0.0, 0.0};
+      for (int i = 0; i < 3; ++i)
+      {
+        double x[3];
+        inPoints->GetPoint(triangles[3 * t + i], x);
+        for (int j = 0; j < 3; ++j)
+        {
+          centroid[j] += x[j] / 3.0;
+        }
+      }
+      keys[t] = std::make_pair(MortonCode(centroid, bounds), t);
+    }
+  });
+  vtkSMPTools::Sort(keys.begin(), keys.end());
+  std::vector<vtkIdType> sorted(numberOfTriangles);
+  for (vtkIdType t = 0; t < numberOfTriangles; ++t)
+  {
+    sorted[t] = keys[t].second;
+  }
+  keys = {};
+
+  const vtkIdType patchSize = this->TrianglesPerPatch;
+  const vtkIdType numberOfPatches = (numberOfTriangles + patchSize - 1) /
+    patchSize;
+  std::vector<PatchOutput> patches(numberOfPatches);
+  vtkSMPThreadLocal<PatchScratch> scratches;
+  vtkSMPTools::For(0, numberOfPatches, 1, [&](vtkIdType begin, vtkIdType end) {
+    auto& scratch = scratches.Local();
+    for (vtkIdType p = begin; p < end; ++p)
+    {
+      const vtkIdType first = p * patchSize;
+      const vtkIdType n = std::min(patchSize, numberOfTriangles - first);
+      const vtkIdType* ids = sorted.data() + first;
+      auto& mesh = scratch.Mesh;
+      BuildPatchMesh(triangles.data(), ids, n, mesh);
+
+      if (this->ReorderTriangles)
+      {
+        TipsifyOrder(mesh, this->CacheSize, scratch);
+      }
+      else
+      {
+        scratch.Order.resize(n);
+        std::iota(scratch.Order.begin(), scratch.Order.end(), 0);
+      }
+
+      auto& patch = patches[p];
+      if (this->GenerateStrips)
+      {
+        BuildStrips(mesh, this->MaximumLength,
+                    this->ReorderTriangles ? this->CacheSize : 0, scratch,
+                    patch);
+        for (auto& id : patch.Connectivity)
+        {
+          id = mesh.Points[id];
+        }
+      }
+      else
+      {
+        patch.Triangles.resize(n);
+        for (vtkIdType i = 0; i < n; ++i)
+        {
+          patch.Triangles[i] = ids[scratch.Order[i]];
+        }
+      }
+    }
+  });
+  this->NumberOfPatches = numberOfPatches;
+
+  // Concatenate the patches.
+  std::vector<vtkIdType> cellStart(numberOfPatches + 1, 0);
+  std::vector<vtkIdType> idStart(numberOfPatches + 1, 0);
+  for (vtkIdType p = 0; p < numberOfPatches; ++p)
+  {
+    const auto& patch = patches[p];
+    const vtkIdType cells = this->GenerateStrips
+      ? static_cast<vtkIdType>(patch.Sizes.size())
+      : static_cast<vtkIdType>(patch.Triangles.size());
+    const vtkIdType ids = this->GenerateStrips
+      ? static_cast<vtkIdType>(patch.Connectivity.size())
+      : 3 * cells;
+    cellStart[p + 1] = cellStart[p] + cells;
+    idStart[p + 1] = idStart[p] + ids;
+  }
+  const vtkIdType numberOfCells = cellStart[numberOfPatches];
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(numberOfCells + 1);
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(idStart[numberOfPatches]);
+  vtkIdType* o = offsets->GetPointer(0);
+  vtkIdType* c = connectivity->GetPointer(0);
+  std::vector<vtkIdType> cellSources;
+  if (!this->GenerateStrips)
+  {
+    cellSources.resize(numberOfCells);
+  }
+  vtkSMPTools::For(0, numberOfPatches, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType p = begin; p < end; ++p)
+    {
+      auto& patch = patches[p];
+      vtkIdType cell = cellStart[p];
+      vtkIdType offset = idStart[p];
+      if (this->GenerateStrips)
+      {
+        for (vtkIdType size : patch.Sizes)
+        {
+          o[cell++] = offset;
+          offset += size;
+        }
+        std::copy(patch.Connectivity.begin(), patch.Connectivity.end(),
+                  c + idStart[p]);
+      }
+      else
+      {
+        for (vtkIdType t : patch.Triangles)
+        {
+          o[cell] = offset;
+          cellSources[cell++] = sources[t];
+          std::copy(triangles.data() + 3 * t, triangles.data() + 3 * t + 3,
+                    c + offset);
+          offset += 3;
+        }
+      }
+      patch = PatchOutput();
+    }
+  });
+  o[numberOfCells] = connectivity->GetNumberOfValues();
+
+  vtkSmartPointer<vtkCellArray> verts = input->GetVerts();
+  vtkSmartPointer<vtkCellArray> lines = input->GetLines();
+  if (this->RenumberPoints)
+  {
+    // The points in the order of first use, then the unused ones.
+    std::vector<vtkIdType> newIds(numberOfPoints, -1);
+    vtkNew<vtkIdList> oldIds;
+    oldIds->SetNumberOfIds(numberOfPoints);
+    vtkIdType next = 0;
+    const vtkIdType numberOfIds = connectivity->GetNumberOfValues();
+    for (vtkIdType i = 0; i < numberOfIds; ++i)
+    {
+      if (newIds[c[i]] < 0)
+      {
+        oldIds->SetId(next, c[i]);
+        newIds[c[i]] = next++;
+      }
+    }
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+      if (newIds[i] < 0)
+      {
+        oldIds->SetId(next, i);
+        newIds[i] = next++;
+      }
+    }
+    vtkSMPTools::For(0, numberOfIds, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; ++i)
+      {
+        c[i] = newIds[c[i]];
+      }
+    });
+
+    auto renumber = [&](vtkCellArray* cells) {
+      vtkNew<vtkCellArray> renumbered;
+      renumbered->AllocateExact(cells->GetNumberOfCells(),
+                                cells->GetNumberOfConnectivityIds());
+      std::vector<vtkIdType> cellIds;
+      auto iterator = vtk::TakeSmartPointer(cells->NewIterator());
+      for (iterator->GoToFirstCell(); !iterator->IsDoneWithTraversal();
+           iterator->GoToNextCell())
+      {
+        iterator->GetCurrentCell(npts, pts);
+        cellIds.resize(npts);
+        for (vtkIdType i = 0; i < npts; ++i)
+        {
+          cellIds[i] = newIds[pts[i]];
+        }
+        renumbered->InsertNextCell(npts, cellIds.data());
+      }
+      return vtkSmartPointer<vtkCellArray>(renumbered);
+    };
+    verts = renumber(verts);
+    lines = renumber(lines);
+    otherPolys->DeepCopy(renumber(otherPolys));
+
+    vtkNew<vtkIdList> sequence;
+    sequence->SetNumberOfIds(numberOfPoints);
+    std::iota(sequence->begin(), sequence->end(), 0);
+    vtkNew<vtkPoints> points;
+    points->SetDataType(inPoints->GetDataType());
+    points->SetNumberOfPoints(numberOfPoints);
+    points->GetData()->InsertTuples(sequence, oldIds, inPoints->GetData());
+    output->SetPoints(points);
+    output->GetPointData()->CopyAllocate(input->GetPointData(),
+                                         numberOfPoints);
+    output->GetPointData()->CopyData(input->GetPointData(), oldIds,
+                                     sequence);
+  }
+  else
+  {
+    output->SetPoints(inPoints);
+    output->GetPointData()->PassData(input->GetPointData());
+  }
+
+  vtkNew<vtkCellArray> cells;
+  cells->SetData(offsets, connectivity);
+  output->SetVerts(verts);
+  output->SetLines(lines);
+  if (this->GenerateStrips)
+  {
+    output->SetPolys(otherPolys);
+    output->SetStrips(cells);
+  }
+  else
+  {
+    // The cell data follows the cells: the vertices, the lines and the
+    // other polygons keep their order, then come the triangles.
+    otherPolys->Append(cells);
+    output->SetPolys(otherPolys);
+    const vtkIdType numberOfOutputCells = output->GetNumberOfCells();
+    vtkNew<vtkIdList> fromIds;
+    fromIds->SetNumberOfIds(numberOfOutputCells);
+    vtkIdType* from = fromIds->GetPointer(0);
+    std::iota(from, from + firstPoly, 0);
+    std::copy(otherSources->begin(), otherSources->end(), from + firstPoly);
+    std::copy(cellSources.begin(), cellSources.end(),
+              from + firstPoly + otherSources->GetNumberOfIds());
+    vtkNew<vtkIdList> toIds;
+    toIds->SetNumberOfIds(numberOfOutputCells);
+    std::iota(toIds->begin(), toIds->end(), 0);
+    output->GetCellData()->CopyAllocate(input->GetCellData(),
+                                        numberOfOutputCells);
+    output->GetCellData()->CopyData(input->GetCellData(), fromIds, toIds);
+  }
+  return 1;
+}
+
+void BuildPatchMesh(const vtkIdType* triangles, const vtkIdType* ids,
+                    vtkIdType n, PatchMesh& mesh)
+{
+  // Number the points of the patch from 0, in the order of their ids.
+  mesh.Points.resize(3 * n);
+  for (vtkIdType t = 0; t < n; ++t)
+  {
+    std::copy(triangles + 3 * ids[t], triangles + 3 * ids[t] + 3,
+              mesh.Points.begin() + 3 * t);
+  }
+  mesh.Triangles = mesh.Points;
+  std::sort(mesh.Points.begin(), mesh.Points.end());
+  mesh.Points.erase(std::unique(mesh.Points.begin(), mesh.Points.end()),
+                    mesh.Points.end());
+  for (auto& id : mesh.Triangles)
+  {
+    id = std::lower_bound(mesh.Points.begin(), mesh.Points.end(), id) -
+      mesh.Points.begin();
+  }
+
+  // The triangles around each point, in compressed rows.
+  const vtkIdType numberOfPoints = mesh.GetNumberOfPoints();
+  mesh.Offsets.assign(numberOfPoints + 1, 0);
+  for (vtkIdType id : mesh.Triangles)
+  {
+    ++mesh.Offsets[id + 1];
+  }
+  std::partial_sum(mesh.Offsets.begin(), mesh.Offsets.end(),
+                   mesh.Offsets.begin());
+  mesh.Incident.resize(3 * n);
+  for (vtkIdType i = 0; i < 3 * n; ++i)
+  {
+    mesh.Incident[mesh.Offsets[mesh.Triangles[i]]++] = i / 3;
+  }
+  // The offsets were moved to the end of each row.
+  for (vtkIdType i = numberOfPoints; i > 0; --i)
+  {
+    mesh.Offsets[i] = mesh.Offsets[i - 1];
+  }
+  mesh.Offsets[0] = 0;
+}
+
+void TipsifyOrder(const PatchMesh& mesh, int cacheSize, PatchScratch& scratch)
+{
+  const vtkIdType numberOfPoints = mesh.GetNumberOfPoints();
+  const vtkIdType numberOfTriangles = mesh.GetNumberOfTriangles();
+  auto& order = scratch.Order;
+  auto& live = scratch.Live;
+  auto& cacheTime = scratch.CacheTime;
+  auto& deadEnds = scratch.DeadEnds;
+  auto& candidates = scratch.Candidates;
+  auto& emitted = scratch.Marks;
+  order.clear();
+  live.resize(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    live[i] = mesh.Offsets[i + 1] - mesh.Offsets[i];
+  }
+  cacheTime.assign(numberOfPoints, 0);
+  deadEnds.clear();
+  emitted.assign(numberOfTriangles, 0);
+
+  // Emit the triangles around a fanning point, then move to the point of
+  // these triangles that stays longest in the cache if its remaining
+  // triangles fit, else back to a point that still has triangles.
+  vtkIdType fan = 0;
+  vtkIdType time = cacheSize + 1;
+  vtkIdType cursor = 1;
+  while (fan >= 0)
+  {
+    candidates.clear();
+    for (vtkIdType i = mesh.Offsets[fan]; i < mesh.Offsets[fan + 1]; ++i)
+    {
+      const vtkIdType t = mesh.Incident[i];
+      if (emitted[t])
+      {
+        continue;
+      }
+      emitted[t] = 1;
+      order.push_back(t);
+      for (int j = 0; j < 3; ++j)
+      {
+        const vtkIdType v = mesh.Triangles[3 * t + j];
+        deadEnds.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (time - cacheTime[v] > cacheSize)
+        {
+          cacheTime[v] = time++;
+        }
+      }
+    }
+
+    fan = -1;
+    vtkIdType best = 0;
+    for (vtkIdType v : candidates)
+    {
+      if (live[v] > 0)
+      {
+        const vtkIdType age = time - cacheTime[v];
+        const vtkIdType priority = age + 2 * live[v] <= cacheSize ? age : 0;
+        if (priority > best)
+        {
+          best = priority;
+          fan = v;
+        }
+      }
+    }
+    while (fan < 0 && !deadEnds.empty())
+    {
+      const vtkIdType v = deadEnds.back();
+      deadEnds.pop_back();
+      if (live[v] > 0)
+      {
+        fan = v;
+      }
+    }
+    for (; fan < 0 && cursor < numberOfPoints; ++cursor)
+    {
+      if (live[cursor] > 0)
+      {
+        fan = cursor;
+      }
+    }
+  }
+}
+
+// Follows the triangles that continue a strip starting with triangle start
+// rotated by rotation, marking them with mark, and returns their number.
+// With a cache, the strip stops before its points not in the cache exceed
+// maximumMisses, and misses is set to their number. The points are
+// appended to strip when it is not null.
+vtkIdType WalkStrip(const PatchMesh& mesh, vtkIdType start, int rotation,
+                    int maximumLength, const VertexCache* cache,
+                    vtkIdType maximumMisses, vtkIdType mark,
+                    std::vector<vtkIdType>& marks,
+                    std::vector<vtkIdType>* strip, vtkIdType& misses)
+{
+  const vtkIdType* triangle = mesh.Triangles.data() + 3 * start;
+  vtkIdType p = triangle[(rotation + 1) % 3];
+  vtkIdType q = triangle[(rotation + 2) % 3];
+  if (strip)
+  {
+    strip->insert(strip->end(), {triangle[rotation], p, q});
+  }
+  marks[start] = mark;
+  misses = 0;
+  if (cache)
+  {
+    misses = std::count_if(triangle, triangle + 3, [&](vtkIdType id) {
+      return !cache->Contains(id);
+    });
+  }
+  vtkIdType length = 1;
+  for (; length < maximumLength; ++length)
+  {
+    // The next triangle holds the last edge of the strip, in the direction
+    // that keeps the orientation: q to p after an even triangle, p to q
+    // after an odd one.
+    const vtkIdType from = (length & 1) ? q : p;
+    const vtkIdType to = (length & 1) ? p : q;
+    vtkIdType next = -1;
+    vtkIdType third = -1;
+    for (vtkIdType i = mesh.Offsets[from]; i < mesh.Offsets[from + 1]; ++i)
+    {
+      const vtkIdType t = mesh.Incident[i];
+      if (marks[t] == 1 || marks[t] == mark)
+      {
+        continue;
+      }
+      const vtkIdType* candidate = mesh.Triangles.data() + 3 * t;
+      for (int j = 0; j < 3; ++j)
+      {
+        if (candidate[j] == from && candidate[(j + 1) % 3] == to)
+        {
+          next = t;
+          third = candidate[(j + 2) % 3];
+        }
+      }
+      if (next >= 0)
+      {
+        break;
+      }
+    }
+    if (next < 0)
+    {
+      break;
+    }
+    if (cache && !cache->Contains(third))
+    {
+      if (misses == maximumMisses)
+      {
+        break;
+      }
+      ++misses;
+    }
+    marks[next] = mark;
+    if (strip)
+    {
+      strip->push_back(third);
+    }
+    p = q;
+    q = third;
+  }
+  return length;
+}
+
+void BuildStrips(const PatchMesh& mesh, int maximumLength, int cacheSize,
+                 PatchScratch& scratch, PatchOutput& output)
+{
+  // A mark of 1 is a triangle in a strip; the trial walks use marks from 2
+  // on, so that they need no clearing.
+  auto& marks = scratch.Marks;
+  marks.assign(mesh.GetNumberOfTriangles(), 0);
+  vtkIdType trial = 2;
+  output.Connectivity.clear();
+  output.Sizes.clear();
+
+  // With a cache size, the strips are kept short enough for the next strip
+  // to run back along the previous one while its points are in the cache.
+  // Live counts the triangles of each point that are not in a strip yet.
+  VertexCache* cache = nullptr;
+  auto& live = scratch.Live;
+  if (cacheSize > 0)
+  {
+    cache = &scratch.Cache;
+    cache->Reset(mesh.GetNumberOfPoints(), cacheSize);
+    live.resize(mesh.GetNumberOfPoints());
+    for (vtkIdType i = 0; i < mesh.GetNumberOfPoints(); ++i)
+    {
+      live[i] = mesh.Offsets[i + 1] - mesh.Offsets[i];
+    }
+  }
+  const vtkIdType maximumMisses = cacheSize / 2;
+  const std::size_t maximumCandidates = 8;
+
+  std::size_t cursor = 0;
+  for (;;)
+  {
+    // The candidate first triangles: those around the newest points of the
+    // cache, else the next one in the order.
+    auto& candidates = scratch.Candidates;
+    candidates.clear();
+    if (cache)
+    {
+      const vtkIdType oldest =
+        std::max<vtkIdType>(cache->Misses - cacheSize, 0);
+      for (vtkIdType k = cache->Misses - 1;
+           k >= oldest && candidates.size() < maximumCandidates; --k)
+      {
+        const vtkIdType v = cache->Ring[k % cacheSize];
+        for (vtkIdType i = mesh.Offsets[v];
+             live[v] > 0 && i < mesh.Offsets[v + 1]; ++i)
+        {
+          if (marks[mesh.Incident[i]] != 1)
+          {
+            candidates.push_back(mesh.Incident[i]);
+          }
+        }
+      }
+    }
+    for (; candidates.empty() && cursor < scratch.Order.size(); ++cursor)
+    {
+      if (marks[scratch.Order[cursor]] != 1)
+      {
+        candidates.push_back(scratch.Order[cursor]);
+      }
+    }
+    if (candidates.empty())
+    {
+      break;
+    }
+
+    // The strip with the fewest misses per triangle, then the longest.
+    vtkIdType start = -1;
+    int best = 0;
+    vtkIdType bestLength = 0;
+    vtkIdType bestMisses = 0;
+    for (vtkIdType candidate : candidates)
+    {
+      for (int rotation = 0; rotation < 3; ++rotation)
+      {
+        vtkIdType misses = 0;
+        const vtkIdType length =
+          WalkStrip(mesh, candidate, rotation, maximumLength, cache,
+                    maximumMisses, trial++, marks, nullptr, misses);
+        const vtkIdType lhs = (misses + 1) * bestLength;
+        const vtkIdType rhs = (bestMisses + 1) * length;
+        if (start < 0 || lhs < rhs || (lhs == rhs && length > bestLength))
+        {
+          start = candidate;
+          best = rotation;
+          bestLength = length;
+          bestMisses = misses;
+        }
+      }
+    }
+    const std::size_t first = output.Connectivity.size();
+    WalkStrip(mesh, start, best, maximumLength, cache, maximumMisses, 1,
+              marks, &output.Connectivity, bestMisses);
+    output.Sizes.push_back(bestLength + 2);
+    if (cache)
+    {
+      for (std::size_t i = first; i < output.Connectivity.size(); ++i)
+      {
+        cache->Fetch(output.Connectivity[i]);
+      }
+      // Point i of the strip is in triangles i - 2 to i.
+      const vtkIdType* ids = output.Connectivity.data() + first;
+      for (vtkIdType i = 0; i < bestLength + 2; ++i)
+      {
+        live[ids[i]] -=
+          std::min(i, bestLength - 1) - std::max<vtkIdType>(i - 2, 0) + 1;
+      }
+    }
+  }
+}
+
+std::uint64_t MortonCode(const double x[3], const double bounds[6])
+{
+  // 21 bits per axis, spread to every third bit.
+  std::uint64_t code = 0;
+  for (int i = 0; i < 3; ++i)
+  {
+    const double length = bounds[2 * i + 1] - bounds[2 * i];
+    const double u = length > 0.0 ? (x[i] - bounds[2 * i]) / length : 0.0;
+    std::uint64_t v = static_cast<std::uint64_t>(
+      std::min(std::max(u, 0.0), 1.0) * ((1 << 21) - 1));
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    code |= v << i;
+  }
+  return code;
+}
+
+vtkSmartPointer<vtkPolyData> MakeSphere(int resolution, bool shuffle)
+{
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetThetaResolution(resolution);
+  sphereSource->SetPhiResolution(resolution);
+  sphereSource->Update();
+  auto sphere = vtkSmartPointer<vtkPolyData>::New();
+  sphere->DeepCopy(sphereSource->GetOutput());
+
+  // The input point ids, to compare the triangles after renumbering.
+  const vtkIdType numberOfPoints = sphere->GetNumberOfPoints();
+  vtkNew<vtkIdTypeArray> originalIds;
+  originalIds->SetName("OriginalIds");
+  originalIds->SetNumberOfValues(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    originalIds->SetValue(i, i);
+  }
+  sphere->GetPointData()->AddArray(originalIds);
+  if (!shuffle)
+  {
+    return sphere;
+  }
+
+  // Shuffle the triangles, as in a mesh assembled in no particular order,
+  // keeping the point ids.
+  std::vector<vtkIdType> triangles;
+  vtkIdType npts;
+  const vtkIdType* pts;
+  auto iterator = vtk::TakeSmartPointer(sphere->GetPolys()->NewIterator());
+  for (iterator->GoToFirstCell(); !iterator->IsDoneWithTraversal();
+       iterator->GoToNextCell())
+  {
+    iterator->GetCurrentCell(npts, pts);
+    triangles.insert(triangles.end(), pts, pts + npts);
+  }
+  const vtkIdType numberOfTriangles =
+    static_cast<vtkIdType>(triangles.size() / 3);
+  std::vector<vtkIdType> order(numberOfTriangles);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 generator(5489u);
+  std::shuffle(order.begin(), order.end(), generator);
+  vtkNew<vtkCellArray> polys;
+  polys->AllocateExact(numberOfTriangles, 3 * numberOfTriangles);
+  for (vtkIdType t : order)
+  {
+    polys->InsertNextCell(3, triangles.data() + 3 * t);
+  }
+  sphere->SetPolys(polys);
+  return sphere;
+}
+
+// The vertex cache misses per triangle of the polygons with three points
+// and the strips, in cell order, for a first in first out cache.
+double CacheMissRatio(vtkPolyData* polyData, int cacheSize)
+{
+  // A point is in the cache if fewer than cacheSize misses happened since
+  // its own miss.
+  std::vector<vtkIdType> missTime(polyData->GetNumberOfPoints(), -cacheSize);
+  vtkIdType misses = 0;
+  auto fetch = [&](vtkIdType id) {
+    if (misses - missTime[id] >= cacheSize)
+    {
+      missTime[id] = misses++;
+    }
+  };
+  vtkIdType numberOfTriangles = 0;
+  vtkIdType npts;
+  const vtkIdType* pts;
+  auto polys = vtk::TakeSmartPointer(polyData->GetPolys()->NewIterator());
+  for (polys->GoToFirstCell(); !polys->IsDoneWithTraversal();
+       polys->GoToNextCell())
+  {
+    polys->GetCurrentCell(npts, pts);
+    if (npts == 3)
+    {
+      std::for_each(pts, pts + 3, fetch);
+      ++numberOfTriangles;
+    }
+  }
+  auto strips = vtk::TakeSmartPointer(polyData->GetStrips()->NewIterator());
+  for (strips->GoToFirstCell(); !strips->IsDoneWithTraversal();
+       strips->GoToNextCell())
+  {
+    strips->GetCurrentCell(npts, pts);
+    std::for_each(pts, pts + npts, fetch);
+    numberOfTriangles += std::max<vtkIdType>(npts - 2, 0);
+  }
+  return numberOfTriangles ? static_cast<double>(misses) / numberOfTriangles
+                           : 0.0;
+}
+
+vtkIdType CountTriangles(vtkPolyData* polyData)
+{
+  return static_cast<vtkIdType>(OrientedTriangles(polyData).size());
+}
+
+// The triangles of the polygons and strips, as input point ids starting
+// with the smallest one, sorted.
+std::vector<std::array<vtkIdType, 3>> OrientedTriangles(vtkPolyData* polyData)
+{
+  auto originalIds = vtkIdTypeArray::SafeDownCast(
+    polyData->GetPointData()->GetArray("OriginalIds"));
+  std::vector<std::array<vtkIdType, 3>> triangles;
+  auto add = [&](vtkIdType a, vtkIdType b, vtkIdType c) {
+    std::array<vtkIdType, 3> triangle = {originalIds->GetValue(a),
+                                         originalIds->GetValue(b),
+                                         originalIds->GetValue(c)};
+    std::rotate(triangle.begin(),
+                std::min_element(triangle.begin(), triangle.end()),
+                triangle.end());
+    triangles.push_back(triangle);
+  };
+  vtkIdType npts;
+  const vtkIdType* pts;
+  auto polys = vtk::TakeSmartPointer(polyData->GetPolys()->NewIterator());
+  for (polys->GoToFirstCell(); !polys->IsDoneWithTraversal();
+       polys->GoToNextCell())
+  {
+    polys->GetCurrentCell(npts, pts);
+    if (npts == 3)
+    {
+      add(pts[0], pts[1], pts[2]);
+    }
+  }
+  auto strips = vtk::TakeSmartPointer(polyData->GetStrips()->NewIterator());
+  for (strips->GoToFirstCell(); !strips->IsDoneWithTraversal();
+       strips->GoToNextCell())
+  {
+    strips->GetCurrentCell(npts, pts);
+    for (vtkIdType i = 0; i + 2 < npts; ++i)
+    {
+      if (i & 1)
+      {
+        add(pts[i + 1], pts[i], pts[i + 2]);
+      }
+      else
+      {
+        add(pts[i], pts[i + 1], pts[i + 2]);
+      }
+    }
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+} // namespace
@@ -0,0 +1,934 @@
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkCellType.h>
+#include <vtkDataSetAlgorithm.h>
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkMeshQuality.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkVersion.h>
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * Computes several quality measures of the triangles and tetrahedra of a
+ * vtkPolyData or vtkUnstructuredGrid in one parallel pass over the cells.
+ *
+ * The measures are those of vtkMeshQuality (verdict):
+ *
+ * Size            the area of triangles, the volume of tetrahedra
+ * AspectRatio     the aspect ratio
+ * MinAngle        the minimum angle of triangles, the minimum dihedral
+ *                 angle of tetrahedra, in degrees
+ * ScaledJacobian  the scaled Jacobian
+ * EquiangleSkew   the equiangle skew, from the angles of the faces
+ *
+ * The edge vectors, face normals and angles of a cell are computed once
+ * and shared by the measures that use them.
+ *
+ * Each measure is added to the cell data, in an array named after it.
+ * Other cells get NaN. The statistics of each measure and cell type are
+ * accumulated as the cells are evaluated, per thread, and merged: the
+ * field data gets a "Mesh Triangle <measure>" array with the minimum,
+ * mean, maximum, variance and number of cells, as vtkMeshQuality's
+ * "Mesh Triangle Quality", and a "Mesh Triangle <measure> Histogram" of
+ * NumberOfBins counts over the histogram range of the measure; values
+ * outside the range are counted in the first or last bin.
+ */
+class MultiMeasureMeshQuality : public vtkDataSetAlgorithm
+{
+public:
+  static MultiMeasureMeshQuality* New();
+  vtkTypeMacro(MultiMeasureMeshQuality, vtkDataSetAlgorithm);
+
+  enum Measure
+  {
+    Size,
+    AspectRatio,
+    MinAngle,
+    ScaledJacobian,
+    EquiangleSkew,
+    NumberOfMeasures
+  };
+
+  static const char* GetMeasureName(int measure);
+
+  // The measures to compute, all of them by default.
+  void AddMeasure(int measure)
+  {
+    if (measure >= 0 && measure < NumberOfMeasures &&
+        std::find(this->Measures.begin(), this->Measures.end(), measure) ==
+          this->Measures.end())
+    {
+      this->Measures.push_back(measure);
+      this->Modified();
+    }
+  }
+  void RemoveAllMeasures()
+  {
+    if (!this->Measures.empty())
+    {
+      this->Measures.clear();
+      this->Modified();
+    }
+  }
+  const std::vector<int>& GetMeasures() const
+  {
+    return this->Measures;
+  }
+
+  // The range of the histogram of a measure. An empty range, the default
+  // for Size, gives no histogram.
+  void SetHistogramRange(int measure, double minimum, double maximum)
+  {
+    if (measure >= 0 && measure < NumberOfMeasures &&
+        (this->HistogramRanges[measure][0] != minimum ||
+         this->HistogramRanges[measure][1] != maximum))
+    {
+      this->HistogramRanges[measure] = {minimum, maximum};
+      this->Modified();
+    }
+  }
+  const double* GetHistogramRange(int measure) const
+  {
+    return this->HistogramRanges[measure].data();
+  }
+
+  vtkSetClampMacro(NumberOfBins, int, 1, 100000);
+  vtkGetMacro(NumberOfBins, int);
+
+protected:
+  MultiMeasureMeshQuality()
+  {
+    for (int m = 0; m < NumberOfMeasures; ++m)
+    {
+      this->Measures.push_back(m);
+    }
+    this->HistogramRanges[Size] = {0.0, 0.0};
+    this->HistogramRanges[AspectRatio] = {1.0, 3.0};
+    this->HistogramRanges[MinAngle] = {0.0, 90.0};
+    this->HistogramRanges[ScaledJacobian] = {-1.0, 1.0};
+    this->HistogramRanges[EquiangleSkew] = {0.0, 1.0};
+  }
+  ~MultiMeasureMeshQuality() override = default;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  std::vector<int> Measures;
+  std::array<std::array<double, 2>, NumberOfMeasures> HistogramRanges;
+  int NumberOfBins = 20;
+
+private:
+  MultiMeasureMeshQuality(const MultiMeasureMeshQuality&) = delete;
+  void operator=(const MultiMeasureMeshQuality&) = delete;
+};
+
+vtkStandardNewMacro(MultiMeasureMeshQuality);
+
+vtkSmartPointer<vtkPolyData> MakeTriangles(vtkIdType numberOfTriangles);
+vtkSmartPointer<vtkUnstructuredGrid> MakeTetrahedra(vtkIdType numberOfTets);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const vtkIdType numberOfTriangles =
+    argc > 1 ? std::max<vtkIdType>(2, std::atoll(argv[1])) : 2000000;
+  const vtkIdType numberOfTets =
+    argc > 2 ? std::max<vtkIdType>(6, std::atoll(argv[2])) : 500000;
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+
+  // The vtkMeshQuality measures that match ours.
+  using SetMeasure = void (vtkMeshQuality::*)();
+  struct Reference
+  {
+    int Measure;
+    SetMeasure Triangle;
+    SetMeasure Tet;
+  };
+  const std::vector<Reference> references = {
+    {MultiMeasureMeshQuality::Size,
+     &vtkMeshQuality::SetTriangleQualityMeasureToArea,
+     &vtkMeshQuality::SetTetQualityMeasureToVolume},
+    {MultiMeasureMeshQuality::AspectRatio,
+     &vtkMeshQuality::SetTriangleQualityMeasureToAspectRatio,
+     &vtkMeshQuality::SetTetQualityMeasureToAspectRatio},
+    {MultiMeasureMeshQuality::MinAngle,
+     &vtkMeshQuality::SetTriangleQualityMeasureToMinAngle,
+     &vtkMeshQuality::SetTetQualityMeasureToMinAngle},
+    {MultiMeasureMeshQuality::ScaledJacobian,
+     &vtkMeshQuality::SetTriangleQualityMeasureToScaledJacobian,
+     &vtkMeshQuality::SetTetQualityMeasureToScaledJacobian},
+#if VTK_VERSION_NUMBER >= 90200000000ULL
+    {MultiMeasureMeshQuality::EquiangleSkew,
+     &vtkMeshQuality::SetTriangleQualityMeasureToEquiangleSkew,
+     &vtkMeshQuality::SetTetQualityMeasureToEquiangleSkew},
+#endif
+  };
+
+  vtkNew<vtkTimerLog> timer;
+  bool ok = true;
+  for (int mesh = 0; mesh < 2; ++mesh)
+  {
+    const bool triangles = mesh == 0;
+    vtkSmartPointer<vtkDataSet> input;
+    if (triangles)
+    {
+      input = MakeTriangles(numberOfTriangles);
+    }
+    else
+    {
+      input = MakeTetrahedra(numberOfTets);
+    }
+    const char* cellName = triangles ? "Triangle" : "Tet";
+    std::cout << std::endl
+              << input->GetNumberOfCells() << " "
+              << (triangles ? "triangles" : "tetrahedra") << ", "
+              << references.size() << " measures" << std::endl;
+
+    // One vtkMeshQuality run per measure, each followed by a loop over the
+    // quality for its statistics.
+    std::vector<vtkSmartPointer<vtkDoubleArray>> qualities;
+    std::vector<std::array<double, 3>> referenceStatistics;
+    timer->StartTimer();
+    for (const auto& reference : references)
+    {
+      vtkNew<vtkMeshQuality> meshQuality;
+      meshQuality->SetInputData(input);
+      (meshQuality->*reference.Triangle)();
+      (meshQuality->*reference.Tet)();
+      meshQuality->Update();
+      auto quality = vtkDoubleArray::SafeDownCast(
+        meshQuality->GetOutput()->GetCellData()->GetArray("Quality"));
+      double minimum = VTK_DOUBLE_MAX;
+      double maximum = VTK_DOUBLE_MIN;
+      double sum = 0.0;
+      for (vtkIdType i = 0; i < quality->GetNumberOfValues(); ++i)
+      {
+        const double value = quality->GetValue(i);
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+        sum += value;
+      }
+      qualities.push_back(quality);
+      referenceStatistics.push_back(
+        {minimum, sum / quality->GetNumberOfValues(), maximum});
+    }
+    timer->StopTimer();
+    const double referenceTime = timer->GetElapsedTime();
+
+    vtkNew<MultiMeasureMeshQuality> qualityFilter;
+    qualityFilter->SetInputData(input);
+    qualityFilter->RemoveAllMeasures();
+    for (const auto& reference : references)
+    {
+      qualityFilter->AddMeasure(reference.Measure);
+    }
+    timer->StartTimer();
+    qualityFilter->Update();
+    timer->StopTimer();
+    const double time = timer->GetElapsedTime();
+    std::cout << std::fixed << std::setprecision(3)
+              << "  vtkMeshQuality, one run per measure: " << referenceTime
+              << " s" << std::endl
+              << "  MultiMeasureMeshQuality, one pass:   " << time << " s ("
+              << std::setprecision(1) << referenceTime / time << "x)"
+              << std::endl;
+
+    std::cout << "  " << std::left << std::setw(16) << "Measure"
+              << std::right << std::setw(14) << "Minimum" << std::setw(14)
+              << "Mean" << std::setw(14) << "Maximum" << std::setw(16)
+              << "Max difference" << std::endl;
+    auto output = qualityFilter->GetOutput();
+    for (size_t r = 0; r < references.size(); ++r)
+    {
+      const char* name =
+        MultiMeasureMeshQuality::GetMeasureName(references[r].Measure);
+      auto values =
+        vtkDoubleArray::SafeDownCast(output->GetCellData()->GetArray(name));
+      auto statistics = vtkDoubleArray::SafeDownCast(
+        output->GetFieldData()->GetArray(
+          (std::string("Mesh ") + cellName + " " + name).c_str()));
+      auto histogram = vtkIdTypeArray::SafeDownCast(
+        output->GetFieldData()->GetArray(
+          (std::string("Mesh ") + cellName + " " + name + " Histogram")
+            .c_str()));
+      // The same values, but for rounding: verdict computes the angles
+      // with acos() and we use atan2().
+      double difference = 0.0;
+      for (vtkIdType i = 0; i < values->GetNumberOfValues(); ++i)
+      {
+        const double expected = qualities[r]->GetValue(i);
+        difference = std::max(difference,
+                              std::abs(values->GetValue(i) - expected) /
+                                std::max(1.0, std::abs(expected)));
+      }
+      const double* summary = statistics->GetTuple(0);
+      bool same = difference < 1e-9 &&
+        summary[4] == static_cast<double>(values->GetNumberOfValues());
+      for (int k = 0; k < 3; ++k)
+      {
+        same = same &&
+          std::abs(summary[k] - referenceStatistics[r][k]) <=
+            1e-9 * std::max(1.0, std::abs(referenceStatistics[r][k]));
+      }
+      if (histogram)
+      {
+        vtkIdType count = 0;
+        for (vtkIdType b = 0; b < histogram->GetNumberOfValues(); ++b)
+        {
+          count += histogram->GetValue(b);
+        }
+        same = same && count == values->GetNumberOfValues();
+      }
+      ok = ok && same;
+      std::cout << "  " << std::left << std::setw(16) << name << std::right
+                << std::setprecision(6) << std::setw(14) << summary[0]
+                << std::setw(14) << summary[1] << std::setw(14) << summary[2]
+                << std::scientific << std::setprecision(2) << std::setw(16)
+                << difference << std::fixed << (same ? "" : "  differs")
+                << std::endl;
+    }
+  }
+  std::cout << std::endl
+            << (ok ? "The measures and statistics match vtkMeshQuality."
+                   : "Some measures differ from vtkMeshQuality.")
+            << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+const char* MultiMeasureMeshQuality::GetMeasureName(int measure)
+{
+  static const char* names[NumberOfMeasures] = {
+    "Size", "AspectRatio", "MinAngle", "ScaledJacobian", "EquiangleSkew"};
+  return measure >= 0 && measure < NumberOfMeasures ? names[measure]
+                                                    : "Unknown";
+}
+
+int MultiMeasureMeshQuality::FillInputPortInformation(
+  int vtkNotUsed(port), vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkPolyData");
+  info->Append(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(),
+               "vtkUnstructuredGrid");
+  return 1;
+}
+
+// As verdict's VERDICT_DBL_MAX, for degenerate cells.
+constexpr double MaximumQuality = 1.0e+30;
+
+// The cell types with measures.
+enum QualityCellType
+{
+  NoQuality = -1,
+  TriangleQuality,
+  TetQuality,
+  NumberOfQualityCellTypes
+};
+
+struct Vector
+{
+  double X, Y, Z;
+
+  Vector operator-(const Vector& other) const
+  {
+    return {this->X - other.X, this->Y - other.Y, this->Z - other.Z};
+  }
+  double Dot(const Vector& other) const
+  {
+    return this->X * other.X + this->Y * other.Y + this->Z * other.Z;
+  }
+  Vector Cross(const Vector& other) const
+  {
+    return {this->Y * other.Z - this->Z * other.Y,
+            this->Z * other.X - this->X * other.Z,
+            this->X * other.Y - this->Y * other.X};
+  }
+  double Length() const
+  {
+    return std::sqrt(this->Dot(*this));
+  }
+};
+
+// The angle, in degrees, between two vectors whose cross product has
+// the given length and whose dot product is dot.
+double Angle(double crossLength, double dot)
+{
+  return vtkMath::DegreesFromRadians(std::atan2(crossLength, dot));
+}
+
+// Equiangle skew from the extreme angles of faces whose angles are all
+// equiangle in an ideal cell.
+double Skew(double minimumAngle, double maximumAngle, double equiangle)
+{
+  return std::max((maximumAngle - equiangle) / (180.0 - equiangle),
+                  (equiangle - minimumAngle) / equiangle);
+}
+
+// The measures of a triangle. The angles are computed only if needed.
+void TriangleMeasures(const Vector p[3], bool angles, double* measures)
+{
+  const Vector e0 = p[1] - p[0];
+  const Vector e1 = p[2] - p[1];
+  const Vector e2 = p[0] - p[2];
+  const double l0 = e0.Dot(e0);
+  const double l1 = e1.Dot(e1);
+  const double l2 = e2.Dot(e2);
+  // Twice the area, the length of the cross product of any two edges.
+  const double area2 = e0.Cross(e2).Length();
+
+  measures[MultiMeasureMeshQuality::Size] = 0.5 * area2;
+
+  const double maximumLength = std::sqrt(std::max({l0, l1, l2}));
+  measures[MultiMeasureMeshQuality::AspectRatio] = area2 < DBL_MIN
+    ? MaximumQuality
+    : std::sqrt(3.0) / 6.0 * maximumLength *
+      (std::sqrt(l0) + std::sqrt(l1) + std::sqrt(l2)) / area2;
+
+  // The two longest edges make the largest product.
+  const double maximumProduct = std::max({l0 * l1, l1 * l2, l2 * l0});
+  measures[MultiMeasureMeshQuality::ScaledJacobian] = maximumProduct < DBL_MIN
+    ? 0.0
+    : 2.0 / std::sqrt(3.0) * area2 / std::sqrt(maximumProduct);
+
+  if (angles)
+  {
+    const double a0 = Angle(area2, -e0.Dot(e2));
+    const double a1 = Angle(area2, -e0.Dot(e1));
+    const double a2 = Angle(area2, -e1.Dot(e2));
+    const double minimumAngle = std::min({a0, a1, a2});
+    const double maximumAngle = std::max({a0, a1, a2});
+    measures[MultiMeasureMeshQuality::MinAngle] = minimumAngle;
+    measures[MultiMeasureMeshQuality::EquiangleSkew] =
+      Skew(minimumAngle, maximumAngle, 60.0);
+  }
+}
+
+// The measures of a tetrahedron.
+void TetMeasures(const Vector p[4], bool angles, double* measures)
+{
+  const Vector ab = p[1] - p[0];
+  const Vector ac = p[2] - p[0];
+  const Vector ad = p[3] - p[0];
+  const Vector bc = p[2] - p[1];
+  const Vector bd = p[3] - p[1];
+  const Vector cd = p[3] - p[2];
+  const double l[6] = {ab.Dot(ab), ac.Dot(ac), ad.Dot(ad),
+                       bc.Dot(bc), bd.Dot(bd), cd.Dot(cd)};
+  // The normals of the faces, as twice their area.
+  const Vector abc = ab.Cross(ac);
+  const Vector abd = ab.Cross(ad);
+  const Vector acd = ac.Cross(ad);
+  const Vector bcd = bc.Cross(bd);
+  const double areas2[4] = {abc.Length(), abd.Length(), acd.Length(),
+                            bcd.Length()};
+  const double determinant = ab.Dot(acd);
+
+  measures[MultiMeasureMeshQuality::Size] = determinant / 6.0;
+
+  const double maximumLength = std::sqrt(*std::max_element(l, l + 6));
+  measures[MultiMeasureMeshQuality::AspectRatio] = determinant < DBL_MIN
+    ? MaximumQuality
+    : std::sqrt(6.0) / 12.0 * maximumLength *
+      (areas2[0] + areas2[1] + areas2[2] + areas2[3]) / determinant;
+
+  // The largest product of the lengths of the edges at a vertex.
+  const double maximumProduct =
+    std::max({l[0] * l[1] * l[2], l[0] * l[3] * l[4], l[1] * l[3] * l[5],
+              l[2] * l[4] * l[5]});
+  measures[MultiMeasureMeshQuality::ScaledJacobian] = maximumProduct < DBL_MIN
+    ? 0.0
+    : std::sqrt(2.0) * determinant / std::sqrt(maximumProduct);
+
+  if (angles)
+  {
+    // The dihedral angle at an edge is the angle between the normals of
+    // its faces, taken from the edge; their cross product is the edge
+    // times the determinant.
+    const double d = std::abs(determinant);
+    const double dihedral = std::min(
+      {Angle(std::sqrt(l[0]) * d, abc.Dot(abd)),
+       Angle(std::sqrt(l[1]) * d, -abc.Dot(acd)),
+       Angle(std::sqrt(l[2]) * d, abd.Dot(acd)),
+       Angle(std::sqrt(l[3]) * d, abc.Dot(bcd)),
+       Angle(std::sqrt(l[4]) * d, -abd.Dot(bcd)),
+       Angle(std::sqrt(l[5]) * d, acd.Dot(bcd))});
+    measures[MultiMeasureMeshQuality::MinAngle] = dihedral;
+
+    // The angles of the faces, three per face.
+    const double faceAngles[12] = {
+      Angle(areas2[0], ab.Dot(ac)), Angle(areas2[0], -ab.Dot(bc)),
+      Angle(areas2[0], ac.Dot(bc)), Angle(areas2[1], ab.Dot(ad)),
+      Angle(areas2[1], -ab.Dot(bd)), Angle(areas2[1], ad.Dot(bd)),
+      Angle(areas2[2], ac.Dot(ad)), Angle(areas2[2], -ac.Dot(cd)),
+      Angle(areas2[2], ad.Dot(cd)), Angle(areas2[3], bc.Dot(bd)),
+      Angle(areas2[3], -bc.Dot(cd)), Angle(areas2[3], bd.Dot(cd))};
+    measures[MultiMeasureMeshQuality::EquiangleSkew] =
+      Skew(*std::min_element(faceAngles, faceAngles + 12),
+           *std::max_element(faceAngles, faceAngles + 12), 60.0);
+  }
+}
+
+// The count, extrema, mean and sum of squared deviations of values,
+// merged as in Chan et al.
+struct QualityStatistics
+{
+  vtkIdType Count = 0;
+  double Minimum = VTK_DOUBLE_MAX;
+  double Maximum = VTK_DOUBLE_MIN;
+  double Mean = 0.0;
+  double M2 = 0.0;
+
+  void Merge(const QualityStatistics& other)
+  {
+    if (other.Count == 0)
+    {
+      return;
+    }
+    const vtkIdType count = this->Count + other.Count;
+    const double delta = other.Mean - this->Mean;
+    this->Mean += delta * other.Count / count;
+    this->M2 += other.M2 +
+      delta * delta * this->Count / count * static_cast<double>(other.Count);
+    this->Count = count;
+    this->Minimum = std::min(this->Minimum, other.Minimum);
+    this->Maximum = std::max(this->Maximum, other.Maximum);
+  }
+};
+
+// The statistics and histograms of each cell type and measure.
+struct QualitySummary
+{
+  std::vector<QualityStatistics> Statistics;
+  std::vector<vtkIdType> Histograms;
+};
+
+// Evaluates the measures of a range of cells, a block at a time. Once a
+// block is evaluated, its values are still in cache and their statistics
+// are computed, two passes over the block, and merged into those of the
+// thread.
+struct EvaluateCells
+{
+  static constexpr vtkIdType BlockSize = 1024;
+
+  vtkCellArray* Cells;
+  // The id of the first cell of Cells, and the grid for the cell types of
+  // an unstructured grid. In a polydata, polygons of 3 points are
+  // triangles.
+  vtkIdType FirstCell;
+  vtkUnstructuredGrid* Grid;
+  vtkPoints* Points;
+  std::vector<int> Measures;
+  std::vector<double*> Values;
+  const std::array<std::array<double, 2>,
+                   MultiMeasureMeshQuality::NumberOfMeasures>* HistogramRanges;
+  int NumberOfBins;
+  vtkSMPThreadLocalObject<vtkIdList> PointIds;
+  vtkSMPThreadLocal<QualitySummary> Summaries;
+
+  void Initialize()
+  {
+    QualitySummary& summary = this->Summaries.Local();
+    const size_t numberOfMeasures = this->Measures.size();
+    summary.Statistics.resize(NumberOfQualityCellTypes * numberOfMeasures);
+    summary.Histograms.resize(NumberOfQualityCellTypes * numberOfMeasures *
+                              this->NumberOfBins);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    vtkIdList* pointIds = this->PointIds.Local();
+    QualitySummary& summary = this->Summaries.Local();
+    const size_t numberOfMeasures = this->Measures.size();
+    bool angles = false;
+    for (int measure : this->Measures)
+    {
+      angles = angles || measure == MultiMeasureMeshQuality::MinAngle ||
+        measure == MultiMeasureMeshQuality::EquiangleSkew;
+    }
+    signed char types[BlockSize];
+    double measures[MultiMeasureMeshQuality::NumberOfMeasures];
+    Vector p[4];
+    for (vtkIdType first = begin; first < end; first += BlockSize)
+    {
+      const vtkIdType last = std::min(first + BlockSize, end);
+      for (vtkIdType i = first; i < last; ++i)
+      {
+        const vtkIdType cellId = this->FirstCell + i;
+        this->Cells->GetCellAtId(i, pointIds);
+        const vtkIdType numberOfPoints = pointIds->GetNumberOfIds();
+        int type = NoQuality;
+        const int cellType =
+          this->Grid ? this->Grid->GetCellType(cellId) : VTK_TRIANGLE;
+        if (cellType == VTK_TRIANGLE && numberOfPoints == 3)
+        {
+          type = TriangleQuality;
+        }
+        else if (cellType == VTK_TETRA && numberOfPoints == 4)
+        {
+          type = TetQuality;
+        }
+        types[i - first] = static_cast<signed char>(type);
+        if (type == NoQuality)
+        {
+          for (size_t m = 0; m < numberOfMeasures; ++m)
+          {
+            this->Values[m][cellId] = std::numeric_limits<double>::quiet_NaN();
+          }
+          continue;
+        }
+        for (vtkIdType k = 0; k < numberOfPoints; ++k)
+        {
+          double x[3];
+          this->Points->GetPoint(pointIds->GetId(k), x);
+          p[k] = {x[0], x[1], x[2]};
+        }
+        if (type == TriangleQuality)
+        {
+          TriangleMeasures(p, angles, measures);
+        }
+        else
+        {
+          TetMeasures(p, angles, measures);
+        }
+        for (size_t m = 0; m < numberOfMeasures; ++m)
+        {
+          this->Values[m][cellId] = measures[this->Measures[m]];
+        }
+      }
+      this->Summarize(first, last, types, summary);
+    }
+  }
+
+  void Summarize(vtkIdType first, vtkIdType last, const signed char* types,
+                 QualitySummary& summary) const
+  {
+    const size_t numberOfMeasures = this->Measures.size();
+    for (size_t m = 0; m < numberOfMeasures; ++m)
+    {
+      const double* values = this->Values[m] + this->FirstCell;
+      const auto& range = (*this->HistogramRanges)[this->Measures[m]];
+      const bool histogram = range[1] > range[0];
+      const double scale = histogram
+        ? this->NumberOfBins / (range[1] - range[0])
+        : 0.0;
+      for (int type = 0; type < NumberOfQualityCellTypes; ++type)
+      {
+        QualityStatistics block;
+        double sum = 0.0;
+        for (vtkIdType i = first; i < last; ++i)
+        {
+          if (types[i - first] == type)
+          {
+            ++block.Count;
+            sum += values[i];
+          }
+        }
+        if (block.Count == 0)
+        {
+          continue;
+        }
+        block.Mean = sum / block.Count;
+        const size_t index = type * numberOfMeasures + m;
+        vtkIdType* bins = summary.Histograms.data() +
+          index * static_cast<size_t>(this->NumberOfBins);
+        for (vtkIdType i = first; i < last; ++i)
+        {
+          if (types[i - first] != type)
+          {
+            continue;
+          }
+          const double value = values[i];
+          const double deviation = value - block.Mean;
+          block.M2 += deviation * deviation;
+          block.Minimum = std::min(block.Minimum, value);
+          block.Maximum = std::max(block.Maximum, value);
+          if (histogram && !std::isnan(value))
+          {
+            const double bin = std::floor((value - range[0]) * scale);
+            ++bins[bin < 0.0 ? 0
+                     : bin >= this->NumberOfBins
+                     ? this->NumberOfBins - 1
+                     : static_cast<int>(bin)];
+          }
+        }
+        summary.Statistics[index].Merge(block);
+      }
+    }
+  }
+
+  void Reduce()
+  {
+  }
+};
+
+int MultiMeasureMeshQuality::RequestData(
+  vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  vtkDataSet* input = vtkDataSet::GetData(inputVector[0]);
+  vtkDataSet* output = vtkDataSet::GetData(outputVector);
+  output->ShallowCopy(input);
+
+  EvaluateCells evaluate;
+  auto polyData = vtkPolyData::SafeDownCast(input);
+  auto grid = vtkUnstructuredGrid::SafeDownCast(input);
+  if (polyData)
+  {
+    evaluate.Cells = polyData->GetPolys();
+    evaluate.FirstCell =
+      polyData->GetNumberOfVerts() + polyData->GetNumberOfLines();
+    evaluate.Grid = nullptr;
+    evaluate.Points = polyData->GetPoints();
+  }
+  else
+  {
+    evaluate.Cells = grid->GetCells();
+    evaluate.FirstCell = 0;
+    evaluate.Grid = grid;
+    evaluate.Points = grid->GetPoints();
+  }
+  const vtkIdType numberOfCells = input->GetNumberOfCells();
+  if (!evaluate.Points || !evaluate.Cells || numberOfCells == 0)
+  {
+    return 1;
+  }
+
+  std::vector<vtkSmartPointer<vtkDoubleArray>> arrays;
+  for (int measure : this->Measures)
+  {
+    auto array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetName(GetMeasureName(measure));
+    array->SetNumberOfValues(numberOfCells);
+    // The cells of a polydata other than its polygons.
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+    std::fill_n(array->GetPointer(0), evaluate.FirstCell, nan);
+    std::fill(array->GetPointer(0) + evaluate.FirstCell +
+                evaluate.Cells->GetNumberOfCells(),
+              array->GetPointer(0) + numberOfCells, nan);
+    arrays.push_back(array);
+    evaluate.Values.push_back(array->GetPointer(0));
+  }
+  evaluate.Measures = this->Measures;
+  evaluate.HistogramRanges = &this->HistogramRanges;
+  evaluate.NumberOfBins = this->NumberOfBins;
+  vtkSMPTools::For(0, evaluate.Cells->GetNumberOfCells(), evaluate);
+
+  // Merge the threads' statistics.
+  const size_t numberOfMeasures = this->Measures.size();
+  QualitySummary total;
+  total.Statistics.resize(NumberOfQualityCellTypes * numberOfMeasures);
+  total.Histograms.resize(NumberOfQualityCellTypes * numberOfMeasures *
+                          this->NumberOfBins);
+  for (const QualitySummary& summary : evaluate.Summaries)
+  {
+    for (size_t i = 0; i < total.Statistics.size(); ++i)
+    {
+      total.Statistics[i].Merge(summary.Statistics[i]);
+    }
+    for (size_t i = 0; i < total.Histograms.size(); ++i)
+    {
+      total.Histograms[i] += summary.Histograms[i];
+    }
+  }
+
+  for (size_t m = 0; m < numberOfMeasures; ++m)
+  {
+    output->GetCellData()->AddArray(arrays[m]);
+    const auto& range = this->HistogramRanges[this->Measures[m]];
+    for (int type = 0; type < NumberOfQualityCellTypes; ++type)
+    {
+      const QualityStatistics& statistics =
+        total.Statistics[type * numberOfMeasures + m];
+      if (statistics.Count == 0)
+      {
+        continue;
+      }
+      const std::string name = std::string("Mesh ") +
+        (type == TriangleQuality ? "Triangle " : "Tet ") +
+        GetMeasureName(this->Measures[m]);
+      vtkNew<vtkDoubleArray> summary;
+      summary->SetName(name.c_str());
+      summary->SetNumberOfComponents(5);
+      summary->SetComponentName(0, "Minimum");
+      summary->SetComponentName(1, "Mean");
+      summary->SetComponentName(2, "Maximum");
+      summary->SetComponentName(3, "Variance");
+      summary->SetComponentName(4, "Count");
+      const double variance = statistics.Count > 1
+        ? statistics.M2 / (statistics.Count - 1)
+        : 0.0;
+      summary->InsertNextTuple5(statistics.Minimum, statistics.Mean,
+                                statistics.Maximum, variance,
+                                static_cast<double>(statistics.Count));
+      output->GetFieldData()->AddArray(summary);
+      if (range[1] > range[0])
+      {
+        vtkNew<vtkIdTypeArray> histogram;
+        histogram->SetName((name + " Histogram").c_str());
+        histogram->SetNumberOfValues(this->NumberOfBins);
+        std::copy_n(total.Histograms.data() +
+                      (type * numberOfMeasures + m) * this->NumberOfBins,
+                    this->NumberOfBins, histogram->GetPointer(0));
+        output->GetFieldData()->AddArray(histogram);
+      }
+    }
+  }
+  return 1;
+}
+
+// A random number in [-0.5, 0.5) for each point and component, a hash of
+// both (SplitMix64), so that the points can be made in any order.
+double Jitter(vtkIdType id, int component)
+{
+  std::uint64_t z = static_cast<std::uint64_t>(3 * id + component) +
+    0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  return static_cast<double>(z >> 11) / 9007199254740992.0 - 0.5;
+}
+
+// A jittered, slightly curved grid of about the number of triangles.
+vtkSmartPointer<vtkPolyData> MakeTriangles(vtkIdType numberOfTriangles)
+{
+  const auto n = static_cast<vtkIdType>(
+                   std::ceil(std::sqrt(numberOfTriangles / 2.0))) +
+    1;
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(n * n);
+  auto x = static_cast<double*>(points->GetVoidPointer(0));
+  vtkSMPTools::For(0, n * n, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType id = begin; id < end; ++id)
+    {
+      const double u = (id % n + 0.4 * Jitter(id, 0)) / (n - 1);
+      const double v = (id / n + 0.4 * Jitter(id, 1)) / (n - 1);
+      x[3 * id] = u;
+      x[3 * id + 1] = v;
+      x[3 * id + 2] = 0.1 * std::sin(6.0 * u) * std::cos(4.0 * v);
+    }
+  });
+
+  const vtkIdType numberOfQuads = (n - 1) * (n - 1);
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(2 * numberOfQuads + 1);
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(6 * numberOfQuads);
+  auto o = offsets->GetPointer(0);
+  auto c = connectivity->GetPointer(0);
+  vtkSMPTools::For(0, numberOfQuads, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType q = begin; q < end; ++q)
+    {
+      const vtkIdType p = q / (n - 1) * n + q % (n - 1);
+      const vtkIdType ids[6] = {p, p + 1, p + n + 1, p, p + n + 1, p + n};
+      std::copy(ids, ids + 6, c + 6 * q);
+      o[2 * q] = 6 * q;
+      o[2 * q + 1] = 6 * q + 3;
+    }
+  });
+  o[2 * numberOfQuads] = 6 * numberOfQuads;
+  vtkNew<vtkCellArray> polys;
+  polys->SetData(offsets, connectivity);
+
+  auto polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetPolys(polys);
+  return polyData;
+}
+
+// A jittered grid of cubes, each split into 6 tetrahedra around its
+// diagonal, of about the number of tetrahedra.
+vtkSmartPointer<vtkUnstructuredGrid> MakeTetrahedra(vtkIdType numberOfTets)
+{
+  const auto n =
+    static_cast<vtkIdType>(std::ceil(std::cbrt(numberOfTets / 6.0))) + 1;
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(n * n * n);
+  auto x = static_cast<double*>(points->GetVoidPointer(0));
+  vtkSMPTools::For(0, n * n * n, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType id = begin; id < end; ++id)
+    {
+      const vtkIdType ijk[3] = {id % n, id / n % n, id / (n * n)};
+      for (int k = 0; k < 3; ++k)
+      {
+        x[3 * id + k] = (ijk[k] + 0.2 * Jitter(id, k)) / (n - 1);
+      }
+    }
+  });
+
+  // The paths from the first to the last corner of a cube, along the
+  // edges, one per tetrahedron.
+  const int paths[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2},
+                           {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+  const vtkIdType steps[3] = {1, n, n * n};
+  const vtkIdType numberOfCubes = (n - 1) * (n - 1) * (n - 1);
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(6 * numberOfCubes + 1);
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(24 * numberOfCubes);
+  auto o = offsets->GetPointer(0);
+  auto c = connectivity->GetPointer(0);
+  vtkSMPTools::For(0, numberOfCubes, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cube = begin; cube < end; ++cube)
+    {
+      const vtkIdType m = n - 1;
+      const vtkIdType first =
+        cube % m + cube / m % m * n + cube / (m * m) * n * n;
+      for (int t = 0; t < 6; ++t)
+      {
+        vtkIdType* ids = c + 24 * cube + 4 * t;
+        ids[0] = first;
+        ids[1] = ids[0] + steps[paths[t][0]];
+        ids[2] = ids[1] + steps[paths[t][1]];
+        ids[3] = ids[2] + steps[paths[t][2]];
+        // Half of the paths give tetrahedra of negative volume.
+        if (t == 1 || t == 2 || t == 5)
+        {
+          std::swap(ids[2], ids[3]);
+        }
+        o[6 * cube + t] = 24 * cube + 4 * t;
+      }
+    }
+  });
+  o[6 * numberOfCubes] = 24 * numberOfCubes;
+  vtkNew<vtkCellArray> cells;
+  cells->SetData(offsets, connectivity);
+
+  auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  grid->SetPoints(points);
+  grid->SetCells(VTK_TETRA, cells);
+  return grid;
+}
+} // namespace
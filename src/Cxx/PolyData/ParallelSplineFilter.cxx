@@ -0,0 +1,1016 @@
+#include <vtkArrayListTemplate.h>
+#include <vtkCardinalSpline.h>
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
+#include <vtkCellData.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkKochanekSpline.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkSpline.h>
+#include <vtkSplineFilter.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * A spline through 3D points, each coordinate fitted as vtkCardinalSpline
+ * fits it, evaluated for arrays of parameters.
+ *
+ * Evaluate() walks the intervals along increasing parameters and evaluates
+ * the samples of each interval in one loop with the coefficients in
+ * registers, which the compiler vectorizes. The first derivatives come
+ * with the positions at little extra cost.
+ *
+ * For sampling by arc length, ArcLengthTable() integrates the arc length
+ * with a five point Gauss-Legendre rule at a few offsets in each interval,
+ * and ParametersAtArcLengths() inverts it from the table: an interpolation
+ * in the table, then usually one or two safeguarded Newton iterations.
+ */
+class BatchCardinalSpline
+{
+public:
+  // Fits the spline through n points (x, y, z interleaved) at increasing
+  // parameters t. The constraints are those of vtkSpline, from 1 to 3.
+  void Fit(const double* t, const double* points, int n, int leftConstraint,
+           double leftValue, int rightConstraint, double rightValue);
+
+  // Evaluates the positions, and the first derivatives when derivatives is
+  // not null, at n parameters clamped to the parameter range. The loops
+  // are fastest for increasing parameters.
+  void Evaluate(const double* t, vtkIdType n, double* points,
+                double* derivatives) const;
+
+  int GetNumberOfIntervals() const
+  {
+    return static_cast<int>(this->Knots.size()) - 1;
+  }
+
+  // The number of entries in the arc length table per interval.
+  static constexpr int TableResolution = 4;
+
+  int GetArcLengthTableSize() const
+  {
+    return this->GetNumberOfIntervals() * TableResolution + 1;
+  }
+
+  // The arc length from the first knot at TableResolution evenly spaced
+  // offsets in each interval, and at the last knot.
+  void ArcLengthTable(double* table) const;
+
+  // The parameters at n increasing arc lengths s, given the table.
+  void ParametersAtArcLengths(const double* table, const double* s,
+                              vtkIdType n, double* t) const;
+
+private:
+  void Fit1D(const double* y, int stride, int leftConstraint,
+             double leftValue, int rightConstraint, double rightValue,
+             double* coefficients);
+  double Speed(int k, double u) const;
+  // The arc length in interval k between the offsets u0 and u1.
+  double ArcLength(int k, double u0, double u1) const;
+
+  std::vector<double> Knots;
+  // Four coefficients per interval for each coordinate, in powers of the
+  // offset in the interval, as in vtkCardinalSpline.
+  std::vector<double> Coefficients[3];
+  std::vector<std::array<double, 3>> Band;
+  std::vector<double> Work;
+};
+
+/**
+ * Resamples the polylines of the input with splines, as vtkSplineFilter
+ * does with NumberOfSubdivisions.
+ *
+ * The polylines are processed in parallel with vtkSMPTools. A
+ * vtkCardinalSpline (the default, open, with constraints 1 to 3) is fitted
+ * and evaluated with BatchCardinalSpline; other splines are copied for
+ * each thread and evaluated a point at a time.
+ *
+ * With ArcLengthSampling on, and a cardinal spline, the samples are spaced
+ * evenly along the arc length of the spline rather than along the
+ * parameter of the spline, which follows the length of the polyline. The
+ * arc length tables of the lines are kept, so that as long as the input
+ * and the spline do not change, resampling the same polylines again, for
+ * instance with a different number of subdivisions, skips the
+ * integration.
+ *
+ * The point data is interpolated as in vtkSplineFilter and the cell data
+ * is copied. Texture coordinates are not generated, and the points are
+ * output in double precision.
+ */
+class ParallelSplineFilter : public vtkPolyDataAlgorithm
+{
+public:
+  static ParallelSplineFilter* New();
+  vtkTypeMacro(ParallelSplineFilter, vtkPolyDataAlgorithm);
+
+  void SetSpline(vtkSpline* spline)
+  {
+    if (this->Spline != spline)
+    {
+      this->Spline = spline;
+      this->Modified();
+    }
+  }
+  vtkSpline* GetSpline()
+  {
+    return this->Spline;
+  }
+
+  vtkSetClampMacro(NumberOfSubdivisions, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfSubdivisions, int);
+
+  vtkSetMacro(ArcLengthSampling, bool);
+  vtkGetMacro(ArcLengthSampling, bool);
+  vtkBooleanMacro(ArcLengthSampling, bool);
+
+  // True if the last execution used BatchCardinalSpline, and if it reused
+  // the arc lengths of the previous one.
+  vtkGetMacro(BatchEvaluated, bool);
+  vtkGetMacro(ArcLengthsReused, bool);
+
+  // The filter is also modified when the spline is.
+  vtkMTimeType GetMTime() override
+  {
+    auto mTime = this->Superclass::GetMTime();
+    if (this->Spline)
+    {
+      mTime = std::max(mTime, this->Spline->GetMTime());
+    }
+    return mTime;
+  }
+
+protected:
+  ParallelSplineFilter()
+  {
+    this->Spline = vtkSmartPointer<vtkCardinalSpline>::New();
+  }
+  ~ParallelSplineFilter() override = default;
+
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  vtkSmartPointer<vtkSpline> Spline;
+  int NumberOfSubdivisions = 100;
+  bool ArcLengthSampling = false;
+
+  bool BatchEvaluated = false;
+  bool ArcLengthsReused = false;
+
+  // The arc length tables of the input lines, TableResolution entries per
+  // input point, and what they were computed for: the input, the spline and
+  // its left and right constraints and values.
+  std::vector<double> ArcLengths;
+  vtkPolyData* ArcLengthsInput = nullptr;
+  vtkMTimeType ArcLengthsInputTime = 0;
+  vtkSpline* ArcLengthsSpline = nullptr;
+  vtkMTimeType ArcLengthsSplineTime = 0;
+  std::array<double, 4> ArcLengthsConstraints{};
+
+private:
+  ParallelSplineFilter(const ParallelSplineFilter&) = delete;
+  void operator=(const ParallelSplineFilter&) = delete;
+};
+
+vtkStandardNewMacro(ParallelSplineFilter);
+
+vtkSmartPointer<vtkPolyData> MakePolylines(int numberOfLines,
+                                           int pointsPerLine);
+double MaximumDistance(vtkPolyData* a, vtkPolyData* b);
+double MaximumScalarDifference(vtkPolyData* a, vtkPolyData* b);
+double SpacingSpread(vtkPolyData* polyData);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const int numberOfLines = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+  const int pointsPerLine = argc > 2 ? std::max(2, std::atoi(argv[2])) : 100;
+  const int samples = argc > 3 ? std::max(2, std::atoi(argv[3])) : 1000;
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << numberOfLines << " polylines of " << pointsPerLine
+            << " points resampled to " << samples << " points" << std::endl;
+  auto polylines = MakePolylines(numberOfLines, pointsPerLine);
+  double bounds[6];
+  polylines->GetBounds(bounds);
+  double size = 0.0;
+  for (int i = 0; i < 3; ++i)
+  {
+    size = std::max(size, bounds[2 * i + 1] - bounds[2 * i]);
+  }
+  // vtkSplineFilter outputs float points.
+  const double tolerance = 1e-6 * size;
+
+  std::cout << std::left << std::setw(28) << "Method" << std::right
+            << std::setw(12) << "Time" << std::setw(16) << "Max difference"
+            << std::setw(16) << "Spacing spread" << std::endl;
+  std::cout << std::fixed;
+  vtkNew<vtkTimerLog> timer;
+  bool ok = true;
+  auto report = [&](const char* name, vtkPolyData* output,
+                    vtkPolyData* reference) {
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << std::setprecision(1)
+              << 1000.0 * timer->GetElapsedTime() << " ms";
+    if (reference)
+    {
+      const double difference = MaximumDistance(output, reference);
+      const double scalarDifference =
+        MaximumScalarDifference(output, reference);
+      std::cout << std::setw(16) << std::scientific << std::setprecision(2)
+                << difference << std::fixed;
+      if (difference > tolerance || scalarDifference > 1e-4)
+      {
+        ok = false;
+      }
+    }
+    else
+    {
+      std::cout << std::setw(16) << "-";
+    }
+    std::cout << std::setw(15) << std::setprecision(2)
+              << 100.0 * SpacingSpread(output) << "%" << std::endl;
+  };
+
+  vtkNew<vtkCardinalSpline> cardinal;
+  vtkNew<vtkKochanekSpline> kochanek;
+  for (vtkSpline* spline : {static_cast<vtkSpline*>(cardinal),
+                            static_cast<vtkSpline*>(kochanek)})
+  {
+    const std::string splineName =
+      spline == cardinal ? "cardinal" : "Kochanek";
+    vtkNew<vtkSplineFilter> splineFilter;
+    splineFilter->SetInputData(polylines);
+    splineFilter->SetSpline(spline);
+    splineFilter->SetSubdivideToSpecified();
+    splineFilter->SetNumberOfSubdivisions(samples - 1);
+    splineFilter->SetMaximumNumberOfPoints(samples);
+    splineFilter->SetGenerateTCoordsToOff();
+    timer->StartTimer();
+    splineFilter->Update();
+    timer->StopTimer();
+    report(("vtkSplineFilter, " + splineName).c_str(),
+           splineFilter->GetOutput(), nullptr);
+
+    vtkNew<ParallelSplineFilter> parallelFilter;
+    parallelFilter->SetInputData(polylines);
+    parallelFilter->SetSpline(spline);
+    parallelFilter->SetNumberOfSubdivisions(samples - 1);
+    timer->StartTimer();
+    parallelFilter->Update();
+    timer->StopTimer();
+    report(("Parallel, " + splineName +
+            (parallelFilter->GetBatchEvaluated() ? ", batch" : ""))
+             .c_str(),
+           parallelFilter->GetOutput(), splineFilter->GetOutput());
+  }
+
+  // Even spacing along the arc length, then again with the arc lengths
+  // kept from the first execution.
+  vtkNew<ParallelSplineFilter> arcLengthFilter;
+  arcLengthFilter->SetInputData(polylines);
+  arcLengthFilter->SetNumberOfSubdivisions(samples - 1);
+  arcLengthFilter->ArcLengthSamplingOn();
+  for (int run = 0; run < 2; ++run)
+  {
+    arcLengthFilter->Modified();
+    timer->StartTimer();
+    arcLengthFilter->Update();
+    timer->StopTimer();
+    report(arcLengthFilter->GetArcLengthsReused() ? "Arc length, reused"
+                                                  : "Arc length",
+           arcLengthFilter->GetOutput(), nullptr);
+  }
+  if (!arcLengthFilter->GetArcLengthsReused() ||
+      SpacingSpread(arcLengthFilter->GetOutput()) > 0.01)
+  {
+    ok = false;
+  }
+  std::cout.unsetf(std::ios_base::floatfield);
+  std::cout << "Spacing spread: the median over the lines of the largest "
+               "deviation of the distance between consecutive samples from "
+               "its mean on the line"
+            << std::endl;
+
+  if (ok)
+  {
+    std::cout << "The parallel filter matches vtkSplineFilter" << std::endl;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+void BatchCardinalSpline::Fit(const double* t, const double* points, int n,
+                              int leftConstraint, double leftValue,
+                              int rightConstraint, double rightValue)
+{
+  this->Knots.assign(t, t + n);
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    this->Coefficients[axis].resize(4 * n);
+    this->Fit1D(points + axis, 3, leftConstraint, leftValue, rightConstraint,
+                rightValue, this->Coefficients[axis].data());
+  }
+}
+
+// The fit of vtkCardinalSpline::Fit1D(), for the constraints 1 to 3: a
+// tridiagonal system for the first derivatives at the knots.
+void BatchCardinalSpline::Fit1D(const double* y, int stride,
+                                int leftConstraint, double leftValue,
+                                int rightConstraint, double rightValue,
+                                double* coefficients)
+{
+  const int size = this->GetNumberOfIntervals();
+  const double* x = this->Knots.data();
+  auto Y = [&](int k) { return y[k * stride]; };
+  auto& band = this->Band;
+  auto& work = this->Work;
+  band.resize(size + 1);
+  work.resize(size + 1);
+
+  switch (leftConstraint)
+  {
+    case 1:
+      band[0][1] = 1.0;
+      band[0][2] = 0.0;
+      work[0] = leftValue;
+      break;
+    case 2:
+      band[0][1] = 2.0;
+      band[0][2] = 1.0;
+      work[0] = 3.0 * ((Y(1) - Y(0)) / (x[1] - x[0])) -
+        0.5 * (x[1] - x[0]) * leftValue;
+      break;
+    default:
+      band[0][1] = 2.0;
+      band[0][2] = 4.0 * ((0.5 + leftValue) / (2.0 + leftValue));
+      work[0] = 6.0 * ((1.0 + leftValue) / (2.0 + leftValue)) *
+        ((Y(1) - Y(0)) / (x[1] - x[0]));
+      break;
+  }
+  for (int k = 1; k < size; ++k)
+  {
+    const double xlk = x[k] - x[k - 1];
+    const double xlkp = x[k + 1] - x[k];
+    band[k][0] = xlkp;
+    band[k][1] = 2.0 * (xlkp + xlk);
+    band[k][2] = xlk;
+    work[k] = 3.0 *
+      (((xlkp * (Y(k) - Y(k - 1))) / xlk) +
+       ((xlk * (Y(k + 1) - Y(k))) / xlkp));
+  }
+  switch (rightConstraint)
+  {
+    case 1:
+      band[size][0] = 0.0;
+      band[size][1] = 1.0;
+      work[size] = rightValue;
+      break;
+    case 2:
+      band[size][0] = 1.0;
+      band[size][1] = 2.0;
+      work[size] = 3.0 * ((Y(size) - Y(size - 1)) / (x[size] - x[size - 1])) +
+        0.5 * (x[size] - x[size - 1]) * rightValue;
+      break;
+    default:
+      band[size][0] = 4.0 * ((0.5 + rightValue) / (2.0 + rightValue));
+      band[size][1] = 2.0;
+      work[size] = 6.0 * ((1.0 + rightValue) / (2.0 + rightValue)) *
+        ((Y(size) - Y(size - 1)) / (x[size] - x[size - 1]));
+      break;
+  }
+
+  band[0][2] = band[0][2] / band[0][1];
+  work[0] = work[0] / band[0][1];
+  band[size][2] = 0.0;
+  for (int k = 1; k <= size; ++k)
+  {
+    band[k][1] = band[k][1] - (band[k][0] * band[k - 1][2]);
+    band[k][2] = band[k][2] / band[k][1];
+    work[k] = (work[k] - (band[k][0] * work[k - 1])) / band[k][1];
+  }
+  for (int k = size - 1; k >= 0; --k)
+  {
+    work[k] = work[k] - (band[k][2] * work[k + 1]);
+  }
+
+  // The cubic of each interval from the derivatives at its ends.
+  double b = 0.0;
+  for (int k = 0; k < size; ++k)
+  {
+    b = x[k + 1] - x[k];
+    double* c = coefficients + 4 * k;
+    c[0] = Y(k);
+    c[1] = work[k];
+    c[2] = (3.0 * (Y(k + 1) - Y(k))) / (b * b) -
+      (work[k + 1] + 2.0 * work[k]) / b;
+    c[3] = (2.0 * (Y(k) - Y(k + 1))) / (b * b * b) +
+      (work[k + 1] + work[k]) / (b * b);
+  }
+  // The last knot continues the last interval.
+  double* c = coefficients + 4 * size;
+  const double* previous = c - 4;
+  c[0] = Y(size);
+  c[1] = work[size];
+  c[2] = previous[2] + 3.0 * previous[3] * b;
+  c[3] = previous[3];
+}
+
+void BatchCardinalSpline::Evaluate(const double* t, vtkIdType n,
+                                   double* points, double* derivatives) const
+{
+  const double* knots = this->Knots.data();
+  const int last = this->GetNumberOfIntervals() - 1;
+  const double tMin = knots[0];
+  const double tMax = knots[last + 1];
+  auto clamp = [&](double value) {
+    return std::min(std::max(value, tMin), tMax);
+  };
+
+  int k = 0;
+  vtkIdType i = 0;
+  while (i < n)
+  {
+    // The interval of t[i]: (knots[k], knots[k + 1]], as vtkSpline finds
+    // it, and the run of samples that follow in it.
+    const double first = clamp(t[i]);
+    if (first <= knots[k])
+    {
+      k = static_cast<int>(
+        std::lower_bound(knots + 1, knots + last + 1, first) - knots - 1);
+    }
+    while (k < last && first > knots[k + 1])
+    {
+      ++k;
+    }
+    vtkIdType end = i + 1;
+    const double upper = k < last ? knots[k + 1] : tMax;
+    while (end < n && clamp(t[end]) <= upper && clamp(t[end]) > knots[k])
+    {
+      ++end;
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      const double* c = this->Coefficients[axis].data() + 4 * k;
+      const double c0 = c[0], c1 = c[1], c2 = c[2], c3 = c[3];
+      const double origin = knots[k];
+      double* x = points + axis;
+      for (vtkIdType j = i; j < end; ++j)
+      {
+        const double u = clamp(t[j]) - origin;
+        x[3 * j] = ((c3 * u + c2) * u + c1) * u + c0;
+      }
+      if (derivatives)
+      {
+        double* dx = derivatives + axis;
+        for (vtkIdType j = i; j < end; ++j)
+        {
+          const double u = clamp(t[j]) - origin;
+          dx[3 * j] = (3.0 * c3 * u + 2.0 * c2) * u + c1;
+        }
+      }
+    }
+    i = end;
+  }
+}
+
+double BatchCardinalSpline::Speed(int k, double u) const
+{
+  double d2 = 0.0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    const double* c = this->Coefficients[axis].data() + 4 * k;
+    const double d = (3.0 * c[3] * u + 2.0 * c[2]) * u + c[1];
+    d2 += d * d;
+  }
+  return std::sqrt(d2);
+}
+
+double BatchCardinalSpline::ArcLength(int k, double u0, double u1) const
+{
+  static const double nodes[5] = {0.0, -0.5384693101056831,
+                                  0.5384693101056831, -0.9061798459386640,
+                                  0.9061798459386640};
+  static const double weights[5] = {0.5688888888888889, 0.4786286704993665,
+                                    0.4786286704993665, 0.2369268850561891,
+                                    0.2369268850561891};
+  const double half = 0.5 * (u1 - u0);
+  double length = 0.0;
+  for (int i = 0; i < 5; ++i)
+  {
+    length += weights[i] * this->Speed(k, u0 + half * (nodes[i] + 1.0));
+  }
+  return half * length;
+}
+
+void BatchCardinalSpline::ArcLengthTable(double* table) const
+{
+  table[0] = 0.0;
+  for (int k = 0; k < this->GetNumberOfIntervals(); ++k)
+  {
+    const double step =
+      (this->Knots[k + 1] - this->Knots[k]) / TableResolution;
+    for (int j = 0; j < TableResolution; ++j)
+    {
+      double* entry = table + k * TableResolution + j;
+      entry[1] = entry[0] + this->ArcLength(k, j * step, (j + 1) * step);
+    }
+  }
+}
+
+void BatchCardinalSpline::ParametersAtArcLengths(const double* table,
+                                                 const double* s, vtkIdType n,
+                                                 double* t) const
+{
+  const int last = this->GetArcLengthTableSize() - 2;
+  int m = 0;
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    const double target = std::min(std::max(s[i], 0.0), table[last + 1]);
+    while (m < last && target > table[m + 1])
+    {
+      ++m;
+    }
+    // Newton iterations on the offset in interval k from the table entry
+    // m, kept in a bracket that bisection shrinks when a step leaves it.
+    const int k = m / TableResolution;
+    const double step =
+      (this->Knots[k + 1] - this->Knots[k]) / TableResolution;
+    const double u0 = (m % TableResolution) * step;
+    const double length = table[m + 1] - table[m];
+    const double goal = target - table[m];
+    double low = u0;
+    double high = u0 + step;
+    double u = length > 0.0 ? u0 + step * goal / length : u0;
+    for (int iteration = 0; iteration < 20; ++iteration)
+    {
+      const double error = this->ArcLength(k, u0, u) - goal;
+      if (std::abs(error) <= 1e-8 * length)
+      {
+        break;
+      }
+      (error > 0.0 ? high : low) = u;
+      const double speed = this->Speed(k, u);
+      double next = speed > 0.0 ? u - error / speed : low - 1.0;
+      if (next <= low || next >= high)
+      {
+        next = 0.5 * (low + high);
+      }
+      u = next;
+    }
+    t[i] = this->Knots[k] + u;
+  }
+}
+
+// The buffers a thread reuses from line to line.
+struct LineScratch
+{
+  BatchCardinalSpline Batch;
+  std::array<vtkSmartPointer<vtkSpline>, 3> Splines;
+  std::vector<vtkIdType> Knots; // Input point ids.
+  std::vector<double> Parameters;
+  std::vector<double> Points;
+  std::vector<double> Samples;
+  std::vector<double> Lengths;
+};
+
+int ParallelSplineFilter::RequestData(vtkInformation* vtkNotUsed(request),
+                                      vtkInformationVector** inputVector,
+                                      vtkInformationVector* outputVector)
+{
+  vtkPolyData* input = vtkPolyData::GetData(inputVector[0]);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector);
+  vtkPoints* inPoints = input->GetPoints();
+  vtkSpline* prototype = this->Spline;
+  if (!inPoints || !prototype)
+  {
+    vtkErrorMacro(<< "No points or no spline.");
+    return 0;
+  }
+
+  auto cardinal = vtkCardinalSpline::SafeDownCast(prototype);
+  const bool batch = cardinal && !cardinal->GetClosed() &&
+    cardinal->GetLeftConstraint() >= 1 &&
+    cardinal->GetRightConstraint() >= 1;
+  this->BatchEvaluated = batch;
+  const bool arcLength = this->ArcLengthSampling && batch;
+  if (this->ArcLengthSampling && !batch)
+  {
+    vtkWarningMacro(<< "Arc length sampling needs an open vtkCardinalSpline "
+                       "with constraints 1 to 3; sampling by parameter.");
+  }
+
+  // The lines, as offsets into their point ids.
+  std::vector<vtkIdType> lineStart(1, 0);
+  std::vector<vtkIdType> lineIds;
+  vtkIdType npts;
+  const vtkIdType* pts;
+  auto lines = vtk::TakeSmartPointer(input->GetLines()->NewIterator());
+  for (lines->GoToFirstCell(); !lines->IsDoneWithTraversal();
+       lines->GoToNextCell())
+  {
+    lines->GetCurrentCell(npts, pts);
+    lineIds.insert(lineIds.end(), pts, pts + npts);
+    lineStart.push_back(static_cast<vtkIdType>(lineIds.size()));
+  }
+  const vtkIdType numberOfLines =
+    static_cast<vtkIdType>(lineStart.size()) - 1;
+
+  // Only the lines with some length are output.
+  std::vector<vtkIdType> outputLine(numberOfLines + 1, 0);
+  vtkSMPTools::For(0, numberOfLines, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType l = begin; l < end; ++l)
+    {
+      outputLine[l + 1] = 0;
+      if (lineStart[l] == lineStart[l + 1])
+      {
+        continue;
+      }
+      double x0[3], x[3];
+      inPoints->GetPoint(lineIds[lineStart[l]], x0);
+      for (vtkIdType i = lineStart[l] + 1; i < lineStart[l + 1]; ++i)
+      {
+        inPoints->GetPoint(lineIds[i], x);
+        if (x[0] != x0[0] || x[1] != x0[1] || x[2] != x0[2])
+        {
+          outputLine[l + 1] = 1;
+          break;
+        }
+      }
+    }
+  });
+  std::partial_sum(outputLine.begin(), outputLine.end(), outputLine.begin());
+  const vtkIdType numberOfOutputLines = outputLine[numberOfLines];
+  const vtkIdType divisions = this->NumberOfSubdivisions;
+  const vtkIdType numberOfOutputPoints = numberOfOutputLines * (divisions + 1);
+
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(numberOfOutputPoints);
+  double* x = vtkDoubleArray::SafeDownCast(points->GetData())->GetPointer(0);
+  vtkPointData* outPD = output->GetPointData();
+  outPD->InterpolateAllocate(input->GetPointData(), numberOfOutputPoints);
+  ArrayList arrays;
+  arrays.AddArrays(numberOfOutputPoints, input->GetPointData(), outPD);
+
+  // The arc lengths are kept while the input and the spline do not change.
+  // The spline is compared by identity as well as by time, as another
+  // spline set with SetSpline() may be older than the input.
+  std::array<double, 4> constraints{};
+  if (cardinal)
+  {
+    constraints = {static_cast<double>(cardinal->GetLeftConstraint()),
+                   cardinal->GetLeftValue(),
+                   static_cast<double>(cardinal->GetRightConstraint()),
+                   cardinal->GetRightValue()};
+  }
+  this->ArcLengthsReused = arcLength && this->ArcLengthsInput == input &&
+    this->ArcLengthsInputTime == input->GetMTime() &&
+    this->ArcLengthsSpline == prototype &&
+    this->ArcLengthsSplineTime == prototype->GetMTime() &&
+    this->ArcLengthsConstraints == constraints &&
+    this->ArcLengths.size() ==
+      lineIds.size() * BatchCardinalSpline::TableResolution;
+  if (arcLength && !this->ArcLengthsReused)
+  {
+    this->ArcLengths.resize(lineIds.size() *
+                            BatchCardinalSpline::TableResolution);
+  }
+  const bool computeLengths = arcLength && !this->ArcLengthsReused;
+
+  vtkSMPThreadLocal<LineScratch> scratches;
+  vtkSMPTools::For(0, numberOfLines, [&](vtkIdType begin, vtkIdType end) {
+    auto& scratch = scratches.Local();
+    if (!batch && !scratch.Splines[0])
+    {
+      for (auto& spline : scratch.Splines)
+      {
+        spline = vtk::TakeSmartPointer(prototype->NewInstance());
+        spline->DeepCopy(prototype);
+      }
+    }
+    auto& knots = scratch.Knots;
+    auto& parameters = scratch.Parameters;
+    auto& knotPoints = scratch.Points;
+    auto& samples = scratch.Samples;
+    for (vtkIdType l = begin; l < end; ++l)
+    {
+      if (outputLine[l + 1] == outputLine[l])
+      {
+        continue;
+      }
+
+      // The knots, at the length along the polyline, skipping the points
+      // that repeat the previous one, as vtkSplineFilter does.
+      knots.clear();
+      knotPoints.clear();
+      parameters.clear();
+      double length = 0.0;
+      double previous[3] = {0.0, 0.0, 0.0};
+      for (vtkIdType i = lineStart[l]; i < lineStart[l + 1]; ++i)
+      {
+        double p[3];
+        inPoints->GetPoint(lineIds[i], p);
+        if (!knots.empty())
+        {
+          const double distance =
+            std::sqrt((p[0] - previous[0]) * (p[0] - previous[0]) +
+                      (p[1] - previous[1]) * (p[1] - previous[1]) +
+                      (p[2] - previous[2]) * (p[2] - previous[2]));
+          if (distance == 0.0)
+          {
+            continue;
+          }
+          length += distance;
+        }
+        knots.push_back(lineIds[i]);
+        knotPoints.insert(knotPoints.end(), p, p + 3);
+        parameters.push_back(length);
+        std::copy(p, p + 3, previous);
+      }
+      const int n = static_cast<int>(knots.size());
+      for (auto& parameter : parameters)
+      {
+        parameter /= length;
+      }
+
+      // The sample parameters, evenly spaced along the parameter or along
+      // the arc length.
+      const vtkIdType first = outputLine[l] * (divisions + 1);
+      samples.resize(divisions + 1);
+      for (vtkIdType i = 0; i <= divisions; ++i)
+      {
+        samples[i] = static_cast<double>(i) / divisions;
+      }
+      if (batch)
+      {
+        auto& spline = scratch.Batch;
+        spline.Fit(parameters.data(), knotPoints.data(), n,
+                   cardinal->GetLeftConstraint(), cardinal->GetLeftValue(),
+                   cardinal->GetRightConstraint(), cardinal->GetRightValue());
+        if (arcLength)
+        {
+          // The table of a line fits in the entries of its points.
+          double* table = this->ArcLengths.data() +
+            lineStart[l] * BatchCardinalSpline::TableResolution;
+          if (computeLengths)
+          {
+            spline.ArcLengthTable(table);
+          }
+          const double total = table[spline.GetArcLengthTableSize() - 1];
+          auto& lengths = scratch.Lengths;
+          lengths.resize(divisions + 1);
+          for (vtkIdType i = 0; i <= divisions; ++i)
+          {
+            lengths[i] = samples[i] * total;
+          }
+          spline.ParametersAtArcLengths(table, lengths.data(),
+                                        divisions + 1, samples.data());
+        }
+        spline.Evaluate(samples.data(), divisions + 1, x + 3 * first,
+                        nullptr);
+      }
+      else
+      {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          auto spline = scratch.Splines[axis].Get();
+          spline->RemoveAllPoints();
+          for (int i = 0; i < n; ++i)
+          {
+            spline->AddPoint(parameters[i], knotPoints[3 * i + axis]);
+          }
+          for (vtkIdType i = 0; i <= divisions; ++i)
+          {
+            x[3 * (first + i) + axis] = spline->Evaluate(samples[i]);
+          }
+        }
+      }
+
+      // Interpolate the point data along the polyline.
+      int k = 0;
+      for (vtkIdType i = 0; i <= divisions; ++i)
+      {
+        const double t = samples[i];
+        while (t > parameters[k + 1] && k < n - 2)
+        {
+          ++k;
+        }
+        const double tc =
+          (t - parameters[k]) / (parameters[k + 1] - parameters[k]);
+        arrays.InterpolateEdge(knots[k], knots[k + 1], tc, first + i);
+      }
+    }
+  });
+  if (computeLengths)
+  {
+    this->ArcLengthsInput = input;
+    this->ArcLengthsInputTime = input->GetMTime();
+    this->ArcLengthsSpline = prototype;
+    this->ArcLengthsSplineTime = prototype->GetMTime();
+    this->ArcLengthsConstraints = constraints;
+  }
+
+  // One polyline per input line with some length.
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(numberOfOutputLines + 1);
+  vtkIdType* o = offsets->GetPointer(0);
+  for (vtkIdType i = 0; i <= numberOfOutputLines; ++i)
+  {
+    o[i] = i * (divisions + 1);
+  }
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(numberOfOutputPoints);
+  vtkIdType* c = connectivity->GetPointer(0);
+  std::iota(c, c + numberOfOutputPoints, 0);
+  vtkNew<vtkCellArray> outLines;
+  outLines->SetData(offsets, connectivity);
+
+  // The cell ids of vtkPolyData number the vertices before the lines.
+  vtkNew<vtkIdList> fromIds;
+  fromIds->SetNumberOfIds(numberOfOutputLines);
+  for (vtkIdType l = 0; l < numberOfLines; ++l)
+  {
+    if (outputLine[l + 1] != outputLine[l])
+    {
+      fromIds->SetId(outputLine[l], input->GetNumberOfVerts() + l);
+    }
+  }
+  vtkNew<vtkIdList> toIds;
+  toIds->SetNumberOfIds(numberOfOutputLines);
+  std::iota(toIds->begin(), toIds->end(), 0);
+  output->GetCellData()->CopyAllocate(input->GetCellData(),
+                                      numberOfOutputLines);
+  output->GetCellData()->CopyData(input->GetCellData(), fromIds, toIds);
+
+  output->SetPoints(points);
+  output->SetLines(outLines);
+  return 1;
+}
+
+vtkSmartPointer<vtkPolyData> MakePolylines(int numberOfLines,
+                                           int pointsPerLine)
+{
+  // Random walks whose direction turns a little at each step, with steps
+  // of varying length, and the index along the line as scalars.
+  std::mt19937 generator(8775070u);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const vtkIdType numberOfPoints =
+    static_cast<vtkIdType>(numberOfLines) * pointsPerLine;
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(numberOfPoints);
+  vtkNew<vtkDoubleArray> scalars;
+  scalars->SetName("Index");
+  scalars->SetNumberOfValues(numberOfPoints);
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfValues(numberOfLines + 1);
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfValues(numberOfPoints);
+  const double side = 10.0 * std::cbrt(static_cast<double>(numberOfLines));
+  vtkIdType id = 0;
+  for (int l = 0; l < numberOfLines; ++l)
+  {
+    offsets->SetValue(l, id);
+    double x[3], direction[3] = {0.0, 0.0, 0.0};
+    for (int j = 0; j < 3; ++j)
+    {
+      x[j] = side * uniform(generator);
+    }
+    for (int i = 0; i < pointsPerLine; ++i, ++id)
+    {
+      points->SetPoint(id, x);
+      scalars->SetValue(id, i);
+      connectivity->SetValue(id, id);
+      double norm = 0.0;
+      for (int j = 0; j < 3; ++j)
+      {
+        direction[j] += 0.5 * uniform(generator);
+        norm += direction[j] * direction[j];
+      }
+      const double step = (1.0 + 0.5 * uniform(generator)) /
+        std::max(std::sqrt(norm), 1e-3);
+      for (int j = 0; j < 3; ++j)
+      {
+        x[j] += step * direction[j];
+      }
+    }
+  }
+  offsets->SetValue(numberOfLines, id);
+  vtkNew<vtkCellArray> lines;
+  lines->SetData(offsets, connectivity);
+
+  auto polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetLines(lines);
+  polyData->GetPointData()->SetScalars(scalars);
+  return polyData;
+}
+
+double MaximumDistance(vtkPolyData* a, vtkPolyData* b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints())
+  {
+    return VTK_DOUBLE_MAX;
+  }
+  double distance = 0.0;
+  for (vtkIdType i = 0; i < a->GetNumberOfPoints(); ++i)
+  {
+    double p[3], q[3];
+    a->GetPoint(i, p);
+    b->GetPoint(i, q);
+    for (int j = 0; j < 3; ++j)
+    {
+      distance = std::max(distance, std::abs(p[j] - q[j]));
+    }
+  }
+  return distance;
+}
+
+double MaximumScalarDifference(vtkPolyData* a, vtkPolyData* b)
+{
+  auto sa = a->GetPointData()->GetScalars();
+  auto sb = b->GetPointData()->GetScalars();
+  if (!sa || !sb || sa->GetNumberOfTuples() != sb->GetNumberOfTuples())
+  {
+    return VTK_DOUBLE_MAX;
+  }
+  double difference = 0.0;
+  for (vtkIdType i = 0; i < sa->GetNumberOfTuples(); ++i)
+  {
+    difference = std::max(difference,
+                          std::abs(sa->GetTuple1(i) - sb->GetTuple1(i)));
+  }
+  return difference;
+}
+
+// The median over the lines of the largest relative deviation of the
+// distance between consecutive points of a line from its mean on the line.
+// The median leaves out the few lines whose spline turns back on itself,
+// where the distances of the samples fall well below their arc length.
+double SpacingSpread(vtkPolyData* polyData)
+{
+  std::vector<double> spreads;
+  std::vector<double> distances;
+  vtkIdType npts;
+  const vtkIdType* pts;
+  auto lines = vtk::TakeSmartPointer(polyData->GetLines()->NewIterator());
+  for (lines->GoToFirstCell(); !lines->IsDoneWithTraversal();
+       lines->GoToNextCell())
+  {
+    lines->GetCurrentCell(npts, pts);
+    distances.clear();
+    double p[3], q[3];
+    polyData->GetPoint(pts[0], p);
+    for (vtkIdType i = 1; i < npts; ++i)
+    {
+      polyData->GetPoint(pts[i], q);
+      distances.push_back(std::sqrt((p[0] - q[0]) * (p[0] - q[0]) +
+                                    (p[1] - q[1]) * (p[1] - q[1]) +
+                                    (p[2] - q[2]) * (p[2] - q[2])));
+      std::copy(q, q + 3, p);
+    }
+    const double mean =
+      std::accumulate(distances.begin(), distances.end(), 0.0) /
+      distances.size();
+    double spread = 0.0;
+    for (double distance : distances)
+    {
+      spread = std::max(spread, std::abs(distance - mean) / mean);
+    }
+    spreads.push_back(spread);
+  }
+  if (spreads.empty())
+  {
+    return 0.0;
+  }
+  auto median = spreads.begin() + spreads.size() / 2;
+  std::nth_element(spreads.begin(), median, spreads.end());
+  return *median;
+}
+} // namespace
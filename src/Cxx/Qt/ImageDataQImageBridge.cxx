@@ -0,0 +1,447 @@
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+#include <vtkTimerLog.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <QColor>
+#include <QImage>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+// Conversions between vtkImageData (unsigned char, 1 to 4 components, rows
+// stored bottom up) and QImage (rows stored top down). All functions work on
+// the z = extent[4] slice of the given extent, which is normally the update
+// extent of the algorithm that produced the image.
+
+// Return the QImage format that has the same memory layout as the scalars,
+// or QImage::Format_Invalid.
+QImage::Format NativeFormat(int numberOfComponents);
+
+// Zero copy: a QImage that shares the scalars of the image. The rows are in
+// VTK order, i.e. the QImage is upside down; draw it with a flipping
+// transform or use ImageDataToQImage when a top down image is needed. The
+// image keeps a reference to the scalars until the QImage is destroyed.
+QImage WrapImageData(vtkImageData* image, const int extent[6]);
+
+// Copy into a top down QImage. Formats with a native QImage equivalent are
+// copied with one memcpy per row; the others, or all of them when argb32 is
+// true, are swizzled into QImage::Format_ARGB32. Rows are processed in
+// parallel with vtkSMPTools.
+QImage ImageDataToQImage(vtkImageData* image, const int extent[6],
+                         bool argb32 = false);
+QImage ImageDataToQImage(vtkImageData* image, bool argb32 = false);
+
+// Copy a QImage into image, flipping the rows. Images that are not
+// Grayscale8, RGB888 or RGBA8888 are converted to RGBA8888 first.
+void QImageToImageData(const QImage& qimage, vtkImageData* image);
+
+// The original per pixel conversion, for comparison.
+QImage NaiveImageDataToQImage(vtkImageData* imageData);
+
+// Compare the red, green and blue values of two images of any format.
+bool SameColors(const QImage& a, const QImage& b);
+
+void MakeTestImage(int width, int height, int numberOfComponents,
+                   vtkImageData* image);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  int width = 3840;
+  int height = 2160;
+  int repeats = 10;
+  if (argc > 2)
+  {
+    width = std::stoi(argv[1]);
+    height = std::stoi(argv[2]);
+  }
+  if (argc > 3)
+  {
+    repeats = std::stoi(argv[3]);
+  }
+
+  std::cout << "Image: " << width << " x " << height << ", " << repeats
+            << " repeats, " << vtkSMPTools::GetBackend() << " backend"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+
+  bool ok = true;
+  vtkNew<vtkTimerLog> timer;
+  for (int components : {3, 4})
+  {
+    vtkNew<vtkImageData> image;
+    MakeTestImage(width, height, components, image);
+    double megaBytes = width * static_cast<double>(height) * components / 1e6;
+
+    std::cout << (components == 3 ? "RGB" : "RGBA") << std::endl;
+    auto report = [&](const char* name, double seconds) {
+      std::cout << "  " << std::left << std::setw(22) << name << std::right
+                << std::setw(12) << megaBytes * repeats / seconds << " MB/s"
+                << std::endl;
+    };
+
+    QImage naive;
+    timer->StartTimer();
+    for (int i = 0; i < repeats; ++i)
+    {
+      naive = NaiveImageDataToQImage(image);
+    }
+    timer->StopTimer();
+    report("QColor per pixel", timer->GetElapsedTime());
+
+    QImage wrapped;
+    timer->StartTimer();
+    for (int i = 0; i < repeats; ++i)
+    {
+      wrapped = WrapImageData(image, image->GetExtent());
+    }
+    timer->StopTimer();
+    report("Zero copy wrap", timer->GetElapsedTime());
+
+    QImage native;
+    timer->StartTimer();
+    for (int i = 0; i < repeats; ++i)
+    {
+      native = ImageDataToQImage(image);
+    }
+    timer->StopTimer();
+    report("Row memcpy", timer->GetElapsedTime());
+
+    QImage swizzled;
+    timer->StartTimer();
+    for (int i = 0; i < repeats; ++i)
+    {
+      swizzled = ImageDataToQImage(image, true);
+    }
+    timer->StopTimer();
+    report("ARGB32 swizzle", timer->GetElapsedTime());
+
+    vtkNew<vtkImageData> roundTrip;
+    timer->StartTimer();
+    for (int i = 0; i < repeats; ++i)
+    {
+      QImageToImageData(native, roundTrip);
+    }
+    timer->StopTimer();
+    report("QImage to vtkImageData", timer->GetElapsedTime());
+
+    // The naive conversion drops alpha, so compare the RGB values only.
+    bool same = !wrapped.isNull() && SameColors(wrapped.mirrored(), naive) &&
+        SameColors(native, naive) && SameColors(swizzled, naive);
+    auto original = vtkUnsignedCharArray::SafeDownCast(
+        image->GetPointData()->GetScalars());
+    auto copy = vtkUnsignedCharArray::SafeDownCast(
+        roundTrip->GetPointData()->GetScalars());
+    same = same && copy &&
+        copy->GetNumberOfValues() == original->GetNumberOfValues() &&
+        std::memcmp(copy->GetPointer(0), original->GetPointer(0),
+                    original->GetNumberOfValues()) == 0;
+    std::cout << "  results " << (same ? "match" : "DIFFER") << std::endl;
+    ok = ok && same;
+
+    // A sub extent, as an algorithm's update extent would be.
+    int extent[6] = {width / 4, width / 2, height / 3, height - 1, 0, 0};
+    QImage part = ImageDataToQImage(image, extent, true);
+    QImage expected =
+        naive.copy(extent[0], height - 1 - extent[3], extent[1] - extent[0] + 1,
+                   extent[3] - extent[2] + 1);
+    bool partOk = SameColors(part, expected);
+    std::cout << "  sub extent " << (partOk ? "matches" : "DIFFERS")
+              << std::endl;
+    ok = ok && partOk;
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+QImage::Format NativeFormat(int numberOfComponents)
+{
+  switch (numberOfComponents)
+  {
+  case 1:
+    return QImage::Format_Grayscale8;
+  case 3:
+    return QImage::Format_RGB888;
+  case 4:
+    return QImage::Format_RGBA8888;
+  default:
+    return QImage::Format_Invalid;
+  }
+}
+
+// Validate the image and clamp the extent to it. Returns the scalars or
+// nullptr.
+vtkUnsignedCharArray* PrepareImage(vtkImageData* image, const int extent[6],
+                                   int clamped[6])
+{
+  if (!image)
+  {
+    return nullptr;
+  }
+  auto scalars =
+      vtkUnsignedCharArray::SafeDownCast(image->GetPointData()->GetScalars());
+  if (!scalars)
+  {
+    std::cerr << "Only unsigned char scalars can be converted." << std::endl;
+    return nullptr;
+  }
+  int* whole = image->GetExtent();
+  for (int i = 0; i < 6; i += 2)
+  {
+    clamped[i] = std::max(extent[i], whole[i]);
+    clamped[i + 1] = std::min(extent[i + 1], whole[i + 1]);
+    if (clamped[i] > clamped[i + 1])
+    {
+      return nullptr;
+    }
+  }
+  return scalars;
+}
+
+void ReleaseScalars(void* info)
+{
+  static_cast<vtkDataArray*>(info)->UnRegister(nullptr);
+}
+
+QImage WrapImageData(vtkImageData* image, const int extent[6])
+{
+  int e[6];
+  vtkUnsignedCharArray* scalars = PrepareImage(image, extent, e);
+  if (!scalars)
+  {
+    return QImage();
+  }
+  int components = scalars->GetNumberOfComponents();
+  QImage::Format format = NativeFormat(components);
+  if (format == QImage::Format_Invalid)
+  {
+    return QImage();
+  }
+
+  vtkIdType increments[3];
+  image->GetIncrements(increments);
+  auto first =
+      static_cast<unsigned char*>(image->GetScalarPointer(e[0], e[2], e[4]));
+  scalars->Register(nullptr);
+  return QImage(first, e[1] - e[0] + 1, e[3] - e[2] + 1,
+                increments[1], format, ReleaseScalars, scalars);
+}
+
+QImage ImageDataToQImage(vtkImageData* image, bool argb32)
+{
+  return image ? ImageDataToQImage(image, image->GetExtent(), argb32)
+               : QImage();
+}
+
+QImage ImageDataToQImage(vtkImageData* image, const int extent[6],
+                         bool argb32)
+{
+  int e[6];
+  vtkUnsignedCharArray* scalars = PrepareImage(image, extent, e);
+  if (!scalars)
+  {
+    return QImage();
+  }
+  int components = scalars->GetNumberOfComponents();
+  QImage::Format format = NativeFormat(components);
+  if (argb32 || format == QImage::Format_Invalid)
+  {
+    format = components == 2 || components == 4 ? QImage::Format_ARGB32
+                                                : QImage::Format_RGB32;
+    argb32 = true;
+  }
+
+  int width = e[1] - e[0] + 1;
+  int height = e[3] - e[2] + 1;
+  QImage qimage(width, height, format);
+  vtkIdType increments[3];
+  image->GetIncrements(increments);
+  const unsigned char* first =
+      static_cast<unsigned char*>(image->GetScalarPointer(e[0], e[2], e[4]));
+  const vtkIdType sourceStride = increments[1];
+  // bits() detaches; take the pointer once, outside the workers.
+  unsigned char* target = qimage.bits();
+  const auto targetStride = qimage.bytesPerLine();
+
+  vtkSMPTools::For(0, height, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType row = begin; row < end; ++row)
+    {
+      const unsigned char* in = first + (height - 1 - row) * sourceStride;
+      unsigned char* out = target + row * targetStride;
+      if (!argb32)
+      {
+        std::memcpy(out, in, static_cast<size_t>(width) * components);
+        continue;
+      }
+      // Plain loops over whole pixels without branches, so that the
+      // compiler can vectorize the swizzle.
+      auto argb = reinterpret_cast<std::uint32_t*>(out);
+      switch (components)
+      {
+      case 1:
+        for (int x = 0; x < width; ++x)
+        {
+          std::uint32_t v = in[x];
+          argb[x] = 0xff000000u | (v << 16) | (v << 8) | v;
+        }
+        break;
+      case 2:
+        for (int x = 0; x < width; ++x)
+        {
+          std::uint32_t v = in[2 * x];
+          std::uint32_t a = in[2 * x + 1];
+          argb[x] = (a << 24) | (v << 16) | (v << 8) | v;
+        }
+        break;
+      case 3:
+        for (int x = 0; x < width; ++x)
+        {
+          argb[x] = 0xff000000u | (std::uint32_t(in[3 * x]) << 16) |
+              (std::uint32_t(in[3 * x + 1]) << 8) | in[3 * x + 2];
+        }
+        break;
+      default:
+        // Format_ARGB32 is not premultiplied, so alpha is copied as is.
+        for (int x = 0; x < width; ++x)
+        {
+          const unsigned char* p = in + x * components;
+          argb[x] = (std::uint32_t(p[3]) << 24) |
+              (std::uint32_t(p[0]) << 16) | (std::uint32_t(p[1]) << 8) | p[2];
+        }
+        break;
+      }
+    }
+  });
+
+  return qimage;
+}
+
+void QImageToImageData(const QImage& qimage, vtkImageData* image)
+{
+  QImage source = qimage;
+  int components = 0;
+  switch (source.format())
+  {
+  case QImage::Format_Grayscale8:
+    components = 1;
+    break;
+  case QImage::Format_RGB888:
+    components = 3;
+    break;
+  case QImage::Format_RGBA8888:
+    components = 4;
+    break;
+  default:
+    source = qimage.convertToFormat(QImage::Format_RGBA8888);
+    components = 4;
+    break;
+  }
+
+  int width = source.width();
+  int height = source.height();
+  // Reuse the scalars when the size matches.
+  int* dims = image->GetDimensions();
+  if (dims[0] != width || dims[1] != height || dims[2] != 1 ||
+      image->GetScalarType() != VTK_UNSIGNED_CHAR ||
+      image->GetNumberOfScalarComponents() != components ||
+      !image->GetPointData()->GetScalars())
+  {
+    image->SetDimensions(width, height, 1);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, components);
+  }
+  auto target = static_cast<unsigned char*>(image->GetScalarPointer());
+  const unsigned char* bits = source.constBits();
+  const auto sourceStride = source.bytesPerLine();
+  const size_t rowBytes = static_cast<size_t>(width) * components;
+
+  vtkSMPTools::For(0, height, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType row = begin; row < end; ++row)
+    {
+      std::memcpy(target + row * rowBytes,
+                  bits + (height - 1 - row) * sourceStride, rowBytes);
+    }
+  });
+  image->GetPointData()->GetScalars()->Modified();
+}
+
+QImage NaiveImageDataToQImage(vtkImageData* imageData)
+{
+  int width = imageData->GetDimensions()[0];
+  int height = imageData->GetDimensions()[1];
+  QImage image(width, height, QImage::Format_RGB32);
+  QRgb* rgbPtr = reinterpret_cast<QRgb*>(image.bits()) + width * (height - 1);
+  unsigned char* colorsPtr =
+      reinterpret_cast<unsigned char*>(imageData->GetScalarPointer());
+
+  for (int row = 0; row < height; row++)
+  {
+    for (int col = 0; col < width; col++)
+    {
+      *(rgbPtr++) = QColor(colorsPtr[0], colorsPtr[1], colorsPtr[2]).rgb();
+      colorsPtr += imageData->GetNumberOfScalarComponents();
+    }
+
+    rgbPtr -= width * 2;
+  }
+
+  return image;
+}
+
+bool SameColors(const QImage& a, const QImage& b)
+{
+  if (a.size() != b.size())
+  {
+    return false;
+  }
+  // Format_RGBA8888 is not premultiplied, so the conversion keeps the
+  // colors of pixels with alpha < 255.
+  QImage ca = a.convertToFormat(QImage::Format_RGBA8888);
+  QImage cb = b.convertToFormat(QImage::Format_RGBA8888);
+  for (int y = 0; y < ca.height(); ++y)
+  {
+    const unsigned char* pa = ca.constScanLine(y);
+    const unsigned char* pb = cb.constScanLine(y);
+    for (int x = 0; x < 4 * ca.width(); x += 4)
+    {
+      if (pa[x] != pb[x] || pa[x + 1] != pb[x + 1] || pa[x + 2] != pb[x + 2])
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void MakeTestImage(int width, int height, int numberOfComponents,
+                   vtkImageData* image)
+{
+  image->SetDimensions(width, height, 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, numberOfComponents);
+  auto pixels = static_cast<unsigned char*>(image->GetScalarPointer());
+  vtkSMPTools::For(0, height, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType y = begin; y < end; ++y)
+    {
+      unsigned char* p = pixels + y * width * numberOfComponents;
+      for (int x = 0; x < width; ++x, p += numberOfComponents)
+      {
+        unsigned char v[4] = {static_cast<unsigned char>(x),
+                              static_cast<unsigned char>(y),
+                              static_cast<unsigned char>(x ^ y),
+                              static_cast<unsigned char>(255 - x)};
+        std::memcpy(p, v, numberOfComponents);
+      }
+    }
+  });
+}
+} // namespace
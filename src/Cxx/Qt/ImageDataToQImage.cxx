@@ -39,13 +39,15 @@ QImage vtkImageDataToQImage(vtkSmartPointer<vtkImageData> imageData)
     return QImage();
   }
 
-  /// \todo retrieve just the UpdateExtent
+  // See the ImageDataQImageBridge example for a conversion that respects
+  // the update extent and avoids the per pixel QColor.
   int width = imageData->GetDimensions()[0];
   int height = imageData->GetDimensions()[1];
   QImage image(width, height, QImage::Format_RGB32);
   QRgb* rgbPtr = reinterpret_cast<QRgb*>(image.bits()) + width * (height - 1);
   unsigned char* colorsPtr =
       reinterpret_cast<unsigned char*>(imageData->GetScalarPointer());
+  int numberOfComponents = imageData->GetNumberOfScalarComponents();
 
   // Loop over the vtkImageData contents.
   for (int row = 0; row < height; row++)
@@ -54,7 +56,7 @@ QImage vtkImageDataToQImage(vtkSmartPointer<vtkImageData> imageData)
     {
       // Swap the vtkImageData RGB values with an equivalent QColor
       *(rgbPtr++) = QColor(colorsPtr[0], colorsPtr[1], colorsPtr[2]).rgb();
-      colorsPtr += imageData->GetNumberOfScalarComponents();
+      colorsPtr += numberOfComponents;
     }
 
     rgbPtr -= width * 2;
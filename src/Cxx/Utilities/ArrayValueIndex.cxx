@@ -0,0 +1,736 @@
+#include <vtkAOSDataArrayTemplate.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// The finalizer of SplitMix64, a cheap hash of 64 bit integers.
+std::uint64_t Hash64(std::uint64_t h)
+{
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+  return h ^ (h >> 31);
+}
+
+/**
+ * An index of the values of a vtkAOSDataArrayTemplate, for exact lookups
+ * like LookupValue(), lookups within a tolerance and range queries.
+ *
+ * The values are hashed by bucket: the range of the values is cut into
+ * buckets of equal width, about two values wide on average, and a bucket
+ * is found through a hash table. The tables are split in shards by hash,
+ * so that Build() fills them in parallel with vtkSMPTools.
+ *
+ * After values are modified or appended, Update() with their range adds
+ * them to a small, serial, hash of buckets, and the index ignores its
+ * entries for them. The index is only rebuilt when that hash holds more
+ * than a sixteenth of the values. As with DataChanged() for LookupValue(),
+ * every modification must be followed by an Update() before the next
+ * lookup.
+ *
+ * The ids found are sorted. A NaN is found by an exact lookup of NaN.
+ */
+template <typename T> class ValueIndex
+{
+public:
+  explicit ValueIndex(vtkAOSDataArrayTemplate<T>* array) : Array(array)
+  {
+  }
+
+  // Index all the values of the array.
+  void Build();
+
+  // Account for the values [begin, end) that were modified, and for all
+  // the values appended since the last Build() or Update().
+  void Update(vtkIdType begin, vtkIdType end);
+
+  // The ids of the values equal to value, and the first of them or -1.
+  void Find(T value, std::vector<vtkIdType>& ids) const;
+  vtkIdType FindFirst(T value) const;
+
+  // The ids of the values within tolerance of value.
+  void FindWithin(T value, double tolerance,
+                  std::vector<vtkIdType>& ids) const;
+
+  // The ids of the values in [low, high].
+  void FindInRange(T low, T high, std::vector<vtkIdType>& ids) const;
+
+  int GetNumberOfBuilds() const
+  {
+    return this->NumberOfBuilds;
+  }
+
+  vtkIdType GetNumberOfUpdatedValues() const
+  {
+    return static_cast<vtkIdType>(this->UpdatedKeys.size());
+  }
+
+private:
+  static constexpr long long NaNKey = INT64_MIN;
+
+  struct Bucket
+  {
+    long long Key;
+    vtkIdType Start; // The first of its ids in Ids.
+    vtkIdType Count; // 0 for an empty slot.
+  };
+
+  struct Entry
+  {
+    long long Key;
+    vtkIdType Id;
+  };
+
+  static bool IsNaN(T value)
+  {
+    return value != value;
+  }
+
+  static std::uint64_t Mix(long long key)
+  {
+    return Hash64(static_cast<std::uint64_t>(key));
+  }
+
+  long long Key(double value) const
+  {
+    const double q =
+      std::floor((value - this->Origin) * this->InverseWidth);
+    if (q != q)
+    {
+      return NaNKey;
+    }
+    // Keys far out of the range, infinities included, share a bucket.
+    return static_cast<long long>(std::min(std::max(q, -4.0e18), 4.0e18));
+  }
+
+  int Shard(std::uint64_t hash) const
+  {
+    return this->ShardBits == 0
+      ? 0
+      : static_cast<int>(hash >> (64 - this->ShardBits));
+  }
+
+  // A power of two, at least twice the number of buckets.
+  static vtkIdType TableSize(vtkIdType numberOfBuckets)
+  {
+    vtkIdType size = 2;
+    while (size < 2 * numberOfBuckets)
+    {
+      size *= 2;
+    }
+    return size;
+  }
+
+  // The bucket key of the built index, or nullptr.
+  const Bucket* FindBucket(long long key) const;
+
+  // The ids in the buckets [lowKey, highKey] whose value passes match.
+  template <typename Match>
+  void Collect(long long lowKey, long long highKey, Match match,
+               std::vector<vtkIdType>& ids) const;
+
+  void AddUpdated(vtkIdType begin, vtkIdType end);
+
+  vtkSmartPointer<vtkAOSDataArrayTemplate<T>> Array;
+  double Origin = 0.0;
+  double InverseWidth = 1.0;
+  int NumberOfBuilds = 0;
+
+  // The built index: the ids grouped by shard, then by bucket, and the
+  // hash table of the buckets of each shard.
+  vtkIdType NumberOfIndexedValues = 0;
+  vtkIdType NumberOfBuckets = 0;
+  int ShardBits = 0;
+  std::vector<vtkIdType> Ids;
+  std::vector<std::vector<Bucket>> Tables;
+
+  // The values updated since the build. Their entries in the built index
+  // are ignored; they are found in UpdatedBuckets instead, under the key
+  // of their value when it was last updated. Entries for the earlier
+  // values of an id are left in place, and skipped by the lookups.
+  std::vector<unsigned char> Updated;
+  std::unordered_map<long long, std::vector<vtkIdType>> UpdatedBuckets;
+  std::unordered_map<vtkIdType, long long> UpdatedKeys;
+  vtkIdType NumberOfUpdatedEntries = 0;
+};
+
+template <typename T> void ValueIndex<T>::Build()
+{
+  const vtkIdType n = this->Array->GetNumberOfValues();
+  const T* values = this->Array->GetPointer(0);
+  ++this->NumberOfBuilds;
+  this->NumberOfIndexedValues = n;
+  this->Updated.assign(n, 0);
+  this->UpdatedBuckets.clear();
+  this->UpdatedKeys.clear();
+  this->NumberOfUpdatedEntries = 0;
+
+  // The range of the values sets the width of the buckets.
+  vtkSMPThreadLocal<std::array<double, 2>> localRanges(
+    std::array<double, 2>{{VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX}});
+  vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+    auto& range = localRanges.Local();
+    for (vtkIdType i = begin; i < end; ++i)
+    {
+      if (!IsNaN(values[i]))
+      {
+        range[0] = std::min(range[0], static_cast<double>(values[i]));
+        range[1] = std::max(range[1], static_cast<double>(values[i]));
+      }
+    }
+  });
+  double low = VTK_DOUBLE_MAX;
+  double high = -VTK_DOUBLE_MAX;
+  for (const auto& range : localRanges)
+  {
+    low = std::min(low, range[0]);
+    high = std::max(high, range[1]);
+  }
+  this->Origin = low <= high ? low : 0.0;
+  double width = low < high && std::isfinite(high - low)
+    ? 2.0 * (high - low) / std::max<vtkIdType>(n, 1)
+    : 1.0;
+  if (std::numeric_limits<T>::is_integer)
+  {
+    width = std::max(1.0, std::floor(width));
+  }
+  this->InverseWidth = 1.0 / width;
+
+  // About 64k values per shard, for up to 4096 shards.
+  this->ShardBits = 0;
+  while (this->ShardBits < 12 && (n >> (16 + this->ShardBits)) > 0)
+  {
+    ++this->ShardBits;
+  }
+  const int numberOfShards = 1 << this->ShardBits;
+
+  // Scatter the entries to their shards: count them per chunk of values,
+  // then write them in the order of the chunks.
+  const vtkIdType numberOfChunks =
+    std::max<vtkIdType>(1, std::min<vtkIdType>(1024, n / 65536));
+  const vtkIdType chunkSize = (n + numberOfChunks - 1) / numberOfChunks;
+  std::vector<vtkIdType> offsets(numberOfChunks * numberOfShards, 0);
+  vtkSMPTools::For(0, numberOfChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType c = begin; c < end; ++c)
+    {
+      vtkIdType* counts = offsets.data() + c * numberOfShards;
+      const vtkIdType last = std::min(n, (c + 1) * chunkSize);
+      for (vtkIdType i = c * chunkSize; i < last; ++i)
+      {
+        ++counts[this->Shard(Mix(this->Key(values[i])))];
+      }
+    }
+  });
+  std::vector<vtkIdType> shardStart(numberOfShards + 1, 0);
+  for (int s = 0; s < numberOfShards; ++s)
+  {
+    vtkIdType offset = shardStart[s];
+    for (vtkIdType c = 0; c < numberOfChunks; ++c)
+    {
+      const vtkIdType count = offsets[c * numberOfShards + s];
+      offsets[c * numberOfShards + s] = offset;
+      offset += count;
+    }
+    shardStart[s + 1] = offset;
+  }
+  std::vector<Entry> entries(n);
+  vtkSMPTools::For(0, numberOfChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType c = begin; c < end; ++c)
+    {
+      vtkIdType* next = offsets.data() + c * numberOfShards;
+      const vtkIdType last = std::min(n, (c + 1) * chunkSize);
+      for (vtkIdType i = c * chunkSize; i < last; ++i)
+      {
+        const long long key = this->Key(values[i]);
+        entries[next[this->Shard(Mix(key))]++] = {key, i};
+      }
+    }
+  });
+
+  // Group the ids of each shard by bucket with a temporary table of its
+  // buckets, in the order in which they first appear, then fill the table
+  // of the shard, sized for its buckets. The ids stay in order within a
+  // bucket.
+  struct ShardScratch
+  {
+    std::vector<vtkIdType> Table;
+    std::vector<long long> Keys;
+    std::vector<vtkIdType> Counts;
+    std::vector<vtkIdType> EntryBuckets;
+  };
+  vtkSMPThreadLocal<ShardScratch> scratches;
+  std::vector<vtkIdType> shardBuckets(numberOfShards, 0);
+  this->Ids.resize(n);
+  this->Tables.assign(numberOfShards, std::vector<Bucket>());
+  vtkSMPTools::For(0, numberOfShards, 1, [&](vtkIdType begin, vtkIdType end) {
+    auto& scratch = scratches.Local();
+    auto& keys = scratch.Keys;
+    auto& counts = scratch.Counts;
+    for (vtkIdType s = begin; s < end; ++s)
+    {
+      const vtkIdType first = shardStart[s];
+      const vtkIdType count = shardStart[s + 1] - first;
+      auto& temporary = scratch.Table;
+      temporary.assign(TableSize(count), -1);
+      auto mask = static_cast<std::uint64_t>(temporary.size() - 1);
+      keys.clear();
+      counts.clear();
+      scratch.EntryBuckets.resize(count);
+      for (vtkIdType j = 0; j < count; ++j)
+      {
+        const long long key = entries[first + j].Key;
+        auto h = Mix(key) & mask;
+        while (temporary[h] >= 0 && keys[temporary[h]] != key)
+        {
+          h = (h + 1) & mask;
+        }
+        if (temporary[h] < 0)
+        {
+          temporary[h] = static_cast<vtkIdType>(keys.size());
+          keys.push_back(key);
+          counts.push_back(0);
+        }
+        ++counts[temporary[h]];
+        scratch.EntryBuckets[j] = temporary[h];
+      }
+
+      auto& table = this->Tables[s];
+      table.assign(TableSize(static_cast<vtkIdType>(keys.size())),
+                   Bucket{0, 0, 0});
+      mask = static_cast<std::uint64_t>(table.size() - 1);
+      vtkIdType start = first;
+      for (size_t b = 0; b < keys.size(); ++b)
+      {
+        auto h = Mix(keys[b]) & mask;
+        while (table[h].Count > 0)
+        {
+          h = (h + 1) & mask;
+        }
+        table[h] = {keys[b], start, counts[b]};
+        // From here on, where the next id of the bucket goes.
+        const vtkIdType bucketCount = counts[b];
+        counts[b] = start;
+        start += bucketCount;
+      }
+      for (vtkIdType j = 0; j < count; ++j)
+      {
+        this->Ids[counts[scratch.EntryBuckets[j]]++] = entries[first + j].Id;
+      }
+      shardBuckets[s] = static_cast<vtkIdType>(keys.size());
+    }
+  });
+  this->NumberOfBuckets =
+    std::accumulate(shardBuckets.begin(), shardBuckets.end(), vtkIdType(0));
+}
+
+template <typename T>
+void ValueIndex<T>::Update(vtkIdType begin, vtkIdType end)
+{
+  const vtkIdType n = this->Array->GetNumberOfValues();
+  const auto previous = static_cast<vtkIdType>(this->Updated.size());
+  if (this->NumberOfBuilds == 0 || n < previous)
+  {
+    this->Build();
+    return;
+  }
+  // Appended values are not in the built index.
+  this->Updated.resize(n, 1);
+  this->AddUpdated(std::max<vtkIdType>(begin, 0), std::min(end, n));
+  this->AddUpdated(previous, n);
+  if (this->NumberOfUpdatedEntries >
+      std::max<vtkIdType>(65536, this->NumberOfIndexedValues / 16))
+  {
+    this->Build();
+  }
+}
+
+template <typename T>
+void ValueIndex<T>::AddUpdated(vtkIdType begin, vtkIdType end)
+{
+  const T* values = this->Array->GetPointer(0);
+  for (vtkIdType i = begin; i < end; ++i)
+  {
+    const long long key = this->Key(values[i]);
+    auto found = this->UpdatedKeys.find(i);
+    if (found != this->UpdatedKeys.end() && found->second == key)
+    {
+      continue;
+    }
+    this->UpdatedKeys[i] = key;
+    this->UpdatedBuckets[key].push_back(i);
+    this->Updated[i] = 1;
+    ++this->NumberOfUpdatedEntries;
+  }
+}
+
+template <typename T>
+const typename ValueIndex<T>::Bucket* ValueIndex<T>::FindBucket(
+  long long key) const
+{
+  if (this->Tables.empty())
+  {
+    return nullptr;
+  }
+  const auto h = Mix(key);
+  const auto& table = this->Tables[this->Shard(h)];
+  const auto mask = static_cast<std::uint64_t>(table.size() - 1);
+  for (auto j = h & mask;; j = (j + 1) & mask)
+  {
+    if (table[j].Count == 0)
+    {
+      return nullptr;
+    }
+    if (table[j].Key == key)
+    {
+      return &table[j];
+    }
+  }
+}
+
+template <typename T>
+template <typename Match>
+void ValueIndex<T>::Collect(long long lowKey, long long highKey, Match match,
+                            std::vector<vtkIdType>& ids) const
+{
+  ids.clear();
+  const T* values = this->Array->GetPointer(0);
+  const vtkIdType n = this->Array->GetNumberOfValues();
+  const double span = static_cast<double>(highKey) - lowKey + 1.0;
+  if (span > static_cast<double>(this->NumberOfBuckets +
+                                 this->UpdatedBuckets.size()))
+  {
+    // More buckets than the index holds: scanning the values is cheaper.
+    // The matches are counted per chunk, then written in order.
+    const vtkIdType numberOfChunks =
+      std::max<vtkIdType>(1, std::min<vtkIdType>(1024, n / 65536));
+    const vtkIdType chunkSize = (n + numberOfChunks - 1) / numberOfChunks;
+    std::vector<vtkIdType> offsets(numberOfChunks + 1, 0);
+    vtkSMPTools::For(0, numberOfChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType c = begin; c < end; ++c)
+      {
+        const vtkIdType last = std::min(n, (c + 1) * chunkSize);
+        for (vtkIdType i = c * chunkSize; i < last; ++i)
+        {
+          offsets[c + 1] += match(values[i]);
+        }
+      }
+    });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    ids.resize(offsets.back());
+    vtkSMPTools::For(0, numberOfChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType c = begin; c < end; ++c)
+      {
+        vtkIdType* next = ids.data() + offsets[c];
+        const vtkIdType last = std::min(n, (c + 1) * chunkSize);
+        for (vtkIdType i = c * chunkSize; i < last; ++i)
+        {
+          if (match(values[i]))
+          {
+            *next++ = i;
+          }
+        }
+      }
+    });
+    return;
+  }
+
+  for (long long key = lowKey; key <= highKey; ++key)
+  {
+    if (const Bucket* bucket = this->FindBucket(key))
+    {
+      for (vtkIdType j = bucket->Start; j < bucket->Start + bucket->Count;
+           ++j)
+      {
+        const vtkIdType id = this->Ids[j];
+        if (!this->Updated[id] && match(values[id]))
+        {
+          ids.push_back(id);
+        }
+      }
+    }
+    auto updated = this->UpdatedBuckets.find(key);
+    if (updated != this->UpdatedBuckets.end())
+    {
+      for (vtkIdType id : updated->second)
+      {
+        // Skip the entries of earlier values.
+        if (this->Key(values[id]) == key && match(values[id]))
+        {
+          ids.push_back(id);
+        }
+      }
+    }
+  }
+  // An id whose value went back to an earlier bucket is there twice.
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+template <typename T>
+void ValueIndex<T>::Find(T value, std::vector<vtkIdType>& ids) const
+{
+  const long long key = this->Key(value);
+  if (IsNaN(value))
+  {
+    this->Collect(key, key, [](T x) { return IsNaN(x); }, ids);
+  }
+  else
+  {
+    this->Collect(key, key, [value](T x) { return x == value; }, ids);
+  }
+}
+
+template <typename T> vtkIdType ValueIndex<T>::FindFirst(T value) const
+{
+  std::vector<vtkIdType> ids;
+  this->Find(value, ids);
+  return ids.empty() ? -1 : ids[0];
+}
+
+template <typename T>
+void ValueIndex<T>::FindWithin(T value, double tolerance,
+                               std::vector<vtkIdType>& ids) const
+{
+  const double x = static_cast<double>(value);
+  if (IsNaN(value) || !(tolerance >= 0.0))
+  {
+    ids.clear();
+    return;
+  }
+  this->Collect(this->Key(x - tolerance), this->Key(x + tolerance),
+                [x, tolerance](T y) {
+                  return std::abs(static_cast<double>(y) - x) <= tolerance;
+                },
+                ids);
+}
+
+template <typename T>
+void ValueIndex<T>::FindInRange(T low, T high,
+                                std::vector<vtkIdType>& ids) const
+{
+  if (IsNaN(low) || IsNaN(high) || high < low)
+  {
+    ids.clear();
+    return;
+  }
+  this->Collect(this->Key(low), this->Key(high),
+                [low, high](T x) { return low <= x && x <= high; }, ids);
+}
+
+// An order independent checksum of a set of ids.
+std::uint64_t Checksum(const vtkIdType* ids, vtkIdType n)
+{
+  std::uint64_t sum = static_cast<std::uint64_t>(n);
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    sum += Hash64(static_cast<std::uint64_t>(ids[i]) + 1);
+  }
+  return sum;
+}
+
+// The values of the benchmark, and a sequence of modified and appended
+// ranges with lookups in between, the same for both methods.
+struct Workload
+{
+  vtkIdType NumberOfValues;
+  int Rounds;
+  vtkIdType UpdateSize;
+  int LookupsPerRound;
+
+  // Integers, so that each value appears about eight times.
+  std::uint64_t GetNumberOfDistinctValues() const
+  {
+    return static_cast<std::uint64_t>(this->NumberOfValues / 8);
+  }
+
+  float Value(std::uint64_t random) const
+  {
+    return static_cast<float>(random % this->GetNumberOfDistinctValues());
+  }
+
+  void Fill(vtkFloatArray* array) const
+  {
+    array->SetNumberOfValues(this->NumberOfValues);
+    float* values = array->GetPointer(0);
+    vtkSMPTools::For(0, this->NumberOfValues, [&](vtkIdType b, vtkIdType e) {
+      for (vtkIdType i = b; i < e; ++i)
+      {
+        values[i] = this->Value(Hash64(static_cast<std::uint64_t>(i)));
+      }
+    });
+  }
+
+  // Modify a range and append as many values, then call update(begin,
+  // end) and lookup(value) for each lookup value. Returns a checksum of
+  // the lookups.
+  template <typename UpdateFunction, typename LookupFunction>
+  std::uint64_t Run(vtkFloatArray* array, UpdateFunction update,
+                    LookupFunction lookup) const
+  {
+    std::mt19937_64 generator(5489u);
+    std::uint64_t checksum = 0;
+    for (int round = 0; round < this->Rounds; ++round)
+    {
+      const vtkIdType n = array->GetNumberOfValues();
+      const vtkIdType begin =
+        static_cast<vtkIdType>(generator() % (n - this->UpdateSize));
+      for (vtkIdType i = begin; i < begin + this->UpdateSize; ++i)
+      {
+        array->SetValue(i, this->Value(generator()));
+      }
+      for (vtkIdType i = 0; i < this->UpdateSize; ++i)
+      {
+        array->InsertNextValue(this->Value(generator()));
+      }
+      update(begin, begin + this->UpdateSize);
+      const float* values = array->GetPointer(0);
+      for (int j = 0; j < this->LookupsPerRound; ++j)
+      {
+        // Mostly values of the array, some that it does not hold.
+        const auto r = generator();
+        const float value = r % 10 == 0
+          ? -1.0f - static_cast<float>(r % 1000)
+          : values[(r >> 8) % array->GetNumberOfValues()];
+        checksum = checksum * 31 + lookup(value);
+      }
+    }
+    return checksum;
+  }
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: ArrayValueIndex [numberOfValues] [rounds] [lookupsPerRound]
+  Workload workload;
+  workload.NumberOfValues =
+    argc > 1 ? std::max(100000LL, std::atoll(argv[1])) : 2000000;
+  workload.Rounds = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+  workload.LookupsPerRound = argc > 3 ? std::max(1, std::atoi(argv[3])) : 1000;
+  workload.UpdateSize = 10000;
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << workload.NumberOfValues << " values, " << workload.Rounds
+            << " rounds of " << workload.UpdateSize << " modified and "
+            << workload.UpdateSize << " appended values, then "
+            << workload.LookupsPerRound << " lookups" << std::endl;
+  const double lookups =
+    static_cast<double>(workload.Rounds) * workload.LookupsPerRound;
+  vtkNew<vtkTimerLog> timer;
+  std::cout << std::fixed << std::setprecision(3);
+
+  // The current way: DataChanged() after each update, and the lookup is
+  // rebuilt by the next LookupValue().
+  vtkNew<vtkFloatArray> current;
+  workload.Fill(current);
+  vtkNew<vtkIdList> idList;
+  timer->StartTimer();
+  const auto currentChecksum = workload.Run(
+    current, [&](vtkIdType, vtkIdType) { current->DataChanged(); },
+    [&](float value) {
+      current->LookupTypedValue(value, idList);
+      return Checksum(idList->GetPointer(0), idList->GetNumberOfIds());
+    });
+  timer->StopTimer();
+  const double currentTime = timer->GetElapsedTime();
+  std::cout << "LookupValue:      " << std::setw(10) << currentTime << " s, "
+            << std::setw(10) << 1.0e6 * currentTime / lookups
+            << " us per lookup" << std::endl;
+
+  vtkNew<vtkFloatArray> indexed;
+  workload.Fill(indexed);
+  ValueIndex<float> index(indexed);
+  std::vector<vtkIdType> ids;
+  timer->StartTimer();
+  index.Build();
+  const auto indexChecksum = workload.Run(
+    indexed, [&](vtkIdType begin, vtkIdType end) { index.Update(begin, end); },
+    [&](float value) {
+      index.Find(value, ids);
+      return Checksum(ids.data(), static_cast<vtkIdType>(ids.size()));
+    });
+  timer->StopTimer();
+  const double indexTime = timer->GetElapsedTime();
+  std::cout << "ValueIndex:       " << std::setw(10) << indexTime << " s, "
+            << std::setw(10) << 1.0e6 * indexTime / lookups
+            << " us per lookup, " << index.GetNumberOfBuilds() << " builds, "
+            << index.GetNumberOfUpdatedValues() << " values updated"
+            << std::endl;
+  std::cout << "Speedup:          " << std::setw(10)
+            << currentTime / indexTime << std::endl;
+  bool ok = currentChecksum == indexChecksum;
+
+  // Range and tolerance queries against a scan of the values.
+  const vtkIdType n = indexed->GetNumberOfValues();
+  const float* values = indexed->GetPointer(0);
+  const double top =
+    static_cast<double>(workload.GetNumberOfDistinctValues());
+  struct Query
+  {
+    const char* Name;
+    double Low;
+    double High;
+    bool Within; // Within (High - Low) / 2 of the middle.
+  };
+  const double middle = std::floor(0.5 * top);
+  for (const Query& query :
+       {Query{"Range, narrow:   ", middle, middle + 10.0, false},
+        Query{"Range, wide:     ", 0.25 * top, 0.75 * top, false},
+        Query{"Within 0.01:     ", middle + 0.99, middle + 1.01, true}})
+  {
+    timer->StartTimer();
+    if (query.Within)
+    {
+      index.FindWithin(static_cast<float>(0.5 * (query.Low + query.High)),
+                       0.5 * (query.High - query.Low), ids);
+    }
+    else
+    {
+      index.FindInRange(static_cast<float>(query.Low),
+                        static_cast<float>(query.High), ids);
+    }
+    timer->StopTimer();
+    const double indexQueryTime = timer->GetElapsedTime();
+    std::vector<vtkIdType> expected;
+    timer->StartTimer();
+    for (vtkIdType i = 0; i < n; ++i)
+    {
+      const double x = values[i];
+      if (query.Low <= x && x <= query.High)
+      {
+        expected.push_back(i);
+      }
+    }
+    timer->StopTimer();
+    std::cout << query.Name << std::setw(10) << 1.0e3 * indexQueryTime
+              << " ms, scan " << std::setw(10)
+              << 1.0e3 * timer->GetElapsedTime() << " ms, " << ids.size()
+              << " values" << std::endl;
+    ok = ok && ids == expected;
+  }
+
+  std::cout << (ok ? "The lookups agree." : "The lookups differ.")
+            << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,322 @@
+#include <vtkAOSDataArrayTemplate.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <vtkSMPTools.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+/**
+ * Accumulates values in fixed size blocks instead of one buffer that is
+ * reallocated, and copied, each time it grows.
+ *
+ * Finalize() copies the blocks into a vtkAOSDataArrayTemplate once, in
+ * parallel. When everything fits in the first block, the block is handed to
+ * the array instead, without a copy.
+ *
+ * Reset() keeps the blocks so that a builder can be reused without going
+ * back to the allocator.
+ */
+template <typename T> class ChunkedArrayBuilder
+{
+public:
+  // blockSize is the number of values per block, it is rounded down to a
+  // multiple of the number of components.
+  explicit ChunkedArrayBuilder(int numberOfComponents = 1,
+                               vtkIdType blockSize = 1 << 20)
+    : NumberOfComponents(numberOfComponents),
+      BlockSize(std::max<vtkIdType>(blockSize / numberOfComponents, 1) *
+                numberOfComponents)
+  {
+  }
+
+  void Append(T value)
+  {
+    if (this->Current == this->CurrentEnd)
+    {
+      this->NextBlock();
+    }
+    *this->Current++ = value;
+  }
+
+  void AppendTuple(const T* tuple)
+  {
+    // Blocks hold whole tuples so a tuple never straddles two blocks.
+    if (this->Current == this->CurrentEnd)
+    {
+      this->NextBlock();
+    }
+    this->Current = std::copy(tuple, tuple + this->NumberOfComponents,
+                              this->Current);
+  }
+
+  vtkIdType GetNumberOfValues() const
+  {
+    if (this->Used == 0)
+    {
+      return 0;
+    }
+    return (this->Used - 1) * this->BlockSize +
+        (this->Current - this->Blocks[this->Used - 1].get());
+  }
+
+  vtkIdType GetNumberOfTuples() const
+  {
+    return this->GetNumberOfValues() / this->NumberOfComponents;
+  }
+
+  void Reset()
+  {
+    this->Used = 0;
+    this->Current = this->CurrentEnd = nullptr;
+  }
+
+  // Move the values into array, the builder is reset.
+  void Finalize(vtkAOSDataArrayTemplate<T>* array);
+
+  // Concatenate several builders (e.g. one per thread) into array.
+  static void Finalize(const std::vector<ChunkedArrayBuilder<T>*>& builders,
+                       vtkAOSDataArrayTemplate<T>* array);
+
+private:
+  void NextBlock()
+  {
+    if (this->Used == this->Blocks.size())
+    {
+      this->Blocks.emplace_back(new T[this->BlockSize]);
+    }
+    this->Current = this->Blocks[this->Used++].get();
+    this->CurrentEnd = this->Current + this->BlockSize;
+  }
+
+  // Number of values in block i.
+  vtkIdType GetBlockFill(size_t i) const
+  {
+    return i + 1 < this->Used
+        ? this->BlockSize
+        : this->Current - this->Blocks[this->Used - 1].get();
+  }
+
+  int NumberOfComponents;
+  vtkIdType BlockSize;
+  std::vector<std::unique_ptr<T[]>> Blocks;
+  size_t Used = 0;
+  T* Current = nullptr;
+  T* CurrentEnd = nullptr;
+};
+
+template <typename T>
+void ChunkedArrayBuilder<T>::Finalize(vtkAOSDataArrayTemplate<T>* array)
+{
+  array->SetNumberOfComponents(this->NumberOfComponents);
+  if (this->Used == 1)
+  {
+    // Zero copy: the array takes ownership of the only block. The block is
+    // larger than needed, the array simply does not use the tail.
+    const auto n = this->GetNumberOfValues();
+    array->SetArray(this->Blocks[0].release(), n, 0,
+                    vtkAbstractArray::VTK_DATA_ARRAY_DELETE);
+    this->Blocks.erase(this->Blocks.begin());
+    this->Reset();
+    return;
+  }
+  Finalize({this}, array);
+  this->Reset();
+}
+
+template <typename T>
+void ChunkedArrayBuilder<T>::Finalize(
+    const std::vector<ChunkedArrayBuilder<T>*>& builders,
+    vtkAOSDataArrayTemplate<T>* array)
+{
+  // Where each block goes in the output.
+  struct Copy
+  {
+    const T* Source;
+    vtkIdType Count;
+    vtkIdType Destination;
+  };
+  std::vector<Copy> copies;
+  vtkIdType total = 0;
+  for (auto builder : builders)
+  {
+    for (size_t i = 0; i < builder->Used; ++i)
+    {
+      const auto fill = builder->GetBlockFill(i);
+      copies.push_back({builder->Blocks[i].get(), fill, total});
+      total += fill;
+    }
+  }
+  const int numberOfComponents =
+      builders.empty() ? 1 : builders[0]->NumberOfComponents;
+  array->SetNumberOfComponents(numberOfComponents);
+  array->SetNumberOfTuples(total / numberOfComponents);
+  T* destination = array->GetPointer(0);
+
+  vtkSMPTools::For(0, static_cast<vtkIdType>(copies.size()), 1,
+                   [&](vtkIdType begin, vtkIdType end) {
+                     for (auto i = begin; i < end; ++i)
+                     {
+                       const auto& c = copies[i];
+                       std::copy(c.Source, c.Source + c.Count,
+                                 destination + c.Destination);
+                     }
+                   });
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: ChunkedArrayBuilder [numberOfValues]
+  vtkIdType numberOfValues = 10000000;
+  if (argc > 1)
+  {
+    numberOfValues = std::atoll(argv[1]);
+  }
+  const vtkIdType numberOfTuples = numberOfValues / 3;
+
+  vtkNew<vtkTimerLog> timer;
+  std::cout << std::fixed << std::setprecision(4);
+  auto report = [&](const char* label, vtkIdType n) {
+    auto seconds = timer->GetElapsedTime();
+    std::cout << label << seconds << " s, "
+              << static_cast<double>(n) / seconds / 1.0e6 << " M/s"
+              << std::endl;
+  };
+  bool ok = true;
+  auto check = [&](const char* label, vtkFloatArray* array, int components) {
+    // Every value is its own index, so the contents are easy to verify.
+    const vtkIdType n = array->GetNumberOfValues();
+    const float* p = array->GetPointer(0);
+    bool same = n == numberOfTuples * components;
+    for (vtkIdType i = 0; same && i < n; ++i)
+    {
+      same = p[i] == static_cast<float>(i);
+    }
+    if (!same)
+    {
+      std::cout << label << ": wrong contents." << std::endl;
+      ok = false;
+    }
+  };
+
+  std::cout << "Appending " << numberOfTuples * 3 << " values" << std::endl;
+
+  // The current way.
+  {
+    vtkNew<vtkFloatArray> array;
+    timer->StartTimer();
+    for (vtkIdType i = 0; i < numberOfTuples * 3; ++i)
+    {
+      array->InsertNextValue(static_cast<float>(i));
+    }
+    timer->StopTimer();
+    report("InsertNextValue:                ", numberOfTuples * 3);
+    check("InsertNextValue", array, 1);
+  }
+  {
+    vtkNew<vtkFloatArray> array;
+    array->SetNumberOfComponents(3);
+    timer->StartTimer();
+    for (vtkIdType i = 0; i < numberOfTuples; ++i)
+    {
+      float tuple[3] = {static_cast<float>(3 * i),
+                        static_cast<float>(3 * i + 1),
+                        static_cast<float>(3 * i + 2)};
+      array->InsertNextTypedTuple(tuple);
+    }
+    timer->StopTimer();
+    report("InsertNextTypedTuple:           ", numberOfTuples * 3);
+    check("InsertNextTypedTuple", array, 3);
+  }
+
+  // The builder, one value at a time and one tuple at a time.
+  {
+    ChunkedArrayBuilder<float> builder;
+    vtkNew<vtkFloatArray> array;
+    timer->StartTimer();
+    for (vtkIdType i = 0; i < numberOfTuples * 3; ++i)
+    {
+      builder.Append(static_cast<float>(i));
+    }
+    builder.Finalize(array);
+    timer->StopTimer();
+    report("Builder Append + Finalize:      ", numberOfTuples * 3);
+    check("Builder Append", array, 1);
+  }
+  {
+    ChunkedArrayBuilder<float> builder(3);
+    vtkNew<vtkFloatArray> array;
+    timer->StartTimer();
+    for (vtkIdType i = 0; i < numberOfTuples; ++i)
+    {
+      float tuple[3] = {static_cast<float>(3 * i),
+                        static_cast<float>(3 * i + 1),
+                        static_cast<float>(3 * i + 2)};
+      builder.AppendTuple(tuple);
+    }
+    builder.Finalize(array);
+    timer->StopTimer();
+    report("Builder AppendTuple + Finalize: ", numberOfTuples * 3);
+    check("Builder AppendTuple", array, 3);
+  }
+
+  // One builder per thread. Each thread appends a contiguous range, the
+  // builders are then concatenated in range order.
+  {
+    const vtkIdType numberOfRanges =
+        std::max(1, vtkSMPTools::GetEstimatedNumberOfThreads()) * 4;
+    const vtkIdType rangeSize =
+        (numberOfTuples * 3 + numberOfRanges - 1) / numberOfRanges;
+    std::vector<ChunkedArrayBuilder<float>> builders(numberOfRanges);
+    vtkNew<vtkFloatArray> array;
+    timer->StartTimer();
+    vtkSMPTools::For(0, numberOfRanges, 1, [&](vtkIdType begin, vtkIdType end) {
+      for (auto r = begin; r < end; ++r)
+      {
+        const auto last = std::min((r + 1) * rangeSize, numberOfTuples * 3);
+        for (auto i = r * rangeSize; i < last; ++i)
+        {
+          builders[r].Append(static_cast<float>(i));
+        }
+      }
+    });
+    std::vector<ChunkedArrayBuilder<float>*> pointers;
+    for (auto& builder : builders)
+    {
+      pointers.push_back(&builder);
+    }
+    ChunkedArrayBuilder<float>::Finalize(pointers, array);
+    timer->StopTimer();
+    report("Parallel builders + Finalize:   ", numberOfTuples * 3);
+    check("Parallel builders", array, 1);
+  }
+
+  // Few enough values for one block: the array adopts the block.
+  {
+    ChunkedArrayBuilder<float> builder(1, numberOfTuples * 3);
+    for (vtkIdType i = 0; i < numberOfTuples * 3; ++i)
+    {
+      builder.Append(static_cast<float>(i));
+    }
+    vtkNew<vtkFloatArray> array;
+    timer->StartTimer();
+    builder.Finalize(array);
+    timer->StopTimer();
+    std::cout << "Single block adopted in:        " << timer->GetElapsedTime()
+              << " s" << std::endl;
+    check("Single block", array, 1);
+  }
+
+  std::cout << (ok ? "All arrays are identical." : "Some arrays differ.")
+            << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,547 @@
+#include <vtkArrayCoordinates.h>
+#include <vtkArrayExtents.h>
+#include <vtkArraySort.h>
+#include <vtkNew.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSparseArray.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * A 2-D sparse matrix in compressed row (CSR) or compressed column (CSC)
+ * storage.
+ *
+ * For CSR, Offsets has Rows + 1 entries and the entries of row r are
+ * [Offsets[r], Offsets[r + 1]) in Indices (the column numbers) and Values.
+ * CSC is the same with the roles of rows and columns exchanged.
+ */
+template <typename T> class CompressedSparseMatrix
+{
+public:
+  enum class Layout
+  {
+    CSR,
+    CSC
+  };
+
+  /**
+   * Build from triplets sorted by the major coordinate (row for CSR, column
+   * for CSC). The minor coordinates need not be sorted.
+   * The offsets are found with a binary search per major index so that the
+   * whole construction runs in parallel without a counting pass.
+   */
+  void FromSortedTriplets(Layout layout, vtkIdType rows, vtkIdType cols,
+                          vtkIdType nnz, const vtkIdType* rowIds,
+                          const vtkIdType* colIds, const T* values);
+
+  // Build from the coordinate storage of a vtkSparseArray. The array is
+  // sorted in place if needed.
+  void FromSparseArray(vtkSparseArray<T>* array, Layout layout);
+
+  // Write back into coordinate storage; the output is sorted by the major
+  // coordinate.
+  void ToSparseArray(vtkSparseArray<T>* array) const;
+
+  // y = A x, in parallel.
+  void Multiply(const T* x, T* y) const;
+
+  vtkIdType GetNumberOfNonZeros() const
+  {
+    return static_cast<vtkIdType>(this->Values.size());
+  }
+
+  Layout Storage = Layout::CSR;
+  vtkIdType Rows = 0;
+  vtkIdType Cols = 0;
+  std::vector<vtkIdType> Offsets;
+  std::vector<vtkIdType> Indices;
+  std::vector<T> Values;
+};
+
+/**
+ * Block compressed row storage: dense BlockSize x BlockSize blocks, stored
+ * row major, indexed like CSR. It trades some explicit zeros for
+ * contiguous inner loops and fewer index loads.
+ */
+template <typename T> class BlockSparseMatrix
+{
+public:
+  // Returns false, leaving the matrix unchanged, if csr is not in CSR
+  // storage or blockSize is less than 1.
+  bool FromCSR(const CompressedSparseMatrix<T>& csr, int blockSize);
+
+  // y = A x, in parallel over block rows.
+  void Multiply(const T* x, T* y) const;
+
+  // Fraction of the stored values that are non-zero.
+  double GetFillRatio(vtkIdType nnz) const
+  {
+    return this->Values.empty()
+        ? 1.0
+        : static_cast<double>(nnz) / static_cast<double>(this->Values.size());
+  }
+
+  int BlockSize = 4;
+  vtkIdType Rows = 0;
+  vtkIdType Cols = 0;
+  std::vector<vtkIdType> Offsets;
+  std::vector<vtkIdType> BlockColumns;
+  std::vector<T> Values;
+};
+
+// The current per-element path.
+void MultiplySparseArray(vtkSparseArray<double>* array, const double* x,
+                         double* y);
+
+double MaxDifference(const std::vector<double>& a,
+                     const std::vector<double>& b);
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: CompressedSparseArray [rows] [nonZerosPerRow]
+  vtkIdType rows = 100000;
+  vtkIdType nnzPerRow = 16;
+  if (argc > 1)
+  {
+    rows = std::atoll(argv[1]);
+  }
+  if (argc > 2)
+  {
+    nnzPerRow = std::atoll(argv[2]);
+  }
+  const vtkIdType cols = rows;
+  nnzPerRow = std::min(nnzPerRow, cols);
+
+  vtkNew<vtkTimerLog> timer;
+  std::cout << std::fixed << std::setprecision(4);
+
+  // Generate a random, co-occurrence like matrix as sorted triplets. Most
+  // of the entries are close to the diagonal so that blocking pays off.
+  std::mt19937_64 generator(8775070);
+  std::normal_distribution<double> offset(0.0, 8.0);
+  std::uniform_real_distribution<double> value(0.0, 1.0);
+  std::vector<vtkIdType> rowIds;
+  std::vector<vtkIdType> colIds;
+  std::vector<double> values;
+  rowIds.reserve(rows * nnzPerRow);
+  colIds.reserve(rows * nnzPerRow);
+  values.reserve(rows * nnzPerRow);
+  std::vector<vtkIdType> rowCols;
+  for (vtkIdType r = 0; r < rows; ++r)
+  {
+    rowCols.clear();
+    for (vtkIdType k = 0; k < nnzPerRow; ++k)
+    {
+      auto c = r + static_cast<vtkIdType>(offset(generator));
+      rowCols.push_back(std::min(std::max<vtkIdType>(c, 0), cols - 1));
+    }
+    std::sort(rowCols.begin(), rowCols.end());
+    rowCols.erase(std::unique(rowCols.begin(), rowCols.end()), rowCols.end());
+    for (auto c : rowCols)
+    {
+      rowIds.push_back(r);
+      colIds.push_back(c);
+      values.push_back(value(generator));
+    }
+  }
+  const auto nnz = static_cast<vtkIdType>(values.size());
+  std::cout << "Matrix: " << rows << " x " << cols << ", " << nnz
+            << " non-zeros" << std::endl;
+
+  // The current way: one AddValue per entry.
+  vtkNew<vtkSparseArray<double>> sparse;
+  timer->StartTimer();
+  sparse->Resize(rows, cols);
+  sparse->ReserveStorage(nnz);
+  sparse->Clear();
+  for (vtkIdType n = 0; n < nnz; ++n)
+  {
+    sparse->AddValue(rowIds[n], colIds[n], values[n]);
+  }
+  timer->StopTimer();
+  std::cout << "vtkSparseArray::AddValue build:    " << timer->GetElapsedTime()
+            << " s" << std::endl;
+
+  // Bulk construction from the same triplets.
+  CompressedSparseMatrix<double> csr;
+  timer->StartTimer();
+  csr.FromSortedTriplets(CompressedSparseMatrix<double>::Layout::CSR, rows,
+                         cols, nnz, rowIds.data(), colIds.data(),
+                         values.data());
+  timer->StopTimer();
+  std::cout << "CSR build from sorted triplets:    " << timer->GetElapsedTime()
+            << " s" << std::endl;
+
+  // Conversions to and from the coordinate storage.
+  CompressedSparseMatrix<double> csc;
+  timer->StartTimer();
+  csc.FromSparseArray(sparse, CompressedSparseMatrix<double>::Layout::CSC);
+  timer->StopTimer();
+  std::cout << "CSC from vtkSparseArray (sorts):   " << timer->GetElapsedTime()
+            << " s" << std::endl;
+
+  vtkNew<vtkSparseArray<double>> roundTrip;
+  timer->StartTimer();
+  csr.ToSparseArray(roundTrip);
+  timer->StopTimer();
+  std::cout << "CSR to vtkSparseArray:             " << timer->GetElapsedTime()
+            << " s" << std::endl;
+
+  BlockSparseMatrix<double> bsr;
+  timer->StartTimer();
+  if (!bsr.FromCSR(csr, 4))
+  {
+    return EXIT_FAILURE;
+  }
+  timer->StopTimer();
+  std::cout << "Blocked (4x4) from CSR:            " << timer->GetElapsedTime()
+            << " s, fill ratio " << bsr.GetFillRatio(nnz) << std::endl;
+
+  // Sparse matrix-vector products.
+  std::vector<double> x(cols);
+  for (vtkIdType c = 0; c < cols; ++c)
+  {
+    x[c] = std::sin(0.01 * c);
+  }
+  std::vector<double> yReference(rows);
+  std::vector<double> y(rows);
+  const double bytes =
+      static_cast<double>(nnz) * (sizeof(double) + sizeof(vtkIdType));
+
+  auto report = [&](const char* label, double seconds) {
+    std::cout << label << seconds << " s, " << bytes / seconds / 1.0e9
+              << " GB/s of matrix data" << std::endl;
+  };
+
+  timer->StartTimer();
+  MultiplySparseArray(sparse, x.data(), yReference.data());
+  timer->StopTimer();
+  report("SpMV vtkSparseArray (per element): ", timer->GetElapsedTime());
+
+  bool ok = true;
+  auto check = [&](const char* label) {
+    auto difference = MaxDifference(yReference, y);
+    if (difference > 1.0e-9)
+    {
+      std::cout << label << " differs by " << difference << std::endl;
+      ok = false;
+    }
+  };
+
+  timer->StartTimer();
+  csr.Multiply(x.data(), y.data());
+  timer->StopTimer();
+  report("SpMV CSR:                          ", timer->GetElapsedTime());
+  check("CSR");
+
+  timer->StartTimer();
+  csc.Multiply(x.data(), y.data());
+  timer->StopTimer();
+  report("SpMV CSC:                          ", timer->GetElapsedTime());
+  check("CSC");
+
+  timer->StartTimer();
+  bsr.Multiply(x.data(), y.data());
+  timer->StopTimer();
+  report("SpMV blocked CSR:                  ", timer->GetElapsedTime());
+  check("Blocked CSR");
+
+  // The round trip must reproduce the original entries.
+  if (roundTrip->GetNonNullSize() != nnz)
+  {
+    std::cout << "Round trip changed the number of non-zeros." << std::endl;
+    ok = false;
+  }
+  else
+  {
+    MultiplySparseArray(roundTrip, x.data(), y.data());
+    check("Round trip");
+  }
+
+  std::cout << "vtkSMPTools backend: " << vtkSMPTools::GetBackend() << ", "
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads"
+            << std::endl;
+  std::cout << (ok ? "All products agree." : "Some products differ.")
+            << std::endl;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+
+template <typename T>
+void CompressedSparseMatrix<T>::FromSortedTriplets(
+    Layout layout, vtkIdType rows, vtkIdType cols, vtkIdType nnz,
+    const vtkIdType* rowIds, const vtkIdType* colIds, const T* values)
+{
+  this->Storage = layout;
+  this->Rows = rows;
+  this->Cols = cols;
+  const bool csr = layout == Layout::CSR;
+  const vtkIdType* major = csr ? rowIds : colIds;
+  const vtkIdType* minor = csr ? colIds : rowIds;
+  const vtkIdType majorSize = csr ? rows : cols;
+
+  this->Offsets.resize(majorSize + 1);
+  this->Indices.resize(nnz);
+  this->Values.resize(nnz);
+
+  vtkSMPTools::For(0, majorSize + 1, [&](vtkIdType begin, vtkIdType end) {
+    for (auto m = begin; m < end; ++m)
+    {
+      this->Offsets[m] = std::lower_bound(major, major + nnz, m) - major;
+    }
+  });
+  vtkSMPTools::For(0, nnz, [&](vtkIdType begin, vtkIdType end) {
+    std::copy(minor + begin, minor + end, this->Indices.begin() + begin);
+    std::copy(values + begin, values + end, this->Values.begin() + begin);
+  });
+}
+
+template <typename T>
+void CompressedSparseMatrix<T>::FromSparseArray(vtkSparseArray<T>* array,
+                                                Layout layout)
+{
+  const auto& extents = array->GetExtents();
+  const vtkIdType nnz = array->GetNonNullSize();
+  const vtkIdType majorDim = layout == Layout::CSR ? 0 : 1;
+  const vtkIdType minorDim = 1 - majorDim;
+
+  // vtkSparseArray keeps its coordinates in insertion order; sort only if
+  // they are not already ordered by the major coordinate.
+  const vtkIdType* major = array->GetCoordinateStorage(majorDim);
+  if (!std::is_sorted(major, major + nnz))
+  {
+    array->Sort(vtkArraySort(majorDim, minorDim));
+  }
+
+  this->FromSortedTriplets(layout, extents[0].GetSize(),
+                           extents[1].GetSize(), nnz,
+                           array->GetCoordinateStorage(0),
+                           array->GetCoordinateStorage(1),
+                           array->GetValueStorage());
+}
+
+template <typename T>
+void CompressedSparseMatrix<T>::ToSparseArray(vtkSparseArray<T>* array) const
+{
+  const vtkIdType nnz = this->GetNumberOfNonZeros();
+  const bool csr = this->Storage == Layout::CSR;
+  array->Resize(this->Rows, this->Cols);
+  array->ReserveStorage(nnz);
+
+  vtkIdType* major = array->GetCoordinateStorage(csr ? 0 : 1);
+  vtkIdType* minor = array->GetCoordinateStorage(csr ? 1 : 0);
+  T* values = array->GetValueStorage();
+  const vtkIdType majorSize = static_cast<vtkIdType>(this->Offsets.size()) - 1;
+
+  vtkSMPTools::For(0, majorSize, [&](vtkIdType begin, vtkIdType end) {
+    for (auto m = begin; m < end; ++m)
+    {
+      std::fill(major + this->Offsets[m], major + this->Offsets[m + 1], m);
+    }
+    const auto first = this->Offsets[begin];
+    const auto last = this->Offsets[end];
+    std::copy(this->Indices.begin() + first, this->Indices.begin() + last,
+              minor + first);
+    std::copy(this->Values.begin() + first, this->Values.begin() + last,
+              values + first);
+  });
+}
+
+template <typename T>
+void CompressedSparseMatrix<T>::Multiply(const T* x, T* y) const
+{
+  if (this->Storage == Layout::CSR)
+  {
+    // Each row is independent.
+    vtkSMPTools::For(0, this->Rows, [&](vtkIdType begin, vtkIdType end) {
+      for (auto r = begin; r < end; ++r)
+      {
+        T sum = 0;
+        for (auto k = this->Offsets[r]; k < this->Offsets[r + 1]; ++k)
+        {
+          sum += this->Values[k] * x[this->Indices[k]];
+        }
+        y[r] = sum;
+      }
+    });
+    return;
+  }
+
+  // CSC scatters into y; each thread accumulates into a private vector that
+  // is then summed, in parallel over the rows.
+  vtkSMPThreadLocal<std::vector<T>> partial;
+  vtkSMPTools::For(0, this->Cols, [&](vtkIdType begin, vtkIdType end) {
+    auto& local = partial.Local();
+    if (local.empty())
+    {
+      local.assign(this->Rows, 0);
+    }
+    for (auto c = begin; c < end; ++c)
+    {
+      const T xc = x[c];
+      for (auto k = this->Offsets[c]; k < this->Offsets[c + 1]; ++k)
+      {
+        local[this->Indices[k]] += this->Values[k] * xc;
+      }
+    }
+  });
+  std::vector<std::vector<T>*> locals;
+  for (auto& local : partial)
+  {
+    if (!local.empty())
+    {
+      locals.push_back(&local);
+    }
+  }
+  vtkSMPTools::For(0, this->Rows, [&](vtkIdType begin, vtkIdType end) {
+    for (auto r = begin; r < end; ++r)
+    {
+      T sum = 0;
+      for (auto local : locals)
+      {
+        sum += (*local)[r];
+      }
+      y[r] = sum;
+    }
+  });
+}
+
+template <typename T>
+bool BlockSparseMatrix<T>::FromCSR(const CompressedSparseMatrix<T>& csr,
+                                   int blockSize)
+{
+  using Layout = typename CompressedSparseMatrix<T>::Layout;
+  if (csr.Storage != Layout::CSR || blockSize < 1)
+  {
+    vtkGenericWarningMacro(<< "FromCSR needs a CSR matrix and a positive "
+                           << "block size.");
+    return false;
+  }
+  this->BlockSize = blockSize;
+  this->Rows = csr.Rows;
+  this->Cols = csr.Cols;
+  const vtkIdType b = blockSize;
+  const vtkIdType blockRows = (csr.Rows + b - 1) / b;
+
+  // First pass: the distinct block columns of each block row.
+  std::vector<std::vector<vtkIdType>> columns(blockRows);
+  vtkSMPTools::For(0, blockRows, [&](vtkIdType begin, vtkIdType end) {
+    for (auto br = begin; br < end; ++br)
+    {
+      auto& cols = columns[br];
+      const auto lastRow = std::min((br + 1) * b, csr.Rows);
+      for (auto k = csr.Offsets[br * b]; k < csr.Offsets[lastRow]; ++k)
+      {
+        cols.push_back(csr.Indices[k] / b);
+      }
+      std::sort(cols.begin(), cols.end());
+      cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    }
+  });
+
+  this->Offsets.assign(blockRows + 1, 0);
+  for (vtkIdType br = 0; br < blockRows; ++br)
+  {
+    this->Offsets[br + 1] =
+        this->Offsets[br] + static_cast<vtkIdType>(columns[br].size());
+  }
+  this->BlockColumns.resize(this->Offsets[blockRows]);
+  this->Values.assign(this->Offsets[blockRows] * b * b, 0);
+
+  // Second pass: scatter the values into their blocks.
+  vtkSMPTools::For(0, blockRows, [&](vtkIdType begin, vtkIdType end) {
+    for (auto br = begin; br < end; ++br)
+    {
+      const auto& cols = columns[br];
+      std::copy(cols.begin(), cols.end(),
+                this->BlockColumns.begin() + this->Offsets[br]);
+      const auto lastRow = std::min((br + 1) * b, csr.Rows);
+      for (auto r = br * b; r < lastRow; ++r)
+      {
+        for (auto k = csr.Offsets[r]; k < csr.Offsets[r + 1]; ++k)
+        {
+          const auto c = csr.Indices[k];
+          const auto block =
+              std::lower_bound(cols.begin(), cols.end(), c / b) - cols.begin();
+          const auto index = (this->Offsets[br] + block) * b * b +
+              (r - br * b) * b + (c - (c / b) * b);
+          this->Values[index] = csr.Values[k];
+        }
+      }
+    }
+  });
+  return true;
+}
+
+template <typename T>
+void BlockSparseMatrix<T>::Multiply(const T* x, T* y) const
+{
+  const vtkIdType b = this->BlockSize;
+  const vtkIdType blockRows = static_cast<vtkIdType>(this->Offsets.size()) - 1;
+  vtkSMPTools::For(0, blockRows, [&](vtkIdType begin, vtkIdType end) {
+    std::vector<T> sums(b);
+    for (auto br = begin; br < end; ++br)
+    {
+      std::fill(sums.begin(), sums.end(), T(0));
+      for (auto k = this->Offsets[br]; k < this->Offsets[br + 1]; ++k)
+      {
+        const T* block = this->Values.data() + k * b * b;
+        const auto c0 = this->BlockColumns[k] * b;
+        const auto width = std::min(b, this->Cols - c0);
+        for (vtkIdType i = 0; i < b; ++i)
+        {
+          T sum = 0;
+          for (vtkIdType j = 0; j < width; ++j)
+          {
+            sum += block[i * b + j] * x[c0 + j];
+          }
+          sums[i] += sum;
+        }
+      }
+      const auto height = std::min(b, this->Rows - br * b);
+      std::copy(sums.begin(), sums.begin() + height, y + br * b);
+    }
+  });
+}
+
+void MultiplySparseArray(vtkSparseArray<double>* array, const double* x,
+                         double* y)
+{
+  const auto rows = array->GetExtents()[0].GetSize();
+  std::fill(y, y + rows, 0.0);
+  vtkArrayCoordinates coordinates;
+  const auto nnz = array->GetNonNullSize();
+  for (vtkIdType n = 0; n < nnz; ++n)
+  {
+    array->GetCoordinatesN(n, coordinates);
+    y[coordinates[0]] += array->GetValueN(n) * x[coordinates[1]];
+  }
+}
+
+double MaxDifference(const std::vector<double>& a,
+                     const std::vector<double>& b)
+{
+  double result = 0.0;
+  for (size_t i = 0; i < a.size(); ++i)
+  {
+    result = std::max(result, std::abs(a[i] - b[i]));
+  }
+  return result;
+}
+
+} // namespace
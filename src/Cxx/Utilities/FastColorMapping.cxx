@@ -0,0 +1,467 @@
+#include <vtkDiscretizableColorTransferFunction.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIntArray.h>
+#include <vtkLookupTable.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkSMPTools.h>
+#include <vtkScalarsToColors.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+#include <vtkTimerLog.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+/**
+ * A dense RGBA8 image of a vtkScalarsToColors, used to map whole arrays
+ * without a virtual call per value.
+ *
+ * The table has NumberOfColors entries covering the range, followed by the
+ * below range, above range and NaN colors, all obtained from the original
+ * object so that its settings (UseBelowRangeColor, NanColor, ...) are
+ * honoured.
+ *
+ * For a vtkLookupTable, or a discretized transfer function, with as many
+ * entries as it has colors, the mapping is the same as MapScalars(). For a
+ * continuous transfer function the result is quantized to the table size.
+ */
+class ColorMappingKernel
+{
+public:
+  // Returns false for the cases the kernel does not handle (log scale,
+  // indexed lookup); use MapScalars() for those.
+  bool Build(vtkScalarsToColors* colors, int numberOfColors);
+
+  // Map the first component of array to RGBA, in parallel.
+  template <typename T>
+  void Map(const T* values, vtkIdType n, unsigned char* rgba) const;
+
+  void Map(vtkDataArray* array, vtkUnsignedCharArray* rgba) const;
+
+  // Build the table only if colors is another object, numberOfColors
+  // differs or colors was modified since the last build; otherwise this is
+  // one time stamp compare. A modification does not always change the
+  // colors, so after a rebuild the new table is compared with the previous
+  // one, hash first, and GetChanged() tells whether the colors differ.
+  bool Update(vtkScalarsToColors* colors, int numberOfColors);
+
+  bool GetChanged() const
+  {
+    return this->Changed;
+  }
+
+  // A 64-bit FNV-1a hash of the table and range; equal tables have equal
+  // hashes. It only speeds up the comparison after a rebuild.
+  std::uint64_t GetHash() const
+  {
+    return this->Hash;
+  }
+
+  bool operator==(const ColorMappingKernel& other) const
+  {
+    return this->Hash == other.Hash && this->Range[0] == other.Range[0] &&
+        this->Range[1] == other.Range[1] && this->Table == other.Table;
+  }
+
+private:
+  enum
+  {
+    // Values processed per block. The index computation for a block is a
+    // loop without branches that the compiler can vectorize, followed by
+    // the table gather.
+    BlockSize = 512
+  };
+
+  int NumberOfColors = 0;
+  double Range[2] = {0.0, 1.0};
+  double Scale = 1.0;
+  // Packed RGBA: [below, colors..., above, NaN]
+  std::vector<std::uint32_t> Table;
+  std::uint64_t Hash = 0;
+
+  // What the table was built from, and when.
+  vtkScalarsToColors* Colors = nullptr;
+  vtkTimeStamp BuildTime;
+  bool Changed = false;
+};
+
+// The way LUTUtilities compares two tables, entry by entry.
+bool CompareEntryByEntry(vtkLookupTable* lut1, vtkLookupTable* lut2);
+
+// Fraction of values whose colors differ and the largest channel difference.
+void CompareColors(vtkUnsignedCharArray* a, vtkUnsignedCharArray* b,
+                   double& mismatch, int& maxDifference);
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: FastColorMapping [numberOfValues]
+  vtkIdType numberOfValues = 10000000;
+  if (argc > 1)
+  {
+    numberOfValues = std::atoll(argv[1]);
+  }
+
+  vtkNew<vtkTimerLog> timer;
+  std::cout << std::fixed << std::setprecision(4);
+
+  // Scalars a little outside [0, 1] with a few NaNs.
+  std::mt19937 generator(8775070);
+  std::uniform_real_distribution<double> distribution(-0.1, 1.1);
+  vtkNew<vtkFloatArray> floats;
+  vtkNew<vtkDoubleArray> doubles;
+  vtkNew<vtkIntArray> ints;
+  floats->SetNumberOfValues(numberOfValues);
+  doubles->SetNumberOfValues(numberOfValues);
+  ints->SetNumberOfValues(numberOfValues);
+  for (vtkIdType i = 0; i < numberOfValues; ++i)
+  {
+    double v = i % 1000 == 999 ? vtkMath::Nan() : distribution(generator);
+    floats->SetValue(i, static_cast<float>(v));
+    doubles->SetValue(i, v);
+    ints->SetValue(i, std::isnan(v) ? 0 : static_cast<int>(v * 255.0));
+  }
+
+  vtkNew<vtkLookupTable> lut;
+  lut->SetNumberOfTableValues(256);
+  lut->SetHueRange(0.667, 0.0);
+  lut->SetTableRange(0.0, 1.0);
+  lut->UseBelowRangeColorOn();
+  lut->UseAboveRangeColorOn();
+  lut->Build();
+
+  vtkNew<vtkDiscretizableColorTransferFunction> ctf;
+  ctf->AddRGBPoint(0.0, 0.23, 0.30, 0.75);
+  ctf->AddRGBPoint(0.5, 0.87, 0.87, 0.87);
+  ctf->AddRGBPoint(1.0, 0.71, 0.02, 0.15);
+  ctf->DiscretizeOn();
+  ctf->SetNumberOfValues(64);
+  ctf->Build();
+
+  struct Case
+  {
+    const char* Name;
+    vtkScalarsToColors* Colors;
+    int NumberOfColors;
+    vtkDataArray* Scalars;
+  };
+  std::vector<Case> cases{
+      {"vtkLookupTable, float", lut, 256, floats},
+      {"vtkLookupTable, double", lut, 256, doubles},
+      {"vtkLookupTable, int", lut, 256, ints},
+      {"Discretized transfer function, float", ctf, 64, floats}};
+
+  // The integers span [-25, 280], map them through a table over [0, 255].
+  vtkNew<vtkLookupTable> intLut;
+  intLut->DeepCopy(lut);
+  intLut->SetTableRange(0, 255);
+  cases[2].Colors = intLut;
+
+  bool ok = true;
+  for (const auto& c : cases)
+  {
+    std::cout << c.Name << std::endl;
+
+    timer->StartTimer();
+    auto reference = vtkSmartPointer<vtkUnsignedCharArray>::Take(
+        c.Colors->MapScalars(c.Scalars, VTK_COLOR_MODE_MAP_SCALARS, 0));
+    timer->StopTimer();
+    auto referenceTime = timer->GetElapsedTime();
+    std::cout << "  MapScalars:        " << referenceTime << " s" << std::endl;
+
+    ColorMappingKernel kernel;
+    timer->StartTimer();
+    const bool built = kernel.Build(c.Colors, c.NumberOfColors);
+    timer->StopTimer();
+    if (!built)
+    {
+      std::cout << "  The kernel does not handle this table." << std::endl;
+      ok = false;
+      continue;
+    }
+    std::cout << "  Kernel build:      " << timer->GetElapsedTime() << " s"
+              << std::endl;
+
+    vtkNew<vtkUnsignedCharArray> rgba;
+    timer->StartTimer();
+    kernel.Map(c.Scalars, rgba);
+    timer->StopTimer();
+    std::cout << "  Kernel map:        " << timer->GetElapsedTime() << " s, "
+              << referenceTime / timer->GetElapsedTime() << "x" << std::endl;
+
+    double mismatch;
+    int maxDifference;
+    CompareColors(reference, rgba, mismatch, maxDifference);
+    std::cout << "  Differing values:  " << std::setprecision(6)
+              << 100.0 * mismatch << "%, max channel difference "
+              << maxDifference << std::setprecision(4) << std::endl;
+    // A value exactly on a bin boundary may round differently.
+    if (mismatch > 1.0e-4)
+    {
+      ok = false;
+    }
+  }
+
+  // Change detection: entry by entry comparison against the modification
+  // time of the table.
+  vtkNew<vtkLookupTable> copy;
+  copy->DeepCopy(lut);
+
+  const int repeats = 1000;
+  timer->StartTimer();
+  bool same = true;
+  for (int i = 0; i < repeats; ++i)
+  {
+    same = CompareEntryByEntry(lut, copy) && same;
+  }
+  timer->StopTimer();
+  std::cout << "Entry by entry comparison: "
+            << 1.0e6 * timer->GetElapsedTime() / repeats << " us" << std::endl;
+
+  // Once the table is built, an unchanged lookup table costs one time stamp
+  // compare.
+  ColorMappingKernel kernel;
+  bool built = kernel.Update(copy, 256);
+  bool changed = false;
+  timer->StartTimer();
+  for (int i = 0; i < repeats; ++i)
+  {
+    built = kernel.Update(copy, 256) && built;
+    changed = kernel.GetChanged() || changed;
+  }
+  timer->StopTimer();
+  std::cout << "Modification time check:   "
+            << 1.0e6 * timer->GetElapsedTime() / repeats << " us" << std::endl;
+
+  // Modified() without a change of colors rebuilds the table, and the
+  // comparison with the previous one finds that nothing changed.
+  timer->StartTimer();
+  for (int i = 0; i < repeats; ++i)
+  {
+    copy->Modified();
+    built = kernel.Update(copy, 256) && built;
+    changed = kernel.GetChanged() || changed;
+  }
+  timer->StopTimer();
+  std::cout << "Rebuild and compare:       "
+            << 1.0e6 * timer->GetElapsedTime() / repeats << " us" << std::endl;
+
+  const std::uint64_t hash = kernel.GetHash();
+  copy->SetTableValue(17, 1.0, 0.0, 1.0, 1.0);
+  built = kernel.Update(copy, 256) && built;
+  std::cout << "Hash before change: " << std::hex << hash
+            << ", after: " << kernel.GetHash() << std::dec << std::endl;
+  if (!built)
+  {
+    std::cout << "Building the change detection tables failed." << std::endl;
+    ok = false;
+  }
+  else if (!same || changed || !kernel.GetChanged())
+  {
+    std::cout << "Change detection failed." << std::endl;
+    ok = false;
+  }
+
+  std::cout << (ok ? "The kernel agrees with MapScalars."
+                   : "The kernel does not agree with MapScalars.")
+            << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+
+std::uint32_t Pack(const unsigned char* rgba)
+{
+  std::uint32_t packed;
+  std::memcpy(&packed, rgba, 4);
+  return packed;
+}
+
+bool ColorMappingKernel::Build(vtkScalarsToColors* colors, int numberOfColors)
+{
+  auto lut = vtkLookupTable::SafeDownCast(colors);
+  if (colors->GetIndexedLookup() ||
+      (lut && lut->GetScale() == VTK_SCALE_LOG10))
+  {
+    return false;
+  }
+  const double* range = colors->GetRange();
+  this->Range[0] = range[0];
+  this->Range[1] = range[1];
+  this->NumberOfColors = numberOfColors;
+  this->Scale = range[1] > range[0]
+      ? numberOfColors / (range[1] - range[0])
+      : 0.0;
+  this->Table.resize(numberOfColors + 3);
+
+  // Sample at the center of each bin.
+  const double width = (range[1] - range[0]) / numberOfColors;
+  this->Table[0] = Pack(colors->MapValue(-VTK_DOUBLE_MAX));
+  for (int i = 0; i < numberOfColors; ++i)
+  {
+    this->Table[i + 1] = Pack(colors->MapValue(range[0] + (i + 0.5) * width));
+  }
+  this->Table[numberOfColors + 1] = Pack(colors->MapValue(VTK_DOUBLE_MAX));
+  this->Table[numberOfColors + 2] = Pack(colors->MapValue(vtkMath::Nan()));
+
+  // FNV-1a over the table and the range.
+  this->Hash = 14695981039346656037ULL;
+  auto mix = [this](const void* data, size_t size) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+      this->Hash = (this->Hash ^ bytes[i]) * 1099511628211ULL;
+    }
+  };
+  mix(this->Range, sizeof(this->Range));
+  mix(this->Table.data(), this->Table.size() * sizeof(std::uint32_t));
+
+  this->Colors = colors;
+  this->BuildTime.Modified();
+  return true;
+}
+
+bool ColorMappingKernel::Update(vtkScalarsToColors* colors, int numberOfColors)
+{
+  this->Changed = false;
+  if (colors == this->Colors && numberOfColors == this->NumberOfColors &&
+      colors->GetMTime() <= this->BuildTime)
+  {
+    return true;
+  }
+  const ColorMappingKernel previous = *this;
+  if (!this->Build(colors, numberOfColors))
+  {
+    return false;
+  }
+  this->Changed = !(*this == previous);
+  return true;
+}
+
+template <typename T>
+void ColorMappingKernel::Map(const T* values, vtkIdType n,
+                             unsigned char* rgba) const
+{
+  const double low = this->Range[0];
+  const double high = this->Range[1];
+  const double scale = this->Scale;
+  const double last = this->NumberOfColors - 1;
+  const int above = this->NumberOfColors + 1;
+  const int nan = this->NumberOfColors + 2;
+  const std::uint32_t* table = this->Table.data();
+  auto output = reinterpret_cast<std::uint32_t*>(rgba);
+
+  vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+    int indices[BlockSize];
+    for (auto blockBegin = begin; blockBegin < end; blockBegin += BlockSize)
+    {
+      const int count =
+          static_cast<int>(std::min<vtkIdType>(BlockSize, end - blockBegin));
+      const T* in = values + blockBegin;
+      // Index computation, written with selects only.
+      for (int i = 0; i < count; ++i)
+      {
+        const double v = static_cast<double>(in[i]);
+        // Converting a NaN to int is undefined, clamp it to 0 first; it
+        // takes the NaN color of the original object below.
+        const bool isNan = std::isnan(v);
+        const double t =
+            std::min(std::max(isNan ? 0.0 : (v - low) * scale, 0.0), last);
+        int index = static_cast<int>(t) + 1;
+        index = v < low ? 0 : index;
+        index = v > high ? above : index;
+        index = isNan ? nan : index;
+        indices[i] = index;
+      }
+      // Gather.
+      std::uint32_t* out = output + blockBegin;
+      for (int i = 0; i < count; ++i)
+      {
+        out[i] = table[indices[i]];
+      }
+    }
+  });
+}
+
+void ColorMappingKernel::Map(vtkDataArray* array,
+                             vtkUnsignedCharArray* rgba) const
+{
+  rgba->SetNumberOfComponents(4);
+  rgba->SetNumberOfTuples(array->GetNumberOfTuples());
+  const auto n = array->GetNumberOfTuples();
+  if (array->GetNumberOfComponents() != 1)
+  {
+    vtkNew<vtkDoubleArray> first;
+    first->SetNumberOfValues(n);
+    for (vtkIdType i = 0; i < n; ++i)
+    {
+      first->SetValue(i, array->GetComponent(i, 0));
+    }
+    this->Map(first->GetPointer(0), n, rgba->GetPointer(0));
+    return;
+  }
+  switch (array->GetDataType())
+  {
+    vtkTemplateMacro(this->Map(static_cast<VTK_TT*>(array->GetVoidPointer(0)),
+                               n, rgba->GetPointer(0)));
+  }
+}
+
+bool CompareEntryByEntry(vtkLookupTable* lut1, vtkLookupTable* lut2)
+{
+  if (lut1->GetNumberOfTableValues() != lut2->GetNumberOfTableValues())
+  {
+    return false;
+  }
+  for (vtkIdType i = 0; i < lut1->GetNumberOfTableValues(); ++i)
+  {
+    double rgba1[4];
+    double rgba2[4];
+    lut1->GetTableValue(i, rgba1);
+    lut2->GetTableValue(i, rgba2);
+    for (int j = 0; j < 4; ++j)
+    {
+      if (rgba1[j] != rgba2[j])
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void CompareColors(vtkUnsignedCharArray* a, vtkUnsignedCharArray* b,
+                   double& mismatch, int& maxDifference)
+{
+  const vtkIdType n = a->GetNumberOfTuples();
+  vtkIdType different = 0;
+  maxDifference = 0;
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    bool differs = false;
+    for (int j = 0; j < 4; ++j)
+    {
+      int d = std::abs(static_cast<int>(a->GetTypedComponent(i, j)) -
+                       static_cast<int>(b->GetTypedComponent(i, j)));
+      maxDifference = std::max(maxDifference, d);
+      differs = differs || d != 0;
+    }
+    different += differs ? 1 : 0;
+  }
+  mismatch = n > 0 ? static_cast<double>(different) / n : 0.0;
+}
+
+} // namespace
@@ -0,0 +1,490 @@
+#include <vtkBrownianPoints.h>
+#include <vtkDataSet.h>
+#include <vtkDataSetAlgorithm.h>
+#include <vtkFloatArray.h>
+#include <vtkImageAlgorithm.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPointSource.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTimerLog.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+/**
+ * Philox4x32-10, a counter-based generator (Salmon et al., "Parallel random
+ * numbers: as easy as 1, 2, 3", SC11).
+ *
+ * The output is a pure function of a 128-bit counter and a 64-bit key, so
+ * any element of a stream can be computed directly. Filling an array in
+ * parallel gives the same values whatever the number of threads.
+ */
+class Philox4x32
+{
+public:
+  using Block = std::array<std::uint32_t, 4>;
+
+  explicit Philox4x32(std::uint64_t seed = 0)
+    : Key{{static_cast<std::uint32_t>(seed),
+           static_cast<std::uint32_t>(seed >> 32)}}
+  {
+  }
+
+  // The four words for counter (index, stream).
+  Block operator()(std::uint64_t index, std::uint32_t stream) const
+  {
+    Block c{{static_cast<std::uint32_t>(index),
+             static_cast<std::uint32_t>(index >> 32), stream, 0}};
+    auto k = this->Key;
+    for (int round = 0; round < 10; ++round)
+    {
+      const auto p0 = static_cast<std::uint64_t>(0xD2511F53u) * c[0];
+      const auto p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * c[2];
+      c = {{static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+            static_cast<std::uint32_t>(p1),
+            static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+            static_cast<std::uint32_t>(p0)}};
+      k[0] += 0x9E3779B9u;
+      k[1] += 0xBB67AE85u;
+    }
+    return c;
+  }
+
+  // A 32-bit word to a double in the open interval (0, 1).
+  static double ToUniform(std::uint32_t x)
+  {
+    return (static_cast<double>(x) + 0.5) * (1.0 / 4294967296.0);
+  }
+
+  /**
+   * Standard normal values number first to first + n - 1 of a stream. Value
+   * j comes from word j % 4 of block j / 4, paired by Box-Muller with the
+   * other word of its pair, so it does not depend on how the range is cut.
+   * The blocks are generated first, then transformed in a separate loop
+   * that the compiler can vectorize.
+   */
+  template <typename T>
+  void FillNormal(std::uint32_t stream, vtkIdType first, vtkIdType n,
+                  T* out) const;
+
+  // Uniform values in (0, 1), numbered as in FillNormal().
+  template <typename T>
+  void FillUniform(std::uint32_t stream, vtkIdType first, vtkIdType n,
+                   T* out) const;
+
+private:
+  std::array<std::uint32_t, 2> Key;
+};
+
+/**
+ * Like vtkBrownianPoints: a random vector, with a uniformly distributed
+ * direction and a speed between MinimumSpeed and MaximumSpeed, at each
+ * point. The vector of point i depends only on Seed and i.
+ */
+class ParallelBrownianPoints : public vtkDataSetAlgorithm
+{
+public:
+  static ParallelBrownianPoints* New();
+  vtkTypeMacro(ParallelBrownianPoints, vtkDataSetAlgorithm);
+
+  vtkSetMacro(Seed, vtkTypeUInt64);
+  vtkGetMacro(Seed, vtkTypeUInt64);
+  vtkSetMacro(MinimumSpeed, double);
+  vtkGetMacro(MinimumSpeed, double);
+  vtkSetMacro(MaximumSpeed, double);
+  vtkGetMacro(MaximumSpeed, double);
+
+  // The vectors of points first to first + n - 1, three floats each.
+  void Generate(vtkIdType first, vtkIdType n, float* vectors) const;
+
+protected:
+  ParallelBrownianPoints() = default;
+  ~ParallelBrownianPoints() override = default;
+
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  vtkTypeUInt64 Seed = 0;
+  double MinimumSpeed = 0.0;
+  double MaximumSpeed = 1.0;
+
+private:
+  ParallelBrownianPoints(const ParallelBrownianPoints&) = delete;
+  void operator=(const ParallelBrownianPoints&) = delete;
+};
+
+vtkStandardNewMacro(ParallelBrownianPoints);
+
+/**
+ * An image of normally distributed noise. The value of a point depends on
+ * Seed and its position in the whole extent only, so requesting a piece
+ * returns exactly that part of the whole image.
+ */
+class RandomFieldSource : public vtkImageAlgorithm
+{
+public:
+  static RandomFieldSource* New();
+  vtkTypeMacro(RandomFieldSource, vtkImageAlgorithm);
+
+  vtkSetVector3Macro(Dimensions, int);
+  vtkGetVector3Macro(Dimensions, int);
+  vtkSetMacro(Seed, vtkTypeUInt64);
+  vtkGetMacro(Seed, vtkTypeUInt64);
+  vtkSetMacro(Mean, double);
+  vtkGetMacro(Mean, double);
+  vtkSetMacro(StandardDeviation, double);
+  vtkGetMacro(StandardDeviation, double);
+
+protected:
+  RandomFieldSource()
+  {
+    this->SetNumberOfInputPorts(0);
+  }
+  ~RandomFieldSource() override = default;
+
+  int RequestInformation(vtkInformation*, vtkInformationVector**,
+                         vtkInformationVector*) override;
+  int RequestData(vtkInformation*, vtkInformationVector**,
+                  vtkInformationVector*) override;
+
+  int Dimensions[3] = {64, 64, 64};
+  vtkTypeUInt64 Seed = 0;
+  double Mean = 0.0;
+  double StandardDeviation = 1.0;
+
+private:
+  RandomFieldSource(const RandomFieldSource&) = delete;
+  void operator=(const RandomFieldSource&) = delete;
+};
+
+vtkStandardNewMacro(RandomFieldSource);
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: ParallelBrownianPoints [numberOfPoints] [imageDimension]
+  vtkIdType numberOfPoints = 1000000;
+  int dimension = 128;
+  if (argc > 1)
+  {
+    numberOfPoints = std::atoll(argv[1]);
+  }
+  if (argc > 2)
+  {
+    dimension = std::atoi(argv[2]);
+  }
+
+  vtkNew<vtkTimerLog> timer;
+  std::cout << std::fixed << std::setprecision(4);
+  bool ok = true;
+
+  vtkNew<vtkPointSource> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  points->SetRadius(1.0);
+  points->Update();
+
+  // The sequential filter.
+  vtkMath::RandomSeed(5070);
+  vtkNew<vtkBrownianPoints> brownian;
+  brownian->SetInputConnection(points->GetOutputPort());
+  brownian->SetMinimumSpeed(0.5);
+  brownian->SetMaximumSpeed(1.0);
+  timer->StartTimer();
+  brownian->Update();
+  timer->StopTimer();
+  auto reference = timer->GetElapsedTime();
+  std::cout << "vtkBrownianPoints:      " << reference << " s, "
+            << numberOfPoints / reference / 1.0e6 << " M points/s"
+            << std::endl;
+
+  vtkNew<ParallelBrownianPoints> parallel;
+  parallel->SetInputConnection(points->GetOutputPort());
+  parallel->SetSeed(5070);
+  parallel->SetMinimumSpeed(0.5);
+  parallel->SetMaximumSpeed(1.0);
+  timer->StartTimer();
+  parallel->Update();
+  timer->StopTimer();
+  std::cout << "ParallelBrownianPoints: " << timer->GetElapsedTime() << " s, "
+            << numberOfPoints / timer->GetElapsedTime() / 1.0e6
+            << " M points/s, " << reference / timer->GetElapsedTime() << "x"
+            << std::endl;
+
+  // The same vectors computed in one piece, as a single thread would.
+  auto vectors = vtkFloatArray::SafeDownCast(
+      parallel->GetOutput()->GetPointData()->GetVectors());
+  std::vector<float> serial(3 * numberOfPoints);
+  parallel->Generate(0, numberOfPoints, serial.data());
+  if (std::memcmp(serial.data(), vectors->GetPointer(0),
+                  serial.size() * sizeof(float)) != 0)
+  {
+    std::cout << "The vectors depend on how the work was split." << std::endl;
+    ok = false;
+  }
+
+  // Each component of a random direction has mean 0 and variance 1/3.
+  double mean[3] = {0.0, 0.0, 0.0};
+  double meanSquare[3] = {0.0, 0.0, 0.0};
+  double minimumSpeed = VTK_DOUBLE_MAX;
+  double maximumSpeed = 0.0;
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    double v[3];
+    vectors->GetTuple(i, v);
+    double speed = vtkMath::Norm(v);
+    minimumSpeed = std::min(minimumSpeed, speed);
+    maximumSpeed = std::max(maximumSpeed, speed);
+    for (int j = 0; j < 3; ++j)
+    {
+      mean[j] += v[j] / speed;
+      meanSquare[j] += v[j] * v[j] / (speed * speed);
+    }
+  }
+  std::cout << "Direction mean:     " << mean[0] / numberOfPoints << " "
+            << mean[1] / numberOfPoints << " " << mean[2] / numberOfPoints
+            << std::endl;
+  std::cout << "Direction variance: " << meanSquare[0] / numberOfPoints << " "
+            << meanSquare[1] / numberOfPoints << " "
+            << meanSquare[2] / numberOfPoints << " (expected 0.3333)"
+            << std::endl;
+  std::cout << "Speed range:        " << minimumSpeed << " " << maximumSpeed
+            << std::endl;
+  const double tolerance = 5.0 / std::sqrt(static_cast<double>(numberOfPoints));
+  for (int j = 0; j < 3; ++j)
+  {
+    if (std::abs(mean[j] / numberOfPoints) > tolerance ||
+        std::abs(meanSquare[j] / numberOfPoints - 1.0 / 3.0) > tolerance)
+    {
+      ok = false;
+    }
+  }
+  if (minimumSpeed < 0.5 - 1.0e-6 || maximumSpeed > 1.0 + 1.0e-6)
+  {
+    ok = false;
+  }
+
+  // A noise image.
+  vtkNew<RandomFieldSource> field;
+  field->SetDimensions(dimension, dimension, dimension);
+  field->SetSeed(8775070);
+  timer->StartTimer();
+  field->Update();
+  timer->StopTimer();
+  const double samples = static_cast<double>(dimension) * dimension * dimension;
+  std::cout << "RandomFieldSource:  " << dimension << "^3 in "
+            << timer->GetElapsedTime() << " s, "
+            << samples / timer->GetElapsedTime() / 1.0e6 << " M samples/s"
+            << std::endl;
+
+  auto noise = vtkFloatArray::SafeDownCast(
+      field->GetOutput()->GetPointData()->GetScalars());
+  double sum = 0.0;
+  double sumSquares = 0.0;
+  for (vtkIdType i = 0; i < noise->GetNumberOfValues(); ++i)
+  {
+    sum += noise->GetValue(i);
+    sumSquares += noise->GetValue(i) * noise->GetValue(i);
+  }
+  const double noiseMean = sum / samples;
+  const double noiseVariance = sumSquares / samples - noiseMean * noiseMean;
+  std::cout << "Noise mean " << noiseMean << ", variance " << noiseVariance
+            << std::endl;
+  if (std::abs(noiseMean) > 5.0 / std::sqrt(samples) ||
+      std::abs(noiseVariance - 1.0) > 10.0 / std::sqrt(samples))
+  {
+    ok = false;
+  }
+
+  std::cout << (ok ? "All checks passed." : "Some checks failed.")
+            << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+
+template <typename T>
+void Philox4x32::FillUniform(std::uint32_t stream, vtkIdType first,
+                             vtkIdType n, T* out) const
+{
+  const vtkIdType last = first + n;
+  vtkIdType j = first;
+  while (j < last)
+  {
+    // Take every word of the block while we have it.
+    const auto block = (*this)(static_cast<std::uint64_t>(j / 4), stream);
+    for (auto lane = j % 4; lane < 4 && j < last; ++lane, ++j)
+    {
+      out[j - first] = static_cast<T>(ToUniform(block[lane]));
+    }
+  }
+}
+
+template <typename T>
+void Philox4x32::FillNormal(std::uint32_t stream, vtkIdType first,
+                            vtkIdType n, T* out) const
+{
+  // Blocks of the stream per batch.
+  const int batch = 64;
+  double u[4 * batch];
+  double z[4 * batch];
+  const double twoPi = 2.0 * vtkMath::Pi();
+
+  const vtkIdType last = first + n;
+  for (vtkIdType b0 = first / 4; b0 * 4 < last; b0 += batch)
+  {
+    const int blocks =
+        static_cast<int>(std::min<vtkIdType>(batch, (last + 3) / 4 - b0));
+    for (int b = 0; b < blocks; ++b)
+    {
+      const auto block = (*this)(static_cast<std::uint64_t>(b0 + b), stream);
+      for (int lane = 0; lane < 4; ++lane)
+      {
+        u[4 * b + lane] = ToUniform(block[lane]);
+      }
+    }
+    // Box-Muller on the pairs (0, 1) and (2, 3) of each block.
+    for (int i = 0; i < 4 * blocks; i += 2)
+    {
+      const double r = std::sqrt(-2.0 * std::log(u[i]));
+      const double theta = twoPi * u[i + 1];
+      z[i] = r * std::cos(theta);
+      z[i + 1] = r * std::sin(theta);
+    }
+    const vtkIdType begin = std::max(first, b0 * 4);
+    const vtkIdType end = std::min(last, (b0 + blocks) * 4);
+    for (auto j = begin; j < end; ++j)
+    {
+      out[j - first] = static_cast<T>(z[j - b0 * 4]);
+    }
+  }
+}
+
+void ParallelBrownianPoints::Generate(vtkIdType first, vtkIdType n,
+                                      float* vectors) const
+{
+  // Stream 0 gives three normal values per point (the direction, after
+  // normalization), stream 1 one uniform value per point (the speed).
+  const Philox4x32 generator(this->Seed);
+  const int batch = 256;
+  double normals[4 * batch];
+  double speeds[batch];
+  for (vtkIdType p0 = first; p0 < first + n; p0 += batch)
+  {
+    const int count =
+        static_cast<int>(std::min<vtkIdType>(batch, first + n - p0));
+    generator.FillNormal(0, 4 * p0, 4 * count, normals);
+    generator.FillUniform(1, p0, count, speeds);
+    for (int i = 0; i < count; ++i)
+    {
+      const double* d = normals + 4 * i;
+      const double length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+      const double speed = this->MinimumSpeed +
+          (this->MaximumSpeed - this->MinimumSpeed) * speeds[i];
+      const double scale = length > 0.0 ? speed / length : 0.0;
+      float* v = vectors + 3 * (p0 - first + i);
+      v[0] = static_cast<float>(d[0] * scale);
+      v[1] = static_cast<float>(d[1] * scale);
+      v[2] = static_cast<float>(d[2] * scale);
+    }
+  }
+}
+
+int ParallelBrownianPoints::RequestData(vtkInformation* vtkNotUsed(request),
+                                        vtkInformationVector** inputVector,
+                                        vtkInformationVector* outputVector)
+{
+  vtkDataSet* input = vtkDataSet::GetData(inputVector[0]);
+  vtkDataSet* output = vtkDataSet::GetData(outputVector);
+
+  output->CopyStructure(input);
+  output->GetPointData()->PassData(input->GetPointData());
+  output->GetCellData()->PassData(input->GetCellData());
+
+  const vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  vtkNew<vtkFloatArray> vectors;
+  vectors->SetName("BrownianVectors");
+  vectors->SetNumberOfComponents(3);
+  vectors->SetNumberOfTuples(numberOfPoints);
+  float* data = vectors->GetPointer(0);
+
+  vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end) {
+    this->Generate(begin, end - begin, data + 3 * begin);
+  });
+
+  output->GetPointData()->SetVectors(vectors);
+  return 1;
+}
+
+int RandomFieldSource::RequestInformation(
+    vtkInformation* vtkNotUsed(request),
+    vtkInformationVector** vtkNotUsed(inputVector),
+    vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  int extent[6] = {0, this->Dimensions[0] - 1, 0, this->Dimensions[1] - 1,
+                   0, this->Dimensions[2] - 1};
+  outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent, 6);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_FLOAT, 1);
+  return 1;
+}
+
+int RandomFieldSource::RequestData(
+    vtkInformation* vtkNotUsed(request),
+    vtkInformationVector** vtkNotUsed(inputVector),
+    vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkImageData* output = vtkImageData::GetData(outInfo);
+
+  int extent[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+  output->SetExtent(extent);
+  output->AllocateScalars(VTK_FLOAT, 1);
+  output->GetPointData()->GetScalars()->SetName("Noise");
+
+  auto scalars = static_cast<float*>(output->GetScalarPointer());
+  const vtkIdType rowLength = extent[1] - extent[0] + 1;
+  const vtkIdType rowsPerSlice = extent[3] - extent[2] + 1;
+  const vtkIdType numberOfRows = rowsPerSlice * (extent[5] - extent[4] + 1);
+  const Philox4x32 generator(this->Seed);
+
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType begin, vtkIdType end) {
+    for (auto row = begin; row < end; ++row)
+    {
+      // Number the values by their position in the whole image.
+      const vtkIdType j = extent[2] + row % rowsPerSlice;
+      const vtkIdType k = extent[4] + row / rowsPerSlice;
+      const vtkIdType first =
+          (k * this->Dimensions[1] + j) * this->Dimensions[0] + extent[0];
+      float* out = scalars + row * rowLength;
+      generator.FillNormal(0, first, rowLength, out);
+      for (vtkIdType i = 0; i < rowLength; ++i)
+      {
+        out[i] = static_cast<float>(this->Mean +
+                                    this->StandardDeviation * out[i]);
+      }
+    }
+  });
+  return 1;
+}
+
+} // namespace
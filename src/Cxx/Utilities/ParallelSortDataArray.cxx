@@ -0,0 +1,705 @@
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkSortDataArray.h>
+#include <vtkStringArray.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+/**
+ * Sorts a key array, stably, and reorders any number of arrays the same
+ * way, like vtkSortDataArray::Sort(keys, values) for several value arrays.
+ *
+ * The sort computes a permutation of the tuples first, and then gathers
+ * each array through it in one parallel pass, moving whole tuples.
+ *
+ * Numeric keys are sorted by a parallel LSD radix sort, eight bits at a
+ * time, on an unsigned image of the keys that has their order: the sign
+ * bit flipped for signed integers, and the bits of floating point keys
+ * flipped so that negative values come first. Passes on a byte that is
+ * the same for all the keys are skipped. Other keys, and numeric keys on
+ * request, are sorted by a parallel merge sort: sorted runs, then rounds
+ * of merges split in pieces of equal size with vtkSMPTools.
+ *
+ * Equal keys keep their order. For floating point keys, -0 sorts before
+ * +0, and NaNs sort after +infinity (or before -infinity if their sign
+ * bit is set).
+ */
+class ParallelSortDataArray
+{
+public:
+  enum Method
+  {
+    Automatic, // Radix for numeric keys, merge otherwise.
+    Radix,
+    Merge
+  };
+
+  // Sort keys, which must have one component, and the tuples of each of
+  // values, which must have as many tuples.
+  static bool Sort(vtkAbstractArray* keys,
+                   const std::vector<vtkAbstractArray*>& values,
+                   Method method = Automatic);
+
+  // The stable sorted order of keys: permutation[i] is the index of the
+  // key that goes to i.
+  static bool ComputePermutation(vtkAbstractArray* keys,
+                                 std::vector<vtkIdType>& permutation,
+                                 Method method = Automatic);
+
+  // Reorder the tuples of array: tuple i becomes the old tuple
+  // permutation[i]. Arrays of any type are supported; those without a
+  // parallel path (bit arrays, variants, ...) go through SetTuple().
+  static void Gather(const std::vector<vtkIdType>& permutation,
+                     vtkAbstractArray* array);
+
+  // The unsigned integer with the order of a numeric key.
+  template <typename T> static auto RadixKey(T value);
+
+  template <typename T>
+  static void RadixSort(const T* keys, vtkIdType n,
+                        std::vector<vtkIdType>& permutation);
+
+  // less(i, j) compares the keys of the indices i and j.
+  template <typename Less>
+  static void MergeSort(vtkIdType n, Less less,
+                        std::vector<vtkIdType>& permutation);
+};
+
+struct Timing
+{
+  double Time = 0.0;
+  bool Sorted = true;
+};
+
+template <typename KeyArray>
+void Benchmark(const char* name, vtkIdType size, int numberOfValueArrays,
+               bool& ok);
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: ParallelSortDataArray [numberOfValueArrays] [size...]
+  const int numberOfValueArrays =
+    argc > 1 ? std::min(4, std::max(1, std::atoi(argv[1]))) : 2;
+  std::vector<vtkIdType> sizes;
+  for (int i = 2; i < argc; ++i)
+  {
+    sizes.push_back(std::max<vtkIdType>(1, std::atoll(argv[i])));
+  }
+  if (sizes.empty())
+  {
+    sizes = {1000000, 4000000};
+  }
+
+  std::cout << "SMP backend: " << vtkSMPTools::GetBackend() << " ("
+            << vtkSMPTools::GetEstimatedNumberOfThreads() << " threads)"
+            << std::endl;
+  std::cout << "Sorting keys and " << numberOfValueArrays
+            << " value arrays; times in seconds" << std::endl;
+  std::cout << std::left << std::setw(10) << "Keys" << std::right
+            << std::setw(12) << "Size" << std::setw(18) << "vtkSortDataArray"
+            << std::setw(10) << "Radix" << std::setw(10) << "Merge"
+            << std::setw(10) << "Speedup" << std::setw(8) << "Stable"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(3);
+  bool ok = true;
+  for (const vtkIdType size : sizes)
+  {
+    Benchmark<vtkIntArray>("int", size, numberOfValueArrays, ok);
+    Benchmark<vtkIdTypeArray>("vtkIdType", size, numberOfValueArrays, ok);
+    Benchmark<vtkFloatArray>("float", size, numberOfValueArrays, ok);
+    Benchmark<vtkDoubleArray>("double", size, numberOfValueArrays, ok);
+    // String keys are slow to sort, so only the first size uses them.
+    if (size == sizes.front())
+    {
+      Benchmark<vtkStringArray>("string", size, numberOfValueArrays, ok);
+    }
+  }
+  std::cout << (ok ? "All the sorts agree and are stable."
+                   : "Some sorts differ or are not stable.")
+            << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+template <typename T> auto ParallelSortDataArray::RadixKey(T value)
+{
+  using Unsigned = std::conditional_t<
+    sizeof(T) == 1, std::uint8_t,
+    std::conditional_t<
+      sizeof(T) == 2, std::uint16_t,
+      std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+  constexpr Unsigned sign = Unsigned(1) << (8 * sizeof(T) - 1);
+  if constexpr (std::is_floating_point<T>::value)
+  {
+    Unsigned bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    return static_cast<Unsigned>((bits & sign) ? ~bits : bits | sign);
+  }
+  else if constexpr (std::is_signed<T>::value)
+  {
+    return static_cast<Unsigned>(static_cast<Unsigned>(value) ^ sign);
+  }
+  else
+  {
+    return static_cast<Unsigned>(value);
+  }
+}
+
+template <typename T>
+void ParallelSortDataArray::RadixSort(const T* keys, vtkIdType n,
+                                      std::vector<vtkIdType>& permutation)
+{
+  using Unsigned = decltype(RadixKey(T()));
+  constexpr int passes = sizeof(Unsigned);
+  const vtkIdType numberOfChunks =
+    std::max<vtkIdType>(1, std::min<vtkIdType>(256, n / 65536));
+  const vtkIdType chunkSize = (n + numberOfChunks - 1) / numberOfChunks;
+
+  // The unsigned keys and their indices, with the count of each byte in
+  // each chunk for every pass.
+  std::vector<Unsigned> radixKeys(n);
+  std::vector<Unsigned> otherKeys(n);
+  permutation.resize(n);
+  std::vector<vtkIdType> otherIndices(n);
+  std::vector<std::array<vtkIdType, 256>> counts(numberOfChunks * passes);
+  vtkSMPTools::For(0, numberOfChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType c = begin; c < end; ++c)
+    {
+      auto chunkCounts = counts.data() + c * passes;
+      for (int pass = 0; pass < passes; ++pass)
+      {
+        chunkCounts[pass].fill(0);
+      }
+      const vtkIdType last = std::min(n, (c + 1) * chunkSize);
+      for (vtkIdType i = c * chunkSize; i < last; ++i)
+      {
+        const Unsigned key = RadixKey(keys[i]);
+        radixKeys[i] = key;
+        permutation[i] = i;
+        for (int pass = 0; pass < passes; ++pass)
+        {
+          ++chunkCounts[pass][(key >> (8 * pass)) & 0xff];
+        }
+      }
+    }
+  });
+
+  bool moved = false;
+  std::vector<vtkIdType> offsets(numberOfChunks * 256);
+  for (int pass = 0; pass < passes; ++pass)
+  {
+    const int shift = 8 * pass;
+    // A byte that is the same for all the keys leaves the order as it is.
+    bool same = false;
+    for (int d = 0; d < 256 && !same; ++d)
+    {
+      vtkIdType total = 0;
+      for (vtkIdType c = 0; c < numberOfChunks; ++c)
+      {
+        total += counts[c * passes + pass][d];
+      }
+      same = total == n;
+    }
+    if (same)
+    {
+      continue;
+    }
+
+    // Once the keys have moved, the counts of the chunks must be redone.
+    if (moved)
+    {
+      vtkSMPTools::For(0, numberOfChunks, 1,
+                       [&](vtkIdType begin, vtkIdType end) {
+                         for (vtkIdType c = begin; c < end; ++c)
+                         {
+                           auto& chunkCounts = counts[c * passes + pass];
+                           chunkCounts.fill(0);
+                           const vtkIdType last =
+                             std::min(n, (c + 1) * chunkSize);
+                           for (vtkIdType i = c * chunkSize; i < last; ++i)
+                           {
+                             ++chunkCounts[(radixKeys[i] >> shift) & 0xff];
+                           }
+                         }
+                       });
+    }
+    vtkIdType offset = 0;
+    for (int d = 0; d < 256; ++d)
+    {
+      for (vtkIdType c = 0; c < numberOfChunks; ++c)
+      {
+        offsets[c * 256 + d] = offset;
+        offset += counts[c * passes + pass][d];
+      }
+    }
+    vtkSMPTools::For(0, numberOfChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType c = begin; c < end; ++c)
+      {
+        vtkIdType* next = offsets.data() + c * 256;
+        const vtkIdType last = std::min(n, (c + 1) * chunkSize);
+        for (vtkIdType i = c * chunkSize; i < last; ++i)
+        {
+          const vtkIdType j = next[(radixKeys[i] >> shift) & 0xff]++;
+          otherKeys[j] = radixKeys[i];
+          otherIndices[j] = permutation[i];
+        }
+      }
+    });
+    radixKeys.swap(otherKeys);
+    permutation.swap(otherIndices);
+    moved = true;
+  }
+}
+
+template <typename Less>
+void ParallelSortDataArray::MergeSort(vtkIdType n, Less less,
+                                      std::vector<vtkIdType>& permutation)
+{
+  permutation.resize(n);
+  std::iota(permutation.begin(), permutation.end(), vtkIdType(0));
+  const vtkIdType numberOfThreads =
+    std::max(1, vtkSMPTools::GetEstimatedNumberOfThreads());
+  const vtkIdType runSize =
+    std::max<vtkIdType>(4096, (n + 4 * numberOfThreads - 1) /
+                          (4 * numberOfThreads));
+  const vtkIdType numberOfRuns = (n + runSize - 1) / runSize;
+  vtkSMPTools::For(0, numberOfRuns, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType r = begin; r < end; ++r)
+    {
+      std::stable_sort(permutation.begin() + r * runSize,
+                       permutation.begin() + std::min(n, (r + 1) * runSize),
+                       less);
+    }
+  });
+
+  // Each round merges pairs of runs. A merge is split in pieces of about
+  // the same size, whatever the number of runs left, so that the last
+  // rounds stay parallel.
+  struct Piece
+  {
+    vtkIdType Begin; // The first run of the pair.
+    vtkIdType Middle;
+    vtkIdType End;
+    vtkIdType First; // The part of the merged output.
+    vtkIdType Last;
+  };
+  const vtkIdType pieceSize =
+    std::max<vtkIdType>(65536, n / (4 * numberOfThreads) + 1);
+  std::vector<vtkIdType> buffer(n);
+  std::vector<Piece> pieces;
+  for (vtkIdType width = runSize; width < n; width *= 2)
+  {
+    pieces.clear();
+    for (vtkIdType begin = 0; begin < n; begin += 2 * width)
+    {
+      const vtkIdType middle = std::min(n, begin + width);
+      const vtkIdType end = std::min(n, begin + 2 * width);
+      for (vtkIdType first = 0; first < end - begin; first += pieceSize)
+      {
+        const vtkIdType last = std::min(end - begin, first + pieceSize);
+        pieces.push_back({begin, middle, end, first, last});
+      }
+    }
+    const vtkIdType* source = permutation.data();
+    vtkIdType* destination = buffer.data();
+    vtkSMPTools::For(
+      0, static_cast<vtkIdType>(pieces.size()), 1,
+      [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType p = begin; p < end; ++p)
+        {
+          const Piece& piece = pieces[p];
+          const vtkIdType* a = source + piece.Begin;
+          const vtkIdType* b = source + piece.Middle;
+          const vtkIdType na = piece.Middle - piece.Begin;
+          const vtkIdType nb = piece.End - piece.Middle;
+          // How many of the first d merged elements come from a; ties go
+          // to a, as in std::merge.
+          auto split = [&](vtkIdType d) {
+            vtkIdType low = std::max<vtkIdType>(0, d - nb);
+            vtkIdType high = std::min(d, na);
+            while (low < high)
+            {
+              const vtkIdType i = (low + high) / 2;
+              const vtkIdType j = d - i;
+              if (j > 0 && i < na && !less(b[j - 1], a[i]))
+              {
+                low = i + 1;
+              }
+              else
+              {
+                high = i;
+              }
+            }
+            return low;
+          };
+          const vtkIdType i0 = split(piece.First);
+          const vtkIdType i1 = split(piece.Last);
+          std::merge(a + i0, a + i1, b + piece.First - i0,
+                     b + piece.Last - i1,
+                     destination + piece.Begin + piece.First, less);
+        }
+      });
+    permutation.swap(buffer);
+  }
+}
+
+bool ParallelSortDataArray::ComputePermutation(
+  vtkAbstractArray* keys, std::vector<vtkIdType>& permutation, Method method)
+{
+  if (keys->GetNumberOfComponents() != 1)
+  {
+    vtkGenericWarningMacro(<< "The keys must have one component.");
+    return false;
+  }
+  const vtkIdType n = keys->GetNumberOfTuples();
+  if (auto strings = vtkStringArray::SafeDownCast(keys))
+  {
+    MergeSort(
+      n,
+      [strings](vtkIdType i, vtkIdType j) {
+        return strings->GetValue(i) < strings->GetValue(j);
+      },
+      permutation);
+    return true;
+  }
+  auto numbers = vtkDataArray::SafeDownCast(keys);
+  if (!numbers)
+  {
+    vtkGenericWarningMacro(<< "Keys of type " << keys->GetClassName()
+                           << " are not supported.");
+    return false;
+  }
+  switch (numbers->GetDataType())
+  {
+    vtkTemplateMacro({
+      const auto* values = static_cast<VTK_TT*>(numbers->GetVoidPointer(0));
+      if (method == Merge)
+      {
+        MergeSort(
+          n,
+          [values](vtkIdType i, vtkIdType j) {
+            return RadixKey(values[i]) < RadixKey(values[j]);
+          },
+          permutation);
+      }
+      else
+      {
+        RadixSort(values, n, permutation);
+      }
+    });
+    default:
+      vtkGenericWarningMacro(<< "Keys of type " << keys->GetClassName()
+                             << " are not supported.");
+      return false;
+  }
+  return true;
+}
+
+void ParallelSortDataArray::Gather(const std::vector<vtkIdType>& permutation,
+                                   vtkAbstractArray* array)
+{
+  const vtkIdType n = static_cast<vtkIdType>(permutation.size());
+  const int components = array->GetNumberOfComponents();
+  const vtkIdType* p = permutation.data();
+
+  auto numbers = vtkDataArray::SafeDownCast(array);
+  if (numbers && numbers->HasStandardMemoryLayout())
+  {
+    switch (numbers->GetDataType())
+    {
+      vtkTemplateMacro({
+        auto sorted = vtk::TakeSmartPointer(numbers->NewInstance());
+        sorted->SetName(array->GetName());
+        sorted->SetNumberOfComponents(components);
+        sorted->SetNumberOfTuples(n);
+        const auto* source = static_cast<VTK_TT*>(array->GetVoidPointer(0));
+        auto* destination = static_cast<VTK_TT*>(sorted->GetVoidPointer(0));
+        vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+          if (components == 1)
+          {
+            for (vtkIdType i = begin; i < end; ++i)
+            {
+              destination[i] = source[p[i]];
+            }
+            return;
+          }
+          for (vtkIdType i = begin; i < end; ++i)
+          {
+            std::copy(source + p[i] * components,
+                      source + (p[i] + 1) * components,
+                      destination + i * components);
+          }
+        });
+        numbers->ShallowCopy(sorted);
+        return;
+      });
+      default:
+        // Gathered below, through SetTuple().
+        break;
+    }
+  }
+
+  if (auto strings = vtkStringArray::SafeDownCast(array))
+  {
+    // The strings are moved out through the permutation and back, so only
+    // their handles are copied, not their characters. SetValue() is not
+    // thread safe, the strings are assigned directly.
+    vtkStdString* values = strings->GetPointer(0);
+    std::vector<vtkStdString> sorted(n * components);
+    vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; ++i)
+      {
+        std::move(values + p[i] * components,
+                  values + (p[i] + 1) * components,
+                  sorted.begin() + i * components);
+      }
+    });
+    std::move(sorted.begin(), sorted.end(), values);
+    strings->DataChanged();
+    return;
+  }
+
+  // Any other type, serially.
+  auto sorted = vtk::TakeSmartPointer(array->NewInstance());
+  sorted->SetName(array->GetName());
+  sorted->SetNumberOfComponents(components);
+  sorted->SetNumberOfTuples(n);
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    sorted->SetTuple(i, p[i], array);
+  }
+  if (numbers)
+  {
+    numbers->ShallowCopy(vtkDataArray::SafeDownCast(sorted));
+  }
+  else
+  {
+    array->DeepCopy(sorted);
+  }
+}
+
+bool ParallelSortDataArray::Sort(vtkAbstractArray* keys,
+                                 const std::vector<vtkAbstractArray*>& values,
+                                 Method method)
+{
+  // Everything that can fail is checked before any array is reordered, so
+  // that the keys and the values stay in step.
+  for (auto array : values)
+  {
+    if (!array || array->GetNumberOfTuples() != keys->GetNumberOfTuples())
+    {
+      vtkGenericWarningMacro(<< "The value arrays must have as many tuples "
+                                "as there are keys.");
+      return false;
+    }
+  }
+  std::vector<vtkIdType> permutation;
+  if (!ComputePermutation(keys, permutation, method))
+  {
+    return false;
+  }
+  Gather(permutation, keys);
+  for (auto array : values)
+  {
+    Gather(permutation, array);
+  }
+  return true;
+}
+
+// Random keys with many duplicates, so that stability matters.
+template <typename KeyArray>
+void FillKeys(KeyArray* keys, vtkIdType size, std::mt19937_64& generator)
+{
+  keys->SetNumberOfValues(size);
+  const auto distinct = static_cast<std::uint64_t>(std::max<vtkIdType>(
+    1, size / 4));
+  for (vtkIdType i = 0; i < size; ++i)
+  {
+    const auto r = static_cast<std::int64_t>(generator() % distinct);
+    if constexpr (std::is_same<KeyArray, vtkStringArray>::value)
+    {
+      keys->SetValue(i, "key" + std::to_string(r));
+    }
+    else if constexpr (std::is_same<KeyArray, vtkIntArray>::value)
+    {
+      keys->SetValue(i, static_cast<int>(r));
+    }
+    else if constexpr (std::is_same<KeyArray, vtkIdTypeArray>::value)
+    {
+      // Negative and large keys, for all the passes of the radix sort.
+      keys->SetValue(i, (r - static_cast<std::int64_t>(distinct / 2)) *
+                          1000003);
+    }
+    else
+    {
+      keys->SetValue(i, static_cast<typename KeyArray::ValueType>(
+                          (static_cast<double>(r) / distinct - 0.5) * 100.0));
+    }
+  }
+}
+
+// The value arrays: the original index, then tuples of three values
+// computed from it, so that every array can be checked.
+std::vector<vtkSmartPointer<vtkAbstractArray>> MakeValues(vtkIdType size,
+                                                          int count)
+{
+  std::vector<vtkSmartPointer<vtkAbstractArray>> values;
+  auto indices = vtkSmartPointer<vtkIdTypeArray>::New();
+  indices->SetNumberOfValues(size);
+  std::iota(indices->GetPointer(0), indices->GetPointer(0) + size,
+            vtkIdType(0));
+  values.push_back(indices);
+  for (int a = 1; a < count; ++a)
+  {
+    auto tuples = vtkSmartPointer<vtkFloatArray>::New();
+    tuples->SetNumberOfComponents(3);
+    tuples->SetNumberOfTuples(size);
+    float* t = tuples->GetPointer(0);
+    vtkSMPTools::For(0, size, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType i = begin; i < end; ++i)
+      {
+        for (int c = 0; c < 3; ++c)
+        {
+          t[3 * i + c] = static_cast<float>((i % 1000000) * 3 + c + a);
+        }
+      }
+    });
+    values.push_back(tuples);
+  }
+  return values;
+}
+
+// True if the keys are sorted, equal keys in the order of their original
+// index, and the other arrays moved with the indices.
+template <typename KeyArray>
+bool IsStablySorted(
+  KeyArray* keys, const std::vector<vtkSmartPointer<vtkAbstractArray>>& values)
+{
+  const vtkIdType n = keys->GetNumberOfValues();
+  const vtkIdType* indices =
+    vtkIdTypeArray::SafeDownCast(values[0])->GetPointer(0);
+  bool ok = true;
+  for (vtkIdType i = 1; i < n && ok; ++i)
+  {
+    const auto previous = keys->GetValue(i - 1);
+    const auto key = keys->GetValue(i);
+    ok = !(key < previous) && (previous < key || indices[i - 1] < indices[i]);
+  }
+  for (size_t a = 1; a < values.size() && ok; ++a)
+  {
+    const float* t = vtkFloatArray::SafeDownCast(values[a])->GetPointer(0);
+    for (vtkIdType i = 0; i < n && ok; ++i)
+    {
+      ok = t[3 * i + 2] ==
+        static_cast<float>((indices[i] % 1000000) * 3 + 2 + a);
+    }
+  }
+  return ok;
+}
+
+template <typename KeyArray>
+void Benchmark(const char* name, vtkIdType size, int numberOfValueArrays,
+               bool& ok)
+{
+  std::mt19937_64 generator(8775070u + size);
+  vtkNew<KeyArray> original;
+  FillKeys(original.GetPointer(), size, generator);
+  vtkNew<vtkTimerLog> timer;
+
+  // vtkSortDataArray sorts the keys with one array at a time, so each
+  // array after the first needs a fresh copy of the keys.
+  vtkNew<KeyArray> reference;
+  {
+    auto values = MakeValues(size, numberOfValueArrays);
+    vtkNew<KeyArray> keys;
+    timer->StartTimer();
+    for (auto& array : values)
+    {
+      keys->DeepCopy(original);
+      vtkSortDataArray::Sort(keys, array);
+    }
+    timer->StopTimer();
+    reference->DeepCopy(keys);
+  }
+  const double referenceTime = timer->GetElapsedTime();
+
+  std::array<Timing, 2> timings;
+  std::array<vtkSmartPointer<KeyArray>, 2> sortedKeys;
+  std::array<std::vector<vtkSmartPointer<vtkAbstractArray>>, 2> sortedValues;
+  const bool numeric = !std::is_same<KeyArray, vtkStringArray>::value;
+  for (int m = numeric ? 0 : 1; m < 2; ++m)
+  {
+    sortedValues[m] = MakeValues(size, numberOfValueArrays);
+    std::vector<vtkAbstractArray*> arrays;
+    for (auto& array : sortedValues[m])
+    {
+      arrays.push_back(array);
+    }
+    sortedKeys[m] = vtkSmartPointer<KeyArray>::New();
+    sortedKeys[m]->DeepCopy(original);
+    timer->StartTimer();
+    const bool sorted = ParallelSortDataArray::Sort(
+      sortedKeys[m], arrays,
+      m == 0 ? ParallelSortDataArray::Radix : ParallelSortDataArray::Merge);
+    timer->StopTimer();
+    timings[m].Time = timer->GetElapsedTime();
+    timings[m].Sorted =
+      sorted && IsStablySorted(sortedKeys[m].Get(), sortedValues[m]);
+  }
+
+  // Both sorts are stable, so they must be identical; vtkSortDataArray
+  // must at least have the same keys.
+  bool same = timings[0].Sorted && timings[1].Sorted;
+  for (vtkIdType i = 0; i < size && same; ++i)
+  {
+    same = sortedKeys[1]->GetValue(i) == reference->GetValue(i) &&
+      (!numeric || sortedKeys[0]->GetValue(i) == sortedKeys[1]->GetValue(i));
+  }
+  if (numeric && same)
+  {
+    const vtkIdType* radix =
+      vtkIdTypeArray::SafeDownCast(sortedValues[0][0])->GetPointer(0);
+    const vtkIdType* merge =
+      vtkIdTypeArray::SafeDownCast(sortedValues[1][0])->GetPointer(0);
+    same = std::equal(radix, radix + size, merge);
+  }
+  ok = ok && same;
+
+  const double best = numeric ? std::min(timings[0].Time, timings[1].Time)
+                              : timings[1].Time;
+  std::cout << std::left << std::setw(10) << name << std::right
+            << std::setw(12) << size << std::setw(18) << referenceTime;
+  if (numeric)
+  {
+    std::cout << std::setw(10) << timings[0].Time;
+  }
+  else
+  {
+    std::cout << std::setw(10) << "-";
+  }
+  std::cout << std::setw(10) << timings[1].Time << std::setw(10)
+            << referenceTime / best << std::setw(8) << (same ? "yes" : "no")
+            << std::endl;
+}
+} // namespace
@@ -0,0 +1,564 @@
+#include <vtkActor.h>
+#include <vtkAlgorithm.h>
+#include <vtkCameraPass.h>
+#include <vtkCommand.h>
+#include <vtkElevationFilter.h>
+#include <vtkLightsPass.h>
+#include <vtkNamedColors.h>
+#include <vtkNew.h>
+#include <vtkOpaquePass.h>
+#include <vtkOverlayPass.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkProperty.h>
+#include <vtkRenderPass.h>
+#include <vtkRenderPassCollection.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+#include <vtkSMPTools.h>
+#include <vtkSequencePass.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTranslucentPass.h>
+#include <vtkVolumetricPass.h>
+#include <vtkWindowedSincPolyDataFilter.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * One completed span. The name must outlive the recorder, class names and
+ * string literals are fine.
+ */
+struct TraceEvent
+{
+  const char* Name;
+  std::int64_t Begin; // ns since the recorder was created.
+  std::int64_t End;
+  std::uint16_t Depth;
+};
+
+/**
+ * A fixed size, single producer ring buffer. Only the owning thread writes
+ * into it so no locking is needed on the hot path, the reader (the exporter)
+ * runs after the traced work has finished.
+ */
+class ThreadRingBuffer
+{
+public:
+  ThreadRingBuffer(int threadIndex, std::size_t capacity)
+    : ThreadIndex(threadIndex), Events(capacity), Mask(capacity - 1)
+  {
+  }
+
+  void Push(const TraceEvent& event)
+  {
+    const auto head = this->Head.load(std::memory_order_relaxed);
+    this->Events[head & this->Mask] = event;
+    this->Head.store(head + 1, std::memory_order_release);
+  }
+
+  // Copy out the events still held in the buffer, oldest first.
+  std::vector<TraceEvent> Snapshot(std::uint64_t& dropped) const
+  {
+    const auto head = this->Head.load(std::memory_order_acquire);
+    const std::uint64_t capacity = this->Events.size();
+    const auto count = std::min<std::uint64_t>(head, capacity);
+    dropped = head - count;
+    std::vector<TraceEvent> result;
+    result.reserve(count);
+    for (auto i = head - count; i < head; ++i)
+    {
+      result.push_back(this->Events[i & this->Mask]);
+    }
+    return result;
+  }
+
+  int ThreadIndex;
+  // Spans opened but not yet closed on this thread.
+  std::vector<std::pair<const char*, std::int64_t>> Open;
+
+private:
+  std::vector<TraceEvent> Events;
+  std::uint64_t Mask;
+  std::atomic<std::uint64_t> Head{0};
+};
+
+/**
+ * Collects spans from any number of threads. Each thread gets its own ring
+ * buffer the first time it records something; that registration is the only
+ * place a lock is taken.
+ */
+class TraceRecorder
+{
+public:
+  // capacity is rounded up to a power of two.
+  explicit TraceRecorder(std::size_t capacity = 1 << 16)
+    : Origin(std::chrono::steady_clock::now())
+  {
+    this->Capacity = 1;
+    while (this->Capacity < capacity)
+    {
+      this->Capacity <<= 1;
+    }
+  }
+
+  std::int64_t Now() const
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - this->Origin)
+        .count();
+  }
+
+  void Begin(const char* name)
+  {
+    if (!this->Enabled.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+    this->Local()->Open.emplace_back(name, this->Now());
+  }
+
+  void End()
+  {
+    if (!this->Enabled.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+    auto buffer = this->Local();
+    if (buffer->Open.empty())
+    {
+      return;
+    }
+    auto open = buffer->Open.back();
+    buffer->Open.pop_back();
+    buffer->Push({open.first, open.second, this->Now(),
+                  static_cast<std::uint16_t>(buffer->Open.size())});
+  }
+
+  void SetEnabled(bool enabled)
+  {
+    this->Enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  void WriteChromeTrace(std::ostream& os) const;
+  void WriteReport(std::ostream& os) const;
+
+private:
+  ThreadRingBuffer* Local()
+  {
+    // Cache the lookup per thread. Recorders are told apart by a serial
+    // number rather than their address, which may be reused.
+    thread_local std::vector<std::pair<std::uint64_t, ThreadRingBuffer*>>
+        buffers;
+    for (const auto& b : buffers)
+    {
+      if (b.first == this->Serial)
+      {
+        return b.second;
+      }
+    }
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Buffers.emplace_back(new ThreadRingBuffer(
+        static_cast<int>(this->Buffers.size()), this->Capacity));
+    buffers.emplace_back(this->Serial, this->Buffers.back().get());
+    return this->Buffers.back().get();
+  }
+
+  static std::uint64_t NextSerial()
+  {
+    static std::atomic<std::uint64_t> serial{0};
+    return ++serial;
+  }
+
+  std::chrono::steady_clock::time_point Origin;
+  std::uint64_t Serial = NextSerial();
+  std::size_t Capacity;
+  std::atomic<bool> Enabled{true};
+  mutable std::mutex Mutex;
+  std::vector<std::unique_ptr<ThreadRingBuffer>> Buffers;
+};
+
+/**
+ * RAII helper for instrumenting a scope by hand.
+ */
+class ScopedSpan
+{
+public:
+  ScopedSpan(TraceRecorder& recorder, const char* name) : Recorder(recorder)
+  {
+    this->Recorder.Begin(name);
+  }
+  ~ScopedSpan()
+  {
+    this->Recorder.End();
+  }
+
+private:
+  TraceRecorder& Recorder;
+};
+
+/**
+ * Turns StartEvent/EndEvent pairs from algorithms, renderers and render
+ * windows into spans named after the class of the caller.
+ */
+class TraceObserver : public vtkCommand
+{
+public:
+  static TraceObserver* New()
+  {
+    return new TraceObserver;
+  }
+
+  void Execute(vtkObject* caller, unsigned long eventId,
+               void* vtkNotUsed(callData)) override
+  {
+    if (eventId == vtkCommand::StartEvent)
+    {
+      this->Recorder->Begin(caller->GetClassName());
+    }
+    else if (eventId == vtkCommand::EndEvent)
+    {
+      this->Recorder->End();
+    }
+  }
+
+  TraceRecorder* Recorder = nullptr;
+};
+
+/**
+ * Records a span, named after the class of the delegate pass, around the
+ * delegate's Render(). Render passes invoke no events, so they are wrapped
+ * instead of observed.
+ */
+class TracedPass : public vtkRenderPass
+{
+public:
+  static TracedPass* New();
+  vtkTypeMacro(TracedPass, vtkRenderPass);
+
+  void Render(const vtkRenderState* s) override
+  {
+    ScopedSpan span(*this->Recorder, this->DelegatePass->GetClassName());
+    this->DelegatePass->Render(s);
+    this->NumberOfRenderedProps =
+        this->DelegatePass->GetNumberOfRenderedProps();
+  }
+
+  void ReleaseGraphicsResources(vtkWindow* w) override
+  {
+    this->DelegatePass->ReleaseGraphicsResources(w);
+  }
+
+  TraceRecorder* Recorder = nullptr;
+  vtkSmartPointer<vtkRenderPass> DelegatePass;
+};
+
+vtkStandardNewMacro(TracedPass);
+
+// Observe obj, pipeline executions, renders...
+void Observe(vtkObject* obj, TraceObserver* observer);
+
+// Wrap pass in a TracedPass.
+vtkSmartPointer<vtkRenderPass> Trace(vtkRenderPass* pass,
+                                     TraceRecorder& recorder);
+
+// Observe every algorithm upstream of, and including, algorithm.
+void InstrumentPipeline(vtkAlgorithm* algorithm, TraceObserver* observer);
+
+// Some work on the calling thread and on the vtkSMPTools workers.
+void ParallelWork(TraceRecorder& recorder, vtkIdType n);
+
+std::string EscapeJSON(const char* s);
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: PipelineTrace [trace.json]
+  // The trace can be loaded with chrome://tracing or https://ui.perfetto.dev
+  TraceRecorder recorder;
+
+  vtkNew<TraceObserver> observer;
+  observer->Recorder = &recorder;
+
+  vtkNew<vtkNamedColors> colors;
+
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetThetaResolution(256);
+  sphere->SetPhiResolution(256);
+
+  vtkNew<vtkWindowedSincPolyDataFilter> smoother;
+  smoother->SetInputConnection(sphere->GetOutputPort());
+  smoother->SetNumberOfIterations(10);
+
+  vtkNew<vtkPolyDataNormals> normals;
+  normals->SetInputConnection(smoother->GetOutputPort());
+
+  vtkNew<vtkElevationFilter> elevation;
+  elevation->SetInputConnection(normals->GetOutputPort());
+  elevation->SetLowPoint(0, 0, -0.5);
+  elevation->SetHighPoint(0, 0, 0.5);
+
+  InstrumentPipeline(elevation, observer);
+
+  vtkNew<vtkPolyDataMapper> mapper;
+  mapper->SetInputConnection(elevation->GetOutputPort());
+
+  vtkNew<vtkActor> actor;
+  actor->SetMapper(mapper);
+  actor->GetProperty()->SetColor(colors->GetColor3d("Tomato").GetData());
+
+  vtkNew<vtkRenderer> renderer;
+  renderer->AddActor(actor);
+  renderer->SetBackground(colors->GetColor3d("SlateGray").GetData());
+
+  vtkNew<vtkRenderWindow> renderWindow;
+  renderWindow->AddRenderer(renderer);
+  renderWindow->SetOffScreenRendering(1);
+  renderWindow->SetWindowName("PipelineTrace");
+
+  Observe(renderer, observer);
+  Observe(renderWindow, observer);
+
+  // The steps of the default render, each pass traced.
+  vtkNew<vtkLightsPass> lightsPass;
+  vtkNew<vtkOpaquePass> opaquePass;
+  vtkNew<vtkTranslucentPass> translucentPass;
+  vtkNew<vtkVolumetricPass> volumetricPass;
+  vtkNew<vtkOverlayPass> overlayPass;
+  vtkNew<vtkRenderPassCollection> passes;
+  for (vtkRenderPass* pass : std::array<vtkRenderPass*, 5>{
+           lightsPass, opaquePass, translucentPass, volumetricPass,
+           overlayPass})
+  {
+    passes->AddItem(Trace(pass, recorder));
+  }
+  vtkNew<vtkSequencePass> sequence;
+  sequence->SetPasses(passes);
+  vtkNew<vtkCameraPass> cameraPass;
+  cameraPass->SetDelegatePass(sequence);
+  renderer->SetPass(Trace(cameraPass, recorder));
+
+  {
+    ScopedSpan span(recorder, "Frames");
+    for (int i = 0; i < 5; ++i)
+    {
+      // Change a parameter so that part of the pipeline re-executes.
+      smoother->SetPassBand(0.1 + 0.01 * i);
+      renderWindow->Render();
+    }
+  }
+
+  {
+    ScopedSpan span(recorder, "ParallelWork");
+    ParallelWork(recorder, 1 << 20);
+  }
+
+  recorder.SetEnabled(false);
+
+  // Estimate the per span overhead with a recorder of its own so that the
+  // spans above are not overwritten.
+  TraceRecorder overheadRecorder;
+  const int numberOfSpans = 100000;
+  auto start = overheadRecorder.Now();
+  for (int i = 0; i < numberOfSpans; ++i)
+  {
+    ScopedSpan span(overheadRecorder, "Empty");
+  }
+  auto overhead =
+      static_cast<double>(overheadRecorder.Now() - start) / numberOfSpans;
+
+  recorder.WriteReport(std::cout);
+  std::cout << "Approximate cost per span: " << std::fixed
+            << std::setprecision(1) << overhead << " ns" << std::endl;
+
+  if (argc > 1)
+  {
+    std::ofstream os(argv[1]);
+    if (!os)
+    {
+      std::cerr << "Cannot open " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+    }
+    recorder.WriteChromeTrace(os);
+    std::cout << "Wrote " << argv[1] << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+namespace {
+
+void Observe(vtkObject* obj, TraceObserver* observer)
+{
+  obj->AddObserver(vtkCommand::StartEvent, observer);
+  obj->AddObserver(vtkCommand::EndEvent, observer);
+}
+
+vtkSmartPointer<vtkRenderPass> Trace(vtkRenderPass* pass,
+                                     TraceRecorder& recorder)
+{
+  auto traced = vtkSmartPointer<TracedPass>::New();
+  traced->Recorder = &recorder;
+  traced->DelegatePass = pass;
+  return traced;
+}
+
+void InstrumentPipeline(vtkAlgorithm* algorithm, TraceObserver* observer)
+{
+  std::set<vtkAlgorithm*> visited;
+  std::vector<vtkAlgorithm*> stack{algorithm};
+  while (!stack.empty())
+  {
+    auto current = stack.back();
+    stack.pop_back();
+    if (!current || !visited.insert(current).second)
+    {
+      continue;
+    }
+    Observe(current, observer);
+    for (int port = 0; port < current->GetNumberOfInputPorts(); ++port)
+    {
+      for (int i = 0; i < current->GetNumberOfInputConnections(port); ++i)
+      {
+        stack.push_back(current->GetInputAlgorithm(port, i));
+      }
+    }
+  }
+}
+
+void ParallelWork(TraceRecorder& recorder, vtkIdType n)
+{
+  std::vector<double> values(n);
+  vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+    ScopedSpan span(recorder, "ParallelWork::Chunk");
+    for (auto i = begin; i < end; ++i)
+    {
+      values[i] = std::sin(0.001 * i) * std::cos(0.002 * i);
+    }
+  });
+}
+
+std::string EscapeJSON(const char* s)
+{
+  std::string result;
+  for (; s && *s; ++s)
+  {
+    if (*s == '"' || *s == '\\')
+    {
+      result += '\\';
+    }
+    result += *s;
+  }
+  return result;
+}
+
+void TraceRecorder::WriteChromeTrace(std::ostream& os) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  auto separator = "\n";
+  for (const auto& buffer : this->Buffers)
+  {
+    std::uint64_t dropped = 0;
+    for (const auto& e : buffer->Snapshot(dropped))
+    {
+      // Complete ("X") events, the times are in microseconds.
+      os << separator << "{\"name\":\"" << EscapeJSON(e.Name)
+         << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->ThreadIndex
+         << ",\"ts\":" << std::fixed << std::setprecision(3) << e.Begin * 1e-3
+         << ",\"dur\":" << (e.End - e.Begin) * 1e-3
+         << ",\"args\":{\"depth\":" << e.Depth << "}}";
+      separator = ",\n";
+    }
+    os << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0"
+       << ",\"tid\":" << buffer->ThreadIndex
+       << ",\"args\":{\"name\":\"Thread " << buffer->ThreadIndex
+       << (dropped ? " (wrapped)" : "") << "\"}}";
+  }
+  os << "\n]}\n";
+}
+
+void TraceRecorder::WriteReport(std::ostream& os) const
+{
+  struct Summary
+  {
+    std::uint64_t Count = 0;
+    std::int64_t Total = 0;
+    std::int64_t Self = 0;
+    std::int64_t Max = 0;
+  };
+  std::map<std::string, Summary> summaries;
+  std::uint64_t totalDropped = 0;
+
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  for (const auto& buffer : this->Buffers)
+  {
+    std::uint64_t dropped = 0;
+    auto events = buffer->Snapshot(dropped);
+    totalDropped += dropped;
+    // Self time is the duration minus the time spent in direct children.
+    // Spans are recorded when they end, so the children of a span are the
+    // spans one level deeper that ended since its previous sibling did.
+    std::vector<std::int64_t> childTime(events.size(), 0);
+    std::vector<std::int64_t> pending;
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+      const std::size_t depth = events[i].Depth;
+      if (pending.size() < depth + 2)
+      {
+        pending.resize(depth + 2, 0);
+      }
+      childTime[i] = pending[depth + 1];
+      pending[depth + 1] = 0;
+      pending[depth] += events[i].End - events[i].Begin;
+    }
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+      auto& summary = summaries[events[i].Name];
+      auto duration = events[i].End - events[i].Begin;
+      summary.Count++;
+      summary.Total += duration;
+      summary.Self += duration - childTime[i];
+      summary.Max = std::max(summary.Max, duration);
+    }
+  }
+
+  os << std::left << std::setw(36) << "Span" << std::right << std::setw(8)
+     << "Count" << std::setw(14) << "Total (ms)" << std::setw(14)
+     << "Self (ms)" << std::setw(14) << "Mean (us)" << std::setw(14)
+     << "Max (us)" << std::endl;
+  os << std::fixed << std::setprecision(3);
+  for (const auto& s : summaries)
+  {
+    os << std::left << std::setw(36) << s.first << std::right << std::setw(8)
+       << s.second.Count << std::setw(14) << s.second.Total * 1e-6
+       << std::setw(14) << s.second.Self * 1e-6 << std::setw(14)
+       << s.second.Total * 1e-3 / s.second.Count << std::setw(14)
+       << s.second.Max * 1e-3 << std::endl;
+  }
+  if (totalDropped)
+  {
+    os << totalDropped << " spans were overwritten, increase the capacity."
+       << std::endl;
+  }
+}
+
+} // namespace
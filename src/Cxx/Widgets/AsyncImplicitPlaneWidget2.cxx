@@ -0,0 +1,487 @@
+#include <vtkActor.h>
+#include <vtkAlgorithm.h>
+#include <vtkCamera.h>
+#include <vtkClipPolyData.h>
+#include <vtkCommand.h>
+#include <vtkImplicitPlaneRepresentation.h>
+#include <vtkImplicitPlaneWidget2.h>
+#include <vtkNamedColors.h>
+#include <vtkNew.h>
+#include <vtkPlane.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkQuadricClustering.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace {
+
+/**
+ * Clips a mesh on a worker thread.
+ *
+ * Request() only records the plane and returns. The worker clips with its
+ * own vtkPlane and vtkClipPolyData. A newer request cancels the running
+ * one: an observer of the filter's ProgressEvent, called on the worker
+ * thread, sets AbortExecute when the request has been superseded.
+ *
+ * The worker reads shallow copies of the meshes, made before it starts, so
+ * that it shares no pipeline objects with the main thread. Results are
+ * handed over as new vtkPolyData objects.
+ */
+class BackgroundClipper
+{
+public:
+  // proxy is a coarser version of mesh, clipped while the plane moves.
+  BackgroundClipper(vtkPolyData* mesh, vtkPolyData* proxy)
+  {
+    this->Mesh->ShallowCopy(mesh);
+    this->Proxy->ShallowCopy(proxy);
+    this->Worker = std::thread([this]() { this->Run(); });
+  }
+
+  ~BackgroundClipper()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Stop = true;
+      ++this->Latest;
+    }
+    this->Condition.notify_all();
+    this->Worker.join();
+  }
+
+  // Supersedes any pending or running request.
+  void Request(const double origin[3], const double normal[3], bool useProxy)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      std::copy(origin, origin + 3, this->Pending.Origin);
+      std::copy(normal, normal + 3, this->Pending.Normal);
+      this->Pending.UseProxy = useProxy;
+      this->Pending.Generation = ++this->Latest;
+      this->HasPending = true;
+    }
+    this->Condition.notify_all();
+  }
+
+  // The most recent completed result, if it has not been taken yet.
+  vtkSmartPointer<vtkPolyData> TakeResult()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    vtkSmartPointer<vtkPolyData> result;
+    std::swap(result, this->Result);
+    return result;
+  }
+
+  // Waits until the last request has completed and returns its result.
+  vtkSmartPointer<vtkPolyData> WaitForLast()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Condition.wait(lock, [this]() {
+      return !this->HasPending && this->ResultGeneration == this->Latest;
+    });
+    vtkSmartPointer<vtkPolyData> result;
+    std::swap(result, this->Result);
+    return result;
+  }
+
+  int GetNumberOfCompleted() const
+  {
+    return this->Completed;
+  }
+  int GetNumberOfCancelled() const
+  {
+    return this->Cancelled;
+  }
+
+private:
+  struct Job
+  {
+    double Origin[3];
+    double Normal[3];
+    bool UseProxy;
+    unsigned long Generation;
+  };
+
+  // Aborts the filter once its request is no longer the latest.
+  class AbortObserver : public vtkCommand
+  {
+  public:
+    static AbortObserver* New()
+    {
+      return new AbortObserver;
+    }
+
+    void Execute(vtkObject* caller, unsigned long, void*) override
+    {
+      if (*this->Latest != this->Generation)
+      {
+        static_cast<vtkAlgorithm*>(caller)->SetAbortExecute(1);
+      }
+    }
+
+    const std::atomic<unsigned long>* Latest = nullptr;
+    unsigned long Generation = 0;
+  };
+
+  void Run()
+  {
+    vtkNew<vtkPlane> plane;
+    vtkNew<vtkClipPolyData> clipper;
+    clipper->SetClipFunction(plane);
+    clipper->InsideOutOn();
+    vtkNew<AbortObserver> observer;
+    observer->Latest = &this->Latest;
+    clipper->AddObserver(vtkCommand::ProgressEvent, observer);
+
+    while (true)
+    {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(this->Mutex);
+        this->Condition.wait(
+            lock, [this]() { return this->Stop || this->HasPending; });
+        if (this->Stop)
+        {
+          return;
+        }
+        job = this->Pending;
+        this->HasPending = false;
+      }
+
+      plane->SetOrigin(job.Origin);
+      plane->SetNormal(job.Normal);
+      clipper->SetInputData(job.UseProxy ? this->Proxy : this->Mesh);
+      observer->Generation = job.Generation;
+      clipper->AbortExecuteOff();
+      // An aborted run leaves the filter looking up to date.
+      clipper->Modified();
+      clipper->Update();
+
+      if (clipper->GetAbortExecute() || this->Latest != job.Generation)
+      {
+        ++this->Cancelled;
+        continue;
+      }
+      auto result = vtkSmartPointer<vtkPolyData>::New();
+      result->ShallowCopy(clipper->GetOutput());
+      {
+        std::lock_guard<std::mutex> lock(this->Mutex);
+        this->Result = result;
+        this->ResultGeneration = job.Generation;
+      }
+      ++this->Completed;
+      this->Condition.notify_all();
+    }
+  }
+
+  vtkNew<vtkPolyData> Mesh;
+  vtkNew<vtkPolyData> Proxy;
+
+  std::mutex Mutex;
+  std::condition_variable Condition;
+  Job Pending;
+  bool HasPending = false;
+  bool Stop = false;
+  std::atomic<unsigned long> Latest{0};
+  vtkSmartPointer<vtkPolyData> Result;
+  unsigned long ResultGeneration = 0;
+  std::atomic<int> Completed{0};
+  std::atomic<int> Cancelled{0};
+
+  std::thread Worker;
+};
+
+// Sends the plane to the clipper while it moves: the proxy during the
+// interaction, the full mesh when it ends.
+class vtkAsyncIPWCallback : public vtkCommand
+{
+public:
+  static vtkAsyncIPWCallback* New()
+  {
+    return new vtkAsyncIPWCallback;
+  }
+
+  void Execute(vtkObject* caller, unsigned long eventId, void*) override
+  {
+    auto planeWidget = static_cast<vtkImplicitPlaneWidget2*>(caller);
+    auto rep = static_cast<vtkImplicitPlaneRepresentation*>(
+        planeWidget->GetRepresentation());
+    this->Clipper->Request(rep->GetOrigin(), rep->GetNormal(),
+                           eventId == vtkCommand::InteractionEvent);
+  }
+
+  BackgroundClipper* Clipper = nullptr;
+};
+
+// Puts the latest result in the mapper, on a repeating timer.
+class vtkSwapResultCallback : public vtkCommand
+{
+public:
+  static vtkSwapResultCallback* New()
+  {
+    return new vtkSwapResultCallback;
+  }
+
+  void Execute(vtkObject*, unsigned long, void*) override
+  {
+    if (auto result = this->Clipper->TakeResult())
+    {
+      this->Mapper->SetInputData(result);
+      this->RenderWindow->Render();
+    }
+  }
+
+  BackgroundClipper* Clipper = nullptr;
+  vtkPolyDataMapper* Mapper = nullptr;
+  vtkRenderWindow* RenderWindow = nullptr;
+};
+
+// The plane of move i out of n: it sweeps the mesh while tilting.
+void GetPlane(int i, int n, const double bounds[6], double origin[3],
+              double normal[3]);
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  // Usage: AsyncImplicitPlaneWidget2 [sphereResolution] [-i]
+  // A resolution of 1600 gives about five million triangles. Without -i,
+  // 200 plane moves are replayed and the latencies reported.
+  int resolution = 200;
+  bool interactive = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::string(argv[i]) == "-i")
+    {
+      interactive = true;
+    }
+    else
+    {
+      resolution = std::max(8, std::atoi(argv[i]));
+    }
+  }
+
+  vtkNew<vtkNamedColors> colors;
+  vtkNew<vtkTimerLog> timer;
+  std::cout << std::fixed << std::setprecision(4);
+
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetRadius(10.0);
+  sphereSource->SetThetaResolution(resolution);
+  sphereSource->SetPhiResolution(resolution);
+  sphereSource->Update();
+  vtkPolyData* mesh = sphereSource->GetOutput();
+
+  // The proxy, for immediate feedback while dragging.
+  vtkNew<vtkQuadricClustering> decimate;
+  decimate->SetInputData(mesh);
+  decimate->SetNumberOfDivisions(64, 64, 64);
+  timer->StartTimer();
+  decimate->Update();
+  timer->StopTimer();
+  std::cout << mesh->GetNumberOfCells() << " triangles, proxy of "
+            << decimate->GetOutput()->GetNumberOfCells() << " built in "
+            << timer->GetElapsedTime() << " s" << std::endl;
+
+  double bounds[6];
+  mesh->GetBounds(bounds);
+
+  vtkNew<vtkPolyDataMapper> mapper;
+  vtkNew<vtkActor> actor;
+  actor->SetMapper(mapper);
+  vtkNew<vtkProperty> backFaces;
+  backFaces->SetDiffuseColor(colors->GetColor3d("Gold").GetData());
+  actor->SetBackfaceProperty(backFaces);
+
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkRenderWindow> renderWindow;
+  renderWindow->AddRenderer(renderer);
+  renderWindow->SetWindowName("AsyncImplicitPlaneWidget2");
+  renderer->AddActor(actor);
+  renderer->SetBackground(colors->GetColor3d("SlateGray").GetData());
+
+  if (interactive)
+  {
+    BackgroundClipper clipper(mesh, decimate->GetOutput());
+    double origin[3];
+    double normal[3];
+    GetPlane(0, 1, bounds, origin, normal);
+    clipper.Request(origin, normal, false);
+    mapper->SetInputData(clipper.WaitForLast());
+
+    vtkNew<vtkRenderWindowInteractor> renderWindowInteractor;
+    renderWindowInteractor->SetRenderWindow(renderWindow);
+
+    vtkNew<vtkAsyncIPWCallback> planeCallback;
+    planeCallback->Clipper = &clipper;
+    vtkNew<vtkImplicitPlaneRepresentation> rep;
+    rep->SetPlaceFactor(1.25); // This must be set prior to placing the widget.
+    rep->PlaceWidget(bounds);
+    rep->SetOrigin(origin);
+    rep->SetNormal(normal);
+    vtkNew<vtkImplicitPlaneWidget2> planeWidget;
+    planeWidget->SetInteractor(renderWindowInteractor);
+    planeWidget->SetRepresentation(rep);
+    planeWidget->AddObserver(vtkCommand::InteractionEvent, planeCallback);
+    planeWidget->AddObserver(vtkCommand::EndInteractionEvent, planeCallback);
+
+    vtkNew<vtkSwapResultCallback> swapCallback;
+    swapCallback->Clipper = &clipper;
+    swapCallback->Mapper = mapper;
+    swapCallback->RenderWindow = renderWindow;
+
+    renderer->GetActiveCamera()->Azimuth(-60);
+    renderer->GetActiveCamera()->Elevation(30);
+    renderer->ResetCamera();
+    renderer->GetActiveCamera()->Zoom(0.75);
+
+    renderWindowInteractor->Initialize();
+    renderWindowInteractor->AddObserver(vtkCommand::TimerEvent, swapCallback);
+    renderWindowInteractor->CreateRepeatingTimer(15);
+    renderWindow->Render();
+    planeWidget->On();
+    renderWindowInteractor->Start();
+    return EXIT_SUCCESS;
+  }
+
+  // Replay: the latency of a move is the time between the event and the
+  // end of the render that follows it.
+  const int numberOfMoves = 200;
+  renderWindow->SetOffScreenRendering(1);
+  renderer->GetActiveCamera()->Azimuth(-60);
+  renderer->GetActiveCamera()->Elevation(30);
+
+  // Synchronous, as in ImplicitPlaneWidget2: the render clips.
+  vtkNew<vtkPolyData> syncMesh;
+  syncMesh->ShallowCopy(mesh);
+  vtkNew<vtkPlane> plane;
+  vtkNew<vtkClipPolyData> syncClipper;
+  syncClipper->SetInputData(syncMesh);
+  syncClipper->SetClipFunction(plane);
+  syncClipper->InsideOutOn();
+  mapper->SetInputConnection(syncClipper->GetOutputPort());
+  renderer->ResetCamera();
+  double worst = 0.0;
+  double total = 0.0;
+  for (int i = 0; i < numberOfMoves; ++i)
+  {
+    double origin[3];
+    double normal[3];
+    GetPlane(i, numberOfMoves, bounds, origin, normal);
+    timer->StartTimer();
+    plane->SetOrigin(origin);
+    plane->SetNormal(normal);
+    renderWindow->Render();
+    timer->StopTimer();
+    worst = std::max(worst, timer->GetElapsedTime());
+    total += timer->GetElapsedTime();
+  }
+  std::cout << "Synchronous clip:  worst " << worst * 1000.0 << " ms, mean "
+            << total / numberOfMoves * 1000.0 << " ms" << std::endl;
+  const vtkIdType expectedCells = syncClipper->GetOutput()->GetNumberOfCells();
+
+  // Asynchronous: the event only posts a request, the render shows the
+  // latest result available. The events are 10 ms apart, like mouse
+  // moves. Each move sets the plane of the representation and invokes the
+  // widget's InteractionEvent, so the request goes through
+  // vtkAsyncIPWCallback as it does when dragging.
+  // Until the first result arrives, the last synchronous one is shown.
+  vtkNew<vtkPolyData> previous;
+  previous->ShallowCopy(syncClipper->GetOutput());
+  mapper->SetInputData(previous);
+  bool ok = true;
+  {
+    BackgroundClipper clipper(mesh, decimate->GetOutput());
+    vtkNew<vtkAsyncIPWCallback> planeCallback;
+    planeCallback->Clipper = &clipper;
+    vtkNew<vtkImplicitPlaneRepresentation> rep;
+    rep->SetPlaceFactor(1.25);
+    rep->PlaceWidget(bounds);
+    vtkNew<vtkImplicitPlaneWidget2> planeWidget;
+    planeWidget->SetRepresentation(rep);
+    planeWidget->AddObserver(vtkCommand::InteractionEvent, planeCallback);
+    planeWidget->AddObserver(vtkCommand::EndInteractionEvent, planeCallback);
+
+    worst = 0.0;
+    total = 0.0;
+    int swapped = 0;
+    for (int i = 0; i < numberOfMoves; ++i)
+    {
+      double origin[3];
+      double normal[3];
+      GetPlane(i, numberOfMoves, bounds, origin, normal);
+      timer->StartTimer();
+      rep->SetOrigin(origin);
+      rep->SetNormal(normal);
+      planeWidget->InvokeEvent(vtkCommand::InteractionEvent, nullptr);
+      if (auto result = clipper.TakeResult())
+      {
+        mapper->SetInputData(result);
+        ++swapped;
+      }
+      renderWindow->Render();
+      timer->StopTimer();
+      worst = std::max(worst, timer->GetElapsedTime());
+      total += timer->GetElapsedTime();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // The end of the drag: the full mesh at the last position.
+    planeWidget->InvokeEvent(vtkCommand::EndInteractionEvent, nullptr);
+    timer->StartTimer();
+    auto last = clipper.WaitForLast();
+    timer->StopTimer();
+    mapper->SetInputData(last);
+    renderWindow->Render();
+
+    std::cout << "Asynchronous clip: worst " << worst * 1000.0
+              << " ms, mean " << total / numberOfMoves * 1000.0 << " ms, "
+              << swapped << " results shown, "
+              << clipper.GetNumberOfCompleted() << " completed, "
+              << clipper.GetNumberOfCancelled() << " cancelled"
+              << std::endl;
+    std::cout << "Full resolution result " << timer->GetElapsedTime()
+              << " s after the end of the drag, "
+              << last->GetNumberOfCells() << " cells (synchronous: "
+              << expectedCells << ")" << std::endl;
+    ok = last->GetNumberOfCells() == expectedCells;
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+
+void GetPlane(int i, int n, const double bounds[6], double origin[3],
+              double normal[3])
+{
+  const double t = n > 1 ? static_cast<double>(i) / (n - 1) : 0.5;
+  for (int k = 0; k < 3; ++k)
+  {
+    origin[k] = 0.5 * (bounds[2 * k] + bounds[2 * k + 1]);
+  }
+  origin[0] = bounds[0] + (0.1 + 0.8 * t) * (bounds[1] - bounds[0]);
+  const double angle = 0.5 * std::sin(6.283185307179586 * t);
+  normal[0] = std::cos(angle);
+  normal[1] = std::sin(angle);
+  normal[2] = 0.0;
+}
+
+} // namespace